@@ -0,0 +1,173 @@
+/*
+	acq_bench.cpp - sustained acquisition with the host source
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Checks the acquisition config is restored from nvm, then
+ * runs the synthetic source at the board's top rate with
+ * one and three channels, checking every sample landed on
+ * its channel. Prints the rate the loop received samples
+ * at, the buffers it was too late for and how busy it was.
+ *
+ * usage: acq_bench [nvm file] [seconds per run]
+ */
+
+#include <Arduino.h>
+#include <unistd.h>
+#include <thread>
+#include "bench_nvm.h"
+#include "acquisition/acquisition.h"
+#include "acquisition/acq_host.h"
+
+struct RunResult {
+	uint64_t samples;
+	uint32_t buffers;
+	uint32_t micros;
+	uint32_t busyMicros;
+	uint32_t misplaced;
+};
+
+const AcqConfig RESTORE_CONFIG = {48000UL, 0x03U};
+
+/**
+ * Starts acquisition so it stores RESTORE_CONFIG
+ *
+ * @return if it started
+ */
+bool storeConfig(void) {
+	if (acqStart(RESTORE_CONFIG) != ACQ_OK) {
+		return false;
+	}
+	acqEnd();
+	return true;
+}
+
+/**
+ * Checks acqInit() starts with RESTORE_CONFIG
+ *
+ * @return if the config came back
+ */
+bool checkConfig(void) {
+	if (acqInit() != ACQ_OK) {
+		return false;
+	}
+	bool restored = acqSampleRate() == RESTORE_CONFIG.sampleRate &&
+		acqChannels() == RESTORE_CONFIG.channels;
+	acqEnd();
+	return restored;
+}
+
+/**
+ * Takes buffers for a while like a loop drawing a trace,
+ * every channel is set to its own level
+ *
+ * @param config rate and channels to acquire
+ * @param seconds time to run
+ * @param result samples received and time spent on them
+ *
+ * @return if acquisition started
+ */
+bool runAcquisition(const AcqConfig &config, uint32_t seconds, RunResult *result) {
+	uint8_t count = 0U;
+	SampleWord levels[Board::adcChannels];
+	for (uint8_t channel = 0U; channel < Board::adcChannels; channel++) {
+		AcqHostSignal signal = {ACQ_WAVE_DC, 0.0f, 0.0f, (channel + 1U) / 10.0f};
+		acqHostSetSignal(channel, signal);
+		if (config.channels & (1U << channel)) {
+			levels[count++] = (SampleWord)(signal.offset * ((1UL << Board::adcBits) - 1UL) + 0.5f);
+		}
+	}
+
+	if (acqStart(config) != ACQ_OK) {
+		return false;
+	}
+
+	result->samples = 0U;
+	result->buffers = 0U;
+	result->busyMicros = 0U;
+	result->misplaced = 0U;
+
+	uint32_t start = micros();
+	while ((uint32_t)(micros() - start) < seconds * 1000000UL) {
+		uint32_t begin = micros();
+		const SampleWord *samples;
+		uint16_t length = acqGetBuffer(&samples);
+		if (length == 0U) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		// each buffer starts at the lowest channel
+		uint32_t misplaced = 0U;
+		for (uint16_t i = 0U; i < length; i++) {
+			if (samples[i] != levels[i % count]) {
+				misplaced++;
+			}
+		}
+
+		if (acqReleaseBuffer()) {
+			result->samples += length;
+			result->buffers++;
+			result->misplaced += misplaced;
+		}
+		result->busyMicros += (uint32_t)(micros() - begin);
+	}
+	result->micros = (uint32_t)(micros() - start);
+	return true;
+}
+
+void printRun(const char *name, const RunResult &result) {
+	debugFlush();
+	printf("\n== %s\n", name);
+	printf("per channel rate run/received: %u/%.0f S/s\n", acqSampleRate(),
+		result.samples * 1e6 / result.micros / acqChannelCount(acqChannels()));
+	printf("buffers %u, overruns %u, loop busy %.1f%%, samples on the wrong channel %u\n",
+		result.buffers, acqOverruns(), result.busyMicros * 100.0 / result.micros, result.misplaced);
+}
+
+int main(int argc, char **argv) {
+	const char *path = argc > 1 ? argv[1] : "acq_bench.bin";
+	uint32_t seconds = argc > 2 ? (uint32_t)atol(argv[2]) : 2U;
+
+	unlink(path);
+	if (!startNvm(path)) {
+		printf("nvm couldn't be started at %s\n", path);
+		return 1;
+	}
+
+	bool restored = checkRestore(path, storeConfig, checkConfig);
+	printf("%s, %u sample double buffers\n", Board::name, (unsigned)ACQ_BUFFER_SAMPLES);
+	printf("config restored from nvm: %s\n", restored ? "yes" : "no");
+
+	RunResult result;
+	bool ok = restored;
+
+	AcqConfig single = {Board::adcMaxRate, 0x01U};
+	ok &= runAcquisition(single, seconds, &result) && result.misplaced == 0U;
+	printRun("one channel at the board's top rate", result);
+	acqEnd();
+
+	AcqConfig multi = {Board::adcMaxRate / 3U, 0x0BU};
+	ok &= runAcquisition(multi, seconds, &result) && result.misplaced == 0U;
+	printRun("three channels sharing the top rate", result);
+	acqEnd();
+
+	nvmEnd();
+	debugFlush();
+	unlink(path);
+	return ok ? 0 : 1;
+}
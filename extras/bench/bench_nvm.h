@@ -0,0 +1,64 @@
+/*
+	bench_nvm.h - nvm fixture shared by the benches
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCH_NVM_H
+#define BENCH_NVM_H
+
+#include <Arduino.h>
+#include "nvm/generic_nvm.h"
+
+#ifdef NVM_FILE
+#include "nvm/core_file.h"
+#endif
+
+#define REGION_SIZE 1024U
+
+/**
+ * Starts nvm on the bench file
+ *
+ * @param path nvm file, unused with Preferences
+ *
+ * @return if nvm started
+ */
+inline bool startNvm(const char *path) {
+	#ifdef NVM_FILE
+		EEPROM.setPath(path);
+	#endif
+	return nvmInit(REGION_SIZE) == NVM_OK;
+}
+
+/**
+ * Stores a config, restarts nvm like a reset would and
+ * checks the config is picked up again
+ *
+ * @param path nvm file
+ * @param store stores the config, false if it couldn't
+ * @param check loads the stored config, false if it didn't come back
+ *
+ * @return if the config came back
+ */
+inline bool checkRestore(const char *path, bool (*store)(void), bool (*check)(void)) {
+	if (!store()) {
+		return false;
+	}
+	nvmFlush();
+	nvmEnd();
+	return startNvm(path) && check();
+}
+
+#endif
@@ -0,0 +1,255 @@
+/*
+	codec_bench.cpp - sample codec ratio and speed
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Encodes and decodes waveforms in acquisition sized
+ * blocks, checking every block decodes to its samples.
+ * Prints the ratio against 16 bit samples and against
+ * samples packed at the ADC's bits, encode and decode
+ * speed, and the samples per second a 115200 baud link
+ * carries. Waveforms are synthetic, recorded from the
+ * host acquisition source, and recorded from a board if
+ * a capture of little endian 16 bit samples is given.
+ *
+ * usage: codec_bench [capture file] [channels in capture]
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdlib.h>
+#include <thread>
+#include "acquisition/acquisition.h"
+#include "acquisition/acq_host.h"
+#include "codec/codec.h"
+
+#define WAVE_SAMPLES 4000000UL
+#define RECORD_SAMPLES 1000000UL
+#define LINK_BYTES_PER_SECOND (115200UL / 10UL)
+#define FULL_SCALE ((float)((1UL << Board::adcBits) - 1UL))
+
+struct Wave {
+	const char *name;
+	uint8_t channels;
+	SampleWord *samples;
+	uint32_t count;
+};
+
+uint32_t noiseState = 12345UL;
+
+/**
+ * Gets noise for the waves, the same every run
+ *
+ * @return noise from -1 to 1
+ */
+float noise(void) {
+	noiseState = noiseState * 1664525UL + 1013904223UL;
+	return (float)(noiseState >> 8) / (float)(1UL << 23) - 1.0f;
+}
+
+SampleWord toSample(float level) {
+	level = level < 0.0f ? 0.0f : (level > 1.0f ? 1.0f : level);
+	return (SampleWord)(level * FULL_SCALE + 0.5f);
+}
+
+/**
+ * Makes a synthetic wave
+ *
+ * @param wave wave to fill, count and channels set
+ * @param shape 0 noisy sine, 1 noisy square, 2 triangle, 3 full scale noise, 4 sines per channel
+ */
+void makeWave(Wave *wave, uint8_t shape) {
+	wave->samples = (SampleWord*)malloc(wave->count * sizeof(SampleWord));
+	for (uint32_t i = 0UL; i < wave->count; i++) {
+		uint32_t set = i / wave->channels;
+		uint8_t slot = (uint8_t)(i % wave->channels);
+		float level;
+		switch (shape) {
+			case 0U:
+				level = 0.5f + 0.45f * sinf(set * 0.002f) + 0.001f * noise();
+				break;
+			case 1U:
+				level = ((set / 500UL) & 1UL ? 0.8f : 0.2f) + 0.001f * noise();
+				break;
+			case 2U:
+				level = (float)(set % 2000UL) / 1000.0f;
+				level = level > 1.0f ? 2.0f - level : level;
+				break;
+			case 3U:
+				level = 0.5f + 0.5f * noise();
+				break;
+			default:
+				level = 0.5f + 0.4f * sinf(set * 0.001f * (slot + 1U)) + 0.001f * noise();
+				break;
+		}
+		wave->samples[i] = toSample(level);
+	}
+}
+
+/**
+ * Records buffers from the host acquisition source
+ *
+ * @param wave wave to fill, count and channels set
+ *
+ * @return if acquisition ran
+ */
+bool recordWave(Wave *wave) {
+	wave->samples = (SampleWord*)malloc(wave->count * sizeof(SampleWord));
+	AcqHostSignal sine = {ACQ_WAVE_SINE, 1000.0f, 0.4f, 0.5f};
+	AcqHostSignal triangle = {ACQ_WAVE_TRIANGLE, 250.0f, 0.3f, 0.5f};
+	acqHostSetSignal(0U, sine);
+	acqHostSetSignal(1U, triangle);
+
+	AcqConfig config = {100000UL, 0x03U};
+	if (acqStart(config) != ACQ_OK) {
+		free(wave->samples);
+		return false;
+	}
+	uint32_t filled = 0UL;
+	while (filled < wave->count) {
+		const SampleWord *samples;
+		uint16_t length = acqGetBuffer(&samples);
+		if (length == 0U) {
+			std::this_thread::yield();
+			continue;
+		}
+		uint32_t take = wave->count - filled < length ? wave->count - filled : length;
+		memcpy(&wave->samples[filled], samples, take * sizeof(SampleWord));
+		if (acqReleaseBuffer()) {
+			filled += take;
+		}
+	}
+	acqEnd();
+	return true;
+}
+
+/**
+ * Loads a capture from a board
+ *
+ * @param wave wave to fill, channels set
+ * @param path capture of little endian 16 bit samples
+ *
+ * @return if the capture was read
+ */
+bool loadWave(Wave *wave, const char *path) {
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) {
+		return false;
+	}
+	fseek(file, 0L, SEEK_END);
+	long bytes = ftell(file);
+	fseek(file, 0L, SEEK_SET);
+
+	wave->count = (uint32_t)(bytes / 2L);
+	wave->count -= wave->count % wave->channels;
+	wave->samples = (SampleWord*)malloc(wave->count * sizeof(SampleWord));
+	uint8_t pair[2];
+	for (uint32_t i = 0UL; i < wave->count && fread(pair, 1U, 2U, file) == 2U; i++) {
+		// a board with a wider ADC is cut down to this build's bits
+		wave->samples[i] = (SampleWord)((pair[0] | (pair[1] << 8)) & (uint16_t)FULL_SCALE);
+	}
+	fclose(file);
+	return wave->count != 0UL;
+}
+
+/**
+ * Encodes and decodes a wave block by block
+ *
+ * @param wave wave to code
+ *
+ * @return if every block came back the same
+ */
+bool benchWave(const Wave &wave) {
+	uint16_t block = (uint16_t)(ACQ_BUFFER_SAMPLES - ACQ_BUFFER_SAMPLES % wave.channels);
+	uint32_t blocks = wave.count / block;
+	uint16_t capacity = CODEC_MAX_BYTES(block);
+	uint8_t *encoded = (uint8_t*)malloc((size_t)blocks * capacity);
+	uint16_t *lengths = (uint16_t*)malloc(blocks * sizeof(uint16_t));
+	uint16_t *decoded = (uint16_t*)malloc(block * sizeof(uint16_t));
+
+	uint64_t bytes = 0U;
+	uint32_t start = micros();
+	for (uint32_t i = 0UL; i < blocks; i++) {
+		lengths[i] = codecEncode(&wave.samples[i * block], block, wave.channels, &encoded[i * capacity], capacity);
+		bytes += lengths[i];
+	}
+	uint32_t encodeMicros = (uint32_t)(micros() - start);
+
+	uint32_t wrong = 0UL;
+	uint32_t decodeMicros = 0UL;
+	for (uint32_t i = 0UL; i < blocks; i++) {
+		start = micros();
+		uint16_t count = codecDecode(&encoded[i * capacity], lengths[i], decoded, block);
+		decodeMicros += (uint32_t)(micros() - start);
+
+		bool same = count == block;
+		for (uint16_t k = 0U; same && k < block; k++) {
+			same = decoded[k] == wave.samples[i * block + k];
+		}
+		wrong += same ? 0UL : 1UL;
+	}
+
+	uint64_t samples = (uint64_t)blocks * block;
+	double ratio = samples * 2.0 / bytes;
+	double packedRatio = samples * Board::adcBits / 8.0 / bytes;
+	printf("%-26s %5.2fx raw, %5.2fx packed, encode %7.1f decode %7.1f MB/s, %6.0f S/s over the link%s\n",
+		wave.name, ratio, packedRatio, samples * 2.0 / encodeMicros, samples * 2.0 / decodeMicros,
+		LINK_BYTES_PER_SECOND / 2.0 * ratio, wrong == 0UL ? "" : "  BLOCKS WRONG");
+
+	free(encoded);
+	free(lengths);
+	free(decoded);
+	return wrong == 0UL;
+}
+
+int main(int argc, char **argv) {
+	printf("%s, %u bit samples, %u sample blocks, %u sample groups, 115200 baud carries %lu S/s raw\n",
+		Board::name, (unsigned)CODEC_SAMPLE_BITS, (unsigned)ACQ_BUFFER_SAMPLES, (unsigned)CODEC_GROUP,
+		(unsigned long)(LINK_BYTES_PER_SECOND / 2UL));
+
+	Wave waves[7] = {
+		{"sine", 1U, NULL, WAVE_SAMPLES},
+		{"square", 1U, NULL, WAVE_SAMPLES},
+		{"triangle", 1U, NULL, WAVE_SAMPLES},
+		{"full scale noise", 1U, NULL, WAVE_SAMPLES},
+		{"sines on 3 channels", 3U, NULL, WAVE_SAMPLES - WAVE_SAMPLES % 3UL},
+		{"recorded host source", 2U, NULL, RECORD_SAMPLES},
+		{"recorded capture", argc > 2 ? (uint8_t)atoi(argv[2]) : (uint8_t)1U, NULL, 0UL}
+	};
+	uint8_t count = 5U;
+	for (uint8_t i = 0U; i < count; i++) {
+		makeWave(&waves[i], i);
+	}
+	if (recordWave(&waves[count])) {
+		count++;
+	}
+	if (argc > 1) {
+		if (waves[6].channels == 0U || !loadWave(&waves[6], argv[1])) {
+			printf("capture %s couldn't be read\n", argv[1]);
+			return 1;
+		}
+		waves[count++] = waves[6];
+	}
+
+	bool ok = true;
+	for (uint8_t i = 0U; i < count; i++) {
+		ok &= benchWave(waves[i]);
+		free(waves[i].samples);
+	}
+	debugFlush();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,530 @@
+/*
+	core_bench.cpp - microbenchmarks of the core routines on the host
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Times the nvm API, the number formatters, log sites,
+ * trace scopes and critical sections of the build it is
+ * linked with. Each case runs enough iterations to take
+ * BENCH_TARGET_NS, is repeated and the median ns per
+ * operation is reported, so two runs can be compared
+ * with extras/tools/bench_compare.py to catch regressions.
+ * Serial output of the core goes to /dev/null.
+ *
+ * usage: core_bench [-f filter] [-r repeats] [-j results.json] [nvm file]
+ */
+
+#include <Arduino.h>
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "format.h"
+#include "critical.h"
+#include "nvm/generic_nvm.h"
+
+#ifdef NVM_FILE
+#include "nvm/core_file.h"
+#else
+#include <Preferences.h>
+#endif
+
+// time each repeat of a case aims for
+#define BENCH_TARGET_NS 20000000ULL
+
+#define REGION_SIZE 1024U
+
+/**
+ * One benchmark, run returns a checksum so the
+ * compiler can't drop the work
+ */
+struct BenchCase {
+	const char *name;
+	uint64_t (*run)(uint32_t iterations);
+};
+
+struct BenchResult {
+	const char *name;
+	double medianNs;
+	double minNs;
+	uint32_t iterations;
+};
+
+volatile uint64_t benchSink = 0U;
+
+uint64_t nowNanos(void) {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Values that mix small counters with full width numbers
+ */
+uint64_t benchValue(uint32_t i) {
+	uint64_t value = (uint64_t)i * 0x9E3779B97F4A7C15ULL;
+	return value >> (i % 64U);
+}
+
+/****************************
+ * Format Cases
+****************************/
+
+uint64_t benchFormatU32(uint32_t iterations) {
+	char buffer[FORMAT_BUFFER_SIZE];
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		sum += formatUnsigned(buffer, (uint32_t)benchValue(i), DEC);
+	}
+	return sum;
+}
+
+uint64_t benchFormatI64(uint32_t iterations) {
+	char buffer[FORMAT_BUFFER_SIZE];
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		int64_t value = (int64_t)benchValue(i);
+		sum += formatSigned(buffer, (i & 1U) ? -value : value, DEC);
+	}
+	return sum;
+}
+
+uint64_t benchFormatHex(uint32_t iterations) {
+	char buffer[FORMAT_BUFFER_SIZE];
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		sum += formatUnsigned(buffer, benchValue(i), HEX);
+	}
+	return sum;
+}
+
+uint64_t benchFormatFloat(uint32_t iterations) {
+	char buffer[FORMAT_BUFFER_SIZE];
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		sum += formatFloat(buffer, (double)(benchValue(i) % 1000000U) / 1000.0, 3U);
+	}
+	return sum;
+}
+
+uint64_t benchPrintInt64(uint32_t iterations) {
+	for (uint32_t i = 0U; i < iterations; i++) {
+		printInt64((int64_t)benchValue(i));
+	}
+	return iterations;
+}
+
+/****************************
+ * Debug Cases
+****************************/
+
+#if DEBUG_LEVEL > DEBUG_LEVEL_NONE
+
+uint64_t benchLogOff(uint32_t iterations) {
+	debugSetCategories(DEBUG_CAT_ERR);
+	for (uint32_t i = 0U; i < iterations; i++) {
+		LOG_E(NVM, "bench value {} at {}", i, (uint16_t)(i & 0xFFU));
+	}
+	debugSetCategories(DEBUG_CAT_ALL);
+	return iterations;
+}
+
+uint64_t benchLogLine(uint32_t iterations) {
+	uint32_t dropped = debugDropped();
+	for (uint32_t i = 0U; i < iterations; i++) {
+		LOG_E(NVM, "bench value {} at {}", i, (uint16_t)(i & 0xFFU));
+		debugPoll();
+	}
+	return debugDropped() - dropped;
+}
+
+#endif
+
+/****************************
+ * Trace And Critical Cases
+****************************/
+
+#ifdef DEBUG_TRACE
+
+uint64_t benchTraceScope(uint32_t iterations) {
+	for (uint32_t i = 0U; i < iterations; i++) {
+		TRACE_SCOPE("benchScope");
+		benchSink = i;
+	}
+	traceClear();
+	return iterations;
+}
+
+#endif
+
+uint64_t benchCritical(uint32_t iterations) {
+	for (uint32_t i = 0U; i < iterations; i++) {
+		CriticalSection critical;
+		benchSink = i;
+	}
+	return iterations;
+}
+
+/****************************
+ * NVM Cases
+****************************/
+
+uint64_t benchWriteU8(uint32_t iterations) {
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		sum += nvmWriteValue(8U, (uint8_t)i);
+	}
+	return sum;
+}
+
+uint64_t benchWriteU32(uint32_t iterations) {
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		sum += nvmWriteValue(16U, i);
+	}
+	return sum;
+}
+
+uint64_t benchWriteU64(uint32_t iterations) {
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		sum += nvmWriteValue(24U, benchValue(i));
+	}
+	return sum;
+}
+
+uint64_t benchWriteDouble(uint32_t iterations) {
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		sum += nvmWriteValue(40U, (double)i * 0.25);
+	}
+	return sum;
+}
+
+uint64_t benchWriteSame(uint32_t iterations) {
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		sum += nvmWriteValue(16U, (uint32_t)1234U);
+	}
+	return sum;
+}
+
+uint64_t benchGetU32(uint32_t iterations) {
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		uint32_t value = 0U;
+		nvmGetValue(16U, &value);
+		sum += value;
+	}
+	return sum;
+}
+
+uint64_t benchGetDouble(uint32_t iterations) {
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		double value = 0.0;
+		nvmGetValue(40U, &value);
+		sum += (uint64_t)value;
+	}
+	return sum;
+}
+
+uint64_t benchWriteFlush(uint32_t iterations) {
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		sum += nvmWriteValue(16U, i);
+		sum += nvmFlush();
+	}
+	return sum;
+}
+
+uint64_t benchBatch(uint32_t iterations) {
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		nvmBeginBatch();
+		nvmWriteValue(8U, (uint8_t)(i & 3U));
+		nvmWriteValue(16U, i);
+		nvmWriteValue(24U, benchValue(i));
+		nvmWriteValue(40U, (double)i * 0.25);
+		sum += nvmCommitBatch();
+	}
+	return sum;
+}
+
+uint64_t benchWriteBytes(uint32_t iterations) {
+	uint8_t data[16];
+	memset(data, 0x5A, sizeof(data));
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		data[0] = (uint8_t)i;
+		sum += nvmWriteBytes(64U, data, sizeof(data), sizeof(data) + NVM_LENGTH_PREFIX);
+	}
+	return sum;
+}
+
+uint64_t benchGetBytes(uint32_t iterations) {
+	uint8_t data[16];
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		uint16_t length = 0U;
+		nvmGetBytes(64U, data, &length, sizeof(data) + NVM_LENGTH_PREFIX);
+		sum += length + data[0];
+	}
+	return sum;
+}
+
+uint64_t benchWriteString(uint32_t iterations) {
+	char text[] = "oscilloscope-0";
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		text[sizeof(text) - 2U] = (char)('0' + i % 10U);
+		sum += nvmWriteString(96U, text, 24U);
+	}
+	return sum;
+}
+
+uint64_t benchGetString(uint32_t iterations) {
+	char text[24];
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		nvmGetString(96U, text, sizeof(text));
+		sum += (uint8_t)text[0];
+	}
+	return sum;
+}
+
+uint64_t benchWriteBlock(uint32_t iterations) {
+	uint8_t block[64];
+	memset(block, 0xA5, sizeof(block));
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		block[i % sizeof(block)] = (uint8_t)i;
+		sum += nvmWriteBlock(128U, block, sizeof(block));
+	}
+	return sum;
+}
+
+uint64_t benchReadBlock(uint32_t iterations) {
+	uint8_t block[64];
+	uint64_t sum = 0U;
+	for (uint32_t i = 0U; i < iterations; i++) {
+		sum += nvmReadBlock(128U, block, sizeof(block)) + block[i % sizeof(block)];
+	}
+	return sum;
+}
+
+const BenchCase benchCases[] = {
+	{"format/u32", benchFormatU32},
+	{"format/i64", benchFormatI64},
+	{"format/hex64", benchFormatHex},
+	{"format/float3", benchFormatFloat},
+	{"debug/printInt64", benchPrintInt64},
+	#if DEBUG_LEVEL > DEBUG_LEVEL_NONE
+		{"debug/log_masked", benchLogOff},
+		{"debug/log_line", benchLogLine},
+	#endif
+	#ifdef DEBUG_TRACE
+		{"trace/scope", benchTraceScope},
+	#endif
+	{"critical/section", benchCritical},
+	{"nvm/write_u8", benchWriteU8},
+	{"nvm/write_u32", benchWriteU32},
+	{"nvm/write_u64", benchWriteU64},
+	{"nvm/write_double", benchWriteDouble},
+	{"nvm/write_unchanged", benchWriteSame},
+	{"nvm/get_u32", benchGetU32},
+	{"nvm/get_double", benchGetDouble},
+	{"nvm/write_flush", benchWriteFlush},
+	{"nvm/batch4", benchBatch},
+	{"nvm/write_bytes16", benchWriteBytes},
+	{"nvm/get_bytes16", benchGetBytes},
+	{"nvm/write_string", benchWriteString},
+	{"nvm/get_string", benchGetString},
+	{"nvm/write_block64", benchWriteBlock},
+	{"nvm/read_block64", benchReadBlock},
+};
+
+/****************************
+ * Runner
+****************************/
+
+/**
+ * Times one run of a case
+ *
+ * @return nanoseconds taken
+ */
+uint64_t timeCase(const BenchCase &benchCase, uint32_t iterations) {
+	uint64_t start = nowNanos();
+	benchSink = benchSink + benchCase.run(iterations);
+	uint64_t elapsed = nowNanos() - start;
+
+	// pending output and async commits land outside the timing
+	debugPoll();
+	return elapsed;
+}
+
+/**
+ * Finds iterations that take about BENCH_TARGET_NS
+ */
+uint32_t calibrate(const BenchCase &benchCase) {
+	uint32_t iterations = 1U;
+	while (iterations < (1UL << 30)) {
+		uint64_t elapsed = timeCase(benchCase, iterations);
+		if (elapsed >= BENCH_TARGET_NS / 10U) {
+			uint64_t scaled = (uint64_t)iterations * BENCH_TARGET_NS / (elapsed ? elapsed : 1U);
+			return scaled < 1U ? 1U : (uint32_t)std::min<uint64_t>(scaled, 1UL << 30);
+		}
+		iterations *= 2U;
+	}
+	return iterations;
+}
+
+BenchResult runCase(const BenchCase &benchCase, uint32_t repeats) {
+	uint32_t iterations = calibrate(benchCase);
+	std::vector<double> samples;
+
+	for (uint32_t i = 0U; i < repeats; i++) {
+		samples.push_back((double)timeCase(benchCase, iterations) / iterations);
+	}
+	std::sort(samples.begin(), samples.end());
+
+	BenchResult result;
+	result.name = benchCase.name;
+	result.medianNs = samples[samples.size() / 2U];
+	result.minNs = samples[0];
+	result.iterations = iterations;
+	return result;
+}
+
+/**
+ * Describes the build so results of different
+ * configurations aren't compared by mistake
+ */
+void buildConfig(char *config, size_t size) {
+	const char *backend = "eeprom file";
+	#if defined(NVM_LOG)
+		backend = "log";
+	#elif defined(NVM_PREF_PACKED)
+		backend = "pref packed";
+	#elif defined(NVM_PREF)
+		backend = "pref";
+	#endif
+
+	snprintf(config, size, "%s, nvm %s%s, debug level %u%s%s", Board::name, backend,
+		#ifdef NVM_ASYNC
+			" async",
+		#else
+			"",
+		#endif
+		(unsigned)DEBUG_LEVEL,
+		#ifdef DEBUG_TOKENIZED
+			" tokenized",
+		#else
+			"",
+		#endif
+		#ifdef DEBUG_TRACE
+			", trace"
+		#else
+			""
+		#endif
+	);
+}
+
+bool writeJson(const char *path, const char *config, const std::vector<BenchResult> &results) {
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		return false;
+	}
+
+	fprintf(file, "{\n \"config\": \"%s\",\n \"results\": {", config);
+	for (size_t i = 0U; i < results.size(); i++) {
+		fprintf(file, "%s\n  \"%s\": {\"ns\": %.3f, \"min_ns\": %.3f, \"iterations\": %u}",
+			i ? "," : "", results[i].name, results[i].medianNs, results[i].minNs, results[i].iterations);
+	}
+	fprintf(file, "\n }\n}\n");
+	return fclose(file) == 0;
+}
+
+bool startNVM(const char *path) {
+	#ifdef NVM_FILE
+		unlink(path);
+		EEPROM.setPath(path);
+	#else
+		Preferences::erase();
+	#endif
+	return nvmInit(REGION_SIZE) == NVM_OK;
+}
+
+int main(int argc, char **argv) {
+	const char *filter = NULL;
+	const char *jsonPath = NULL;
+	const char *path = "core_bench.bin";
+	uint32_t repeats = 5U;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+			filter = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-r") && i + 1 < argc) {
+			repeats = (uint32_t)atol(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-j") && i + 1 < argc) {
+			jsonPath = argv[++i];
+		}
+		else {
+			path = argv[i];
+		}
+	}
+	if (repeats == 0U) {
+		repeats = 1U;
+	}
+
+	FILE *discard = fopen("/dev/null", "w");
+	Serial.setOutput(discard);
+
+	if (!startNVM(path)) {
+		printf("nvm couldn't be started\n");
+		return 1;
+	}
+
+	char config[128];
+	buildConfig(config, sizeof(config));
+	printf("%s, median of %u\n", config, repeats);
+	printf("%-24s %12s %12s %12s\n", "case", "ns/op", "min ns/op", "iterations");
+
+	std::vector<BenchResult> results;
+	for (size_t i = 0U; i < sizeof(benchCases) / sizeof(benchCases[0]); i++) {
+		if (filter != NULL && strstr(benchCases[i].name, filter) == NULL) {
+			continue;
+		}
+		BenchResult result = runCase(benchCases[i], repeats);
+		printf("%-24s %12.2f %12.2f %12u\n", result.name, result.medianNs, result.minNs, result.iterations);
+		fflush(stdout);
+		results.push_back(result);
+	}
+
+	nvmEnd();
+	debugFlush();
+	Serial.setOutput(NULL);
+	fclose(discard);
+
+	if (jsonPath != NULL && !writeJson(jsonPath, config, results)) {
+		printf("couldn't write %s\n", jsonPath);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,215 @@
+/*
+	decimate_bench.cpp - decimation throughput and glitch capture
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Decimates a slow sine with one sample glitches in
+ * acquisition sized blocks, with one channel and with the
+ * glitches on the middle of three. Prints samples per
+ * second, the glitches that made it into the points, the
+ * glitches keeping every Nth sample would have shown, and
+ * the bytes per second the points take on the link at the
+ * board's top ADC rate. Also checks decInit() restores
+ * the config from nvm.
+ *
+ * usage: decimate_bench [nvm file] [samples]
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "bench_nvm.h"
+#include "acquisition/acquisition.h"
+#include "decimation/decimation.h"
+
+#define DEFAULT_SAMPLES 8000000UL
+
+// sets between glitches, further apart than any span
+#define GLITCH_SPACING 7919UL
+#define GLITCH_HIGH 4095U
+#define GLITCH_LOW 0U
+
+struct Signal {
+	const char *name;
+	uint8_t channels;
+	uint8_t glitchSlot; // place in a set of the glitched channel
+	SampleWord *samples;
+	uint32_t count;
+};
+
+const DecConfig RESTORE_CONFIG = {DEC_PEAK, 100U};
+
+/**
+ * Begins decimation so it stores RESTORE_CONFIG
+ *
+ * @return if it began
+ */
+bool storeConfig(void) {
+	return decBegin(RESTORE_CONFIG, 0x03U);
+}
+
+/**
+ * Checks decInit() picks up RESTORE_CONFIG
+ *
+ * @return if the config came back
+ */
+bool checkConfig(void) {
+	DecConfig restored;
+	return decLoadConfig(&restored, 0x03U) && decInit(0x03U) &&
+		restored.mode == RESTORE_CONFIG.mode && restored.points == RESTORE_CONFIG.points;
+}
+
+/**
+ * Fills a signal with a sine on every channel and
+ * glitches alternately high and low on one
+ *
+ * @param signal signal to fill
+ */
+void fillSignal(Signal *signal) {
+	uint8_t stride = acqChannelCount(signal->channels);
+	uint32_t glitches = 0UL;
+	for (uint32_t i = 0UL; i < signal->count; i++) {
+		uint32_t set = i / stride;
+		uint8_t slot = (uint8_t)(i % stride);
+		float level = 0.5f + 0.3f * sinf((float)set * 0.0007f + slot);
+		signal->samples[i] = (SampleWord)(level * 4095.0f + 0.5f);
+
+		if (slot == signal->glitchSlot && set % GLITCH_SPACING == GLITCH_SPACING / 2U) {
+			signal->samples[i] = (glitches & 1UL) ? GLITCH_LOW : GLITCH_HIGH;
+			glitches++;
+		}
+	}
+}
+
+/**
+ * Counts glitch samples in a block of points or samples
+ *
+ * @param values points or samples
+ * @param count values in the block
+ * @param stride values per set
+ * @param slot place of the glitched channel in a set
+ *
+ * @return glitches seen
+ */
+uint32_t countGlitches(const SampleWord *values, uint16_t count, uint8_t stride, uint8_t slot) {
+	uint32_t seen = 0UL;
+	for (uint16_t i = slot; i < count; i += stride) {
+		if (values[i] == GLITCH_HIGH || values[i] == GLITCH_LOW) {
+			seen++;
+		}
+	}
+	return seen;
+}
+
+/**
+ * Decimates a signal block by block
+ *
+ * @param signal signal to decimate
+ * @param config mode and points
+ *
+ * @return if the points kept every glitch, or the mode isn't expected to
+ */
+bool benchDecimate(const Signal &signal, const DecConfig &config) {
+	uint8_t stride = acqChannelCount(signal.channels);
+	uint16_t block = (uint16_t)(ACQ_BUFFER_SAMPLES - ACQ_BUFFER_SAMPLES % stride);
+	if (!decBegin(config, signal.channels)) {
+		printf("config refused\n");
+		return false;
+	}
+
+	uint32_t end = signal.count - signal.count % block;
+	uint32_t outSamples = 0UL;
+	uint32_t seen = 0UL;
+	uint32_t naive = 0UL;
+	uint32_t glitches = 0UL;
+
+	const SampleWord *points;
+	uint32_t start = micros();
+	for (uint32_t offset = 0UL; offset < end; offset += block) {
+		outSamples += decReduce(&signal.samples[offset], block, &points);
+	}
+	uint32_t elapsed = (uint32_t)(micros() - start);
+
+	// again untimed, min/max points are pairs per channel
+	uint8_t width = decPointSamples();
+	for (uint32_t offset = 0UL; offset < end; offset += block) {
+		uint16_t length = decReduce(&signal.samples[offset], block, &points);
+		for (uint8_t part = 0U; part < width; part++) {
+			seen += countGlitches(points, length, (uint8_t)(stride * width), (uint8_t)(signal.glitchSlot * width + part));
+		}
+	}
+
+	// every Nth set, for comparison
+	uint16_t sets = (uint16_t)(block / stride);
+	uint16_t step = (uint16_t)(sets / (config.points < sets ? config.points : sets));
+	for (uint32_t offset = 0UL; offset < end; offset += block) {
+		glitches += countGlitches(&signal.samples[offset], block, stride, signal.glitchSlot);
+		for (uint16_t set = 0U; set < sets; set += step) {
+			naive += countGlitches(&signal.samples[offset + set * stride], stride, stride, signal.glitchSlot);
+		}
+	}
+
+	static const char *MODES[DEC_MODES] = {"min/max", "average", "peak"};
+	double linkBytes = (double)outSamples * sizeof(SampleWord) / (end / stride) * Board::adcMaxRate / stride;
+	printf("%-8s %8.1f Msamples/s, glitches kept %5u/%u (every Nth sample %u), %8.0f link bytes/s\n",
+		MODES[config.mode], end / (double)elapsed, seen, glitches, naive, linkBytes);
+
+	return config.mode == DEC_AVERAGE || seen == glitches;
+}
+
+int main(int argc, char **argv) {
+	const char *path = argc > 1 ? argv[1] : "decimate_bench.bin";
+	uint32_t count = argc > 2 ? (uint32_t)atol(argv[2]) : DEFAULT_SAMPLES;
+
+	unlink(path);
+	if (!startNvm(path)) {
+		printf("nvm couldn't be started at %s\n", path);
+		return 1;
+	}
+
+	bool ok = checkRestore(path, storeConfig, checkConfig);
+	printf("%s, %u sample blocks, top ADC rate %u S/s sends %u link bytes/s undecimated\n",
+		Board::name, (unsigned)ACQ_BUFFER_SAMPLES, Board::adcMaxRate,
+		(unsigned)(Board::adcMaxRate * sizeof(SampleWord)));
+	printf("config restored from nvm: %s\n", ok ? "yes" : "no");
+
+	Signal signals[2] = {
+		{"one channel", 0x01U, 0U, NULL, count},
+		{"glitches on the middle of three channels", 0x07U, 1U, NULL, (uint32_t)(count - count % 3UL)}
+	};
+
+	for (uint8_t i = 0U; i < 2U; i++) {
+		Signal &signal = signals[i];
+		signal.samples = (SampleWord*)malloc(signal.count * sizeof(SampleWord));
+		fillSignal(&signal);
+
+		printf("\n== %s\n", signal.name);
+		uint16_t points = (uint16_t)(DEC_MAX_POINTS / acqChannelCount(signal.channels));
+		points = points < DEC_DEFAULT_POINTS ? points : (uint16_t)DEC_DEFAULT_POINTS;
+		for (uint8_t mode = 0U; mode < DEC_MODES; mode++) {
+			DecConfig config = {mode, points};
+			ok &= benchDecimate(signal, config);
+		}
+		free(signal.samples);
+	}
+
+	nvmEnd();
+	debugFlush();
+	unlink(path);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+/*
+	format_bench.cpp - compares number formatting with the String template
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Formats the same 64 bit values with the String based
+ * printInt64 the core used before and with format.h, and
+ * prints the time and heap allocations per number. Both
+ * shift and divide paths of format.h are measured.
+ * The host String keeps short text inline, on boards
+ * every String in the loop is a heap allocation.
+ *
+ * usage: format_bench [numbers]
+ */
+
+#include <Arduino.h>
+#include <chrono>
+#include <new>
+#include <stdlib.h>
+#include "format.h"
+
+uint64_t allocations = 0U;
+
+void *operator new(size_t size) {
+	allocations++;
+	void *memory = malloc(size);
+	if (memory == NULL) {
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void *memory) noexcept {
+	free(memory);
+}
+
+void operator delete(void *memory, size_t size) noexcept {
+	free(memory);
+}
+
+/**
+ * The String based template printInt64 used to be,
+ * returning the text instead of printing it
+ *
+ * @param value integer to format
+ *
+ * @return formatted value
+ */
+template <typename T>
+String legacyFormatInt64(T value) {
+	bool sign = false;
+
+	if (value < 0) {
+		sign = true;
+	}
+
+	if (value == 0) {
+		return String("0");
+	}
+
+	String final = "";
+
+	while (value) {
+		int64_t digit = value % 10;
+		int8_t sdigit = abs(digit);
+		final = (String)sdigit + final;
+		value = (value - digit) / 10;
+	}
+
+	if (sign) {
+		final = String("-") + final;
+	}
+	return final;
+}
+
+/**
+ * Shift and add divide by 10 used on 8 bit targets,
+ * same steps as formatDivMod10() without Board::hardwareDivide
+ */
+uint8_t shiftFormat(char *buffer, uint64_t value) {
+	char digits[20];
+	uint8_t count = 0U;
+
+	do {
+		uint64_t q = (value >> 1) + (value >> 2);
+		q += q >> 4;
+		q += q >> 8;
+		q += q >> 16;
+		q += q >> 32;
+		q >>= 3;
+		uint8_t remainder = (uint8_t)(value - ((q << 3) + (q << 1)));
+		while (remainder > 9U) {
+			q++;
+			remainder -= 10U;
+		}
+		digits[count++] = (char)('0' + remainder);
+		value = q;
+	} while (value);
+
+	for (uint8_t i = 0U; i < count; i++) {
+		buffer[i] = digits[count - 1U - i];
+	}
+	buffer[count] = '\0';
+	return count;
+}
+
+uint64_t nowNanos(void) {
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void printResult(const char *name, uint64_t nanos, uint64_t allocs, uint32_t numbers, uint64_t checksum) {
+	printf("%-28s %8.1f ns/number %8.2f allocations/number (checksum %llu)\n",
+		name, (double)nanos / numbers, (double)allocs / numbers, (unsigned long long)checksum);
+}
+
+int main(int argc, char **argv) {
+	uint32_t numbers = argc > 1 ? (uint32_t)atol(argv[1]) : 200000U;
+	int64_t *values = (int64_t*)malloc(numbers * sizeof(int64_t));
+
+	// mix of small counters and full width values like timestamps
+	uint64_t seed = 0x9E3779B97F4A7C15ULL;
+	for (uint32_t i = 0U; i < numbers; i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+		values[i] = (int64_t)(seed >> (seed % 64U));
+		if (i & 1U) {
+			values[i] = (int64_t)(0U - (uint64_t)values[i]);
+		}
+	}
+
+	uint64_t checksum = 0U;
+	uint64_t allocs = allocations;
+	uint64_t start = nowNanos();
+	for (uint32_t i = 0U; i < numbers; i++) {
+		String text = legacyFormatInt64(values[i]);
+		checksum += text.length();
+	}
+	printResult("String template", nowNanos() - start, allocations - allocs, numbers, checksum);
+
+	char buffer[FORMAT_BUFFER_SIZE];
+
+	checksum = 0U;
+	allocs = allocations;
+	start = nowNanos();
+	for (uint32_t i = 0U; i < numbers; i++) {
+		checksum += formatSigned(buffer, values[i], DEC);
+	}
+	printResult("formatSigned", nowNanos() - start, allocations - allocs, numbers, checksum);
+
+	checksum = 0U;
+	allocs = allocations;
+	start = nowNanos();
+	for (uint32_t i = 0U; i < numbers; i++) {
+		uint64_t magnitude = values[i] < 0 ? 0U - (uint64_t)values[i] : (uint64_t)values[i];
+		checksum += shiftFormat(buffer, magnitude);
+		checksum += values[i] < 0 ? 1U : 0U;
+	}
+	printResult("shift divide (8 bit path)", nowNanos() - start, allocations - allocs, numbers, checksum);
+
+	checksum = 0U;
+	allocs = allocations;
+	start = nowNanos();
+	for (uint32_t i = 0U; i < numbers; i++) {
+		checksum += formatFloat(buffer, (double)(values[i] % 1000000) / 1000.0, 3U);
+	}
+	printResult("formatFloat 3 decimals", nowNanos() - start, allocations - allocs, numbers, checksum);
+
+	free(values);
+	return 0;
+}
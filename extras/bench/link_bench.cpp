@@ -0,0 +1,348 @@
+/*
+	link_bench.cpp - link frame loopback throughput and recovery
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Sends acquisition sized blocks as raw and as coded
+ * frames from one thread through a byte ring to a parser
+ * on another, checking every frame arrives whole and in
+ * sequence. Prints MB/s, frames per second and the
+ * samples per second a 115200 baud link carries after
+ * framing. Then flips bits in a stream of frames mixed
+ * with log frames and checks the parser recovers without
+ * accepting a frame it shouldn't.
+ *
+ * usage: link_bench [frames]
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdlib.h>
+#include <thread>
+#include "sample_ring.h"
+#include "acquisition/acquisition.h"
+#include "codec/codec.h"
+#include "link/link_frame.h"
+#include "nvm/generic_nvm.h"
+
+#define DEFAULT_FRAMES 50000UL
+#define CORRUPT_FRAMES 20000UL
+#define LINK_BYTES_PER_SECOND (115200UL / 10UL)
+#define FULL_SCALE ((1UL << Board::adcBits) - 1UL)
+#define CHANNELS 0x03U
+
+// bytes in flight between the threads
+typedef SampleRing<uint8_t, 1UL << 20> ByteRing;
+
+ByteRing byteRing;
+LinkParser parser;
+bool coded = false;
+
+// bytes of frames in a stream for the corruption test
+uint8_t *stream = NULL;
+uint32_t streamSize = 0UL;
+uint32_t streamCapacity = 0UL;
+
+// one period of a sine the blocks are cut from
+#define WAVE_SIZE 4096U
+SampleWord wave[WAVE_SIZE];
+
+/**
+ * Gets the sample a frame holds at a place, so the
+ * receiver can check it from the sequence alone
+ *
+ * @param sequence frame sequence
+ * @param index place in the frame
+ *
+ * @return sample
+ */
+inline SampleWord expectedSample(uint16_t sequence, uint16_t index) {
+	uint32_t phase = (uint32_t)sequence * 37UL + (uint32_t)(index >> 1) * ((index & 1U) + 1U);
+	return wave[phase & (WAVE_SIZE - 1U)];
+}
+
+/**
+ * Fills a block for a frame
+ *
+ * @param samples block to fill
+ * @param count samples in the block
+ * @param sequence frame sequence
+ */
+void fillBlock(SampleWord *samples, uint16_t count, uint16_t sequence) {
+	for (uint16_t i = 0U; i < count; i++) {
+		samples[i] = expectedSample(sequence, i);
+	}
+}
+
+/**
+ * Sink into the ring between the threads, waits for room
+ * like a blocking transport would
+ */
+bool ringSink(const LinkSpan *spans, uint8_t count) {
+	uint32_t size = 0UL;
+	for (uint8_t i = 0U; i < count; i++) {
+		size += spans[i].size;
+	}
+	while (byteRing.available() < size) {
+		std::this_thread::yield();
+	}
+	for (uint8_t i = 0U; i < count; i++) {
+		byteRing.pushN(spans[i].data, spans[i].size);
+	}
+	return true;
+}
+
+/**
+ * Sink appending to the corruption test stream
+ */
+bool streamSink(const LinkSpan *spans, uint8_t count) {
+	for (uint8_t i = 0U; i < count; i++) {
+		if (streamSize + spans[i].size > streamCapacity) {
+			return false;
+		}
+		memcpy(&stream[streamSize], spans[i].data, spans[i].size);
+		streamSize += spans[i].size;
+	}
+	return true;
+}
+
+/**
+ * Checks a received frame holds what was sent
+ *
+ * @param frame frame from linkParse()
+ * @param block samples in a block
+ *
+ * @return if the samples match their sequence
+ */
+bool checkFrame(const LinkFrame &frame, uint16_t block) {
+	static uint16_t decoded[ACQ_BUFFER_SAMPLES];
+	const uint8_t *bytes = frame.payload;
+	uint16_t count = (uint16_t)(frame.length / sizeof(SampleWord));
+
+	if (frame.kind == (LINK_BLOCK | LINK_CODED)) {
+		count = codecDecode(frame.payload, frame.length, decoded, ACQ_BUFFER_SAMPLES);
+		bytes = (const uint8_t*)decoded;
+	}
+	else if (frame.kind != LINK_BLOCK) {
+		return false;
+	}
+	if (count != block || frame.channels != CHANNELS || frame.bits != Board::adcBits) {
+		return false;
+	}
+	for (uint16_t i = 0U; i < count; i++) {
+		uint16_t sample = (uint16_t)(bytes[2U * i] | (bytes[2U * i + 1U] << 8));
+		if (sample != expectedSample(frame.sequence, i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Sends frames from the calling thread
+ *
+ * @param frames frames to send
+ * @param block samples in a block
+ */
+void produce(uint32_t frames, uint16_t block) {
+	static SampleWord samples[ACQ_BUFFER_SAMPLES];
+	static uint8_t encoded[CODEC_MAX_BYTES(ACQ_BUFFER_SAMPLES)];
+
+	linkBegin(ringSink);
+	for (uint32_t i = 0UL; i < frames; i++) {
+		fillBlock(samples, block, (uint16_t)i);
+		if (coded) {
+			uint16_t length = codecEncode(samples, block, acqChannelCount(CHANNELS), encoded, sizeof(encoded));
+			linkSendFrame(LINK_BLOCK | LINK_CODED, CHANNELS, encoded, length);
+		}
+		else {
+			linkSendSamples(samples, block, CHANNELS);
+		}
+	}
+}
+
+/**
+ * Streams frames between two threads
+ *
+ * @param frames frames to send
+ *
+ * @return if every frame came through
+ */
+bool benchLoopback(uint32_t frames) {
+	uint16_t block = (uint16_t)(ACQ_BUFFER_SAMPLES - ACQ_BUFFER_SAMPLES % acqChannelCount(CHANNELS));
+	byteRing.reset();
+	linkParserReset(&parser);
+
+	uint32_t start = micros();
+	std::thread producer(produce, frames, block);
+
+	uint64_t bytes = 0U;
+	uint32_t wrong = 0UL;
+	uint32_t checked = 0UL;
+	uint32_t checkMicros = 0UL;
+	while (parser.frames < frames) {
+		const uint8_t *span;
+		uint32_t ready = byteRing.peekContiguous(&span);
+		if (ready == 0UL) {
+			std::this_thread::yield();
+			continue;
+		}
+		uint16_t size = (uint16_t)(ready < 0xFFFFUL ? ready : 0xFFFFUL);
+		uint16_t used;
+		LinkFrame frame;
+		bool whole = linkParse(&parser, span, size, &used, &frame);
+		byteRing.consume(used);
+		bytes += used;
+
+		// every 64th frame is checked, checking them all would dominate
+		if (whole && (frame.sequence & 63U) == 0U) {
+			uint32_t checkStart = micros();
+			wrong += checkFrame(frame, block) ? 0UL : 1UL;
+			checked++;
+			checkMicros += (uint32_t)(micros() - checkStart);
+		}
+	}
+	producer.join();
+	uint32_t elapsed = (uint32_t)(micros() - start) - checkMicros;
+
+	double perFrame = (double)bytes / frames;
+	double samplesPerSecond = LINK_BYTES_PER_SECOND / perFrame * block;
+	printf("%-6s %7.1f bytes/frame, %8.1f MB/s, %8.0f frames/s, %6.0f S/s at 115200 baud, checked %u lost %u bad %u%s\n",
+		coded ? "coded" : "raw", perFrame, bytes / (double)elapsed, frames * 1e6 / elapsed, samplesPerSecond,
+		(unsigned)checked, (unsigned)parser.lost, (unsigned)parser.corrupt, wrong == 0UL ? "" : "  FRAMES WRONG");
+
+	return wrong == 0UL && parser.lost == 0UL && parser.corrupt == 0UL && parser.skipped == 0UL;
+}
+
+/**
+ * Flips bits in a stream of frames and log frames, then
+ * parses it in random sized pieces
+ *
+ * @return if no bad frame was accepted
+ */
+bool benchCorruption(void) {
+	const uint16_t block = 64U;
+	SampleWord samples[block];
+	streamCapacity = CORRUPT_FRAMES * (LINK_HEADER_SIZE + block * sizeof(SampleWord) + LINK_CRC_SIZE + 16UL);
+	stream = (uint8_t*)malloc(streamCapacity);
+	streamSize = 0UL;
+
+	uint32_t seed = 2463534242UL;
+	linkBegin(streamSink);
+	for (uint32_t i = 0UL; i < CORRUPT_FRAMES; i++) {
+		fillBlock(samples, block, (uint16_t)i);
+		linkSendSamples(samples, block, CHANNELS);
+
+		// a log frame between some, sync and all
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		if ((seed & 7UL) == 0UL) {
+			uint8_t junk[12] = {0xA5U, LINK_SYNC, 0x07U, 0x00U, LINK_SYNC, 0x40U, 0U, 0U, LINK_SYNC, 0x01U, 0x02U, 0x03U};
+			LinkSpan span = {junk, (uint16_t)sizeof(junk)};
+			streamSink(&span, 1U);
+		}
+	}
+
+	// one flipped bit per 4 frames or so
+	uint32_t flips = CORRUPT_FRAMES / 4UL;
+	for (uint32_t i = 0UL; i < flips; i++) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		stream[seed % streamSize] ^= (uint8_t)(1U << (seed >> 29));
+	}
+
+	linkParserReset(&parser);
+	uint32_t accepted = 0UL;
+	uint32_t falseAccepts = 0UL;
+	for (uint32_t offset = 0UL; offset < streamSize;) {
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		uint16_t size = (uint16_t)(1UL + seed % 700UL);
+		size = offset + size < streamSize ? size : (uint16_t)(streamSize - offset);
+
+		uint16_t used;
+		LinkFrame frame;
+		while (linkParse(&parser, &stream[offset], size, &used, &frame)) {
+			accepted++;
+			falseAccepts += checkFrame(frame, block) ? 0UL : 1UL;
+			offset += used;
+			size = (uint16_t)(size - used);
+		}
+		offset += used;
+	}
+
+	printf("%u bit flips over %u frames: %u frames kept, %u lost, %u CRC failures, %u bytes skipped, %u false accepts\n",
+		(unsigned)flips, (unsigned)CORRUPT_FRAMES, (unsigned)accepted, (unsigned)parser.lost,
+		(unsigned)parser.corrupt, (unsigned)parser.skipped, (unsigned)falseAccepts);
+
+	free(stream);
+
+	// a frame only goes missing with a flip in it
+	return falseAccepts == 0UL && accepted + flips >= CORRUPT_FRAMES;
+}
+
+/**
+ * Checks nvmCrc16() against the CRC-16 CCITT a bit at a time
+ *
+ * @return if they match
+ */
+bool checkCrc(void) {
+	uint8_t data[257];
+	for (uint16_t i = 0U; i < sizeof(data); i++) {
+		data[i] = (uint8_t)(i * 97U + 13U);
+	}
+	for (uint16_t size = 0U; size <= sizeof(data); size++) {
+		uint16_t crc = 0xFFFFU;
+		for (uint16_t i = 0U; i < size; i++) {
+			crc ^= (uint16_t)(data[i] << 8);
+			for (uint8_t bit = 0U; bit < 8U; bit++) {
+				crc = (uint16_t)(crc & 0x8000U ? (crc << 1) ^ 0x1021U : crc << 1);
+			}
+		}
+		if (nvmCrc16(0xFFFFU, data, size) != crc) {
+			return false;
+		}
+	}
+	// the standard check value of "123456789"
+	return nvmCrc16(0xFFFFU, (const uint8_t*)"123456789", 9U) == 0x29B1U;
+}
+
+int main(int argc, char **argv) {
+	uint32_t frames = argc > 1 ? (uint32_t)atol(argv[1]) : DEFAULT_FRAMES;
+
+	for (uint16_t i = 0U; i < WAVE_SIZE; i++) {
+		wave[i] = (SampleWord)((0.5f + 0.4f * sinf(i * 6.2831853f / WAVE_SIZE)) * FULL_SCALE + 0.5f);
+	}
+
+	bool ok = checkCrc();
+	printf("%s, %u sample blocks, %u header and %u CRC bytes a frame, 115200 baud carries %lu S/s unframed\n",
+		Board::name, (unsigned)ACQ_BUFFER_SAMPLES, (unsigned)LINK_HEADER_SIZE, (unsigned)LINK_CRC_SIZE,
+		(unsigned long)(LINK_BYTES_PER_SECOND / sizeof(SampleWord)));
+	printf("CRC-16 matches bitwise: %s\n", ok ? "yes" : "no");
+
+	coded = false;
+	ok &= benchLoopback(frames);
+	coded = true;
+	ok &= benchLoopback(frames);
+	ok &= benchCorruption();
+
+	debugFlush();
+	return ok ? 0 : 1;
+}
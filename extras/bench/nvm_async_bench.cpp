@@ -0,0 +1,143 @@
+/*
+	nvm_async_bench.cpp - compares inline and async nvm commits
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Writes bursts of settings like a sketch reacting to user
+ * input, once flushing every write inline and once through
+ * the async queue, and prints how long the calling loop was
+ * held up plus how many commits reached the device.
+ *
+ * usage: nvm_async_bench [nvm file] [bursts]
+ */
+
+#include <Arduino.h>
+#include <unistd.h>
+#include "nvm/generic_nvm.h"
+#include "nvm/core_file.h"
+
+#define REGION_SIZE 1024U
+#define BURST_WRITES 50U
+
+struct BurstResult {
+	uint32_t maxMicros;
+	uint64_t totalMicros;
+	uint32_t writes;
+};
+
+/**
+ * Writes one burst of changing values
+ *
+ * @param burst index of the burst
+ * @param flush if every write is flushed inline
+ * @param result timings to add the burst to
+ */
+void writeBurst(uint32_t burst, bool flush, BurstResult *result) {
+	for (uint32_t i = 0U; i < BURST_WRITES; i++) {
+		uint32_t start = micros();
+		nvmWriteValue((uint16_t)(16U + (i & 7U) * 4U), burst * BURST_WRITES + i);
+		if (flush) {
+			nvmFlush();
+		}
+		uint32_t elapsed = micros() - start;
+
+		if (elapsed > result->maxMicros) {
+			result->maxMicros = elapsed;
+		}
+		result->totalMicros += elapsed;
+		result->writes++;
+
+		// debug output goes out between writes, not inside them
+		debugPoll();
+	}
+}
+
+void printResult(const char *name, const BurstResult &result) {
+	const NVMFileStats &device = EEPROM.stats();
+
+	debugFlush();
+	printf("\n== %s\n", name);
+	printf("write call us avg/max: %.2f/%u\n",
+		(double)result.totalMicros / result.writes, result.maxMicros);
+	printf("device: commits %u, page erases %u, bytes programmed %u\n",
+		device.commits, device.pageErases, device.bytesProgrammed);
+}
+
+/**
+ * Checks the last burst was persisted
+ *
+ * @param bursts number of bursts written
+ *
+ * @return if every key holds its last value
+ */
+bool checkValues(uint32_t bursts) {
+	for (uint32_t i = BURST_WRITES - 8U; i < BURST_WRITES; i++) {
+		uint32_t value = 0U;
+		nvmGetValue((uint16_t)(16U + (i & 7U) * 4U), &value);
+		if (value != (bursts - 1U) * BURST_WRITES + i) {
+			return false;
+		}
+	}
+	return true;
+}
+
+int main(int argc, char **argv) {
+	const char *path = argc > 1 ? argv[1] : "nvm_async_bench.bin";
+	uint32_t bursts = argc > 2 ? (uint32_t)atol(argv[2]) : 20U;
+
+	unlink(path);
+	EEPROM.setPath(path);
+	if (nvmInit(REGION_SIZE) != NVM_OK) {
+		printf("nvm couldn't be started at %s\n", path);
+		return 1;
+	}
+
+	BurstResult inlineResult = {0U, 0U, 0U};
+	EEPROM.resetStats();
+	for (uint32_t burst = 0U; burst < bursts; burst++) {
+		writeBurst(burst, true, &inlineResult);
+	}
+	printResult("inline, flush every write", inlineResult);
+	printf("values persisted: %s\n", checkValues(bursts) ? "yes" : "no");
+
+	#ifdef NVM_ASYNC
+		BurstResult asyncResult = {0U, 0U, 0U};
+		EEPROM.resetStats();
+		nvmStartAsync(20U);
+		for (uint32_t burst = 0U; burst < bursts; burst++) {
+			writeBurst(burst, false, &asyncResult);
+			// idle time between bursts lets the worker commit
+			delay(40U);
+		}
+
+		uint32_t start = micros();
+		bool synced = nvmSync();
+		uint32_t syncMicros = micros() - start;
+		nvmStopAsync();
+
+		printResult("async, 20 ms quiet window", asyncResult);
+		printf("final nvmSync() %s after %u us\n", synced ? "committed" : "failed", syncMicros);
+		printf("values persisted: %s\n", checkValues(bursts) ? "yes" : "no");
+	#else
+		printf("\nbuild with -DNVM_ASYNC=ON to compare async commits\n");
+	#endif
+
+	nvmEnd();
+	debugFlush();
+	unlink(path);
+	return 0;
+}
@@ -0,0 +1,145 @@
+/*
+	nvm_power_loss.cpp - sweeps power cuts across an nvm update
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Writes an old set of values, then replays a batched update
+ * once per programmed byte with the power cut at that byte.
+ * After each cut nvm is restarted and the values are checked
+ * to be wholly old, wholly new or torn. Fails if any cut
+ * left them torn.
+ *
+ * usage: nvm_power_loss [nvm file]
+ */
+
+#include <Arduino.h>
+#include <unistd.h>
+#include "nvm/generic_nvm.h"
+#include "nvm/core_file.h"
+
+#define REGION_SIZE 512U
+
+struct Settings {
+	uint8_t mode;
+	uint16_t rate;
+	uint32_t channels;
+	float level;
+};
+
+enum Outcome {
+	OUTCOME_OLD,
+	OUTCOME_NEW,
+	OUTCOME_TORN
+};
+
+const Settings OLD_SETTINGS = {1U, 1000U, 0x0000000FUL, 1.5f};
+const Settings NEW_SETTINGS = {2U, 48000U, 0x000000F0UL, -0.25f};
+
+bool writeSettings(const Settings &settings) {
+	return nvmBeginBatch() &&
+		nvmWriteValue(16U, settings.mode) &&
+		nvmWriteValue(18U, settings.rate) &&
+		nvmWriteValue(20U, settings.channels) &&
+		nvmWriteValue(24U, settings.level) &&
+		nvmCommitBatch();
+}
+
+bool readSettings(Settings *settings) {
+	return nvmGetValue(16U, &settings->mode) &&
+		nvmGetValue(18U, &settings->rate) &&
+		nvmGetValue(20U, &settings->channels) &&
+		nvmGetValue(24U, &settings->level);
+}
+
+bool sameSettings(const Settings &left, const Settings &right) {
+	return left.mode == right.mode && left.rate == right.rate &&
+		left.channels == right.channels && left.level == right.level;
+}
+
+/**
+ * Starts from an erased file holding only the old settings
+ */
+bool formatOld(const char *path) {
+	nvmEnd();
+	unlink(path);
+	return nvmInit(REGION_SIZE) == NVM_OK && writeSettings(OLD_SETTINGS);
+}
+
+enum Outcome restartAndCheck(void) {
+	Settings settings;
+	nvmEnd();
+
+	if (nvmInit(REGION_SIZE) != NVM_OK || !readSettings(&settings)) {
+		return OUTCOME_TORN;
+	}
+	if (sameSettings(settings, OLD_SETTINGS)) {
+		return OUTCOME_OLD;
+	}
+	if (sameSettings(settings, NEW_SETTINGS)) {
+		return OUTCOME_NEW;
+	}
+	return OUTCOME_TORN;
+}
+
+int main(int argc, char **argv) {
+	const char *path = argc > 1 ? argv[1] : "nvm_power_loss.bin";
+	EEPROM.setPath(path);
+
+	// measures the update without a cut
+	if (!formatOld(path)) {
+		printf("nvm couldn't be formatted at %s\n", path);
+		return 1;
+	}
+	EEPROM.resetStats();
+	writeSettings(NEW_SETTINGS);
+	NVMFileStats update = EEPROM.stats();
+
+	debugFlush();
+	printf("update: commits %u, page erases %u, bytes programmed %u, modelled busy %.3f ms\n",
+		update.commits, update.pageErases, update.bytesProgrammed,
+		(double)update.busyMicros / 1000.0);
+
+	uint32_t counts[3] = {0U, 0U, 0U};
+	uint32_t firstTorn = 0U;
+
+	for (uint32_t cut = 0U; cut < update.bytesProgrammed; cut++) {
+		formatOld(path);
+		EEPROM.setPowerLoss(cut);
+		writeSettings(NEW_SETTINGS);
+		EEPROM.clearPowerLoss();
+
+		enum Outcome outcome = restartAndCheck();
+		if (outcome == OUTCOME_TORN && counts[OUTCOME_TORN] == 0U) {
+			firstTorn = cut;
+		}
+		counts[outcome]++;
+		debugPoll();
+	}
+
+	debugFlush();
+
+	printf("cuts: %u, old %u, new %u, torn %u\n",
+		update.bytesProgrammed, counts[OUTCOME_OLD], counts[OUTCOME_NEW], counts[OUTCOME_TORN]);
+	if (counts[OUTCOME_TORN] != 0U) {
+		printf("first torn cut after %u bytes\n", firstTorn);
+	}
+
+	nvmEnd();
+	debugFlush();
+	unlink(path);
+	return counts[OUTCOME_TORN] == 0U ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+/*
+	nvm_stats_bench.cpp - drives the nvm api and prints its stats
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Runs a few persistence patterns a sketch could use and
+ * prints nvmGetStats() plus the file device counters after
+ * each, so flush frequency can be picked from data.
+ *
+ * usage: nvm_stats_bench [nvm file] [iterations]
+ */
+
+#include <Arduino.h>
+#include <unistd.h>
+#include "nvm/generic_nvm.h"
+#include "nvm/nvm_stats.h"
+#include "nvm/core_file.h"
+
+#define REGION_SIZE 1024U
+
+void printPattern(const char *name, uint32_t iterations) {
+	const NVMFileStats &device = EEPROM.stats();
+
+	debugFlush();
+	printf("\n== %s (%u iterations)\n", name, iterations);
+	nvmPrintStats();
+	printf("device: commits %u, page erases %u, bytes programmed %u, modelled busy %.3f ms\n",
+		device.commits, device.pageErases, device.bytesProgrammed,
+		(double)device.busyMicros / 1000.0);
+}
+
+void startPattern(void) {
+	nvmResetStats();
+	EEPROM.resetStats();
+}
+
+int main(int argc, char **argv) {
+	const char *path = argc > 1 ? argv[1] : "nvm_stats_bench.bin";
+	uint32_t iterations = argc > 2 ? (uint32_t)atol(argv[2]) : 1000U;
+
+	unlink(path);
+	EEPROM.setPath(path);
+	if (nvmInit(REGION_SIZE) != NVM_OK) {
+		printf("nvm couldn't be started at %s\n", path);
+		return 1;
+	}
+
+	// same value written every loop
+	startPattern();
+	for (uint32_t i = 0U; i < iterations; i++) {
+		nvmWriteValue(8U, (uint16_t)1234U);
+		nvmFlush();
+		debugPoll();
+	}
+	printPattern("unchanged value, flush every write", iterations);
+
+	// changing sample counter persisted every loop
+	startPattern();
+	for (uint32_t i = 0U; i < iterations; i++) {
+		nvmWriteValue(16U, i);
+		nvmFlush();
+		debugPoll();
+	}
+	printPattern("changing value, flush every write", iterations);
+
+	// same counter with a flush every 100 loops
+	startPattern();
+	for (uint32_t i = 0U; i < iterations; i++) {
+		nvmWriteValue(16U, i);
+		if (i % 100U == 99U) {
+			nvmFlush();
+		}
+		debugPoll();
+	}
+	nvmFlush();
+	printPattern("changing value, flush every 100 writes", iterations);
+
+	// settings group saved together
+	startPattern();
+	for (uint32_t i = 0U; i < iterations; i++) {
+		nvmBeginBatch();
+		nvmWriteValue(32U, (uint8_t)(i & 3U));
+		nvmWriteValue(34U, (uint16_t)(1000U + i));
+		nvmWriteValue(36U, (float)i * 0.5f);
+		nvmWriteValue(40U, (double)i * 0.25);
+		nvmCommitBatch();
+		debugPoll();
+	}
+	printPattern("4 value batch", iterations);
+
+	// reads of every type
+	startPattern();
+	for (uint32_t i = 0U; i < iterations; i++) {
+		uint8_t mode;
+		uint16_t rate;
+		float level;
+		double offset;
+		nvmGetValue(32U, &mode);
+		nvmGetValue(34U, &rate);
+		nvmGetValue(36U, &level);
+		nvmGetValue(40U, &offset);
+		debugPoll();
+	}
+	printPattern("4 value reads", iterations);
+
+	nvmEnd();
+	debugFlush();
+	unlink(path);
+	return 0;
+}
@@ -0,0 +1,114 @@
+/*
+	nvm_trace_bench.cpp - traces a sampling loop that persists settings
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Runs a loop shaped like the scope firmware: take a
+ * block of samples, process it, and now and then save a
+ * setting and flush. Built with -DDEBUG_TRACE=ON every
+ * scope and nvm entry point is traced and the buffer is
+ * dumped to stdout at the end:
+ *
+ * nvm_trace_bench > trace.bin
+ * log_tokens.py dict src -o tokens.json
+ * trace_to_chrome.py tokens.json trace.bin -o trace.json
+ *
+ * usage: nvm_trace_bench [nvm file] [loops]
+ */
+
+#include <Arduino.h>
+#include <unistd.h>
+#include "nvm/generic_nvm.h"
+#include "nvm/core_file.h"
+#include "trace.h"
+
+#define REGION_SIZE 1024U
+#define SAMPLES 256U
+
+uint16_t samples[SAMPLES];
+
+/**
+ * Fills the sample block with a synthetic waveform
+ *
+ * @param loop index of the loop
+ */
+void takeSamples(uint32_t loop) {
+	TRACE_SCOPE("takeSamples");
+
+	uint32_t seed = loop * 2654435761UL;
+	for (uint16_t i = 0U; i < SAMPLES; i++) {
+		seed = seed * 1103515245UL + 12345UL;
+		samples[i] = (uint16_t)((i * 16U + (seed >> 24)) & 0x0FFFU);
+	}
+}
+
+/**
+ * Finds the peak to peak level of the block
+ *
+ * @return peak to peak of the samples
+ */
+uint16_t processSamples(void) {
+	TRACE_SCOPE("processSamples");
+
+	uint16_t low = 0xFFFFU;
+	uint16_t high = 0U;
+	for (uint16_t i = 0U; i < SAMPLES; i++) {
+		low = samples[i] < low ? samples[i] : low;
+		high = samples[i] > high ? samples[i] : high;
+	}
+	return high - low;
+}
+
+int main(int argc, char **argv) {
+	const char *path = argc > 1 ? argv[1] : "nvm_trace_bench.bin";
+	uint32_t loops = argc > 2 ? (uint32_t)atol(argv[2]) : 500U;
+
+	unlink(path);
+	EEPROM.setPath(path);
+	if (nvmInit(REGION_SIZE) != NVM_OK) {
+		fprintf(stderr, "nvm couldn't be started at %s\n", path);
+		return 1;
+	}
+
+	uint32_t level = 0U;
+	for (uint32_t loop = 0U; loop < loops; loop++) {
+		TRACE_SCOPE("loop");
+
+		takeSamples(loop);
+		level += processSamples();
+
+		// trigger level changed by the user every 10 loops
+		if (loop % 10U == 9U) {
+			nvmWriteValue(16U, (uint16_t)(level / 10U));
+			level = 0U;
+		}
+		if (loop % 50U == 49U) {
+			nvmFlush();
+		}
+		debugPoll();
+	}
+
+	#ifdef DEBUG_TRACE
+		traceDump();
+	#else
+		fprintf(stderr, "build with -DDEBUG_TRACE=ON to record a trace\n");
+	#endif
+
+	nvmEnd();
+	unlink(path);
+	return 0;
+}
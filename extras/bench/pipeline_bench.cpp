@@ -0,0 +1,238 @@
+/*
+	pipeline_bench.cpp - pipeline stage times with one and two cores
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Runs the synthetic source at the board's top rate
+ * through the pipeline into the loopback transport, with
+ * the process stage in the loop and on its own thread,
+ * streaming raw, coded and decimated blocks and trigger
+ * frames. Every frame is parsed back and checked against
+ * the kind the config sends. For each prints the blocks
+ * passed on and dropped, the time each stage took a
+ * block, and the samples per second the stages could
+ * keep up with, their sum with one core and the slower
+ * of the two with two, against the same config on one
+ * core.
+ *
+ * Copying a block on the host costs a fraction of what
+ * the process stage does, unlike a board unpacking its
+ * ADC results, so two cores gain little. Each config is
+ * run again with the acquire stage given busy work
+ * matching the process stage measured on one core, the
+ * balanced case two cores should about double.
+ *
+ * usage: pipeline_bench [nvm file] [seconds per run]
+ */
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include "bench_nvm.h"
+#include "acquisition/acquisition.h"
+#include "trigger/trigger.h"
+#include "decimation/decimation.h"
+#include "codec/codec.h"
+#include "transport/transport.h"
+#include "transport/transport_host.h"
+#include "pipeline/pipeline.h"
+
+#define DRAIN_MICROS 200000UL
+#define BENCH_CHANNELS 0x03U
+
+struct Run {
+	const char *name;
+	PipeConfig config;
+	uint8_t kind; // link kind every frame should have
+	double work; // busy microseconds added to the acquire stage a block
+};
+
+LinkParser parser;
+double single = 1.0; // samples per second the last run on one core kept up with
+double singleProcess = 0.0; // process stage microseconds a block of that run
+double singleAcquire = 0.0; // acquire stage microseconds a block of that run
+uint32_t received = 0UL;
+uint32_t wrong = 0UL;
+
+/**
+ * Reads what the loopback holds and checks each frame
+ *
+ * @param kind link kind every frame should have
+ */
+void receive(uint8_t kind) {
+	static uint8_t data[32768];
+	uint16_t size = transportHostRead(data, sizeof(data));
+	const uint8_t *next = data;
+	uint16_t used;
+	LinkFrame frame;
+	while (linkParse(&parser, next, size, &used, &frame)) {
+		uint16_t count;
+		uint8_t channels;
+		bool same = frame.kind == kind && frame.channels == BENCH_CHANNELS;
+		if (kind & LINK_CODED) {
+			same &= codecPeek(frame.payload, frame.length, &count, &channels);
+		}
+		wrong += same ? 0UL : 1UL;
+		received++;
+		next += used;
+		size = (uint16_t)(size - used);
+	}
+}
+
+/**
+ * Keeps the loop busy like a costlier acquire stage
+ *
+ * @param micros time to spin for
+ */
+void busyWork(double micros) {
+	std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() +
+		std::chrono::nanoseconds((int64_t)(micros * 1000.0));
+	while (std::chrono::steady_clock::now() < end) {}
+}
+
+/**
+ * Runs one config for a while
+ *
+ * @param run config and the kind it sends
+ * @param duration microseconds to acquire for
+ *
+ * @return if every frame sent arrived as expected
+ */
+bool benchRun(const Run &run, uint32_t duration) {
+	AcqConfig acq = {Board::adcMaxRate / acqChannelCount(BENCH_CHANNELS), BENCH_CHANNELS};
+	TransportConfig loopback = {TRANSPORT_LOOPBACK, 0UL, 0UL, 0U, "", ""};
+	linkParserReset(&parser);
+	received = 0UL;
+	wrong = 0UL;
+
+	if (!transportBegin(loopback) || acqStart(acq) != ACQ_OK || !pipelineBegin(run.config)) {
+		printf("%-38s couldn't start\n", run.name);
+		acqEnd();
+		transportEnd();
+		return false;
+	}
+
+	uint32_t start = micros();
+	while ((uint32_t)(micros() - start) < duration) {
+		if (!pipelinePoll()) {
+			std::this_thread::yield();
+		}
+		else if (run.work > 0.0) {
+			busyWork(run.work);
+		}
+		receive(run.kind);
+	}
+	acqEnd();
+
+	// lets the process stage finish the blocks handed off
+	uint32_t drainStart = micros();
+	while ((uint32_t)(micros() - drainStart) < DRAIN_MICROS) {
+		pipelinePoll();
+		receive(run.kind);
+	}
+	pipelineEnd();
+	drainStart = micros();
+	while (transportPending() != 0UL && (uint32_t)(micros() - drainStart) < DRAIN_MICROS) {
+		transportPoll();
+		receive(run.kind);
+	}
+	receive(run.kind);
+
+	PipeStats stats;
+	pipelineGetStats(&stats);
+	uint32_t blocks = stats.blocks != 0UL ? stats.blocks : 1UL;
+	double acquire = (double)stats.acquireMicros / blocks + run.work;
+	double process = (double)stats.processMicros / blocks;
+
+	// samples a block stands for, a buffer or a trigger frame
+	double samples = run.config.source == PIPE_STREAM ? (double)ACQ_BUFFER_SAMPLES : (double)Board::adcMaxRate * duration / 1e6 / blocks;
+	double slower = acquire > process ? acquire : process;
+	double sustained = samples * 1e6 / (run.config.cores == 2U ? slower : acquire + process);
+	if (run.config.cores == 1U) {
+		single = sustained;
+		singleAcquire = acquire;
+		singleProcess = process;
+	}
+
+	printf("%-38s %u core%s %5u blocks %3u dropped, acquire %7.2f us process %7.2f us a block, "
+		"keeps up with %8.2f MS/s (%.2fx one core), lost %u bad %u\n",
+		run.name, run.config.cores, run.config.cores == 2U ? "s" : " ",
+		(unsigned)stats.blocks, (unsigned)stats.dropped, acquire, process,
+		sustained / 1e6, sustained / single,
+		(unsigned)(stats.frames - received), (unsigned)(wrong + parser.corrupt));
+
+	transportEnd();
+	return wrong == 0UL && parser.corrupt == 0UL && received == stats.frames && stats.refused == 0UL;
+}
+
+int main(int argc, char **argv) {
+	const char *path = argc > 1 ? argv[1] : "pipeline_bench.bin";
+	uint32_t duration = (uint32_t)((argc > 2 ? atof(argv[2]) : 1.0) * 1e6);
+
+	unlink(path);
+	if (!startNvm(path)) {
+		printf("nvm couldn't be started at %s\n", path);
+		return 1;
+	}
+
+	TrigConfig trigger = {TRIG_RISING, 0U, 2048U, 64U, 200U, 800U, 0UL, 0UL, 0UL};
+	DecConfig decimate = {DEC_MINMAX, DEC_DEFAULT_POINTS};
+	if (!trigBegin(trigger, BENCH_CHANNELS) || !decBegin(decimate, BENCH_CHANNELS)) {
+		printf("trigger or decimation couldn't be started\n");
+		return 1;
+	}
+
+	printf("%s, %u S/s on %u channels, %u sample buffers, %u blocks between the stages\n",
+		Board::name, (unsigned)Board::adcMaxRate, (unsigned)acqChannelCount(BENCH_CHANNELS),
+		(unsigned)ACQ_BUFFER_SAMPLES, (unsigned)PIPE_BLOCKS);
+
+	Run runs[4] = {
+		{"raw buffers", {PIPE_STREAM, false, false, 1U}, LINK_BLOCK, 0.0},
+		{"coded buffers", {PIPE_STREAM, false, true, 1U}, LINK_BLOCK | LINK_CODED, 0.0},
+		{"coded min/max points", {PIPE_STREAM, true, true, 1U}, LINK_MINMAX | LINK_CODED, 0.0},
+		{"trigger frames", {PIPE_TRIGGERED, false, false, 1U}, LINK_TRIGGERED, 0.0}
+	};
+
+	bool ok = true;
+	for (uint8_t i = 0U; i < 4U; i++) {
+		Run run = runs[i];
+		ok &= benchRun(run, duration);
+		#ifdef PIPE_DUAL_CORE
+			run.config.cores = 2U;
+			ok &= benchRun(run, duration);
+		#endif
+
+		// the acquire stage a board with the same process stage would need to gain most
+		char name[48];
+		snprintf(name, sizeof(name), "%s, acquire matched", runs[i].name);
+		run = runs[i];
+		run.name = name;
+		run.work = singleProcess > singleAcquire ? singleProcess - singleAcquire : 0.0;
+		ok &= benchRun(run, duration);
+		#ifdef PIPE_DUAL_CORE
+			run.config.cores = 2U;
+			ok &= benchRun(run, duration);
+		#endif
+	}
+
+	nvmEnd();
+	debugFlush();
+	unlink(path);
+	return ok ? 0 : 1;
+}
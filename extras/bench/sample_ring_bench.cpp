@@ -0,0 +1,205 @@
+/*
+	sample_ring_bench.cpp - sample ring throughput between two threads
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Streams samples from a producer thread standing in for
+ * the ADC interrupt to a consumer standing in for the loop,
+ * through a ring guarded by CriticalSection, the sample ring
+ * one sample at a time and the sample ring in blocks. Prints
+ * samples per second and checks every sample arrived in order.
+ *
+ * usage: sample_ring_bench [samples]
+ */
+
+#include <Arduino.h>
+#include <stdlib.h>
+#include <thread>
+#include "sample_ring.h"
+#include "critical.h"
+
+#define DEFAULT_SAMPLES 20000000UL
+#define BLOCK_SAMPLES 64U
+
+// the sample stream, 12 bit like the ADC
+#define SAMPLE_AT(i) ((SampleWord)((i) & 0x0FFFU))
+
+/**
+ * Ring of the same size that locks on every access,
+ * what the sample ring replaces
+ */
+class LockedRing {
+	public:
+		bool push(SampleWord value) {
+			CriticalSection lock;
+			if (count == SAMPLE_RING_SIZE) {
+				return false;
+			}
+			samples[head] = value;
+			head = (head + 1U) & (SAMPLE_RING_SIZE - 1U);
+			count++;
+			return true;
+		}
+
+		bool pop(SampleWord *value) {
+			CriticalSection lock;
+			if (count == 0U) {
+				return false;
+			}
+			*value = samples[tail];
+			tail = (tail + 1U) & (SAMPLE_RING_SIZE - 1U);
+			count--;
+			return true;
+		}
+
+	private:
+		uint32_t head = 0U;
+		uint32_t tail = 0U;
+		uint32_t count = 0U;
+		SampleWord samples[SAMPLE_RING_SIZE];
+};
+
+static LockedRing lockedRing;
+static BoardSampleRing sampleRing;
+
+/**
+ * Pushes one sample at a time, waiting while full
+ */
+template <typename R>
+void produceSingle(R *ring, uint32_t total) {
+	for (uint32_t i = 0U; i < total; i++) {
+		while (!ring->push(SAMPLE_AT(i))) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+/**
+ * Pops one sample at a time, waiting while empty
+ *
+ * @return samples out of order
+ */
+template <typename R>
+uint32_t consumeSingle(R *ring, uint32_t total) {
+	uint32_t errors = 0U;
+	SampleWord value;
+	for (uint32_t i = 0U; i < total; i++) {
+		while (!ring->pop(&value)) {
+			std::this_thread::yield();
+		}
+		if (value != SAMPLE_AT(i)) {
+			errors++;
+		}
+	}
+	return errors;
+}
+
+/**
+ * Pushes blocks like a DMA transfer completing
+ */
+void produceBlocks(BoardSampleRing *ring, uint32_t total) {
+	SampleWord block[BLOCK_SAMPLES];
+	uint32_t sent = 0U;
+
+	while (sent < total) {
+		uint32_t count = total - sent < BLOCK_SAMPLES ? total - sent : BLOCK_SAMPLES;
+		for (uint32_t i = 0U; i < count; i++) {
+			block[i] = SAMPLE_AT(sent + i);
+		}
+
+		uint32_t added = 0U;
+		while (added < count) {
+			uint32_t pushed = ring->pushN(&block[added], count - added);
+			if (pushed == 0U) {
+				std::this_thread::yield();
+			}
+			added += pushed;
+		}
+		sent += count;
+	}
+}
+
+/**
+ * Reads samples in place and frees them a span at a time
+ *
+ * @return samples out of order
+ */
+uint32_t consumeSpans(BoardSampleRing *ring, uint32_t total) {
+	uint32_t errors = 0U;
+	uint32_t received = 0U;
+	const SampleWord *span;
+
+	while (received < total) {
+		uint32_t ready = ring->peekContiguous(&span);
+		if (ready == 0U) {
+			std::this_thread::yield();
+			continue;
+		}
+		for (uint32_t i = 0U; i < ready; i++) {
+			if (span[i] != SAMPLE_AT(received + i)) {
+				errors++;
+			}
+		}
+		ring->consume(ready);
+		received += ready;
+	}
+	return errors;
+}
+
+/**
+ * Runs a producer thread against the consumer on this one
+ *
+ * @return if every sample arrived in order
+ */
+template <typename P, typename C>
+bool runCase(const char *name, uint32_t total, P produce, C consume) {
+	uint32_t start = micros();
+	std::thread producer(produce);
+	uint32_t errors = consume();
+	producer.join();
+	uint32_t elapsed = micros() - start;
+
+	printf("%-14s %8.2f Msamples/s %8u ms  %s\n", name,
+		elapsed ? (double)total / elapsed : 0.0, elapsed / 1000U,
+		errors ? "OUT OF ORDER" : "ok");
+	return errors == 0U;
+}
+
+int main(int argc, char **argv) {
+	uint32_t total = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : DEFAULT_SAMPLES;
+	bool ok = true;
+
+	printf("%s, %u sample ring, %u byte samples, %u byte indexes, %u samples\n",
+		Board::name, (unsigned)SAMPLE_RING_SIZE, (unsigned)sizeof(SampleWord),
+		(unsigned)sizeof(BoardSampleRing::Index), total);
+
+	ok &= runCase("locked", total,
+		[=]() {produceSingle(&lockedRing, total);},
+		[=]() {return consumeSingle(&lockedRing, total);});
+
+	sampleRing.reset();
+	ok &= runCase("push/pop", total,
+		[=]() {produceSingle(&sampleRing, total);},
+		[=]() {return consumeSingle(&sampleRing, total);});
+
+	sampleRing.reset();
+	ok &= runCase("pushN/peek", total,
+		[=]() {produceBlocks(&sampleRing, total);},
+		[=]() {return consumeSpans(&sampleRing, total);});
+
+	return ok ? 0 : 1;
+}
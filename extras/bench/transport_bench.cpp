@@ -0,0 +1,312 @@
+/*
+	transport_bench.cpp - transport throughput and latency per medium
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Streams link frames over each host transport, the
+ * loopback, the pty at two bauds and UDP to localhost,
+ * reading them back into a parser. For each prints the
+ * bytes per second the medium took with frames offered as
+ * fast as the batches take them, the average write, the
+ * latency from send to parse under that load and the
+ * latency of a frame sent alone. Also checks
+ * transportLoadConfig() restores the medium and WiFi
+ * credentials from nvm.
+ *
+ * usage: transport_bench [nvm file] [seconds per medium]
+ */
+
+#include <Arduino.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "bench_nvm.h"
+#include "transport/transport.h"
+#include "transport/transport_host.h"
+
+#define FRAME_SAMPLES 256U
+#define IDLE_FRAMES 20U
+#define DRAIN_MICROS 5000000UL
+#define BENCH_PORT 52101U
+#define LOCALHOST 0x0100007FUL
+
+struct Medium {
+	const char *name;
+	TransportConfig config;
+	bool lossless; // every frame must arrive
+};
+
+struct Latency {
+	uint32_t frames;
+	uint64_t total;
+	uint32_t most;
+};
+
+LinkParser parser;
+SampleWord block[FRAME_SAMPLES];
+uint32_t sentAt[65536];
+uint16_t sequence = 0U;
+int receiver = -1;
+uint8_t medium = TRANSPORT_LOOPBACK;
+uint32_t wrong = 0UL;
+
+const TransportConfig RESTORE_UDP = {TRANSPORT_UDP, 921600UL, LOCALHOST, BENCH_PORT, "scope-lab", "probe-1234"};
+const TransportConfig RESTORE_LOOPBACK = {TRANSPORT_LOOPBACK, 0UL, 0UL, 0U, "", ""};
+
+/**
+ * Opens UDP then the loopback so the loopback is stored
+ * with the UDP credentials
+ *
+ * @return if both opened
+ */
+bool storeConfig(void) {
+	if (!transportBegin(RESTORE_UDP)) {
+		return false;
+	}
+	transportEnd();
+	if (!transportBegin(RESTORE_LOOPBACK)) {
+		return false;
+	}
+	transportEnd();
+	return true;
+}
+
+/**
+ * Checks transportLoadConfig() picks up the loopback
+ * with the UDP credentials still stored
+ *
+ * @return if the config came back
+ */
+bool checkConfig(void) {
+	const TransportConfig &config = RESTORE_LOOPBACK;
+	TransportConfig restored;
+	return transportLoadConfig(&restored) &&
+		restored.medium == config.medium && restored.baud == config.baud &&
+		restored.address == config.address && restored.port == config.port &&
+		strcmp(restored.ssid, RESTORE_UDP.ssid) == 0 && strcmp(restored.pass, RESTORE_UDP.pass) == 0;
+}
+
+/**
+ * Opens what reads the medium back
+ *
+ * @param config medium being read
+ *
+ * @return if it opened
+ */
+bool openReceiver(const TransportConfig &config) {
+	if (config.medium == TRANSPORT_SERIAL) {
+		receiver = open(transportHostPtyName(), O_RDONLY | O_NOCTTY | O_NONBLOCK);
+	}
+	else if (config.medium == TRANSPORT_UDP) {
+		receiver = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+		int size = 1 << 22;
+		setsockopt(receiver, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+		struct sockaddr_in local;
+		memset(&local, 0, sizeof(local));
+		local.sin_family = AF_INET;
+		local.sin_port = htons(config.port);
+		local.sin_addr.s_addr = config.address;
+		if (bind(receiver, (const struct sockaddr*)&local, sizeof(local)) != 0) {
+			close(receiver);
+			receiver = -1;
+		}
+	}
+	return config.medium == TRANSPORT_LOOPBACK || receiver >= 0;
+}
+
+void closeReceiver(void) {
+	if (receiver >= 0) {
+		close(receiver);
+		receiver = -1;
+	}
+}
+
+/**
+ * Reads what arrived and parses it
+ *
+ * @param latency latency of the frames parsed
+ *
+ * @return frames parsed
+ */
+uint32_t receive(Latency *latency) {
+	static uint8_t data[65536];
+	ssize_t size;
+	if (medium == TRANSPORT_LOOPBACK) {
+		size = transportHostRead(data, sizeof(data) - 1U);
+	}
+	else {
+		size = read(receiver, data, sizeof(data) - 1U);
+	}
+	if (size <= 0) {
+		return 0UL;
+	}
+
+	uint32_t now = micros();
+	uint32_t frames = 0UL;
+	const uint8_t *next = data;
+	uint16_t left = (uint16_t)size;
+	uint16_t used;
+	LinkFrame frame;
+	while (linkParse(&parser, next, left, &used, &frame)) {
+		uint32_t delay = now - sentAt[frame.sequence];
+		latency->frames++;
+		latency->total += delay;
+		latency->most = delay > latency->most ? delay : latency->most;
+
+		// the first sample carries the sequence, the rest are fixed
+		SampleWord first = (SampleWord)(frame.payload[0] | (frame.payload[1] << 8));
+		bool same = frame.length == sizeof(block) && first == (SampleWord)(frame.sequence & 0x0FFFU) &&
+			memcmp(&frame.payload[sizeof(SampleWord)], &block[1], sizeof(block) - sizeof(SampleWord)) == 0;
+		wrong += same ? 0UL : 1UL;
+
+		frames++;
+		next += used;
+		left = (uint16_t)(left - used);
+	}
+	return frames;
+}
+
+/**
+ * Sends a frame if the batches have room
+ *
+ * @return if it was sent
+ */
+bool send(void) {
+	const uint32_t size = LINK_HEADER_SIZE + sizeof(block) + LINK_CRC_SIZE;
+	if (!transportReady(size)) {
+		return false;
+	}
+	block[0] = (SampleWord)(sequence & 0x0FFFU);
+	sentAt[sequence] = micros();
+	if (!linkSendSamples(block, FRAME_SAMPLES, 0x01U)) {
+		return false;
+	}
+	sequence++;
+	return true;
+}
+
+/**
+ * Runs one medium
+ *
+ * @param run medium and config
+ * @param duration microseconds to offer frames for
+ *
+ * @return if nothing came back wrong, and nothing was lost on a lossless medium
+ */
+bool benchMedium(const Medium &run, uint32_t duration) {
+	if (!transportBegin(run.config) || !openReceiver(run.config)) {
+		printf("%-20s couldn't open\n", run.name);
+		transportEnd();
+		return false;
+	}
+	medium = run.config.medium;
+	linkBegin(transportSink);
+	linkParserReset(&parser);
+	sequence = 0U;
+	wrong = 0UL;
+
+	// as fast as the batches take frames
+	Latency loaded = {0UL, 0U, 0UL};
+	uint32_t sent = 0UL;
+	uint32_t received = 0UL;
+	uint32_t start = micros();
+	while ((uint32_t)(micros() - start) < duration) {
+		sent += send() ? 1UL : 0UL;
+		transportPoll();
+		received += receive(&loaded);
+	}
+	TransportStats stats;
+	transportGetStats(&stats);
+	uint32_t elapsed = (uint32_t)(micros() - start);
+	uint32_t inTime = loaded.frames;
+
+	uint32_t drainStart = micros();
+	while (received < sent && (uint32_t)(micros() - drainStart) < DRAIN_MICROS) {
+		transportPoll();
+		received += receive(&loaded);
+	}
+
+	// one frame at a time
+	Latency idle = {0UL, 0U, 0UL};
+	for (uint8_t i = 0U; i < IDLE_FRAMES; i++) {
+		if (!send()) {
+			break;
+		}
+		sent++;
+		uint32_t waitStart = micros();
+		uint32_t arrived = 0UL;
+		while (arrived == 0UL && (uint32_t)(micros() - waitStart) < DRAIN_MICROS) {
+			transportPoll();
+			arrived = receive(&idle);
+		}
+		received += arrived;
+	}
+
+	printf("%-20s %4u MTU %10.0f bytes/s %8.0f frames/s, %6.1f byte writes, %6u stalls, "
+		"latency loaded %8.2f max %8.2f ms, alone %7.3f max %7.3f ms, lost %u bad %u refused %u%s\n",
+		run.name, (unsigned)(run.config.medium == TRANSPORT_SERIAL ? TRANSPORT_SERIAL_MTU :
+			(run.config.medium == TRANSPORT_UDP ? TRANSPORT_UDP_MTU : TRANSPORT_BLE_MTU)),
+		stats.bytes * 1e6 / elapsed, inTime * 1e6 / elapsed,
+		stats.writes != 0UL ? (double)stats.bytes / stats.writes : 0.0, (unsigned)stats.stalls,
+		loaded.frames != 0UL ? loaded.total / 1000.0 / loaded.frames : 0.0, loaded.most / 1000.0,
+		idle.frames != 0UL ? idle.total / 1000.0 / idle.frames : 0.0, idle.most / 1000.0,
+		(unsigned)(sent - received), (unsigned)(parser.corrupt + wrong), (unsigned)linkRefused(),
+		wrong == 0UL ? "" : "  FRAMES WRONG");
+
+	closeReceiver();
+	transportEnd();
+	return wrong == 0UL && parser.corrupt == 0UL && (!run.lossless || received == sent);
+}
+
+int main(int argc, char **argv) {
+	const char *path = argc > 1 ? argv[1] : "transport_bench.bin";
+	uint32_t duration = (uint32_t)((argc > 2 ? atof(argv[2]) : 1.0) * 1e6);
+
+	for (uint16_t i = 0U; i < FRAME_SAMPLES; i++) {
+		block[i] = (SampleWord)((i * 37U) & 0x0FFFU);
+	}
+
+	unlink(path);
+	if (!startNvm(path)) {
+		printf("nvm couldn't be started at %s\n", path);
+		return 1;
+	}
+
+	bool ok = checkRestore(path, storeConfig, checkConfig);
+	printf("%s, %u byte batches, %u byte frames\n", Board::name, (unsigned)TRANSPORT_BATCH_SIZE,
+		(unsigned)(LINK_HEADER_SIZE + sizeof(block) + LINK_CRC_SIZE));
+	printf("medium and credentials restored from nvm: %s\n", ok ? "yes" : "no");
+
+	Medium media[4] = {
+		{"loopback", {TRANSPORT_LOOPBACK, 0UL, 0UL, 0U, "", ""}, true},
+		{"pty at 115200 baud", {TRANSPORT_SERIAL, 115200UL, 0UL, 0U, "", ""}, true},
+		{"pty at 2000000 baud", {TRANSPORT_SERIAL, 2000000UL, 0UL, 0U, "", ""}, true},
+		{"UDP to localhost", {TRANSPORT_UDP, 0UL, LOCALHOST, BENCH_PORT, "", ""}, false}
+	};
+	for (uint8_t i = 0U; i < 4U; i++) {
+		ok &= benchMedium(media[i], duration);
+	}
+
+	nvmEnd();
+	debugFlush();
+	unlink(path);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,303 @@
+/*
+	trigger_bench.cpp - trigger scan and frame throughput on synthetic signals
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Builds a noisy sine, a noisy square and a pulse train of
+ * mixed widths, then:
+ * - walks every Schmitt crossing with the one at a time scan
+ *   and the word scan, checking both find the same samples
+ * - runs each trigger mode over the signals in acquisition
+ *   sized blocks, taking every frame it can, and checks each
+ *   frame matches the signal around its trigger
+ * Prints samples per second and how many times the board's
+ * top ADC rate that is. Also checks trigInit() restores the
+ * config from nvm.
+ *
+ * usage: trigger_bench [nvm file] [samples]
+ */
+
+#include <Arduino.h>
+#include <math.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "bench_nvm.h"
+#include "acquisition/acquisition.h"
+#include "trigger/trigger.h"
+
+#define DEFAULT_SAMPLES 8000000UL
+#define FULL_SCALE 4095.0f
+
+struct Signal {
+	const char *name;
+	uint8_t channels;
+	SampleWord *samples;
+	uint32_t count;
+};
+
+const TrigConfig RESTORE_CONFIG = {TRIG_PULSE_LOW, 1U, 1000U, 40U, 100U, 400U, 1234UL, 10UL, 90UL};
+
+/**
+ * Begins the trigger so it stores RESTORE_CONFIG
+ *
+ * @return if it began
+ */
+bool storeConfig(void) {
+	return trigBegin(RESTORE_CONFIG, 0x03U);
+}
+
+/**
+ * Checks trigInit() picks up RESTORE_CONFIG
+ *
+ * @return if the config came back
+ */
+bool checkConfig(void) {
+	const TrigConfig &config = RESTORE_CONFIG;
+	TrigConfig restored;
+	return trigLoadConfig(&restored, 0x03U) && trigInit(0x03U) &&
+		restored.mode == config.mode && restored.source == config.source &&
+		restored.level == config.level && restored.hysteresis == config.hysteresis &&
+		restored.preTrigger == config.preTrigger && restored.length == config.length &&
+		restored.holdoff == config.holdoff && restored.pulseMin == config.pulseMin &&
+		restored.pulseMax == config.pulseMax;
+}
+
+uint32_t noiseState = 12345UL;
+
+/**
+ * Gets noise for the signals, the same every run
+ *
+ * @return noise from -1 to 1
+ */
+float noise(void) {
+	noiseState = noiseState * 1664525UL + 1013904223UL;
+	return (float)(noiseState >> 8) / (float)(1UL << 23) - 1.0f;
+}
+
+SampleWord toSample(float level) {
+	if (level < 0.0f) {
+		level = 0.0f;
+	}
+	if (level > 1.0f) {
+		level = 1.0f;
+	}
+	return (SampleWord)(level * FULL_SCALE + 0.5f);
+}
+
+/**
+ * Fills a signal, channel 0 is the interesting one and
+ * any others are a slow ramp
+ *
+ * @param signal signal to fill, its name picks the wave
+ * @param wave 0 sine, 1 square, 2 pulses
+ */
+void fillSignal(Signal *signal, uint8_t wave) {
+	uint8_t stride = acqChannelCount(signal->channels);
+	for (uint32_t i = 0UL; i < signal->count; i++) {
+		uint32_t set = i / stride;
+		if (i % stride != 0U) {
+			signal->samples[i] = (SampleWord)(set % 4096UL);
+			continue;
+		}
+
+		float level;
+		if (wave == 0U) {
+			level = 0.5f + 0.4f * sinf((float)set * 0.0031f) + 0.01f * noise();
+		}
+		else if (wave == 1U) {
+			level = ((set / 700UL) & 1UL ? 0.8f : 0.2f) + 0.05f * noise();
+		}
+		else {
+			// high pulses of 20, 50 and 100 samples, 80 low between
+			static const uint32_t WIDTHS[3] = {20UL, 50UL, 100UL};
+			uint32_t period = set % 500UL;
+			uint32_t width = WIDTHS[(set / 500UL) % 3UL];
+			level = (period < width ? 0.9f : 0.1f) + 0.02f * noise();
+		}
+		signal->samples[i] = toSample(level);
+	}
+}
+
+/**
+ * Walks the crossings of the first channel, above high
+ * then below low in turn
+ *
+ * @param W word to scan with
+ * @param signal signal to scan
+ * @param found set to the crossings, or checked against them
+ * @param check if found is checked instead of set
+ *
+ * @return crossings found, or 0 if a check failed
+ */
+template <typename W>
+uint32_t walkCrossings(const Signal &signal, uint32_t *found, bool check) {
+	const SampleWord HIGH = 2048U;
+	const SampleWord LOW = 1984U;
+	uint8_t stride = acqChannelCount(signal.channels);
+	uint16_t block = (uint16_t)(ACQ_BUFFER_SAMPLES - ACQ_BUFFER_SAMPLES % stride);
+	bool high = signal.samples[0] >= HIGH;
+	uint32_t crossings = 0UL;
+
+	for (uint32_t offset = 0UL; offset + block <= signal.count; offset += block) {
+		const SampleWord *samples = &signal.samples[offset];
+		uint16_t i = 0U;
+		while (true) {
+			i = high ?
+				trigFind<W, false>(samples, i, block, stride, 0U, LOW) :
+				trigFind<W, true>(samples, i, block, stride, 0U, HIGH);
+			if (i >= block) {
+				break;
+			}
+			if (check && found[crossings] != offset + i) {
+				return 0UL;
+			}
+			found[crossings++] = offset + i;
+			high = !high;
+			i = (uint16_t)(i + stride);
+		}
+	}
+	return crossings;
+}
+
+/**
+ * Compares the scans over a signal
+ *
+ * @param signal signal to scan
+ *
+ * @return if both found the same crossings
+ */
+bool benchScan(const Signal &signal) {
+	uint32_t *found = (uint32_t*)malloc(signal.count * sizeof(uint32_t));
+
+	uint32_t start = micros();
+	uint32_t crossings = walkCrossings<SampleWord>(signal, found, false);
+	uint32_t scalarMicros = (uint32_t)(micros() - start);
+
+	start = micros();
+	uint32_t checked = walkCrossings<TrigWord>(signal, found, true);
+	uint32_t wordMicros = (uint32_t)(micros() - start);
+
+	free(found);
+	bool same = checked == crossings;
+	printf("%-22s %7u crossings, one at a time %8.1f, words %8.1f Msamples/s  %s\n",
+		signal.name, crossings, signal.count / (double)scalarMicros, signal.count / (double)wordMicros,
+		same ? "same" : "DIFFERENT");
+	return same;
+}
+
+/**
+ * Runs a trigger over a signal, taking every frame
+ *
+ * @param name name of the run
+ * @param signal signal to trigger on
+ * @param config trigger to run
+ *
+ * @return if every frame matched the signal
+ */
+bool benchTrigger(const char *name, const Signal &signal, const TrigConfig &config) {
+	uint8_t stride = acqChannelCount(signal.channels);
+	uint16_t block = (uint16_t)(ACQ_BUFFER_SAMPLES - ACQ_BUFFER_SAMPLES % stride);
+	if (!trigBegin(config, signal.channels)) {
+		printf("%-22s config refused\n", name);
+		return false;
+	}
+
+	uint32_t frames = 0UL;
+	uint32_t mismatched = 0UL;
+	uint32_t end = signal.count - signal.count % block;
+
+	uint32_t start = micros();
+	for (uint32_t offset = 0UL; offset < end; offset += block) {
+		trigPush(&signal.samples[offset], block);
+
+		const SampleWord *frame;
+		uint32_t position;
+		uint16_t length = trigGetFrame(&frame, &position);
+		if (length != 0U) {
+			const SampleWord *expected = &signal.samples[(position - config.preTrigger) * stride];
+			if (length != config.length * stride || memcmp(frame, expected, length * sizeof(SampleWord)) != 0) {
+				mismatched++;
+			}
+			frames++;
+			trigReleaseFrame();
+		}
+	}
+	uint32_t elapsed = (uint32_t)(micros() - start);
+
+	double rate = end / (double)elapsed;
+	printf("%-22s %7u frames %8.1f Msamples/s, %6.0fx the top ADC rate  %s\n", name, frames, rate,
+		rate * 1e6 / Board::adcMaxRate, mismatched == 0UL && frames != 0UL ? "ok" : "FRAMES WRONG");
+	return mismatched == 0UL && frames != 0UL;
+}
+
+int main(int argc, char **argv) {
+	const char *path = argc > 1 ? argv[1] : "trigger_bench.bin";
+	uint32_t count = argc > 2 ? (uint32_t)atol(argv[2]) : DEFAULT_SAMPLES;
+
+	unlink(path);
+	if (!startNvm(path)) {
+		printf("nvm couldn't be started at %s\n", path);
+		return 1;
+	}
+
+	bool ok = checkRestore(path, storeConfig, checkConfig);
+	printf("%s, %u sample frames, %u sample blocks, %u byte scan words\n", Board::name,
+		(unsigned)TRIG_FRAME_SAMPLES, (unsigned)ACQ_BUFFER_SAMPLES, (unsigned)sizeof(TrigWord));
+	printf("config restored from nvm: %s\n", ok ? "yes" : "no");
+
+	Signal signals[5] = {
+		{"sine", 0x01U, NULL, count},
+		{"square", 0x01U, NULL, count},
+		{"pulses", 0x01U, NULL, count},
+		{"square, 2 channels", 0x03U, NULL, count},
+		{"square, 3 channels", 0x07U, NULL, (uint32_t)(count - count % 3UL)}
+	};
+	static const uint8_t WAVES[5] = {0U, 1U, 2U, 1U, 1U};
+	for (uint8_t i = 0U; i < 5U; i++) {
+		signals[i].samples = (SampleWord*)malloc(signals[i].count * sizeof(SampleWord));
+		fillSignal(&signals[i], WAVES[i]);
+	}
+
+	printf("\n== Schmitt crossings\n");
+	for (uint8_t i = 0U; i < 5U; i++) {
+		ok &= benchScan(signals[i]);
+	}
+
+	printf("\n== Triggers, frames taken as soon as they're ready\n");
+	TrigConfig rising = {TRIG_RISING, 0U, 2048U, 64U, 200U, 800U, 0UL, 0UL, 0UL};
+	TrigConfig falling = {TRIG_FALLING, 0U, 2048U, 64U, 200U, 800U, 0UL, 0UL, 0UL};
+	TrigConfig level = {TRIG_LEVEL, 0U, 3000U, 0U, 200U, 800U, 5000UL, 0UL, 0UL};
+	TrigConfig pulse = {TRIG_PULSE_HIGH, 0U, 2048U, 64U, 200U, 800U, 0UL, 40UL, 60UL};
+	TrigConfig gap = {TRIG_PULSE_LOW, 0U, 2048U, 64U, 200U, 800U, 0UL, 350UL, 450UL};
+	TrigConfig multi = {TRIG_RISING, 0U, 2048U, 64U, 200U, 800U, 2000UL, 0UL, 0UL};
+
+	ok &= benchTrigger("rising, sine", signals[0], rising);
+	ok &= benchTrigger("falling, square", signals[1], falling);
+	ok &= benchTrigger("level, sine", signals[0], level);
+	ok &= benchTrigger("50 sample pulses", signals[2], pulse);
+	ok &= benchTrigger("low gaps of 350-450", signals[2], gap);
+	ok &= benchTrigger("rising, 2 channels", signals[3], multi);
+	ok &= benchTrigger("rising, 3 channels", signals[4], multi);
+
+	for (uint8_t i = 0U; i < 5U; i++) {
+		free(signals[i].samples);
+	}
+	nvmEnd();
+	debugFlush();
+	unlink(path);
+	return ok ? 0 : 1;
+}
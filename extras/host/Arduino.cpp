@@ -0,0 +1,51 @@
+/*
+	Arduino.cpp - minimal Arduino API for building the core on a Linux host
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Arduino.h"
+#include <time.h>
+
+HostSerial Serial;
+
+/**
+ * Gets microseconds of the monotonic clock
+ * 
+ * @return microseconds since an arbitrary start
+ */
+static uint64_t hostMicros(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000000ULL + (uint64_t)now.tv_nsec / 1000ULL;
+}
+
+unsigned long millis(void) {
+	return (unsigned long)(hostMicros() / 1000ULL);
+}
+
+unsigned long micros(void) {
+	return (unsigned long)hostMicros();
+}
+
+void delay(unsigned long ms) {
+	struct timespec wait = {(time_t)(ms / 1000UL), (long)(ms % 1000UL) * 1000000L};
+	nanosleep(&wait, NULL);
+}
+
+void delayMicroseconds(unsigned int us) {
+	struct timespec wait = {(time_t)(us / 1000000U), (long)(us % 1000000U) * 1000L};
+	nanosleep(&wait, NULL);
+}
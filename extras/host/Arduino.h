@@ -0,0 +1,132 @@
+/*
+	Arduino.h - minimal Arduino API for building the core on a Linux host
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <cstdlib>
+#include <string>
+
+/****************************
+ * Flash Strings
+****************************/
+
+#define PROGMEM
+#define PGM_P const char *
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+/****************************
+ * String
+****************************/
+
+class String : public std::string {
+	public:
+		String(const char *value = "") : std::string(value) {}
+		String(const std::string &value) : std::string(value) {}
+		String(char value) : std::string(1, value) {}
+		String(int value) : std::string(std::to_string(value)) {}
+		String(unsigned int value) : std::string(std::to_string(value)) {}
+		String(long value) : std::string(std::to_string(value)) {}
+		String(unsigned long value) : std::string(std::to_string(value)) {}
+		String(long long value) : std::string(std::to_string(value)) {}
+		String(unsigned long long value) : std::string(std::to_string(value)) {}
+};
+
+inline String operator+(const String &left, const String &right) {
+	return String((const std::string&)left + (const std::string&)right);
+}
+
+/****************************
+ * Serial
+****************************/
+
+#define DEC 10
+#define HEX 16
+
+class HostSerial {
+	public:
+		HostSerial(void) : output(NULL) {}
+
+		void begin(unsigned long baud) {}
+		void flush(void) { fflush(stream()); }
+		int available(void) { return 0; }
+		int read(void) { return -1; }
+		int availableForWrite(void) { return 4096; }
+
+		/**
+		 * Sends serial output to a file instead of stdout,
+		 * benchmarks use it to drop debug output
+		 *
+		 * @param file file to write to, NULL for stdout
+		 */
+		void setOutput(FILE *file) { output = file; }
+
+		size_t write(uint8_t value) { return fwrite(&value, 1U, 1U, stream()); }
+		size_t write(const uint8_t *data, size_t size) { return fwrite(data, 1U, size, stream()); }
+
+		size_t print(const __FlashStringHelper *value) { return print((const char*)value); }
+		size_t print(const char *value) { return (size_t)fprintf(stream(), "%s", value); }
+		size_t print(const String &value) { return print(value.c_str()); }
+		size_t print(char value) { return (size_t)fprintf(stream(), "%c", value); }
+		size_t print(unsigned char value, int base = DEC) { return print((unsigned long long)value, base); }
+		size_t print(int value, int base = DEC) { return print((long long)value, base); }
+		size_t print(unsigned int value, int base = DEC) { return print((unsigned long long)value, base); }
+		size_t print(long value, int base = DEC) { return print((long long)value, base); }
+		size_t print(unsigned long value, int base = DEC) { return print((unsigned long long)value, base); }
+		size_t print(long long value, int base = DEC) {
+			return (size_t)fprintf(stream(), base == HEX ? "%llX" : "%lld", value);
+		}
+		size_t print(unsigned long long value, int base = DEC) {
+			return (size_t)fprintf(stream(), base == HEX ? "%llX" : "%llu", value);
+		}
+		size_t print(double value, int digits = 2) { return (size_t)fprintf(stream(), "%.*f", digits, value); }
+
+		size_t println(void) { return print('\n'); }
+
+		template <typename T>
+		size_t println(T value) { return print(value) + println(); }
+
+		template <typename T>
+		size_t println(T value, int format) { return print(value, format) + println(); }
+
+	private:
+		FILE *output;
+
+		FILE *stream(void) { return output != NULL ? output : stdout; }
+};
+
+extern HostSerial Serial;
+
+/****************************
+ * Timing
+****************************/
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+#endif
@@ -0,0 +1,368 @@
+/*
+	Preferences.cpp - in memory ESP32 Preferences for building the core on a Linux host
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "Preferences.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// bytes of a value held by one nvs entry
+#define PREF_ENTRY_SIZE 32U
+
+struct PrefEntry {
+	PreferenceType type;
+	std::vector<uint8_t> data;
+};
+
+typedef std::map<std::string, PrefEntry> PrefStore;
+
+static PrefStore prefStore;
+static size_t prefEntriesUsed = 0U;
+static PreferencesStats prefStats = {0U, 0U, 0U};
+
+/**
+ * Gets nvs entries taken by a value, strings and blobs
+ * take a header entry plus their data
+ *
+ * @param type type of value
+ * @param len bytes of value
+ *
+ * @return entries used
+ */
+static size_t prefEntries(PreferenceType type, size_t len) {
+	if (type == PT_STR || type == PT_BLOB) {
+		return 1U + (len + PREF_ENTRY_SIZE - 1U) / PREF_ENTRY_SIZE;
+	}
+	return 1U;
+}
+
+/**
+ * Checks a key or namespace fits nvs
+ *
+ * @param name key or namespace
+ *
+ * @return if name is valid
+ */
+static bool prefValidName(const char *name) {
+	return name != NULL && name[0] != '\0' && strlen(name) <= PREF_KEY_MAX;
+}
+
+/**
+ * Builds the store key of a key in a namespace
+ *
+ * @param space namespace
+ * @param key key in namespace
+ *
+ * @return store key
+ */
+static std::string prefStoreKey(const char *space, const char *key) {
+	std::string storeKey(space);
+	storeKey.push_back('\0');
+	storeKey.append(key);
+	return storeKey;
+}
+
+Preferences::Preferences(void) : opened(false), readOnly(false) {
+	space[0] = '\0';
+}
+
+Preferences::~Preferences(void) {
+	end();
+}
+
+bool Preferences::begin(const char *name, bool readOnly, const char *partition_label) {
+	if (opened || !prefValidName(name)) {
+		return false;
+	}
+	strcpy(space, name);
+	this->readOnly = readOnly;
+	opened = true;
+	return true;
+}
+
+void Preferences::end(void) {
+	opened = false;
+}
+
+bool Preferences::clear(void) {
+	if (!opened || readOnly) {
+		return false;
+	}
+
+	std::string prefix(space);
+	prefix.push_back('\0');
+
+	PrefStore::iterator entry = prefStore.lower_bound(prefix);
+	while (entry != prefStore.end() && entry->first.compare(0U, prefix.size(), prefix) == 0) {
+		prefEntriesUsed -= prefEntries(entry->second.type, entry->second.data.size());
+		entry = prefStore.erase(entry);
+	}
+	return true;
+}
+
+bool Preferences::remove(const char *key) {
+	if (!opened || readOnly || !prefValidName(key)) {
+		return false;
+	}
+
+	PrefStore::iterator entry = prefStore.find(prefStoreKey(space, key));
+	if (entry == prefStore.end()) {
+		return false;
+	}
+	prefEntriesUsed -= prefEntries(entry->second.type, entry->second.data.size());
+	prefStore.erase(entry);
+	return true;
+}
+
+size_t Preferences::put(const char *key, PreferenceType type, const void *value, size_t len) {
+	if (!opened || readOnly || !prefValidName(key)) {
+		return 0U;
+	}
+
+	// a key written again replaces its old value, whatever its type
+	std::string storeKey = prefStoreKey(space, key);
+	size_t freed = 0U;
+	PrefStore::iterator old = prefStore.find(storeKey);
+	if (old != prefStore.end()) {
+		freed = prefEntries(old->second.type, old->second.data.size());
+	}
+
+	size_t needed = prefEntries(type, len);
+	if (prefEntriesUsed - freed + needed > PREF_ENTRIES) {
+		return 0U;
+	}
+
+	PrefEntry &entry = prefStore[storeKey];
+	entry.type = type;
+	entry.data.assign((const uint8_t*)value, (const uint8_t*)value + len);
+	prefEntriesUsed = prefEntriesUsed - freed + needed;
+
+	prefStats.puts++;
+	prefStats.bytesWritten += (uint32_t)len;
+	return len;
+}
+
+size_t Preferences::get(const char *key, PreferenceType type, void *value, size_t maxLen) {
+	if (!opened || !prefValidName(key)) {
+		return 0U;
+	}
+
+	prefStats.gets++;
+
+	PrefStore::const_iterator entry = prefStore.find(prefStoreKey(space, key));
+	if (entry == prefStore.end() || entry->second.type != type) {
+		return 0U;
+	}
+
+	size_t len = entry->second.data.size();
+	if (len > maxLen) {
+		return 0U;
+	}
+	if (len > 0U) {
+		memcpy(value, entry->second.data.data(), len);
+	}
+	return len;
+}
+
+size_t Preferences::putChar(const char *key, int8_t value) {
+	return put(key, PT_I8, &value, sizeof(value));
+}
+
+size_t Preferences::putUChar(const char *key, uint8_t value) {
+	return put(key, PT_U8, &value, sizeof(value));
+}
+
+size_t Preferences::putShort(const char *key, int16_t value) {
+	return put(key, PT_I16, &value, sizeof(value));
+}
+
+size_t Preferences::putUShort(const char *key, uint16_t value) {
+	return put(key, PT_U16, &value, sizeof(value));
+}
+
+size_t Preferences::putInt(const char *key, int32_t value) {
+	return put(key, PT_I32, &value, sizeof(value));
+}
+
+size_t Preferences::putUInt(const char *key, uint32_t value) {
+	return put(key, PT_U32, &value, sizeof(value));
+}
+
+size_t Preferences::putLong(const char *key, int32_t value) {
+	return putInt(key, value);
+}
+
+size_t Preferences::putULong(const char *key, uint32_t value) {
+	return putUInt(key, value);
+}
+
+size_t Preferences::putLong64(const char *key, int64_t value) {
+	return put(key, PT_I64, &value, sizeof(value));
+}
+
+size_t Preferences::putULong64(const char *key, uint64_t value) {
+	return put(key, PT_U64, &value, sizeof(value));
+}
+
+size_t Preferences::putFloat(const char *key, float value) {
+	return putBytes(key, &value, sizeof(value));
+}
+
+size_t Preferences::putDouble(const char *key, double value) {
+	return putBytes(key, &value, sizeof(value));
+}
+
+size_t Preferences::putBool(const char *key, bool value) {
+	return putUChar(key, (uint8_t)(value ? 1U : 0U));
+}
+
+size_t Preferences::putString(const char *key, const char *value) {
+	size_t len = strlen(value);
+	return put(key, PT_STR, value, len + 1U) == len + 1U ? len : 0U;
+}
+
+size_t Preferences::putString(const char *key, const String &value) {
+	return putString(key, value.c_str());
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len) {
+	// like the ESP32, an empty blob isn't stored
+	if (len == 0U) {
+		return 0U;
+	}
+	return put(key, PT_BLOB, value, len);
+}
+
+bool Preferences::isKey(const char *key) {
+	return getType(key) != PT_INVALID;
+}
+
+PreferenceType Preferences::getType(const char *key) {
+	if (!opened || !prefValidName(key)) {
+		return PT_INVALID;
+	}
+	PrefStore::const_iterator entry = prefStore.find(prefStoreKey(space, key));
+	return entry == prefStore.end() ? PT_INVALID : entry->second.type;
+}
+
+int8_t Preferences::getChar(const char *key, int8_t defaultValue) {
+	int8_t value;
+	return get(key, PT_I8, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+uint8_t Preferences::getUChar(const char *key, uint8_t defaultValue) {
+	uint8_t value;
+	return get(key, PT_U8, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+int16_t Preferences::getShort(const char *key, int16_t defaultValue) {
+	int16_t value;
+	return get(key, PT_I16, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+uint16_t Preferences::getUShort(const char *key, uint16_t defaultValue) {
+	uint16_t value;
+	return get(key, PT_U16, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+int32_t Preferences::getInt(const char *key, int32_t defaultValue) {
+	int32_t value;
+	return get(key, PT_I32, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+uint32_t Preferences::getUInt(const char *key, uint32_t defaultValue) {
+	uint32_t value;
+	return get(key, PT_U32, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+int32_t Preferences::getLong(const char *key, int32_t defaultValue) {
+	return getInt(key, defaultValue);
+}
+
+uint32_t Preferences::getULong(const char *key, uint32_t defaultValue) {
+	return getUInt(key, defaultValue);
+}
+
+int64_t Preferences::getLong64(const char *key, int64_t defaultValue) {
+	int64_t value;
+	return get(key, PT_I64, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+uint64_t Preferences::getULong64(const char *key, uint64_t defaultValue) {
+	uint64_t value;
+	return get(key, PT_U64, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+float Preferences::getFloat(const char *key, float defaultValue) {
+	float value;
+	return get(key, PT_BLOB, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+double Preferences::getDouble(const char *key, double defaultValue) {
+	double value;
+	return get(key, PT_BLOB, &value, sizeof(value)) == sizeof(value) ? value : defaultValue;
+}
+
+bool Preferences::getBool(const char *key, bool defaultValue) {
+	return getUChar(key, defaultValue ? 1U : 0U) == 1U;
+}
+
+size_t Preferences::getString(const char *key, char *value, size_t maxLen) {
+	return get(key, PT_STR, value, maxLen);
+}
+
+String Preferences::getString(const char *key, const String &defaultValue) {
+	size_t len = getBytesLength(key);
+	if (getType(key) != PT_STR || len == 0U) {
+		return defaultValue;
+	}
+
+	std::vector<char> value(len);
+	return get(key, PT_STR, value.data(), len) == len ? String(value.data()) : defaultValue;
+}
+
+size_t Preferences::getBytesLength(const char *key) {
+	if (!opened || !prefValidName(key)) {
+		return 0U;
+	}
+	PrefStore::const_iterator entry = prefStore.find(prefStoreKey(space, key));
+	return entry == prefStore.end() ? 0U : entry->second.data.size();
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t maxLen) {
+	return get(key, PT_BLOB, buf, maxLen);
+}
+
+size_t Preferences::freeEntries(void) {
+	return PREF_ENTRIES - prefEntriesUsed;
+}
+
+const PreferencesStats &Preferences::stats(void) {
+	return prefStats;
+}
+
+void Preferences::resetStats(void) {
+	prefStats.puts = 0U;
+	prefStats.gets = 0U;
+	prefStats.bytesWritten = 0U;
+}
+
+void Preferences::erase(void) {
+	prefStore.clear();
+	prefEntriesUsed = 0U;
+}
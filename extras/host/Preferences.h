@@ -0,0 +1,157 @@
+/*
+	Preferences.h - in memory ESP32 Preferences for building the core on a Linux host
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include "Arduino.h"
+
+/****************************
+ * NVS Model
+ *
+ * Values live in memory for the life of the process and
+ * follow the ESP32 rules the core relies on: keys and
+ * namespaces of at most 15 characters, typed integers,
+ * floats and doubles stored as blobs, reads of another
+ * type fail and an entry budget of a 20 KiB nvs partition.
+****************************/
+
+// longest key or namespace, nvs keeps 16 bytes with the terminator
+#define PREF_KEY_MAX 15U
+
+// 32 byte entries free in a default nvs partition, one page is kept spare
+#define PREF_ENTRIES (4U * 126U)
+
+enum PreferenceType {
+	PT_I8, PT_U8, PT_I16, PT_U16, PT_I32, PT_U32, PT_I64, PT_U64,
+	PT_STR, PT_BLOB, PT_INVALID
+};
+
+/**
+ * Counters of work done by the preferences store
+ */
+struct PreferencesStats {
+	uint32_t puts;
+	uint32_t gets;
+	uint32_t bytesWritten;
+};
+
+class Preferences {
+	public:
+		Preferences(void);
+		~Preferences(void);
+
+		/**
+		 * Opens a namespace
+		 *
+		 * @param name namespace of at most PREF_KEY_MAX characters
+		 * @param readOnly if puts and removes are refused
+		 * @param partition_label ignored on the host
+		 *
+		 * @return if the namespace was opened
+		 */
+		bool begin(const char *name, bool readOnly = false, const char *partition_label = NULL);
+		void end(void);
+
+		bool clear(void);
+		bool remove(const char *key);
+
+		size_t putChar(const char *key, int8_t value);
+		size_t putUChar(const char *key, uint8_t value);
+		size_t putShort(const char *key, int16_t value);
+		size_t putUShort(const char *key, uint16_t value);
+		size_t putInt(const char *key, int32_t value);
+		size_t putUInt(const char *key, uint32_t value);
+		size_t putLong(const char *key, int32_t value);
+		size_t putULong(const char *key, uint32_t value);
+		size_t putLong64(const char *key, int64_t value);
+		size_t putULong64(const char *key, uint64_t value);
+		size_t putFloat(const char *key, float value);
+		size_t putDouble(const char *key, double value);
+		size_t putBool(const char *key, bool value);
+		size_t putString(const char *key, const char *value);
+		size_t putString(const char *key, const String &value);
+		size_t putBytes(const char *key, const void *value, size_t len);
+
+		bool isKey(const char *key);
+		PreferenceType getType(const char *key);
+
+		int8_t getChar(const char *key, int8_t defaultValue = 0);
+		uint8_t getUChar(const char *key, uint8_t defaultValue = 0);
+		int16_t getShort(const char *key, int16_t defaultValue = 0);
+		uint16_t getUShort(const char *key, uint16_t defaultValue = 0);
+		int32_t getInt(const char *key, int32_t defaultValue = 0);
+		uint32_t getUInt(const char *key, uint32_t defaultValue = 0);
+		int32_t getLong(const char *key, int32_t defaultValue = 0);
+		uint32_t getULong(const char *key, uint32_t defaultValue = 0);
+		int64_t getLong64(const char *key, int64_t defaultValue = 0);
+		uint64_t getULong64(const char *key, uint64_t defaultValue = 0);
+		float getFloat(const char *key, float defaultValue = NAN);
+		double getDouble(const char *key, double defaultValue = NAN);
+		bool getBool(const char *key, bool defaultValue = false);
+
+		/**
+		 * Reads a string with its terminator
+		 *
+		 * @param key key to read
+		 * @param value buffer to read into
+		 * @param maxLen size of the buffer
+		 *
+		 * @return length read including the terminator, 0 if it didn't fit
+		 */
+		size_t getString(const char *key, char *value, size_t maxLen);
+		String getString(const char *key, const String &defaultValue = String());
+
+		size_t getBytesLength(const char *key);
+
+		/**
+		 * Reads a blob
+		 *
+		 * @param key key to read
+		 * @param buf buffer to read into
+		 * @param maxLen size of the buffer
+		 *
+		 * @return length read, 0 if it didn't fit
+		 */
+		size_t getBytes(const char *key, void *buf, size_t maxLen);
+
+		size_t freeEntries(void);
+
+		/**
+		 * Gets the counters of every namespace
+		 *
+		 * @return counters since the last resetStats()
+		 */
+		static const PreferencesStats &stats(void);
+		static void resetStats(void);
+
+		/**
+		 * Drops every namespace, like erasing the nvs partition
+		 */
+		static void erase(void);
+
+	private:
+		bool opened;
+		bool readOnly;
+		char space[PREF_KEY_MAX + 1U];
+
+		size_t put(const char *key, PreferenceType type, const void *value, size_t len);
+		size_t get(const char *key, PreferenceType type, void *value, size_t maxLen);
+};
+
+#endif
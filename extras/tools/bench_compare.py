@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+#
+#	bench_compare.py - compares two core_bench result files
+#	Copyright (C) 2025 Camren Chraplak
+#
+#	This program is free software: you can redistribute it and/or modify
+#	it under the terms of the GNU General Public License as published by
+#	the Free Software Foundation, either version 3 of the License, or
+#	(at your option) any later version.
+#
+#	This program is distributed in the hope that it will be useful,
+#	but WITHOUT ANY WARRANTY; without even the implied warranty of
+#	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#	GNU General Public License for more details.
+#
+#	You should have received a copy of the GNU General Public License
+#	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+"""
+Compares the results of two core_bench runs and fails when a case
+got slower than the threshold.
+
+  bench_compare.py baseline.json current.json [-t percent]
+
+Both files come from 'core_bench -j', usually the baseline from the
+main branch and the current from a change, built with the same
+options. Cases only in one of the files are listed but never fail.
+Host timings move a few percent between runs, keep the threshold
+above that or run core_bench with more repeats.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+	with open(path, encoding="utf-8") as file:
+		return json.load(file)
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+	parser.add_argument("baseline")
+	parser.add_argument("current")
+	parser.add_argument("-t", "--threshold", type=float, default=10.0,
+		help="percent slower that counts as a regression, default 10")
+	args = parser.parse_args()
+
+	baseline = load(args.baseline)
+	current = load(args.current)
+
+	if baseline["config"] != current["config"]:
+		print("warning: builds differ\n  baseline: %s\n  current:  %s" % (baseline["config"], current["config"]))
+
+	regressions = 0
+	print("%-24s %12s %12s %9s" % ("case", "base ns/op", "ns/op", "change"))
+	for name, result in current["results"].items():
+		base = baseline["results"].get(name)
+		if base is None:
+			print("%-24s %12s %12.2f %9s" % (name, "-", result["ns"], "new"))
+			continue
+
+		change = (result["ns"] - base["ns"]) * 100.0 / base["ns"] if base["ns"] else 0.0
+		flag = ""
+		if change > args.threshold:
+			flag = "  slower"
+			regressions += 1
+		elif change < -args.threshold:
+			flag = "  faster"
+		print("%-24s %12.2f %12.2f %+8.1f%%%s" % (name, base["ns"], result["ns"], change, flag))
+
+	for name in baseline["results"]:
+		if name not in current["results"]:
+			print("%-24s %12.2f %12s %9s" % (name, baseline["results"][name]["ns"], "-", "gone"))
+
+	if regressions:
+		print("%d case(s) more than %.0f%% slower" % (regressions, args.threshold))
+		return 1
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
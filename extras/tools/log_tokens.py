@@ -0,0 +1,300 @@
+#!/usr/bin/env python3
+#
+#	log_tokens.py - builds the log token dictionary and decodes log frames
+#	Copyright (C) 2025 Camren Chraplak
+#
+#	This program is free software: you can redistribute it and/or modify
+#	it under the terms of the GNU General Public License as published by
+#	the Free Software Foundation, either version 3 of the License, or
+#	(at your option) any later version.
+#
+#	This program is distributed in the hope that it will be useful,
+#	but WITHOUT ANY WARRANTY; without even the implied warranty of
+#	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#	GNU General Public License for more details.
+#
+#	You should have received a copy of the GNU General Public License
+#	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+"""
+Tokenized logging support for builds with DEBUG_TOKENIZED.
+
+  log_tokens.py dict [src dirs or files] [-o tokens.json]
+      scans the LOG_ and TRACE_ sites and writes the token ->
+      tag and format dictionary, trace names get the tag "trace"
+
+  log_tokens.py decode tokens.json [capture file, default stdin]
+      turns log frames back into '[tag]:text' lines, bytes that
+      aren't frames (sample data, plain prints) are passed through
+
+A frame is sync 0xA5, token (u32 LE), payload length (u8), the
+payload of typed arguments and a crc-8 (poly 0x07) over everything
+after the sync byte. See src/debug.h.
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+
+FRAME_SYNC = 0xA5
+FRAME_HEADER = 6
+
+# DebugArgType in src/debug.h, struct format of each type
+ARG_FORMATS = {
+	1: "?",
+	2: "b", 3: "B",
+	4: "h", 5: "H",
+	6: "i", 7: "I",
+	8: "q", 9: "Q",
+	10: "f", 11: "d",
+}
+ARG_FLOATS = (10, 11)
+ARG_STRING = 12
+
+# log macros with a fixed category
+SITE_CATEGORIES = {"LOG_NVM": "NVM", "LOG_ERROR": "ERR"}
+
+SITE = re.compile(r'\b(LOG_NVM|LOG_ERROR|LOG_TAG|LOG_[EWIT])\s*\(')
+CATEGORY = re.compile(r'\s*(\w+)\s*,')
+TRACE_SITE = re.compile(r'\b(?:TRACE_SCOPE|TRACE_BEGIN_SITE|TRACE_END_SITE)\s*\(')
+TRACE_TAG = "trace"
+CATEGORY_TAG = re.compile(r'#define\s+DEBUG_TAG_(\w+)\s+"((?:[^"\\]|\\.)*)"')
+LITERAL = re.compile(r'\s*"((?:[^"\\]|\\.)*)"')
+ESCAPES = {"n": "\n", "t": "\t", "r": "\r", "0": "\0", "\\": "\\", '"': '"', "'": "'"}
+
+
+def fnv1a(text):
+	value = 2166136261
+	for byte in text.encode("utf-8"):
+		value = ((value ^ byte) * 16777619) & 0xFFFFFFFF
+	return value
+
+
+def unescape(literal):
+	return re.sub(r"\\(.)", lambda match: ESCAPES.get(match.group(1), match.group(1)), literal)
+
+
+def read_literals(source, position):
+	"""Reads adjacent string literals, returns the text and the end position"""
+	text = ""
+	while True:
+		match = LITERAL.match(source, position)
+		if not match:
+			return text, position
+		text += unescape(match.group(1))
+		position = match.end()
+
+
+def read_sources(src_dirs):
+	sources = []
+	for src_dir in src_dirs:
+		if os.path.isfile(src_dir):
+			with open(src_dir, encoding="utf-8") as file:
+				sources.append((os.path.relpath(src_dir), file.read()))
+			continue
+		for root, _, files in os.walk(src_dir):
+			for name in sorted(files):
+				if name.endswith((".c", ".cpp", ".h", ".ino")):
+					path = os.path.join(root, name)
+					with open(path, encoding="utf-8") as file:
+						sources.append((os.path.relpath(path), file.read()))
+	return sources
+
+
+def scan_sites(src_dirs):
+	sources = read_sources(src_dirs)
+	tags = {}
+	for _, source in sources:
+		for match in CATEGORY_TAG.finditer(source):
+			tags[match.group(1)] = unescape(match.group(2))
+
+	sites = []
+	for path, source in sources:
+		for match in SITE.finditer(source):
+			position = match.end()
+			macro = match.group(1)
+
+			if macro == "LOG_TAG":
+				tag, position = read_literals(source, position)
+				comma = re.match(r"\s*,", source[position:])
+				if not tag or not comma:
+					continue
+				position += comma.end()
+			else:
+				category = SITE_CATEGORIES.get(macro)
+				if category is None:
+					found = CATEGORY.match(source, position)
+					if not found:
+						continue
+					category = found.group(1)
+					position = found.end()
+				if category not in tags:
+					# the macro definitions themselves
+					continue
+				tag = tags[category]
+
+			text, _ = read_literals(source, position)
+			if not text and macro != "LOG_TAG":
+				continue
+
+			line = source.count("\n", 0, match.start()) + 1
+			sites.append((tag, text, "%s:%d" % (path, line)))
+
+		for match in TRACE_SITE.finditer(source):
+			name, _ = read_literals(source, match.end())
+			if name:
+				line = source.count("\n", 0, match.start()) + 1
+				sites.append((TRACE_TAG, name, "%s:%d" % (path, line)))
+	return sites
+
+
+def build_dictionary(args):
+	tokens = {}
+	collisions = 0
+
+	for tag, text, where in scan_sites(args.src):
+		token = "%08x" % fnv1a(tag + "|" + text)
+		entry = tokens.get(token)
+		if entry and (entry["tag"], entry["format"]) != (tag, text):
+			print("collision %s: %s and %s" % (token, entry["sites"][0], where), file=sys.stderr)
+			collisions += 1
+			continue
+		if not entry:
+			entry = tokens[token] = {"tag": tag, "format": text, "sites": []}
+		entry["sites"].append(where)
+
+	with open(args.output, "w", encoding="utf-8") as file:
+		json.dump(tokens, file, indent=1, sort_keys=True)
+
+	print("%d log sites, %d tokens written to %s" % (
+		sum(len(entry["sites"]) for entry in tokens.values()), len(tokens), args.output))
+	return 1 if collisions else 0
+
+
+def crc8(data):
+	crc = 0
+	for byte in data:
+		crc ^= byte
+		for _ in range(8):
+			crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+	return crc
+
+
+def parse_args(payload):
+	values = []
+	position = 0
+	while position < len(payload):
+		arg_type = payload[position]
+		position += 1
+
+		if arg_type == ARG_STRING:
+			size = payload[position]
+			text = payload[position + 1:position + 1 + size].decode("utf-8", "replace")
+			values.append(text)
+			position += 1 + size
+			continue
+
+		code = ARG_FORMATS.get(arg_type)
+		if code is None:
+			raise ValueError("unknown argument type %d" % arg_type)
+		size = struct.calcsize("<" + code)
+		value = struct.unpack_from("<" + code, payload, position)[0]
+		position += size
+
+		if arg_type in ARG_FLOATS:
+			# Serial.print() of a float shows 2 decimals
+			values.append("%.2f" % value)
+		elif arg_type == 1:
+			values.append("1" if value else "0")
+		else:
+			values.append(str(value))
+	return values
+
+
+def format_line(entry, values):
+	parts = entry["format"].split("{}")
+	text = parts[0]
+	for index, part in enumerate(parts[1:]):
+		text += (values[index] if index < len(values) else "?") + part
+	return "[%s]:%s\n" % (entry["tag"], text)
+
+
+def decode_frames(data, tokens, out):
+	"""Decodes a capture, returns the bytes left for more data"""
+	position = 0
+	while position < len(data):
+		sync = data.find(bytes([FRAME_SYNC]), position)
+		if sync < 0:
+			out.write(data[position:])
+			return b""
+		out.write(data[position:sync])
+
+		if sync + FRAME_HEADER > len(data):
+			return data[sync:]
+		length = data[sync + 5]
+		end = sync + FRAME_HEADER + length + 1
+		if end > len(data):
+			return data[sync:]
+
+		frame = data[sync:end]
+		token = "%08x" % struct.unpack_from("<I", frame, 1)[0]
+		if crc8(frame[1:-1]) != frame[-1]:
+			# not a frame, the sync byte was data
+			out.write(data[sync:sync + 1])
+			position = sync + 1
+			continue
+
+		entry = tokens.get(token)
+		if entry is None:
+			out.write(("[?]:unknown token %s\n" % token).encode())
+		else:
+			try:
+				out.write(format_line(entry, parse_args(frame[FRAME_HEADER:-1])).encode("utf-8"))
+			except (ValueError, struct.error, IndexError) as error:
+				out.write(("[?]:bad arguments for %s: %s\n" % (token, error)).encode())
+		position = end
+	return b""
+
+
+def decode(args):
+	with open(args.tokens, encoding="utf-8") as file:
+		tokens = json.load(file)
+
+	source = open(args.capture, "rb") if args.capture != "-" else sys.stdin.buffer
+	out = sys.stdout.buffer
+	pending = b""
+
+	while True:
+		chunk = source.read1(4096) if hasattr(source, "read1") else source.read(4096)
+		if not chunk:
+			break
+		pending = decode_frames(pending + chunk, tokens, out)
+		out.flush()
+
+	out.write(pending)
+	return 0
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+	commands = parser.add_subparsers(dest="command", required=True)
+
+	build = commands.add_parser("dict", help="build the token dictionary from the sources")
+	build.add_argument("src", nargs="*", default=[os.path.join(os.path.dirname(__file__), "..", "..", "src")])
+	build.add_argument("-o", "--output", default="tokens.json")
+	build.set_defaults(run=build_dictionary)
+
+	read = commands.add_parser("decode", help="decode a capture of the serial port")
+	read.add_argument("tokens")
+	read.add_argument("capture", nargs="?", default="-")
+	read.set_defaults(run=decode)
+
+	args = parser.parse_args()
+	return args.run(args)
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+#
+#	trace_to_chrome.py - converts a traceDump() capture to a Chrome trace
+#	Copyright (C) 2025 Camren Chraplak
+#
+#	This program is free software: you can redistribute it and/or modify
+#	it under the terms of the GNU General Public License as published by
+#	the Free Software Foundation, either version 3 of the License, or
+#	(at your option) any later version.
+#
+#	This program is distributed in the hope that it will be useful,
+#	but WITHOUT ANY WARRANTY; without even the implied warranty of
+#	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#	GNU General Public License for more details.
+#
+#	You should have received a copy of the GNU General Public License
+#	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+"""
+Converts the capture of a traceDump() into Chrome trace event JSON,
+which loads in chrome://tracing and https://ui.perfetto.dev, and
+prints how much time each traced scope took.
+
+  trace_to_chrome.py tokens.json capture.bin [-o trace.json]
+
+tokens.json comes from 'log_tokens.py dict src' and names the sites.
+The capture can hold other serial output around the dump, the last
+dump in it is converted.
+
+A dump is "TRC1", ticks per ms (u32), events recorded (u32), events
+in the dump (u16) and that many events of time (u32), site (u16),
+phase 'B' or 'E' (u8) and track (u8), all little endian. See src/trace.h.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+DUMP_MAGIC = b"TRC1"
+HEADER = struct.Struct("<4sIIH")
+EVENT = struct.Struct("<IHBB")
+
+
+def trace_site(token):
+	"""Folds a 32 bit token to the 16 bit site id, same as traceSite()"""
+	return (token ^ (token >> 16)) & 0xFFFF
+
+
+def load_names(path):
+	with open(path, encoding="utf-8") as file:
+		tokens = json.load(file)
+	names = {}
+	for token, entry in tokens.items():
+		if entry["tag"] == "trace":
+			names[trace_site(int(token, 16))] = entry["format"]
+	return names
+
+
+def read_dump(data):
+	start = data.rfind(DUMP_MAGIC)
+	if start < 0:
+		raise ValueError("no trace dump in the capture")
+
+	_, ticks_per_ms, recorded, count = HEADER.unpack_from(data, start)
+	position = start + HEADER.size
+	if position + count * EVENT.size > len(data):
+		raise ValueError("trace dump is cut short")
+
+	events = [EVENT.unpack_from(data, position + i * EVENT.size) for i in range(count)]
+	return ticks_per_ms, recorded, events
+
+
+def convert(ticks_per_ms, events, names):
+	"""Builds the trace events and the time spent in each scope"""
+	trace = []
+	totals = {}
+	stacks = {}
+	last = None
+	ticks = 0
+
+	for time, site, phase, track in events:
+		# the clock wraps at 32 bits, events are in record order, a
+		# small step back between tracks isn't taken for a wrap
+		if last is not None:
+			step = (time - last) & 0xFFFFFFFF
+			ticks += step - (1 << 32) if step >= 1 << 31 else step
+		last = time
+		# times start at the first event
+		micros = ticks * 1000.0 / ticks_per_ms
+
+		name = names.get(site, "site 0x%04x" % site)
+		stack = stacks.setdefault(track, [])
+
+		if phase == ord("B"):
+			stack.append((name, micros))
+		elif phase == ord("E"):
+			if not stack or stack[-1][0] != name:
+				# its begin was overwritten in the ring
+				continue
+			_, begin = stack.pop()
+			total = totals.setdefault(name, [0, 0.0, 0.0])
+			total[0] += 1
+			total[1] += micros - begin
+			total[2] = max(total[2], micros - begin)
+		else:
+			continue
+
+		trace.append({
+			"name": name,
+			"ph": chr(phase),
+			"ts": micros,
+			"pid": 0,
+			"tid": track,
+		})
+
+	return trace, totals
+
+
+def main():
+	parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+	parser.add_argument("tokens")
+	parser.add_argument("capture", nargs="?", default="-")
+	parser.add_argument("-o", "--output", default="trace.json")
+	args = parser.parse_args()
+
+	names = load_names(args.tokens)
+	if args.capture == "-":
+		data = sys.stdin.buffer.read()
+	else:
+		with open(args.capture, "rb") as file:
+			data = file.read()
+
+	try:
+		ticks_per_ms, recorded, events = read_dump(data)
+	except ValueError as error:
+		print(error, file=sys.stderr)
+		return 1
+
+	trace, totals = convert(ticks_per_ms, events, names)
+	with open(args.output, "w", encoding="utf-8") as file:
+		json.dump({"traceEvents": trace, "displayTimeUnit": "ns"}, file)
+
+	print("%d of %d recorded events written to %s" % (len(events), recorded, args.output))
+	print("%-24s %8s %12s %10s %10s" % ("scope", "count", "total us", "mean us", "max us"))
+	for name, (count, total, longest) in sorted(totals.items(), key=lambda item: -item[1][1]):
+		print("%-24s %8d %12.1f %10.2f %10.2f" % (name, count, total, total / count, longest))
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,166 @@
+/*
+	acq_avr.cpp - timer triggered ADC acquisition on the Uno
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "acquisition.h"
+
+#if defined(UNOR3)
+
+/****************************
+ * AVR Acquisition
+ *
+ * Timer1 compare B starts each conversion, so the rate
+ * doesn't drift with interrupt latency, and the ADC
+ * interrupt stores the result. The ATmega328P has no DMA,
+ * the interrupt is the only work per sample. Timer1 is
+ * taken while acquiring, which stops analogWrite() on
+ * pins 9 and 10 and the Servo library.
+****************************/
+
+// ADC clocks of a timer triggered conversion, rounded up from 13.5
+#define AVR_CONVERSION_CLOCKS 14UL
+
+// CPU cycles the interrupt needs to switch channels before the next trigger
+#define AVR_ISR_CYCLES 80UL
+
+// AVcc reference, as analogRead() uses by default
+#define AVR_ADMUX_BASE _BV(REFS0)
+
+SampleWord *avrFill = NULL;
+uint16_t avrPosition = 0U;
+uint16_t avrSamples = 0U;
+
+// ADMUX of each channel in turn, only read when there is more than one
+uint8_t avrMux[Board::adcChannels];
+uint8_t avrMuxCount = 0U;
+uint8_t avrMuxNext = 0U;
+
+ISR(ADC_vect) {
+	SampleWord sample = ADC;
+
+	// the trigger is the flag rising, clear it for the next match
+	TIFR1 = _BV(OCF1B);
+
+	if (avrMuxCount > 1U) {
+		// takes effect at the next trigger
+		ADMUX = avrMux[avrMuxNext];
+		avrMuxNext = (uint8_t)(avrMuxNext + 1U == avrMuxCount ? 0U : avrMuxNext + 1U);
+	}
+
+	avrFill[avrPosition] = sample;
+	if (++avrPosition == avrSamples) {
+		avrPosition = 0U;
+		acqBufferDone();
+		avrFill = acqFillBuffer();
+	}
+}
+
+/**
+ * Gets the ADC prescaler bits of the slowest ADC clock
+ * that finishes a conversion within a period, a slower
+ * clock converts more accurately
+ *
+ * @param period CPU cycles between triggers
+ *
+ * @return ADPS bits
+ */
+uint8_t avrAdcPrescaler(uint32_t period) {
+	uint8_t bits = 7U;
+	for (uint32_t divider = 128UL; divider > 16UL; divider >>= 1U, bits--) {
+		if (divider * AVR_CONVERSION_CLOCKS <= period) {
+			break;
+		}
+	}
+	return bits;
+}
+
+/****************************
+ * Backend Methods
+****************************/
+
+uint32_t acqBackendStart(uint32_t conversionRate, uint8_t channels, uint16_t bufferSamples) {
+	avrMuxCount = 0U;
+	for (uint8_t channel = 0U; channel < Board::adcChannels; channel++) {
+		if (channels & (1U << channel)) {
+			avrMux[avrMuxCount++] = (uint8_t)(AVR_ADMUX_BASE | channel);
+		}
+	}
+
+	// the channel has to change before the next trigger
+	uint32_t minPeriod = 16UL * AVR_CONVERSION_CLOCKS;
+	if (avrMuxCount > 1U) {
+		minPeriod += AVR_ISR_CYCLES;
+	}
+
+	uint32_t period = F_CPU / conversionRate;
+	if (period < minPeriod) {
+		period = minPeriod;
+	}
+
+	uint8_t timerClock = _BV(CS10);
+	uint32_t timerDivider = 1UL;
+	if (period > 65536UL) {
+		timerClock = _BV(CS11);
+		timerDivider = 8UL;
+	}
+	uint16_t top = (uint16_t)(period / timerDivider - 1UL);
+
+	avrFill = acqFillBuffer();
+	avrPosition = 0U;
+	avrSamples = bufferSamples;
+	avrMuxNext = avrMuxCount > 1U ? 1U : 0U;
+
+	uint8_t state = SREG;
+	cli();
+
+	// CTC on OCR1A, compare B at the top triggers the ADC
+	TCCR1A = 0U;
+	TCCR1B = 0U;
+	TCNT1 = 0U;
+	OCR1A = top;
+	OCR1B = top;
+	TIMSK1 = 0U;
+	TIFR1 = _BV(OCF1B);
+
+	DIDR0 = (uint8_t)(channels & 0x3FU);
+	ADMUX = avrMux[0];
+	ADCSRB = _BV(ADTS2) | _BV(ADTS0);
+	ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIF) | _BV(ADIE) | avrAdcPrescaler(period);
+
+	TCCR1B = _BV(WGM12) | timerClock;
+
+	SREG = state;
+	return F_CPU / (timerDivider * ((uint32_t)top + 1UL));
+}
+
+void acqBackendStop(void) {
+	uint8_t state = SREG;
+	cli();
+
+	TCCR1B = 0U;
+	ADCSRB = 0U;
+	DIDR0 = 0U;
+
+	// back to how init() leaves it for analogRead()
+	ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+
+	SREG = state;
+}
+
+void acqBackendPoll(void) {}
+
+#endif
@@ -0,0 +1,178 @@
+/*
+	acq_esp32.cpp - continuous DMA ADC acquisition on the ESP32
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "acquisition.h"
+
+#if defined(ESP32DEVC)
+
+#include <esp_adc/adc_continuous.h>
+
+/****************************
+ * ESP32 Acquisition
+ *
+ * The continuous ADC driver runs ADC1 through I2S DMA
+ * into a pool it owns, one interrupt per frame. The loop
+ * reads the pool straight into the buffers in
+ * acqBackendPoll(), then clears the channel number the
+ * ESP32 puts in the top bits of every sample.
+ *
+ * The driver can't convert slower than 20 kS/s over all
+ * channels, slower rates run at that minimum.
+****************************/
+
+// samples per DMA frame before rounding to whole sample sets
+#define ESP_FRAME_SAMPLES 256U
+
+// buffers of samples the driver's pool can hold while the loop is busy
+#define ESP_POOL_BUFFERS 2U
+
+// bits of a sample, the channel number sits above
+#define ESP_SAMPLE_MASK 0x0FFFU
+#define ESP_CHANNEL_SHIFT 12U
+
+adc_continuous_handle_t espHandle = NULL;
+uint16_t espSamples = 0U;
+uint16_t espPosition = 0U;
+uint8_t espFirstChannel = 0U;
+bool espResync = false;
+
+volatile uint32_t espOverflows = 0UL;
+uint32_t espOverflowsSeen = 0UL;
+
+bool IRAM_ATTR espPoolOverflow(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *edata, void *userData) {
+	espOverflows++;
+	return false;
+}
+
+/****************************
+ * Backend Methods
+****************************/
+
+uint32_t acqBackendStart(uint32_t conversionRate, uint8_t channels, uint16_t bufferSamples) {
+	adc_digi_pattern_config_t pattern[Board::adcChannels];
+	uint8_t count = 0U;
+	for (uint8_t channel = 0U; channel < Board::adcChannels; channel++) {
+		if (channels & (1U << channel)) {
+			pattern[count].atten = ADC_ATTEN_DB_12;
+			pattern[count].channel = channel;
+			pattern[count].unit = ADC_UNIT_1;
+			pattern[count].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+			if (count == 0U) {
+				espFirstChannel = channel;
+			}
+			count++;
+		}
+	}
+
+	// frames of whole sample sets, in the driver's 4 byte steps
+	uint16_t step = (count & 1U) ? (uint16_t)(count * 2U) : count;
+	uint16_t frameSamples = (uint16_t)(ESP_FRAME_SAMPLES - ESP_FRAME_SAMPLES % step);
+
+	adc_continuous_handle_cfg_t handleConfig = {};
+	handleConfig.max_store_buf_size = (uint32_t)bufferSamples * ESP_POOL_BUFFERS * SOC_ADC_DIGI_RESULT_BYTES;
+	handleConfig.conv_frame_size = (uint32_t)frameSamples * SOC_ADC_DIGI_RESULT_BYTES;
+	if (adc_continuous_new_handle(&handleConfig, &espHandle) != ESP_OK) {
+		espHandle = NULL;
+		return 0UL;
+	}
+
+	if (conversionRate < SOC_ADC_SAMPLE_FREQ_THRES_LOW) {
+		conversionRate = SOC_ADC_SAMPLE_FREQ_THRES_LOW;
+	}
+
+	adc_continuous_config_t config = {};
+	config.pattern_num = count;
+	config.adc_pattern = pattern;
+	config.sample_freq_hz = conversionRate;
+	config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+	config.format = ADC_DIGI_OUTPUT_FORMAT_TYPE1;
+
+	adc_continuous_evt_cbs_t callbacks = {};
+	callbacks.on_pool_ovf = espPoolOverflow;
+
+	if (adc_continuous_config(espHandle, &config) != ESP_OK ||
+		adc_continuous_register_event_callbacks(espHandle, &callbacks, NULL) != ESP_OK ||
+		adc_continuous_start(espHandle) != ESP_OK) {
+
+		adc_continuous_deinit(espHandle);
+		espHandle = NULL;
+		return 0UL;
+	}
+
+	espSamples = bufferSamples;
+	espPosition = 0U;
+	espResync = false;
+	espOverflowsSeen = espOverflows;
+	return conversionRate;
+}
+
+void acqBackendStop(void) {
+	if (espHandle != NULL) {
+		adc_continuous_stop(espHandle);
+		adc_continuous_deinit(espHandle);
+		espHandle = NULL;
+	}
+}
+
+void acqBackendPoll(void) {
+	// frames were dropped, start again at the first channel
+	uint32_t overflows = espOverflows;
+	if (overflows != espOverflowsSeen) {
+		espOverflowsSeen = overflows;
+		espPosition = 0U;
+		espResync = true;
+		acqBufferDropped();
+	}
+
+	while (true) {
+		SampleWord *buffer = acqFillBuffer();
+		uint32_t bytes = 0UL;
+		if (adc_continuous_read(espHandle, (uint8_t*)&buffer[espPosition],
+			(uint32_t)(espSamples - espPosition) * sizeof(SampleWord), &bytes, 0U) != ESP_OK) {
+			return;
+		}
+
+		uint16_t start = espPosition;
+		uint16_t end = (uint16_t)(start + bytes / sizeof(SampleWord));
+
+		if (espResync) {
+			uint16_t first = start;
+			while (first < end && (buffer[first] >> ESP_CHANNEL_SHIFT) != espFirstChannel) {
+				first++;
+			}
+			if (first == end) {
+				continue;
+			}
+			memmove(&buffer[start], &buffer[first], (end - first) * sizeof(SampleWord));
+			end = (uint16_t)(end - (first - start));
+			espResync = false;
+		}
+
+		for (uint16_t i = start; i < end; i++) {
+			buffer[i] &= ESP_SAMPLE_MASK;
+		}
+
+		espPosition = end;
+		if (espPosition == espSamples) {
+			espPosition = 0U;
+			acqBufferDone();
+		}
+	}
+}
+
+#endif
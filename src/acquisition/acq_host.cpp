@@ -0,0 +1,171 @@
+/*
+	acq_host.cpp - synthetic ADC source for the Linux host
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "acq_host.h"
+
+#ifdef HOSTLINUX
+
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#define ACQ_HOST_FULL_SCALE ((float)((1UL << Board::adcBits) - 1UL))
+
+AcqHostSignal acqHostSignals[Board::adcChannels];
+bool acqHostSignalsSet = false;
+std::mutex acqHostMutex;
+
+std::thread acqHostWorker;
+std::atomic<bool> acqHostRunning(false);
+
+uint32_t acqHostRate = 0UL;
+uint8_t acqHostChannels = 0U;
+uint16_t acqHostSamples = 0U;
+
+/**
+ * Sets every channel to its starting sine
+ */
+void acqHostDefaults(void) {
+	for (uint8_t channel = 0U; channel < Board::adcChannels; channel++) {
+		acqHostSignals[channel].wave = ACQ_WAVE_SINE;
+		acqHostSignals[channel].frequency = 50.0f * (float)(channel + 1U);
+		acqHostSignals[channel].amplitude = 0.4f;
+		acqHostSignals[channel].offset = 0.5f;
+	}
+	acqHostSignalsSet = true;
+}
+
+/**
+ * Gets a level of a wave
+ *
+ * @param wave wave to generate
+ * @param phase place in the period, 0 to 1
+ * @param noise state of the noise generator
+ *
+ * @return level from -1 to 1
+ */
+float acqHostWaveLevel(enum AcqHostWave wave, double phase, uint32_t *noise) {
+	switch (wave) {
+		case ACQ_WAVE_SINE:
+			return (float)sin(phase * 2.0 * M_PI);
+		case ACQ_WAVE_SQUARE:
+			return phase < 0.5 ? 1.0f : -1.0f;
+		case ACQ_WAVE_TRIANGLE:
+			return (float)(phase < 0.5 ? phase * 4.0 - 1.0 : 3.0 - phase * 4.0);
+		case ACQ_WAVE_NOISE:
+			// xorshift32
+			*noise ^= *noise << 13;
+			*noise ^= *noise >> 17;
+			*noise ^= *noise << 5;
+			return (float)*noise / 2147483648.0f - 1.0f;
+		default:
+			return 0.0f;
+	}
+}
+
+/**
+ * Fills buffers until stopped, like the ADC and DMA would
+ */
+void acqHostLoop(void) {
+	uint8_t order[Board::adcChannels];
+	uint8_t count = 0U;
+	for (uint8_t channel = 0U; channel < Board::adcChannels; channel++) {
+		if (acqHostChannels & (1U << channel)) {
+			order[count++] = channel;
+		}
+	}
+
+	double phases[Board::adcChannels] = {0.0};
+	uint32_t noise = 0x12345678UL;
+	double channelRate = (double)acqHostRate / count;
+	std::chrono::nanoseconds bufferTime(
+		(int64_t)((double)acqHostSamples * 1e9 / acqHostRate));
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now();
+
+	while (acqHostRunning.load(std::memory_order_relaxed)) {
+		AcqHostSignal signals[Board::adcChannels];
+		{
+			std::lock_guard<std::mutex> lock(acqHostMutex);
+			memcpy(signals, acqHostSignals, sizeof(signals));
+		}
+
+		SampleWord *buffer = acqFillBuffer();
+		for (uint16_t i = 0U; i < acqHostSamples; i += count) {
+			for (uint8_t slot = 0U; slot < count; slot++) {
+				uint8_t channel = order[slot];
+				const AcqHostSignal &signal = signals[channel];
+
+				float level = signal.offset + signal.amplitude * acqHostWaveLevel(signal.wave, phases[channel], &noise);
+				level = level < 0.0f ? 0.0f : (level > 1.0f ? 1.0f : level);
+				buffer[i + slot] = (SampleWord)(level * ACQ_HOST_FULL_SCALE + 0.5f);
+
+				phases[channel] += signal.frequency / channelRate;
+				phases[channel] -= floor(phases[channel]);
+			}
+		}
+
+		deadline += bufferTime;
+		std::this_thread::sleep_until(deadline);
+		acqBufferDone();
+	}
+}
+
+bool acqHostSetSignal(uint8_t channel, const AcqHostSignal &signal) {
+	if (channel >= Board::adcChannels) {
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(acqHostMutex);
+	if (!acqHostSignalsSet) {
+		acqHostDefaults();
+	}
+	acqHostSignals[channel] = signal;
+	return true;
+}
+
+/****************************
+ * Backend Methods
+****************************/
+
+uint32_t acqBackendStart(uint32_t conversionRate, uint8_t channels, uint16_t bufferSamples) {
+	{
+		std::lock_guard<std::mutex> lock(acqHostMutex);
+		if (!acqHostSignalsSet) {
+			acqHostDefaults();
+		}
+	}
+
+	acqHostRate = conversionRate;
+	acqHostChannels = channels;
+	acqHostSamples = bufferSamples;
+
+	acqHostRunning = true;
+	acqHostWorker = std::thread(acqHostLoop);
+	return conversionRate;
+}
+
+void acqBackendStop(void) {
+	acqHostRunning = false;
+	acqHostWorker.join();
+}
+
+void acqBackendPoll(void) {}
+
+#endif
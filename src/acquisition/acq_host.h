@@ -0,0 +1,63 @@
+/*
+	acq_host.h - synthetic ADC source for the Linux host
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "../compile_flags.h"
+
+#ifndef ACQHOST_H
+#define ACQHOST_H
+
+#ifdef HOSTLINUX
+
+#include <Arduino.h>
+#include "acquisition.h"
+
+/****************************
+ * Synthetic Source
+ *
+ * A thread stands in for the ADC and its DMA, filling
+ * each buffer with a generated signal per channel and
+ * queueing it when the buffer would have been converted.
+ * Like the ADC it never waits for the loop.
+****************************/
+
+enum AcqHostWave {ACQ_WAVE_DC, ACQ_WAVE_SINE, ACQ_WAVE_SQUARE, ACQ_WAVE_TRIANGLE, ACQ_WAVE_NOISE};
+
+/**
+ * Signal on one channel, levels are fractions of full scale
+ */
+struct AcqHostSignal {
+	enum AcqHostWave wave;
+	float frequency; // Hz
+	float amplitude; // peak, 0.5 spans the whole range
+	float offset; // middle level
+};
+
+/**
+ * Sets the signal of a channel, takes effect from the
+ * next buffer. Channels start as sines of 50 Hz times
+ * the channel number plus one
+ *
+ * @param channel channel 0 to Board::adcChannels - 1
+ * @param signal signal to generate
+ *
+ * @return if channel exists
+ */
+bool acqHostSetSignal(uint8_t channel, const AcqHostSignal &signal);
+
+#endif
+#endif
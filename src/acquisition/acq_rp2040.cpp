@@ -0,0 +1,188 @@
+/*
+	acq_rp2040.cpp - ADC FIFO and DMA acquisition on the Pico
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "acquisition.h"
+
+#if defined(PICO)
+
+#include <hardware/adc.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+
+/****************************
+ * RP2040 Acquisition
+ *
+ * The ADC paces itself from its 48 MHz clock and round
+ * robins the channels into its FIFO. A DMA channel per
+ * buffer moves the FIFO into it, and when it finishes
+ * it chains to a control channel that rewinds its write
+ * address and chains on to the next buffer's channel, so
+ * no sample is touched by a core. The rewind can't wait
+ * for the interrupt, which is held off while a flash
+ * sector is erased, far longer than a buffer lasts. The
+ * DMA interrupt only queues the finished buffers.
+****************************/
+
+// ADC clock and the cycles of one conversion
+#define PICO_ADC_CLOCK 48000000UL
+#define PICO_ADC_CYCLES 96UL
+
+// GPIO of ADC channel 0
+#define PICO_ADC_FIRST_PIN 26U
+
+int picoDma[ACQ_BUFFERS];
+int picoControl[ACQ_BUFFERS];
+uint8_t picoNext = 0U;
+
+// start of each buffer, copied into its channel by its control channel
+SampleWord *picoWriteAddr[ACQ_BUFFERS];
+
+/**
+ * Unclaims DMA channels claimed so far
+ *
+ * @param channels channels, negative ones weren't claimed
+ */
+void picoUnclaim(const int *channels) {
+	for (uint8_t i = 0U; i < ACQ_BUFFERS; i++) {
+		if (channels[i] >= 0) {
+			dma_channel_unclaim(channels[i]);
+		}
+	}
+}
+
+/**
+ * Queues every buffer finished since the last interrupt
+ * in the order they were filled
+ */
+void picoDmaIrq(void) {
+	while (dma_channel_get_irq0_status(picoDma[picoNext])) {
+		dma_channel_acknowledge_irq0(picoDma[picoNext]);
+		acqBufferDone();
+
+		picoNext = (uint8_t)((picoNext + 1U) & (ACQ_BUFFERS - 1U));
+	}
+}
+
+/****************************
+ * Backend Methods
+****************************/
+
+uint32_t acqBackendStart(uint32_t conversionRate, uint8_t channels, uint16_t bufferSamples) {
+	adc_init();
+
+	uint8_t first = 0xFFU;
+	for (uint8_t channel = 0U; channel < Board::adcChannels; channel++) {
+		if (channels & (1U << channel)) {
+			adc_gpio_init(PICO_ADC_FIRST_PIN + channel);
+			if (first == 0xFFU) {
+				first = channel;
+			}
+		}
+	}
+	adc_select_input(first);
+	adc_set_round_robin(channels);
+
+	// DREQ on every sample, no error bit so samples stay 12 bits
+	adc_fifo_setup(true, true, 1U, false, false);
+
+	// conversions start every 1 + div cycles, div is 16.8 fixed point
+	uint32_t period = (uint32_t)(((uint64_t)PICO_ADC_CLOCK << 8U) / conversionRate);
+	if (period < (PICO_ADC_CYCLES << 8U)) {
+		period = PICO_ADC_CYCLES << 8U;
+	}
+	adc_set_clkdiv((float)(period - 256UL) / 256.0f);
+
+	bool claimed = true;
+	for (uint8_t i = 0U; i < ACQ_BUFFERS; i++) {
+		picoDma[i] = dma_claim_unused_channel(false);
+		picoControl[i] = dma_claim_unused_channel(false);
+		claimed = claimed && picoDma[i] >= 0 && picoControl[i] >= 0;
+	}
+	if (!claimed) {
+		picoUnclaim(picoDma);
+		picoUnclaim(picoControl);
+		return 0UL;
+	}
+
+	for (uint8_t i = 0U; i < ACQ_BUFFERS; i++) {
+		picoWriteAddr[i] = acqBuffer(i);
+
+		dma_channel_config config = dma_channel_get_default_config(picoDma[i]);
+		channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+		channel_config_set_read_increment(&config, false);
+		channel_config_set_write_increment(&config, true);
+		channel_config_set_dreq(&config, DREQ_ADC);
+		channel_config_set_chain_to(&config, picoControl[i]);
+
+		dma_channel_configure(picoDma[i], &config, acqBuffer(i), &adc_hw->fifo, bufferSamples, false);
+		dma_channel_set_irq0_enabled(picoDma[i], true);
+
+		// the transfer count reloads itself, the address doesn't
+		dma_channel_config control = dma_channel_get_default_config(picoControl[i]);
+		channel_config_set_transfer_data_size(&control, DMA_SIZE_32);
+		channel_config_set_read_increment(&control, false);
+		channel_config_set_write_increment(&control, false);
+		channel_config_set_chain_to(&control, picoDma[(i + 1U) & (ACQ_BUFFERS - 1U)]);
+
+		dma_channel_configure(
+			picoControl[i], &control, &dma_hw->ch[picoDma[i]].write_addr, &picoWriteAddr[i], 1U, false
+		);
+	}
+
+	picoNext = 0U;
+
+	irq_add_shared_handler(DMA_IRQ_0, picoDmaIrq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+	irq_set_enabled(DMA_IRQ_0, true);
+
+	adc_fifo_drain();
+	dma_channel_start(picoDma[0]);
+	adc_run(true);
+
+	return (uint32_t)(((uint64_t)PICO_ADC_CLOCK << 8U) / period);
+}
+
+void acqBackendStop(void) {
+	adc_run(false);
+
+	// without DREQs no data channel can finish and chain on
+	adc_fifo_drain();
+
+	for (uint8_t i = 0U; i < ACQ_BUFFERS; i++) {
+		// an abort can raise the interrupt, disable it first
+		dma_channel_set_irq0_enabled(picoDma[i], false);
+	}
+	// a control channel left running would start its next channel again
+	for (uint8_t i = 0U; i < ACQ_BUFFERS; i++) {
+		dma_channel_abort(picoControl[i]);
+	}
+	for (uint8_t i = 0U; i < ACQ_BUFFERS; i++) {
+		dma_channel_abort(picoDma[i]);
+		dma_channel_acknowledge_irq0(picoDma[i]);
+	}
+	picoUnclaim(picoDma);
+	picoUnclaim(picoControl);
+
+	irq_remove_handler(DMA_IRQ_0, picoDmaIrq);
+	adc_fifo_setup(false, false, 0U, false, false);
+	adc_fifo_drain();
+	adc_set_round_robin(0U);
+}
+
+void acqBackendPoll(void) {}
+
+#endif
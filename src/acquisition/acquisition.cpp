@@ -0,0 +1,232 @@
+/*
+	acquisition.cpp - continuous ADC acquisition into double buffers
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "acquisition.h"
+#include "../nvm/eeprom_addresses.h"
+#include "../trace.h"
+
+#define ACQ_BUFFER_MASK ((uint8_t)(ACQ_BUFFERS - 1U))
+
+SampleWord acqBuffers[ACQ_BUFFERS][ACQ_BUFFER_SAMPLES];
+
+// numbers of filled buffers, from the ADC to the loop
+SampleRing<uint8_t, ACQ_BUFFERS> acqReady;
+
+// number of the buffer the ADC is filling
+SampleRingCounter<uint8_t> acqFilling;
+
+// loop side
+bool acqActive = false;
+bool acqHolding = false;
+uint8_t acqHeld = 0U;
+uint8_t acqNext = 0U;
+uint16_t acqBufferLength = 0U;
+uint32_t acqOverrunCount = 0UL;
+uint32_t acqRate = 0UL;
+uint8_t acqChannelBits = 0U;
+
+/**
+ * Checks the ADC hasn't come back around to a buffer,
+ * reads of the buffer before this are covered
+ *
+ * @param number number of the buffer
+ *
+ * @return if the buffer still holds its samples
+ */
+bool acqBufferValid(uint8_t number) {
+	return (uint8_t)(acqFilling.loadAfterReads() - number) < ACQ_BUFFERS;
+}
+
+/****************************
+ * Acquisition Methods
+****************************/
+
+enum AcqStartCode acqCheckConfig(const AcqConfig &config) {
+	if (config.channels == 0U || (config.channels & (uint8_t)~ACQ_CHANNEL_MASK) != 0U) {
+		return ACQ_INVALID_CHANNELS;
+	}
+	if (config.sampleRate < ACQ_MIN_RATE ||
+		config.sampleRate > Board::adcMaxRate / acqChannelCount(config.channels)) {
+		return ACQ_INVALID_RATE;
+	}
+	return ACQ_OK;
+}
+
+bool acqLoadConfig(AcqConfig *config) {
+	AcqConfig stored;
+	if (nvmGetField<NVMSampleRateField>(&stored.sampleRate) &&
+		nvmGetField<NVMChannelsField>(&stored.channels) &&
+		acqCheckConfig(stored) == ACQ_OK) {
+
+		*config = stored;
+		return true;
+	}
+
+	config->sampleRate = ACQ_DEFAULT_RATE;
+	config->channels = ACQ_DEFAULT_CHANNELS;
+	return false;
+}
+
+enum AcqStartCode acqInit(void) {
+	AcqConfig config;
+	if (!acqLoadConfig(&config)) {
+		LOG_I(ACQ, "No stored acquisition, using defaults");
+	}
+	return acqStart(config);
+}
+
+enum AcqStartCode acqStart(const AcqConfig &config) {
+	TRACE_SCOPE("acqStart");
+
+	if (acqActive) {
+		LOG_W(ACQ, "Acquisition already started");
+		return ACQ_STARTED;
+	}
+
+	enum AcqStartCode code = acqCheckConfig(config);
+	if (code != ACQ_OK) {
+		LOG_E(ACQ, "Can't acquire channels {} at {} S/s", config.channels, config.sampleRate);
+		return code;
+	}
+
+	// whole sample sets per buffer so each starts at the lowest channel
+	uint8_t count = acqChannelCount(config.channels);
+	acqBufferLength = (uint16_t)(ACQ_BUFFER_SAMPLES - ACQ_BUFFER_SAMPLES % count);
+
+	acqReady.reset();
+	acqFilling.publish(0U);
+	acqHolding = false;
+	acqNext = 0U;
+	acqOverrunCount = 0UL;
+
+	uint32_t conversionRate = acqBackendStart(config.sampleRate * count, config.channels, acqBufferLength);
+	if (conversionRate == 0UL) {
+		LOG_E(ACQ, "ADC didn't start");
+		return ACQ_FAILED;
+	}
+
+	acqRate = conversionRate / count;
+	acqChannelBits = config.channels;
+	acqActive = true;
+
+	nvmWriteField<NVMSampleRateField>(config.sampleRate);
+	nvmWriteField<NVMChannelsField>(config.channels);
+
+	LOG_I(ACQ, "Acquiring channels {} at {} S/s", config.channels, acqRate);
+	return ACQ_OK;
+}
+
+void acqEnd(void) {
+	if (!acqActive) {
+		return;
+	}
+	acqBackendStop();
+	acqActive = false;
+	acqHolding = false;
+	acqRate = 0UL;
+	acqChannelBits = 0U;
+}
+
+uint8_t acqChannelCount(uint8_t channels) {
+	uint8_t count = 0U;
+	for (; channels != 0U; channels &= (uint8_t)(channels - 1U)) {
+		count++;
+	}
+	return count;
+}
+
+bool acqRunning(void) {
+	return acqActive;
+}
+
+uint32_t acqSampleRate(void) {
+	return acqRate;
+}
+
+uint8_t acqChannels(void) {
+	return acqChannelBits;
+}
+
+uint16_t acqGetBuffer(const SampleWord **samples) {
+	if (!acqActive) {
+		return 0U;
+	}
+	if (acqHolding) {
+		acqReleaseBuffer();
+	}
+
+	acqBackendPoll();
+
+	uint8_t number;
+	while (acqReady.pop(&number)) {
+		// numbers skipped were filled while the queue was full
+		acqOverrunCount += (uint8_t)(number - acqNext);
+		acqNext = (uint8_t)(number + 1U);
+
+		if (acqBufferValid(number)) {
+			acqHeld = number;
+			acqHolding = true;
+			*samples = acqBuffers[number & ACQ_BUFFER_MASK];
+			return acqBufferLength;
+		}
+		acqOverrunCount++;
+	}
+	return 0U;
+}
+
+bool acqReleaseBuffer(void) {
+	if (!acqHolding) {
+		return false;
+	}
+	acqHolding = false;
+
+	if (!acqBufferValid(acqHeld)) {
+		acqOverrunCount++;
+		LOG_T(ACQ, "Buffer {} overwritten while held", acqHeld);
+		return false;
+	}
+	return true;
+}
+
+uint32_t acqOverruns(void) {
+	return acqOverrunCount;
+}
+
+/****************************
+ * Backend Methods
+****************************/
+
+SampleWord *acqFillBuffer(void) {
+	return acqBuffers[acqFilling.loadOwn() & ACQ_BUFFER_MASK];
+}
+
+SampleWord *acqBuffer(uint8_t index) {
+	return acqBuffers[index & ACQ_BUFFER_MASK];
+}
+
+void acqBufferDone(void) {
+	uint8_t number = acqFilling.loadOwn();
+
+	// with the queue full the loop sees a gap in the numbers
+	acqReady.push(number);
+	acqFilling.publish((uint8_t)(number + 1U));
+}
+
+void acqBufferDropped(void) {
+	acqOverrunCount++;
+}
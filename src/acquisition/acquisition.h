@@ -0,0 +1,244 @@
+/*
+	acquisition.h - continuous ADC acquisition into double buffers
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef ACQUISITION_H
+#define ACQUISITION_H
+
+#include <Arduino.h>
+#include "../compile_flags.h"
+#include "../board_traits.h"
+#include "../sample_ring.h"
+#include "../debug.h"
+
+/****************************
+ * Acquisition
+ *
+ * The ADC converts continuously into ACQ_BUFFERS buffers
+ * in turn, with DMA on the ESP32 and Pico, an interrupt
+ * per conversion on the Uno and a thread on the host.
+ * Each filled buffer is numbered and queued for the loop,
+ * which gets it with acqGetBuffer() and hands it back
+ * with acqReleaseBuffer().
+ *
+ * The ADC never waits for the loop. A buffer is valid
+ * until the ADC comes back around to it, one buffer time
+ * with double buffers, and buffers the loop was too late
+ * for are counted by acqOverruns().
+ *
+ * With more than one channel the samples are interleaved
+ * from the lowest channel up and every buffer starts at
+ * the lowest channel.
+****************************/
+
+// buffers the ADC fills in turn, a power of two
+#ifndef ACQ_BUFFERS
+#define ACQ_BUFFERS 2U
+#endif
+
+// samples per second per channel used when none is stored
+#ifndef ACQ_DEFAULT_RATE
+#define ACQ_DEFAULT_RATE 10000UL
+#endif
+
+// channel bits used when none are stored
+#ifndef ACQ_DEFAULT_CHANNELS
+#define ACQ_DEFAULT_CHANNELS 0x01U
+#endif
+
+// slowest rate the timers and dividers can pace
+#define ACQ_MIN_RATE 100UL
+
+// every channel of the board
+#define ACQ_CHANNEL_MASK ((uint8_t)((1U << Board::adcChannels) - 1U))
+
+static_assert(ACQ_BUFFERS >= 2U && (ACQ_BUFFERS & (ACQ_BUFFERS - 1U)) == 0U,
+	"ACQ_BUFFERS must be a power of two of at least 2");
+static_assert(Board::adcChannels <= 8U, "ADC channels must fit a byte of channel bits");
+static_assert(ACQ_BUFFER_SAMPLES >= Board::adcChannels, "ACQ buffers must hold a sample of every channel");
+
+// result of starting acquisition
+enum AcqStartCode {ACQ_OK, ACQ_STARTED, ACQ_FAILED, ACQ_INVALID_RATE, ACQ_INVALID_CHANNELS};
+
+/**
+ * Rate and channels to acquire
+ */
+struct AcqConfig {
+	uint32_t sampleRate; // samples per second per channel
+	uint8_t channels; // bit per channel, bit 0 is the first ADC channel
+};
+
+/****************************
+ * Acquisition Methods
+****************************/
+
+/**
+ * Starts acquisition with the rate and channels stored
+ * by the last acqStart(), or the defaults
+ *
+ * @return code from trying to start
+ */
+enum AcqStartCode acqInit(void);
+
+/**
+ * Starts acquisition and stores the config for the
+ * next acqInit(), nvmFlush() makes it persist
+ *
+ * @param config rate and channels to acquire
+ *
+ * @return code from trying to start
+ */
+enum AcqStartCode acqStart(const AcqConfig &config);
+
+/**
+ * Stops the ADC, buffers not released yet are dropped
+ */
+void acqEnd(void);
+
+/**
+ * Gets if acquisition is running
+ *
+ * @return if the ADC is converting
+ */
+bool acqRunning(void);
+
+/**
+ * Checks the ADC can acquire a config
+ *
+ * @param config rate and channels to check
+ *
+ * @return ACQ_OK or the reason it can't
+ */
+enum AcqStartCode acqCheckConfig(const AcqConfig &config);
+
+/**
+ * Reads the config stored by acqStart()
+ *
+ * @param config set to the stored config, the defaults if none is valid
+ *
+ * @return if a stored config was found
+ */
+bool acqLoadConfig(AcqConfig *config);
+
+/**
+ * Gets the rate the ADC really runs at, dividers round
+ * the requested rate
+ *
+ * @return samples per second per channel, 0 when stopped
+ */
+uint32_t acqSampleRate(void);
+
+/**
+ * Gets the channels being acquired
+ *
+ * @return channel bits, 0 when stopped
+ */
+uint8_t acqChannels(void);
+
+/**
+ * Counts the channels in channel bits
+ *
+ * @param channels channel bits
+ *
+ * @return channels set
+ */
+uint8_t acqChannelCount(uint8_t channels);
+
+/**
+ * Gets the oldest filled buffer, it stays valid until
+ * the ADC comes back around to it
+ *
+ * @param samples set to the first sample
+ *
+ * @return samples in the buffer, 0 if none is ready
+ */
+uint16_t acqGetBuffer(const SampleWord **samples);
+
+/**
+ * Hands the buffer from acqGetBuffer() back
+ *
+ * @return if the ADC didn't overwrite it while it was held
+ */
+bool acqReleaseBuffer(void);
+
+/**
+ * Gets buffers lost because the loop was too late,
+ * counted by acqGetBuffer() and acqReleaseBuffer()
+ *
+ * @return buffers lost since acquisition started
+ */
+uint32_t acqOverruns(void);
+
+/****************************
+ * Backend Methods
+ *
+ * Implemented once per board. The backend fills
+ * acqFillBuffer() and calls acqBufferDone() from its
+ * interrupt, DMA callback or thread when it is full.
+****************************/
+
+/**
+ * Gets the buffer the ADC fills next
+ *
+ * @return first sample of the buffer
+ */
+SampleWord *acqFillBuffer(void);
+
+/**
+ * Gets a buffer by its place in the turn
+ *
+ * @param index buffer 0 to ACQ_BUFFERS - 1
+ *
+ * @return first sample of the buffer
+ */
+SampleWord *acqBuffer(uint8_t index);
+
+/**
+ * Queues the buffer from acqFillBuffer() for the loop,
+ * safe to call from an interrupt
+ */
+void acqBufferDone(void);
+
+/**
+ * Counts a buffer the backend lost before it was queued,
+ * only from acqBackendPoll()
+ */
+void acqBufferDropped(void);
+
+/**
+ * Starts the ADC converting into the buffers
+ *
+ * @param conversionRate conversions per second over all channels
+ * @param channels channel bits
+ * @param bufferSamples samples in a buffer, a multiple of the channel count
+ *
+ * @return conversions per second the ADC runs at, 0 if it failed
+ */
+uint32_t acqBackendStart(uint32_t conversionRate, uint8_t channels, uint16_t bufferSamples);
+
+/**
+ * Stops the ADC, no acqBufferDone() follows
+ */
+void acqBackendStop(void);
+
+/**
+ * Moves converted samples to the buffers when the board
+ * can't do it without the loop, called by acqGetBuffer()
+ */
+void acqBackendPoll(void);
+
+#endif
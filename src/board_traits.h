@@ -0,0 +1,287 @@
+/*
+	board_traits.h - compile time capabilities of each board
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef BOARD_TRAITS_H
+#define BOARD_TRAITS_H
+
+#include <Arduino.h>
+#include "compile_flags.h"
+
+/****************************
+ * Board Traits
+ *
+ * Each board describes its limits as constexpr values,
+ * so buffers are sized and algorithms chosen at compile
+ * time with plain C++ instead of #ifdef chains. The
+ * preprocessor is still used where a board has APIs
+ * or headers the others don't.
+****************************/
+
+enum BoardId : uint8_t {
+	BOARD_UNOR3,
+	BOARD_ESP32DEVC,
+	BOARD_PICO,
+	BOARD_HOSTLINUX
+};
+
+/**
+ * Capabilities of a board, only the specializations
+ * below exist so an unknown board fails to build
+ *
+ * @param ID board to describe
+ */
+template <BoardId ID>
+struct BoardTraits;
+
+/**
+ * Arduino Uno r3, ATmega328P at 16 MHz
+ */
+template <>
+struct BoardTraits<BOARD_UNOR3> {
+	static constexpr const char *name = "Uno r3";
+	static constexpr uint32_t ramBytes = 2048UL;
+	static constexpr uint8_t cores = 1U;
+
+	// 8 bit ALU, 64 bit math is a library call per operation
+	static constexpr uint8_t wordBits = 8U;
+	static constexpr bool native64 = false;
+	static constexpr bool hardwareDivide = false;
+	// Print has no long long overloads
+	static constexpr bool print64 = false;
+
+	// timer triggered conversions of 14 cycles of a /16 ADC clock,
+	// analogRead() manages 9615, about 8 effective bits past 15 kS/s
+	static constexpr uint8_t adcBits = 10U;
+	static constexpr uint32_t adcMaxRate = 71428UL;
+	// A0 to A5
+	static constexpr uint8_t adcChannels = 6U;
+
+	static constexpr uint32_t nvmBytes = 1024UL;
+
+	static constexpr uint16_t debugRingSize = 128U;
+	static constexpr uint8_t debugLineSize = 80U;
+	static constexpr uint16_t traceEvents = 32U;
+	static constexpr uint32_t sampleRingSize = 64UL;
+	static constexpr uint16_t acqBufferSamples = 64U;
+	static constexpr uint16_t triggerFrameSamples = 128U;
+	static constexpr uint16_t decimatePoints = 32U;
+	static constexpr uint16_t transportBatch = 160U;
+};
+
+/**
+ * ESP32 Devkit C v4, dual core Xtensa LX6 at 240 MHz
+ */
+template <>
+struct BoardTraits<BOARD_ESP32DEVC> {
+	static constexpr const char *name = "ESP32 Devkit C";
+	static constexpr uint32_t ramBytes = 327680UL;
+	static constexpr uint8_t cores = 2U;
+
+	static constexpr uint8_t wordBits = 32U;
+	static constexpr bool native64 = false;
+	static constexpr bool hardwareDivide = true;
+	static constexpr bool print64 = true;
+
+	// ADC1 through I2S DMA, analogRead() alone is far slower
+	static constexpr uint8_t adcBits = 12U;
+	static constexpr uint32_t adcMaxRate = 2000000UL;
+	// ADC1, ADC2 is shared with the radio
+	static constexpr uint8_t adcChannels = 8U;
+
+	// default nvs partition
+	static constexpr uint32_t nvmBytes = 20480UL;
+
+	static constexpr uint16_t debugRingSize = 4096U;
+	static constexpr uint8_t debugLineSize = 128U;
+	static constexpr uint16_t traceEvents = 2048U;
+	static constexpr uint32_t sampleRingSize = 8192UL;
+	static constexpr uint16_t acqBufferSamples = 4096U;
+	static constexpr uint16_t triggerFrameSamples = 4096U;
+	static constexpr uint16_t decimatePoints = 1024U;
+	static constexpr uint16_t transportBatch = 8192U;
+};
+
+/**
+ * Raspberry Pi Pico, dual core RP2040 Cortex-M0+ at 133 MHz
+ */
+template <>
+struct BoardTraits<BOARD_PICO> {
+	static constexpr const char *name = "Pico";
+	static constexpr uint32_t ramBytes = 270336UL;
+	static constexpr uint8_t cores = 2U;
+
+	// M0+ has no divide instruction but the SIO has a divider
+	static constexpr uint8_t wordBits = 32U;
+	static constexpr bool native64 = false;
+	static constexpr bool hardwareDivide = true;
+	static constexpr bool print64 = true;
+
+	static constexpr uint8_t adcBits = 12U;
+	static constexpr uint32_t adcMaxRate = 500000UL;
+	// GP26 to GP29
+	static constexpr uint8_t adcChannels = 4U;
+
+	static constexpr uint32_t nvmBytes = 4096UL;
+
+	static constexpr uint16_t debugRingSize = 1024U;
+	static constexpr uint8_t debugLineSize = 128U;
+	static constexpr uint16_t traceEvents = 1024U;
+	static constexpr uint32_t sampleRingSize = 8192UL;
+	static constexpr uint16_t acqBufferSamples = 2048U;
+	static constexpr uint16_t triggerFrameSamples = 4096U;
+	static constexpr uint16_t decimatePoints = 1024U;
+	static constexpr uint16_t transportBatch = 8192U;
+};
+
+/**
+ * Linux host, the ADC is modelled on the Pico's
+ */
+template <>
+struct BoardTraits<BOARD_HOSTLINUX> {
+	static constexpr const char *name = "Linux host";
+	static constexpr uint32_t ramBytes = 16777216UL;
+	static constexpr uint8_t cores = 4U;
+
+	static constexpr uint8_t wordBits = 64U;
+	static constexpr bool native64 = true;
+	static constexpr bool hardwareDivide = true;
+	static constexpr bool print64 = true;
+
+	static constexpr uint8_t adcBits = 12U;
+	static constexpr uint32_t adcMaxRate = 500000UL;
+	static constexpr uint8_t adcChannels = 8U;
+
+	static constexpr uint32_t nvmBytes = 65536UL;
+
+	static constexpr uint16_t debugRingSize = 16384U;
+	static constexpr uint8_t debugLineSize = 128U;
+	static constexpr uint16_t traceEvents = 16384U;
+	static constexpr uint32_t sampleRingSize = 65536UL;
+	static constexpr uint16_t acqBufferSamples = 4096U;
+	static constexpr uint16_t triggerFrameSamples = 8192U;
+	static constexpr uint16_t decimatePoints = 4096U;
+	static constexpr uint16_t transportBatch = 16384U;
+};
+
+/****************************
+ * Selected Board
+****************************/
+
+#if defined(UNOR3)
+#define BOARD_ID BOARD_UNOR3
+#elif defined(ESP32DEVC)
+#define BOARD_ID BOARD_ESP32DEVC
+#elif defined(PICO)
+#define BOARD_ID BOARD_PICO
+#elif defined(HOSTLINUX)
+#define BOARD_ID BOARD_HOSTLINUX
+#endif
+
+// code reading builds have no board, the Uno is the most limited
+#if !defined(BOARD_ID) && defined(DEBUG_INSPECT)
+#define BOARD_ID BOARD_UNOR3
+#endif
+
+typedef BoardTraits<BOARD_ID> Board;
+
+/**
+ * Smallest unsigned type that holds a sample of the
+ * given resolution
+ *
+ * @param BITS bits per sample
+ */
+template <uint8_t BITS, bool WIDE = (BITS > 8U)>
+struct BoardSampleWord {
+	typedef uint8_t type;
+};
+
+template <uint8_t BITS>
+struct BoardSampleWord<BITS, true> {
+	typedef uint16_t type;
+};
+
+// type of one raw ADC sample on this board
+typedef BoardSampleWord<Board::adcBits>::type SampleWord;
+
+static_assert(Board::adcBits <= 16U, "ADC samples must fit 16 bits");
+
+/****************************
+ * Buffer Sizes
+ *
+ * Defined before here to override the board's size
+****************************/
+
+/**
+ * Bytes of debug output queued until debugPoll() sends
+ * them and the longest text log line, ring is a power of two
+ */
+#ifndef DEBUG_RING_SIZE
+#define DEBUG_RING_SIZE ((uint16_t)Board::debugRingSize)
+#endif
+#ifndef DEBUG_LINE_SIZE
+#define DEBUG_LINE_SIZE ((uint8_t)Board::debugLineSize)
+#endif
+
+/**
+ * Trace events held before the oldest are overwritten,
+ * 8 bytes each and a power of two
+ */
+#ifndef TRACE_EVENTS
+#define TRACE_EVENTS ((uint16_t)Board::traceEvents)
+#endif
+
+/**
+ * Samples held between the ADC and the processing loop,
+ * a power of two and at most 128 on the Uno
+ */
+#ifndef SAMPLE_RING_SIZE
+#define SAMPLE_RING_SIZE ((uint32_t)Board::sampleRingSize)
+#endif
+
+/**
+ * Samples in each of the acquisition double buffers
+ */
+#ifndef ACQ_BUFFER_SAMPLES
+#define ACQ_BUFFER_SAMPLES ((uint16_t)Board::acqBufferSamples)
+#endif
+
+/**
+ * Samples of a triggered frame over all channels, also
+ * the pre-trigger history, a power of two
+ */
+#ifndef TRIG_FRAME_SAMPLES
+#define TRIG_FRAME_SAMPLES ((uint16_t)Board::triggerFrameSamples)
+#endif
+
+/**
+ * Most points a block is decimated to over all channels,
+ * each point is two samples in min/max mode
+ */
+#ifndef DEC_MAX_POINTS
+#define DEC_MAX_POINTS ((uint16_t)Board::decimatePoints)
+#endif
+
+/**
+ * Bytes in each of the transport double buffers, a
+ * frame can use both while neither is being sent
+ */
+#ifndef TRANSPORT_BATCH_SIZE
+#define TRANSPORT_BATCH_SIZE ((uint16_t)Board::transportBatch)
+#endif
+
+#endif
@@ -0,0 +1,193 @@
+/*
+	codec.cpp - lossless sample block compression
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "codec.h"
+
+/**
+ * Bits packed from the lowest up, a byte is stored as
+ * soon as it's whole
+ */
+struct CodecWriter {
+	uint8_t *next;
+	uint8_t *end;
+	uint32_t pending;
+	uint8_t bits;
+	bool full;
+};
+
+/**
+ * Bits read from the lowest up
+ */
+struct CodecReader {
+	const uint8_t *next;
+	const uint8_t *end;
+	uint32_t pending;
+	uint8_t bits;
+	bool empty;
+};
+
+/**
+ * Appends bits to a block
+ *
+ * @param writer block being written
+ * @param value value to append, no wider than width
+ * @param width bits of value, at most 16
+ */
+inline void codecPut(CodecWriter *writer, uint16_t value, uint8_t width) {
+	if (writer->full) {
+		return;
+	}
+	writer->pending |= (uint32_t)value << writer->bits;
+	writer->bits = (uint8_t)(writer->bits + width);
+	while (writer->bits >= 8U) {
+		if (writer->next == writer->end) {
+			writer->full = true;
+			return;
+		}
+		*writer->next++ = (uint8_t)writer->pending;
+		writer->pending >>= 8;
+		writer->bits = (uint8_t)(writer->bits - 8U);
+	}
+}
+
+/**
+ * Takes bits from a block
+ *
+ * @param reader block being read
+ * @param width bits to take, at most 16
+ *
+ * @return value taken, 0 once the block runs out
+ */
+inline uint16_t codecGet(CodecReader *reader, uint8_t width) {
+	while (reader->bits < width) {
+		if (reader->next == reader->end) {
+			reader->empty = true;
+			return 0U;
+		}
+		reader->pending |= (uint32_t)*reader->next++ << reader->bits;
+		reader->bits = (uint8_t)(reader->bits + 8U);
+	}
+	uint16_t value = (uint16_t)(reader->pending & ((1UL << width) - 1UL));
+	reader->pending >>= width;
+	reader->bits = (uint8_t)(reader->bits - width);
+	return value;
+}
+
+/**
+ * Gets the bits needed for a value
+ *
+ * @param value value to fit
+ *
+ * @return bits up to the highest set one
+ */
+inline uint8_t codecWidth(uint16_t value) {
+	return value == 0U ? 0U : (uint8_t)(sizeof(unsigned int) * 8U - __builtin_clz((unsigned int)value));
+}
+
+/****************************
+ * Codec Methods
+****************************/
+
+uint16_t codecEncode(const SampleWord *samples, uint16_t count, uint8_t channels, uint8_t *data, uint16_t capacity) {
+	if (channels == 0U || count % channels != 0U || capacity < CODEC_HEADER_SIZE) {
+		return 0U;
+	}
+
+	data[0] = (uint8_t)count;
+	data[1] = (uint8_t)(count >> 8);
+	data[2] = channels;
+	data[3] = CODEC_SAMPLE_BITS;
+
+	CodecWriter writer = {&data[CODEC_HEADER_SIZE], &data[capacity], 0UL, 0U, false};
+
+	uint16_t i = channels < count ? channels : count;
+	for (uint16_t channel = 0U; channel < i; channel++) {
+		codecPut(&writer, samples[channel], CODEC_SAMPLE_BITS);
+	}
+
+	uint16_t zigzag[CODEC_GROUP];
+	for (; i < count && !writer.full; i = (uint16_t)(i + CODEC_GROUP)) {
+		uint8_t length = (uint8_t)((uint16_t)(count - i) < CODEC_GROUP ? count - i : CODEC_GROUP);
+
+		// small either way of zero becomes a small positive number
+		uint16_t widest = 0U;
+		for (uint8_t k = 0U; k < length; k++) {
+			int16_t difference = (int16_t)(samples[i + k] - samples[i + k - channels]);
+			zigzag[k] = (uint16_t)((uint16_t)((uint16_t)difference << 1) ^ (uint16_t)(difference >> 15));
+			widest |= zigzag[k];
+		}
+
+		uint8_t width = codecWidth(widest);
+		codecPut(&writer, width, CODEC_WIDTH_BITS);
+		if (width != 0U) {
+			for (uint8_t k = 0U; k < length; k++) {
+				codecPut(&writer, zigzag[k], width);
+			}
+		}
+	}
+
+	if (writer.bits != 0U) {
+		codecPut(&writer, 0U, (uint8_t)(8U - writer.bits));
+	}
+	if (writer.full) {
+		return 0U;
+	}
+	return (uint16_t)(writer.next - data);
+}
+
+bool codecPeek(const uint8_t *data, uint16_t length, uint16_t *count, uint8_t *channels) {
+	if (length < CODEC_HEADER_SIZE) {
+		return false;
+	}
+	*count = (uint16_t)(data[0] | (data[1] << 8));
+	*channels = data[2];
+	uint8_t bits = data[3];
+	return *channels != 0U && *count % *channels == 0U && bits != 0U && bits + 1U < (1U << CODEC_WIDTH_BITS);
+}
+
+uint16_t codecDecode(const uint8_t *data, uint16_t length, uint16_t *samples, uint16_t capacity) {
+	uint16_t count;
+	uint8_t channels;
+	if (!codecPeek(data, length, &count, &channels) || count > capacity) {
+		return 0U;
+	}
+	uint8_t bits = data[3];
+
+	CodecReader reader = {&data[CODEC_HEADER_SIZE], &data[length], 0UL, 0U, false};
+
+	uint16_t i = channels < count ? channels : count;
+	for (uint16_t channel = 0U; channel < i; channel++) {
+		samples[channel] = codecGet(&reader, bits);
+	}
+
+	for (; i < count && !reader.empty; i = (uint16_t)(i + CODEC_GROUP)) {
+		uint8_t groupLength = (uint8_t)((uint16_t)(count - i) < CODEC_GROUP ? count - i : CODEC_GROUP);
+		uint8_t width = (uint8_t)codecGet(&reader, CODEC_WIDTH_BITS);
+		if (width > bits + 1U) {
+			return 0U;
+		}
+
+		for (uint8_t k = 0U; k < groupLength; k++) {
+			uint16_t zigzag = width != 0U ? codecGet(&reader, width) : 0U;
+			uint16_t difference = (uint16_t)((zigzag >> 1) ^ (uint16_t)-(int16_t)(zigzag & 1U));
+			samples[i + k] = (uint16_t)(samples[i + k - channels] + difference);
+		}
+	}
+
+	return reader.empty ? 0U : count;
+}
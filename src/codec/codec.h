@@ -0,0 +1,108 @@
+/*
+	codec.h - lossless sample block compression
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <Arduino.h>
+#include "../compile_flags.h"
+#include "../board_traits.h"
+
+/****************************
+ * Sample Codec
+ *
+ * Neighbouring samples of a channel are close, so each
+ * sample is sent as the zig-zagged difference from the
+ * channel's last one. Differences are packed in groups of
+ * CODEC_GROUP, each group as narrow as its widest one.
+ *
+ * A block is
+ * - 4 header bytes: sample count, little endian, channels
+ *   interleaved and bits per sample
+ * - the first sample set at the bits per sample
+ * - for every group a 4 bit width, then the group's
+ *   differences at that width
+ * packed from the lowest bit of each byte up, the last
+ * byte padded with zeros. Blocks don't depend on each
+ * other so a lost block doesn't spoil the next.
+****************************/
+
+// differences sharing a width, 16 keeps the width at 1/4 bit a sample
+#ifndef CODEC_GROUP
+#define CODEC_GROUP 16U
+#endif
+
+#define CODEC_HEADER_SIZE 4U
+#define CODEC_WIDTH_BITS 4U
+
+// bits a sample is coded with on this board
+#define CODEC_SAMPLE_BITS ((uint8_t)Board::adcBits)
+
+static_assert(CODEC_SAMPLE_BITS + 1U < (1U << CODEC_WIDTH_BITS), "Zig-zagged differences must fit the group width");
+
+/**
+ * Most bytes a block can encode to, noise as wide as the
+ * ADC with a sign bit on every difference
+ */
+#define CODEC_MAX_BYTES(count) ((uint16_t)(CODEC_HEADER_SIZE + \
+	(((uint32_t)(count) * (CODEC_SAMPLE_BITS + 1U) + \
+	((uint32_t)(count) + CODEC_GROUP - 1U) / CODEC_GROUP * CODEC_WIDTH_BITS + 7U) / 8U)))
+
+/****************************
+ * Codec Methods
+****************************/
+
+/**
+ * Encodes a block of samples
+ *
+ * @param samples block of whole sample sets
+ * @param count samples in the block
+ * @param channels channels interleaved in the block, 1 to 255
+ * @param data where to write the block
+ * @param capacity bytes available, CODEC_MAX_BYTES(count) always fits
+ *
+ * @return bytes written, 0 if they didn't fit
+ */
+uint16_t codecEncode(const SampleWord *samples, uint16_t count, uint8_t channels, uint8_t *data, uint16_t capacity);
+
+/**
+ * Gets the samples and channels of an encoded block
+ * without decoding it
+ *
+ * @param data encoded block
+ * @param length bytes received
+ * @param count set to samples in the block
+ * @param channels set to channels interleaved
+ *
+ * @return if the header is whole and valid
+ */
+bool codecPeek(const uint8_t *data, uint16_t length, uint16_t *count, uint8_t *channels);
+
+/**
+ * Decodes a block, from any board
+ *
+ * @param data encoded block
+ * @param length bytes received
+ * @param samples where to write the samples
+ * @param capacity samples available
+ *
+ * @return samples written, 0 if the block was cut short, invalid or too big
+ */
+uint16_t codecDecode(const uint8_t *data, uint16_t length, uint16_t *samples, uint16_t capacity);
+
+#endif
@@ -21,15 +21,49 @@
 ****************************/
 
 /**
- * Debug flag to show undefined methods
+ * Log levels, a site is built in when its level is at
+ * or below DEBUG_LEVEL
+ */
+#define DEBUG_LEVEL_NONE 0
+#define DEBUG_LEVEL_ERROR 1
+#define DEBUG_LEVEL_WARN 2
+#define DEBUG_LEVEL_INFO 3
+#define DEBUG_LEVEL_TRACE 4
+
+/**
+ * Most detailed log level built in, sites past it are
+ * left out of the build entirely. Levels and categories
+ * built in can be switched at runtime, see debugSetLevel()
+ */
+#ifndef DEBUG_LEVEL
+#define DEBUG_LEVEL DEBUG_LEVEL_NONE
+#endif
+
+/**
+ * Debug flag to show undefined methods, only for
+ * reading the code, the build won't run
  */
 //#define DEBUG_INSPECT
 
 /**
- * Debug flag to show undefined nvm methods
+ * Debug flag to show undefined nvm methods, only for
+ * reading the code, the build won't run
  */
 //#define DEBUG_NVM
 
+/**
+ * Sends log sites as binary frames of a token and raw
+ * arguments instead of text, decoded on the host with
+ * extras/tools/log_tokens.py
+ */
+//#define DEBUG_TOKENIZED
+
+/**
+ * Records TRACE_SCOPE begin and end times for traceDump(),
+ * converted with extras/tools/trace_to_chrome.py
+ */
+//#define DEBUG_TRACE
+
 /****************************
  * Selected Board
 ****************************/
@@ -55,30 +89,138 @@
 #define PICO
 #endif
 
+/**
+ * Linux host, used to run the core off target
+ */
+#if defined(__linux__) && !defined(ARDUINO)
+#define HOSTLINUX
+#endif
+
 /****************************
  * EEPROM Config
 ****************************/
 
+/**
+ * Runs the Preferences methods on the host against the
+ * in memory Preferences in extras/host instead of EEPROM
+ */
+//#define NVM_HOST_PREF
+
+#if defined(NVM_HOST_PREF) && !defined(HOSTLINUX)
+#undef NVM_HOST_PREF
+#endif
+
 /**
  * Uses EEPROM method for NVM storage
  */
-#if defined(UNOR3) || defined(PICO)
+#if defined(UNOR3) || defined(PICO) || (defined(HOSTLINUX) && !defined(NVM_HOST_PREF))
 #define NVM_EEPROM
 #endif
 
+/**
+ * Backs the EEPROM methods with a memory mapped file
+ * that counts commits, models page erases and can
+ * simulate a power cut
+ */
+#if defined(HOSTLINUX) && !defined(NVM_HOST_PREF)
+#define NVM_FILE
+#endif
+
+/**
+ * Backs the EEPROM methods with flash sectors erased one
+ * at a time, the EEPROM library erases its only sector on
+ * every commit
+ */
+#if defined(PICO)
+#define NVM_FLASH
+#endif
+
 /**
  * Uses Preferences method for NVM storage
  */
-#if defined(ESP32DEVC)
+#if defined(ESP32DEVC) || defined(NVM_HOST_PREF)
 #define NVM_PREF
 #endif
 
+/**
+ * Packs all Preferences values into one blob that is
+ * loaded at nvmInit and written back on nvmFlush()
+ */
+//#define NVM_PREF_PACKED
+
+#if defined(NVM_PREF_PACKED) && !defined(NVM_PREF)
+#undef NVM_PREF_PACKED
+#endif
+
+/**
+ * Stores nvm values in a log structured, wear leveled
+ * region on top of EEPROM instead of fixed addresses
+ */
+//#define NVM_LOG
+
+#if defined(NVM_LOG) && defined(NVM_PREF)
+#undef NVM_LOG
+#endif
+
+/**
+ * Flash emulated EEPROM needs a sized begin and commits,
+ * begin reports if the sectors are clear of the sketch
+ */
+#if defined(PICO)
+#define __NVM_BEGIN__
+#define __NVM_BEGIN_SIZE__
+#define __NVM_BEGIN_RETURN__
+#define __NVM_COMMIT__
+#endif
+
+/**
+ * Models AVR style EEPROM with the nvm file, every write
+ * programs its byte straight away instead of on commit
+ */
+//#define NVM_FILE_BYTE_WRITE
+
+/**
+ * File backed EEPROM behaves like flash emulated EEPROM
+ * and reports if the file could be mapped
+ */
+#if defined(NVM_FILE)
+#define __NVM_BEGIN__
+#define __NVM_BEGIN_SIZE__
+#define __NVM_BEGIN_RETURN__
+#ifndef NVM_FILE_BYTE_WRITE
+#define __NVM_COMMIT__
+#endif
+#endif
+
+/****************************
+ * Transport Config
+****************************/
+
+/**
+ * Streams link frames over WiFi UDP, a POSIX socket
+ * stands in on the host
+ */
+#if defined(ESP32DEVC) || defined(HOSTLINUX)
+#define TRANSPORT_WIFI
+#endif
+
+/**
+ * Streams link frames as BLE notifications
+ */
+#if defined(ESP32DEVC)
+#define TRANSPORT_BLUETOOTH
+#endif
+
 /****************************
- * Variable Support
+ * Pipeline Config
 ****************************/
 
-#if defined(ESP32DEVC) || defined(PICO)
-#define INT64_SUPPORT
+/**
+ * Runs the pipeline's processing stage on the second
+ * core, a thread on the host
+ */
+#if defined(ESP32DEVC) || defined(PICO) || defined(HOSTLINUX)
+#define PIPE_DUAL_CORE
 #endif
 
 /****************************
@@ -93,7 +235,6 @@
 #define __NVM_BEGIN__
 #define __NVM_BEGIN_SIZE__
 #define __NVM_COMMIT__
-#undef INT64_SUPPORT
 #define DEBUG_INSPECT
 
 #endif
@@ -105,8 +246,42 @@
 
 #undef NVM_PREF
 #undef NVM_EEPROM
-#define __ERROR_DEBUG__
-#define __NVM_DEBUG__
-#define __TAG_DEBUG__
+#undef DEBUG_LEVEL
+#define DEBUG_LEVEL DEBUG_LEVEL_TRACE
+
+#endif
+
+/****************************
+ * NVM Cache Config
+****************************/
+
+/**
+ * Keeps a RAM shadow of the EEPROM region so
+ * writes are only committed on nvmFlush()
+ */
+#ifdef __NVM_COMMIT__
+#define NVM_SHADOW
+#endif
 
-#endif
\ No newline at end of file
+/**
+ * Queues value writes in RAM and commits them from a
+ * background task once writes go quiet, see nvmStartAsync()
+ */
+//#define NVM_ASYNC
+
+// needs a second task, pico FreeRTOS support is optional
+#if defined(NVM_ASYNC) && !defined(ESP32DEVC) && !defined(HOSTLINUX)
+#undef NVM_ASYNC
+#endif
+
+/****************************
+ * NVM Stats Config
+****************************/
+
+/**
+ * Counts nvm operations, latency and wear for
+ * nvmGetStats(), left off on the Uno to save RAM
+ */
+#if defined(ESP32DEVC) || defined(PICO) || defined(HOSTLINUX)
+#define NVM_STATS
+#endif
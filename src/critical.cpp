@@ -0,0 +1,95 @@
+/*
+	critical.cpp - short critical sections shared by tasks and interrupts
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "critical.h"
+
+#if defined(HOSTLINUX)
+
+#include <mutex>
+
+std::mutex criticalLock;
+
+void criticalEnter(void) {
+	criticalLock.lock();
+}
+
+void criticalExit(void) {
+	criticalLock.unlock();
+}
+
+#elif defined(ESP32DEVC)
+
+// spinlock, also keeps the other core out
+portMUX_TYPE criticalLock = portMUX_INITIALIZER_UNLOCKED;
+
+void criticalEnter(void) {
+	portENTER_CRITICAL_SAFE(&criticalLock);
+}
+
+void criticalExit(void) {
+	portEXIT_CRITICAL_SAFE(&criticalLock);
+}
+
+#elif defined(PICO)
+
+#include <pico/multicore.h>
+
+// spin lock, also keeps the other core out
+spin_lock_t *criticalSpinLock = NULL;
+
+// core 1 runs code that answers the SDK lockout instead of the Pico core's
+volatile bool criticalLockout = false;
+
+spin_lock_t *criticalClaimLock(void) {
+	if (criticalSpinLock == NULL) {
+		criticalSpinLock = spin_lock_init((uint)spin_lock_claim_unused(true));
+	}
+	return criticalSpinLock;
+}
+
+// claimed before setup() so the cores never race to claim it
+spin_lock_t *const criticalClaimed = criticalClaimLock();
+
+void criticalLockoutBegin(void) {
+	multicore_lockout_victim_init();
+	criticalLockout = true;
+}
+
+void criticalLockoutEnd(void) {
+	criticalLockout = false;
+}
+
+void criticalPauseOtherCore(void) {
+	if (criticalLockout) {
+		multicore_lockout_start_blocking();
+	}
+	else {
+		rp2040.idleOtherCore();
+	}
+}
+
+void criticalResumeOtherCore(void) {
+	if (criticalLockout) {
+		multicore_lockout_end_blocking();
+	}
+	else {
+		rp2040.resumeOtherCore();
+	}
+}
+
+#endif
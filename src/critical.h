@@ -0,0 +1,122 @@
+/*
+	critical.h - short critical sections shared by tasks and interrupts
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef CRITICAL_H
+#define CRITICAL_H
+
+#include <Arduino.h>
+#include "compile_flags.h"
+
+#if defined(HOSTLINUX) || defined(ESP32DEVC)
+
+/**
+ * Enters the critical section shared by the debug ring
+ * and trace buffer, a mutex on the host and a spinlock
+ * holding off interrupts on the ESP32
+ */
+void criticalEnter(void);
+
+/**
+ * Leaves the critical section
+ */
+void criticalExit(void);
+
+#elif defined(PICO)
+#include <hardware/sync.h>
+
+// hardware spin lock of the critical section, NULL until claimed
+extern spin_lock_t *criticalSpinLock;
+
+/**
+ * Claims the hardware spin lock of the critical section
+ *
+ * @return the spin lock
+ */
+spin_lock_t *criticalClaimLock(void);
+
+/**
+ * Gets the hardware spin lock of the critical section,
+ * claimed on first use so static constructors can use it
+ *
+ * @return the spin lock
+ */
+inline spin_lock_t *criticalLock(void) {
+	spin_lock_t *lock = criticalSpinLock;
+	return lock != NULL ? lock : criticalClaimLock();
+}
+
+/**
+ * Lets core 1 code started with multicore_launch_core1()
+ * be paused by criticalPauseOtherCore(), call it first
+ * in the entry and criticalLockoutEnd() before returning
+ */
+void criticalLockoutBegin(void);
+
+/**
+ * Ends criticalLockoutBegin() on core 1
+ */
+void criticalLockoutEnd(void);
+
+/**
+ * Parks the other core in RAM so flash can be rewritten,
+ * core 1 code from criticalLockoutBegin() through the SDK
+ * lockout and setup1() / loop1() through the Pico core
+ */
+void criticalPauseOtherCore(void);
+
+/**
+ * Lets the other core run again
+ */
+void criticalResumeOtherCore(void);
+
+#endif
+
+/**
+ * Keeps other tasks, cores and interrupts out while in
+ * scope. Only wrap a few loads and stores, sections don't nest
+ */
+struct CriticalSection {
+	CriticalSection(void) {
+		#if defined(PICO)
+			state = spin_lock_blocking(criticalLock());
+		#elif defined(UNOR3)
+			state = SREG;
+			cli();
+		#else
+			criticalEnter();
+		#endif
+	}
+
+	~CriticalSection(void) {
+		#if defined(PICO)
+			spin_unlock(criticalLock(), state);
+		#elif defined(UNOR3)
+			SREG = state;
+		#else
+			criticalExit();
+		#endif
+	}
+
+	#if defined(PICO)
+		uint32_t state;
+	#elif defined(UNOR3)
+		uint8_t state;
+	#endif
+};
+
+#endif
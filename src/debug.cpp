@@ -17,25 +17,276 @@
 */
 
 #include "debug.h"
+#include "critical.h"
 
-#if defined(__TAG_DEBUG__) || defined(__ERROR_DEBUG__) || defined(__NVM_DEBUG__)
+#if DEBUG_LEVEL > DEBUG_LEVEL_NONE
 
-void printTag(const __FlashStringHelper * tag) {
-	Serial.print(F("["));
-	Serial.print(tag);
-	Serial.print(F("]:"));
+static_assert((DEBUG_RING_SIZE & (DEBUG_RING_SIZE - 1U)) == 0U, "DEBUG_RING_SIZE must be a power of two");
+static_assert(DEBUG_RING_SIZE <= 32768UL, "DEBUG_RING_SIZE must fit the 16 bit ring indexes");
+
+volatile uint8_t debugLevel = DEBUG_LEVEL;
+volatile uint16_t debugCategories = DEBUG_CAT_ALL;
+
+uint8_t debugRing[DEBUG_RING_SIZE];
+
+// free running, masked on access, only the writers move head
+volatile uint16_t debugHead = 0U;
+volatile uint16_t debugTail = 0U;
+volatile uint32_t debugDropCount = 0U;
+
+bool debugWrite(const uint8_t *data, uint16_t size) {
+	CriticalSection critical;
+	uint16_t head = debugHead;
+
+	if ((uint16_t)(DEBUG_RING_SIZE - (uint16_t)(head - debugTail)) < size) {
+		debugDropCount++;
+		return false;
+	}
+
+	uint16_t offset = head & (DEBUG_RING_SIZE - 1U);
+	uint16_t first = DEBUG_RING_SIZE - offset;
+	if (first > size) {
+		first = size;
+	}
+	memcpy(&debugRing[offset], data, first);
+	memcpy(debugRing, data + first, size - first);
+
+	debugHead = head + size;
+	return true;
 }
 
-#endif
+uint16_t debugPoll(void) {
+	uint16_t sent = 0U;
+
+	while (true) {
+		uint16_t head;
+		{
+			CriticalSection critical;
+			head = debugHead;
+		}
+
+		uint16_t tail = debugTail;
+		uint16_t pending = head - tail;
+		int room = Serial.availableForWrite();
+		if (pending == 0U || room <= 0) {
+			break;
+		}
+
+		// sends up to the end of the ring, the rest next pass
+		uint16_t offset = tail & (DEBUG_RING_SIZE - 1U);
+		uint16_t size = DEBUG_RING_SIZE - offset;
+		if (size > pending) {
+			size = pending;
+		}
+		if ((int)size > room) {
+			size = (uint16_t)room;
+		}
+		Serial.write(&debugRing[offset], size);
+
+		{
+			CriticalSection critical;
+			debugTail = tail + size;
+		}
+		sent += size;
+	}
+
+	return sent;
+}
+
+void debugFlush(void) {
+	while (true) {
+		uint16_t pending;
+		{
+			CriticalSection critical;
+			pending = debugHead - debugTail;
+		}
+		if (pending == 0U) {
+			break;
+		}
+		if (debugPoll() == 0U) {
+			delay(1);
+		}
+	}
+	Serial.flush();
+}
+
+uint32_t debugDropped(void) {
+	CriticalSection critical;
+	return debugDropCount;
+}
+
+void debugSetLevel(uint8_t level) {
+	debugLevel = level > DEBUG_LEVEL ? DEBUG_LEVEL : level;
+}
+
+void debugSetCategories(uint16_t categories) {
+	debugCategories = categories;
+}
+
+void printTag(const __FlashStringHelper * tag) {
+	DebugLine line;
+	line.length = 0U;
+	debugLineAppend(&line, "[", 1U);
+	debugLineFlash(&line, (PGM_P)tag);
+	debugLineAppend(&line, "]:", 2U);
+	debugWrite((const uint8_t*)line.text, line.length);
+}
 
-#ifdef __ERROR_DEBUG__
 void printError(void) {
 	printTag(F("Err"));
 }
-#endif
 
-#ifdef __NVM_DEBUG__
 void printNVM(void) {
 	printTag(F("NVM"));
 }
-#endif
\ No newline at end of file
+
+#endif
+
+/**
+ * Prints a 64 bit integer through the formatter, for
+ * cores whose Print has no long long overloads
+ * 
+ * @param PRINT64 if the core prints long long itself
+ * @param T int64_t or uint64_t
+ */
+template <bool PRINT64, typename T>
+struct DebugPrint64 {
+	static void print(T value) {
+		char buffer[FORMAT_BUFFER_SIZE];
+		formatNumber(buffer, value, DEC);
+		Serial.print(buffer);
+	}
+};
+
+/**
+ * Hands 64 bit integers to the core's Print
+ */
+template <typename T>
+struct DebugPrint64<true, T> {
+	static void print(T value) {
+		Serial.print(value, DEC);
+	}
+};
+
+void printInt64(int64_t value) {
+	DebugPrint64<Board::print64, int64_t>::print(value);
+}
+
+void printInt64(uint64_t value) {
+	DebugPrint64<Board::print64, uint64_t>::print(value);
+}
+
+#if DEBUG_LEVEL > DEBUG_LEVEL_NONE
+
+void debugFrameBegin(DebugFrame *frame, uint32_t token) {
+	frame->data[0] = DEBUG_FRAME_SYNC;
+	frame->data[1] = (uint8_t)token;
+	frame->data[2] = (uint8_t)(token >> 8);
+	frame->data[3] = (uint8_t)(token >> 16);
+	frame->data[4] = (uint8_t)(token >> 24);
+	frame->data[5] = 0U;
+	frame->length = 6U;
+}
+
+void debugFrameArg(DebugFrame *frame, uint8_t argType, const void *data, uint8_t size) {
+	bool sized = argType == DEBUG_ARG_STRING;
+	uint8_t overhead = sized ? 2U : 1U;
+	uint8_t room = DEBUG_FRAME_PAYLOAD - frame->data[5];
+
+	// strings are cut to fit, other arguments are dropped
+	if (sized && overhead + size > room && room > overhead) {
+		size = room - overhead;
+	}
+	uint8_t needed = overhead + size;
+
+	if (needed > room) {
+		return;
+	}
+
+	frame->data[frame->length++] = argType;
+	if (sized) {
+		frame->data[frame->length++] = size;
+	}
+	memcpy(&frame->data[frame->length], data, size);
+	frame->length += size;
+	frame->data[5] += needed;
+}
+
+void debugTokenArg(DebugFrame *frame, const __FlashStringHelper *value) {
+	char text[DEBUG_FRAME_PAYLOAD];
+	PGM_P address = (PGM_P)value;
+	uint8_t size = 0U;
+
+	while (size < DEBUG_FRAME_PAYLOAD) {
+		text[size] = (char)pgm_read_byte(address + size);
+		if (text[size] == '\0') {
+			break;
+		}
+		size++;
+	}
+
+	debugFrameArg(frame, DEBUG_ARG_STRING, text, size);
+}
+
+void debugFrameEnd(DebugFrame *frame) {
+	// crc-8 0x07 over everything after the sync byte
+	uint8_t crc = 0U;
+	for (uint8_t i = 1U; i < frame->length; i++) {
+		crc ^= frame->data[i];
+		for (uint8_t bit = 0U; bit < 8U; bit++) {
+			crc = (crc & 0x80U) ? (uint8_t)((crc << 1) ^ 0x07U) : (uint8_t)(crc << 1);
+		}
+	}
+	frame->data[frame->length++] = crc;
+
+	debugWrite(frame->data, frame->length);
+}
+
+void debugLineAppend(DebugLine *line, const char *text, uint8_t size) {
+	// room is kept for the line ending
+	uint8_t room = DEBUG_LINE_SIZE - 2U - line->length;
+	if (size > room) {
+		size = room;
+	}
+	memcpy(&line->text[line->length], text, size);
+	line->length += size;
+}
+
+void debugLineFlash(DebugLine *line, PGM_P text) {
+	while (line->length < DEBUG_LINE_SIZE - 2U) {
+		char character = (char)pgm_read_byte(text++);
+		if (character == '\0') {
+			break;
+		}
+		line->text[line->length++] = character;
+	}
+}
+
+void debugLineEnd(DebugLine *line) {
+	// same ending as Serial.println()
+	#ifdef HOSTLINUX
+		line->text[line->length++] = '\n';
+	#else
+		line->text[line->length++] = '\r';
+		line->text[line->length++] = '\n';
+	#endif
+	debugWrite((const uint8_t*)line->text, line->length);
+}
+
+PGM_P debugTextSegment(DebugLine *line, PGM_P format) {
+	while (true) {
+		char character = (char)pgm_read_byte(format);
+		if (character == '\0') {
+			return NULL;
+		}
+		if (character == '{' && (char)pgm_read_byte(format + 1) == '}') {
+			return format + 2;
+		}
+		if (line->length < DEBUG_LINE_SIZE - 2U) {
+			line->text[line->length++] = character;
+		}
+		format++;
+	}
+}
+
+#endif
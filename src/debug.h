@@ -21,69 +21,511 @@
 
 #include <Arduino.h>
 #include "compile_flags.h"
+#include "board_traits.h"
+#include "format.h"
 
-#ifdef __TAG_DEBUG__
+#if DEBUG_LEVEL > DEBUG_LEVEL_NONE
 /**
- * Prints formatted tag to serial monitor '[tag]:'
+ * Queues formatted tag for the serial monitor '[tag]:'
  * 
  * @param tag tag formatted with F()
  * @return void
  */
 void printTag(const __FlashStringHelper * tag);
-#endif
 
-#ifdef __ERROR_DEBUG__
 /**
- * Prints error tag '[Err]:'
+ * Queues error tag '[Err]:'
  * 
  * @return void
  */
 void printError(void);
-#endif
 
-#ifdef __NVM_DEBUG__
 /**
- * Prints nvm tag '[NVM]:'
+ * Queues nvm tag '[NVM]:'
  * 
  * @return void
  */
 void printNVM(void);
 #endif
 
-#ifndef INT64_SUPPORT
+/**
+ * Prints a 64 bit integer to the serial monitor, boards
+ * without Board::print64 can't Serial.print() it
+ * 
+ * @param value integer to print
+ */
+void printInt64(int64_t value);
 
 /**
- * Prints a 64 bit integer to the serial monitor
+ * Prints an unsigned 64 bit integer to the serial monitor
  * 
  * @param value integer to print
  */
-template <typename T>
-void printInt64(T value) {
+void printInt64(uint64_t value);
+
+/****************************
+ * Debug Ring
+ * 
+ * Debug output is queued in a ring of DEBUG_RING_SIZE
+ * bytes instead of going to Serial, so a log site never
+ * waits on the UART. Each line or frame is queued whole
+ * from any task or interrupt, a line that doesn't fit is
+ * dropped and counted. Call debugPoll() from loop() or
+ * other idle time to send what Serial can take.
+****************************/
 
-	bool sign = false;
+#if DEBUG_LEVEL > DEBUG_LEVEL_NONE
+
+/**
+ * Queues debug output, safe from interrupts
+ * 
+ * @param data bytes to queue
+ * @param size number of bytes
+ * 
+ * @return if the bytes were queued, false if dropped
+ */
+bool debugWrite(const uint8_t *data, uint16_t size);
+
+/**
+ * Sends queued debug output without waiting on Serial,
+ * only call it from one task
+ * 
+ * @return number of bytes sent
+ */
+uint16_t debugPoll(void);
+
+/**
+ * Sends all queued debug output, waiting on Serial,
+ * for before a reset, sleep or exit
+ */
+void debugFlush(void);
+
+/**
+ * Gets how many lines or frames were dropped because
+ * the ring was full
+ * 
+ * @return dropped count since start
+ */
+uint32_t debugDropped(void);
+
+#else
+
+inline uint16_t debugPoll(void) {
+	return 0U;
+}
+
+inline void debugFlush(void) {}
+
+inline uint32_t debugDropped(void) {
+	return 0U;
+}
+
+#endif
+
+/****************************
+ * Log Sites
+ * 
+ * Each log site prints one line, each {} in the format
+ * is replaced by the next argument:
+ * 
+ * LOG_NVM("EEPROM wrote value '{}' from key {}", value, key);
+ * 
+ * With DEBUG_TOKENIZED the format never reaches flash,
+ * the site sends a binary frame holding a hash of its
+ * tag and format plus the raw arguments instead, which
+ * extras/tools/log_tokens.py turns back into text
+****************************/
+
+/**
+ * Hashes a log site with 32 bit FNV-1a at compile time
+ * 
+ * @param text tag, '|' and format of the site
+ * @param hash hash of the text before
+ * 
+ * @return token of the site
+ */
+constexpr uint32_t debugHash(const char *text, uint32_t hash = 2166136261UL) {
+	return *text ? debugHash(text + 1, (hash ^ (uint8_t)*text) * 16777619UL) : hash;
+}
+
+/**
+ * Forces a token to be computed while compiling
+ * 
+ * @param TOKEN token of the site
+ */
+template <uint32_t TOKEN>
+struct DebugToken {
+	static const uint32_t value = TOKEN;
+};
+
+#if DEBUG_LEVEL > DEBUG_LEVEL_NONE
+
+// first byte of a tokenized log frame
+#define DEBUG_FRAME_SYNC 0xA5U
+
+// most bytes of arguments in one frame, the rest are dropped
+#ifndef DEBUG_FRAME_PAYLOAD
+#define DEBUG_FRAME_PAYLOAD 48U
+#endif
+
+// type of a tokenized argument, sizes follow VarType
+enum DebugArgType {
+	DEBUG_ARG_BOOL = 1,
+	DEBUG_ARG_INT8, DEBUG_ARG_UINT8,
+	DEBUG_ARG_INT16, DEBUG_ARG_UINT16,
+	DEBUG_ARG_INT32, DEBUG_ARG_UINT32,
+	DEBUG_ARG_INT64, DEBUG_ARG_UINT64,
+	DEBUG_ARG_FLOAT, DEBUG_ARG_DOUBLE,
+	DEBUG_ARG_STRING
+};
+
+/**
+ * Binary log frame being built on the stack
+ */
+struct DebugFrame {
+	uint8_t length;
+	uint8_t data[7U + DEBUG_FRAME_PAYLOAD];
+};
+
+/**
+ * Starts a frame: sync, token and payload length
+ * 
+ * @param frame frame to start
+ * @param token token of the site
+ */
+void debugFrameBegin(DebugFrame *frame, uint32_t token);
+
+/**
+ * Adds an argument to a frame, dropped if it doesn't fit
+ * 
+ * @param frame frame to add to
+ * @param argType type of the argument
+ * @param data bytes of the argument, little endian
+ * @param size number of bytes
+ */
+void debugFrameArg(DebugFrame *frame, uint8_t argType, const void *data, uint8_t size);
+
+/**
+ * Adds a crc to a frame and queues it
+ * 
+ * @param frame frame to send
+ */
+void debugFrameEnd(DebugFrame *frame);
+
+/**
+ * Text log line being built on the stack
+ */
+struct DebugLine {
+	uint8_t length;
+	char text[DEBUG_LINE_SIZE];
+};
+
+/**
+ * Adds text to a line, cut once the line is full
+ * 
+ * @param line line to add to
+ * @param text text to add
+ * @param size number of characters
+ */
+void debugLineAppend(DebugLine *line, const char *text, uint8_t size);
+
+/**
+ * Adds flash text to a line
+ * 
+ * @param line line to add to
+ * @param text text in flash
+ */
+void debugLineFlash(DebugLine *line, PGM_P text);
+
+/**
+ * Ends a line and queues it
+ * 
+ * @param line line to send
+ */
+void debugLineEnd(DebugLine *line);
+
+/**
+ * Adds a format up to its next {} to a line
+ * 
+ * @param line line to add to
+ * @param format format in flash
+ * 
+ * @return format after the {}, NULL once the format ended
+ */
+PGM_P debugTextSegment(DebugLine *line, PGM_P format);
+
+/**
+ * Gets the tokenized type of an argument
+ * 
+ * @return type of T
+ */
+template <typename T>
+inline uint8_t debugArgType(void) {
+	if ((T)0.5 != (T)0) {
+		return sizeof(T) == sizeof(float) ? DEBUG_ARG_FLOAT : DEBUG_ARG_DOUBLE;
+	}
 
-	if (value < 0) {
-		sign = true;
+	bool isSigned = (T)-1 < (T)0;
+	switch (sizeof(T)) {
+		case 1:
+			return isSigned ? DEBUG_ARG_INT8 : DEBUG_ARG_UINT8;
+		case 2:
+			return isSigned ? DEBUG_ARG_INT16 : DEBUG_ARG_UINT16;
+		case 4:
+			return isSigned ? DEBUG_ARG_INT32 : DEBUG_ARG_UINT32;
+		default:
+			return isSigned ? DEBUG_ARG_INT64 : DEBUG_ARG_UINT64;
 	}
+}
+
+template <typename T>
+inline void debugTokenArg(DebugFrame *frame, T value) {
+	debugFrameArg(frame, debugArgType<T>(), &value, sizeof(T));
+}
+
+inline void debugTokenArg(DebugFrame *frame, bool value) {
+	debugFrameArg(frame, DEBUG_ARG_BOOL, &value, 1U);
+}
+
+inline void debugTokenArg(DebugFrame *frame, const char *value) {
+	size_t size = strlen(value);
+	debugFrameArg(frame, DEBUG_ARG_STRING, value, size > DEBUG_FRAME_PAYLOAD ? DEBUG_FRAME_PAYLOAD : (uint8_t)size);
+}
 
-	if (value == 0) {
-		Serial.print(F("0"));
-		return;
+inline void debugTokenArg(DebugFrame *frame, char *value) {
+	debugTokenArg(frame, (const char*)value);
+}
+
+/**
+ * Adds a flash string to a frame
+ * 
+ * @param frame frame to add to
+ * @param value string formatted with F()
+ */
+void debugTokenArg(DebugFrame *frame, const __FlashStringHelper *value);
+
+inline void debugTokenArgs(DebugFrame *frame) {}
+
+template <typename T, typename... ARGS>
+inline void debugTokenArgs(DebugFrame *frame, T value, ARGS... args) {
+	debugTokenArg(frame, value);
+	debugTokenArgs(frame, args...);
+}
+
+/**
+ * Sends a tokenized log frame
+ * 
+ * @param token token of the site
+ * @param args arguments of the site
+ */
+template <typename... ARGS>
+void debugToken(uint32_t token, ARGS... args) {
+	DebugFrame frame;
+	debugFrameBegin(&frame, token);
+	debugTokenArgs(&frame, args...);
+	debugFrameEnd(&frame);
+}
+
+template <typename T>
+inline void debugTextArg(DebugLine *line, T value) {
+	char buffer[FORMAT_BUFFER_SIZE];
+	uint8_t size;
+
+	if ((T)0.5 != (T)0) {
+		size = formatFloat(buffer, (double)value, 2U);
+	}
+	else if (sizeof(T) > sizeof(uint32_t)) {
+		if ((T)-1 < (T)0) {
+			size = formatSigned(buffer, (int64_t)value, DEC);
+		}
+		else {
+			size = formatUnsigned(buffer, (uint64_t)value, DEC);
+		}
 	}
+	else if ((T)-1 < (T)0) {
+		size = formatSigned(buffer, (int32_t)value, DEC);
+	}
+	else {
+		size = formatUnsigned(buffer, (uint32_t)value, DEC);
+	}
+
+	debugLineAppend(line, buffer, size);
+}
+
+inline void debugTextArg(DebugLine *line, bool value) {
+	debugLineAppend(line, value ? "1" : "0", 1U);
+}
+
+inline void debugTextArg(DebugLine *line, const char *value) {
+	size_t size = strlen(value);
+	debugLineAppend(line, value, size > DEBUG_LINE_SIZE ? DEBUG_LINE_SIZE : (uint8_t)size);
+}
 
-	String final = "";
+inline void debugTextArg(DebugLine *line, char *value) {
+	debugTextArg(line, (const char*)value);
+}
+
+inline void debugTextArg(DebugLine *line, const __FlashStringHelper *value) {
+	debugLineFlash(line, (PGM_P)value);
+}
 
-	while (value) {
-		int64_t digit = value % 10;
-		int8_t sdigit = abs(digit);
-		final = (String)sdigit + final;
-		value = (value - digit) / 10;
+inline void debugTextArgs(DebugLine *line, PGM_P format) {
+	while (format != NULL) {
+		format = debugTextSegment(line, format);
 	}
+}
 
-	if (sign) Serial.print(F("-"));
-	Serial.print(final);
+template <typename T, typename... ARGS>
+inline void debugTextArgs(DebugLine *line, PGM_P format, T value, ARGS... args) {
+	if (format != NULL) {
+		format = debugTextSegment(line, format);
+	}
+	debugTextArg(line, value);
+	debugTextArgs(line, format, args...);
 }
 
+/**
+ * Queues a log line '[tag]:text'
+ * 
+ * @param tag tag formatted with F()
+ * @param format format formatted with F()
+ * @param args arguments replacing each {}
+ */
+template <typename... ARGS>
+void debugText(const __FlashStringHelper *tag, const __FlashStringHelper *format, ARGS... args) {
+	DebugLine line;
+	line.length = 0U;
+	debugLineAppend(&line, "[", 1U);
+	debugLineFlash(&line, (PGM_P)tag);
+	debugLineAppend(&line, "]:", 2U);
+	debugTextArgs(&line, (PGM_P)format, args...);
+	debugLineEnd(&line);
+}
+
+#endif
+
+#ifdef DEBUG_TOKENIZED
+#define DEBUG_LOG(tag, format, ...) \
+	debugToken(DebugToken<debugHash(tag "|" format)>::value, ##__VA_ARGS__)
+#else
+#define DEBUG_LOG(tag, format, ...) debugText(F(tag), F(format), ##__VA_ARGS__)
+#endif
+
+/****************************
+ * Log Levels
+ * 
+ * LOG_E, LOG_W, LOG_I and LOG_T log at error, warning,
+ * info and trace level in a category, which also gives
+ * the tag of the line:
+ * 
+ * LOG_W(NVM, "EEPROM not started");
+ * 
+ * Sites past DEBUG_LEVEL compile to nothing. Sites built
+ * in only log while their level and category are enabled
+ * at runtime, which costs one compare when they are off.
+****************************/
+
+// categories for debugSetCategories(), each with its tag
+#define DEBUG_CAT_ERR 0x0001U
+#define DEBUG_CAT_NVM 0x0002U
+#define DEBUG_CAT_TAG 0x0004U
+#define DEBUG_CAT_ACQ 0x0008U
+#define DEBUG_CAT_TRIG 0x0010U
+#define DEBUG_CAT_DEC 0x0020U
+#define DEBUG_CAT_LINK 0x0040U
+#define DEBUG_CAT_ALL 0xFFFFU
+
+#define DEBUG_TAG_ERR "Err"
+#define DEBUG_TAG_NVM "NVM"
+#define DEBUG_TAG_ACQ "ACQ"
+#define DEBUG_TAG_TRIG "Trig"
+#define DEBUG_TAG_DEC "Dec"
+#define DEBUG_TAG_LINK "Link"
+
+#if DEBUG_LEVEL > DEBUG_LEVEL_NONE
+
+extern volatile uint8_t debugLevel;
+extern volatile uint16_t debugCategories;
+
+/**
+ * Sets the most detailed level logged, levels past
+ * DEBUG_LEVEL stay out
+ * 
+ * @param level DEBUG_LEVEL_NONE to DEBUG_LEVEL_TRACE
+ */
+void debugSetLevel(uint8_t level);
+
+/**
+ * Sets the categories logged
+ * 
+ * @param categories DEBUG_CAT_ flags ored together
+ */
+void debugSetCategories(uint16_t categories);
+
+/**
+ * Checks if a site logs right now
+ * 
+ * @param level level of the site
+ * @param category category of the site
+ * 
+ * @return if the site should log
+ */
+inline bool debugEnabled(uint8_t level, uint16_t category) {
+	return level <= debugLevel && (debugCategories & category) != 0U;
+}
+
+#define DEBUG_SITE(level, category, tag, format, ...) \
+	do { \
+		if (debugEnabled(level, category)) { \
+			DEBUG_LOG(tag, format, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+#else
+
+inline void debugSetLevel(uint8_t level) {}
+
+inline void debugSetCategories(uint16_t categories) {}
+
+#endif
+
+#if DEBUG_LEVEL >= DEBUG_LEVEL_ERROR
+#define LOG_E(category, format, ...) DEBUG_SITE(DEBUG_LEVEL_ERROR, \
+	DEBUG_CAT_##category, DEBUG_TAG_##category, format, ##__VA_ARGS__)
+#else
+#define LOG_E(category, format, ...)
+#endif
+
+#if DEBUG_LEVEL >= DEBUG_LEVEL_WARN
+#define LOG_W(category, format, ...) DEBUG_SITE(DEBUG_LEVEL_WARN, \
+	DEBUG_CAT_##category, DEBUG_TAG_##category, format, ##__VA_ARGS__)
+#else
+#define LOG_W(category, format, ...)
+#endif
+
+#if DEBUG_LEVEL >= DEBUG_LEVEL_INFO
+#define LOG_I(category, format, ...) DEBUG_SITE(DEBUG_LEVEL_INFO, \
+	DEBUG_CAT_##category, DEBUG_TAG_##category, format, ##__VA_ARGS__)
+#else
+#define LOG_I(category, format, ...)
+#endif
+
+#if DEBUG_LEVEL >= DEBUG_LEVEL_TRACE
+#define LOG_T(category, format, ...) DEBUG_SITE(DEBUG_LEVEL_TRACE, \
+	DEBUG_CAT_##category, DEBUG_TAG_##category, format, ##__VA_ARGS__)
+#else
+#define LOG_T(category, format, ...)
+#endif
+
+// nvm trace and errors, the most common sites
+#define LOG_NVM(format, ...) LOG_T(NVM, format, ##__VA_ARGS__)
+#define LOG_ERROR(format, ...) LOG_E(ERR, format, ##__VA_ARGS__)
+
+// sketch logs with their own tag at info level
+#if DEBUG_LEVEL >= DEBUG_LEVEL_INFO
+#define LOG_TAG(tag, format, ...) DEBUG_SITE(DEBUG_LEVEL_INFO, DEBUG_CAT_TAG, tag, format, ##__VA_ARGS__)
+#else
+#define LOG_TAG(tag, format, ...)
 #endif
 
 #endif
\ No newline at end of file
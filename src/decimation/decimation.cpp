@@ -0,0 +1,200 @@
+/*
+	decimation.cpp - reduces sample blocks to display points
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "decimation.h"
+#include "../acquisition/acquisition.h"
+#include "../nvm/eeprom_addresses.h"
+
+#define DEC_MID_SCALE ((SampleWord)(1UL << (Board::adcBits - 1U)))
+
+SampleWord decOutput[DEC_MAX_POINTS * 2U];
+
+// last peak point of each channel
+SampleWord decLast[Board::adcChannels];
+
+bool decActive = false;
+uint8_t decMode = DEC_MINMAX;
+uint16_t decPoints = 0U;
+uint8_t decStride = 0U;
+
+/**
+ * Decimates a block, one span of every channel at a time
+ *
+ * @param MODE DecMode of the points
+ * @param SINGLE if the block is one channel, so spans are contiguous
+ * @param samples block of whole sample sets
+ * @param sets sample sets in the block
+ * @param points points per channel, at most sets
+ *
+ * @return samples in the points
+ */
+template <uint8_t MODE, bool SINGLE>
+uint16_t decReduceBlock(const SampleWord *samples, uint16_t sets, uint16_t points) {
+	const uint8_t stride = SINGLE ? 1U : decStride;
+
+	// spans differ by at most one set, spread evenly
+	const uint16_t base = (uint16_t)(sets / points);
+	const uint16_t extra = (uint16_t)(sets % points);
+	uint16_t error = 0U;
+
+	SampleWord *out = decOutput;
+	for (uint16_t point = 0U; point < points; point++) {
+		uint16_t span = base;
+		error = (uint16_t)(error + extra);
+		if (error >= points) {
+			error = (uint16_t)(error - points);
+			span++;
+		}
+
+		for (uint8_t channel = 0U; channel < stride; channel++) {
+			const SampleWord *sample = samples + channel;
+			const SampleWord *end = sample + (uint32_t)span * stride;
+
+			if (MODE == DEC_AVERAGE) {
+				uint32_t sum = 0UL;
+				for (; sample < end; sample += stride) {
+					sum += *sample;
+				}
+				*out++ = (SampleWord)((sum + span / 2U) / span);
+				continue;
+			}
+
+			SampleWord low = *sample;
+			SampleWord high = *sample;
+			for (sample += stride; sample < end; sample += stride) {
+				low = *sample < low ? *sample : low;
+				high = *sample > high ? *sample : high;
+			}
+
+			if (MODE == DEC_MINMAX) {
+				*out++ = low;
+				*out++ = high;
+			}
+			else {
+				// follows a glitch away from the trace, then back
+				SampleWord last = decLast[channel];
+				int32_t down = (int32_t)last - (int32_t)low;
+				int32_t up = (int32_t)high - (int32_t)last;
+				last = down > up ? low : high;
+				decLast[channel] = last;
+				*out++ = last;
+			}
+		}
+		samples += (uint32_t)span * stride;
+	}
+	return (uint16_t)(out - decOutput);
+}
+
+/****************************
+ * Decimation Methods
+****************************/
+
+bool decCheckConfig(const DecConfig &config, uint8_t channels) {
+	uint8_t stride = acqChannelCount(channels);
+	return config.mode < DEC_MODES &&
+		stride != 0U &&
+		config.points != 0U &&
+		(uint32_t)config.points * stride <= DEC_MAX_POINTS;
+}
+
+bool decLoadConfig(DecConfig *config, uint8_t channels) {
+	DecConfig stored;
+	if (nvmGetField<NVMDecModeField>(&stored.mode) &&
+		nvmGetField<NVMDecPointsField>(&stored.points) &&
+		decCheckConfig(stored, channels)) {
+
+		*config = stored;
+		return true;
+	}
+
+	uint8_t stride = acqChannelCount(channels);
+	uint16_t points = (uint16_t)(DEC_MAX_POINTS / (stride != 0U ? stride : 1U));
+
+	config->mode = DEC_MINMAX;
+	config->points = points < DEC_DEFAULT_POINTS ? points : (uint16_t)DEC_DEFAULT_POINTS;
+	return false;
+}
+
+bool decInit(uint8_t channels) {
+	DecConfig config;
+	if (!decLoadConfig(&config, channels)) {
+		LOG_I(DEC, "No stored decimation, using defaults");
+	}
+	return decBegin(config, channels);
+}
+
+bool decBegin(const DecConfig &config, uint8_t channels) {
+	if (!decCheckConfig(config, channels)) {
+		LOG_E(DEC, "Can't decimate channels {} to {} points in mode {}", channels, config.points, config.mode);
+		decActive = false;
+		return false;
+	}
+
+	decMode = config.mode;
+	decPoints = config.points;
+	decStride = acqChannelCount(channels);
+	for (uint8_t channel = 0U; channel < Board::adcChannels; channel++) {
+		decLast[channel] = DEC_MID_SCALE;
+	}
+	decActive = true;
+
+	nvmWriteField<NVMDecModeField>(config.mode);
+	nvmWriteField<NVMDecPointsField>(config.points);
+
+	LOG_I(DEC, "Decimating to {} points in mode {}", config.points, config.mode);
+	return true;
+}
+
+uint16_t decReduce(const SampleWord *samples, uint16_t count, const SampleWord **points) {
+	if (!decActive) {
+		return 0U;
+	}
+	uint16_t sets = (uint16_t)(count / decStride);
+	if (sets == 0U) {
+		return 0U;
+	}
+
+	uint16_t spans = decPoints < sets ? decPoints : sets;
+	bool single = decStride == 1U;
+	uint16_t length;
+
+	switch (decMode) {
+		case DEC_AVERAGE:
+			length = single ?
+				decReduceBlock<DEC_AVERAGE, true>(samples, sets, spans) :
+				decReduceBlock<DEC_AVERAGE, false>(samples, sets, spans);
+			break;
+		case DEC_PEAK:
+			length = single ?
+				decReduceBlock<DEC_PEAK, true>(samples, sets, spans) :
+				decReduceBlock<DEC_PEAK, false>(samples, sets, spans);
+			break;
+		default:
+			length = single ?
+				decReduceBlock<DEC_MINMAX, true>(samples, sets, spans) :
+				decReduceBlock<DEC_MINMAX, false>(samples, sets, spans);
+			break;
+	}
+
+	*points = decOutput;
+	return length;
+}
+
+uint8_t decPointSamples(void) {
+	return decMode == DEC_MINMAX ? 2U : 1U;
+}
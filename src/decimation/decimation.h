@@ -0,0 +1,126 @@
+/*
+	decimation.h - reduces sample blocks to display points
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef DECIMATION_H
+#define DECIMATION_H
+
+#include <Arduino.h>
+#include "../compile_flags.h"
+#include "../board_traits.h"
+#include "../debug.h"
+
+/****************************
+ * Decimation
+ *
+ * An app only draws about one point per screen column,
+ * so each block, an acquisition buffer or a trigger
+ * frame, is cut into the configured number of equal
+ * spans per channel and each span becomes one point.
+ * Dropping samples would hide a glitch between points,
+ * the min/max and peak modes keep every extreme.
+ *
+ * Points are interleaved like the samples, from the
+ * lowest channel up. Blocks shorter than the point count
+ * give one point per sample set.
+****************************/
+
+// points per channel used when none are stored, about a screen's width
+#ifndef DEC_DEFAULT_POINTS
+#define DEC_DEFAULT_POINTS 320U
+#endif
+
+enum DecMode : uint8_t {
+	DEC_MINMAX, // lowest then highest sample of the span
+	DEC_AVERAGE, // rounded mean of the span
+	DEC_PEAK, // extreme of the span furthest from the last point
+	DEC_MODES
+};
+
+/**
+ * How blocks are decimated
+ */
+struct DecConfig {
+	uint8_t mode; // DecMode
+	uint16_t points; // per channel per block
+};
+
+/****************************
+ * Decimation Methods
+****************************/
+
+/**
+ * Starts decimation with the config stored by the last
+ * decBegin(), or min/max at DEC_DEFAULT_POINTS
+ *
+ * @param channels channel bits of the blocks decimated
+ *
+ * @return if decimation started
+ */
+bool decInit(uint8_t channels);
+
+/**
+ * Starts decimation and stores the config for the next
+ * decInit()
+ *
+ * @param config mode and points
+ * @param channels channel bits of the blocks decimated
+ *
+ * @return if config was valid
+ */
+bool decBegin(const DecConfig &config, uint8_t channels);
+
+/**
+ * Checks a config fits the output with a set of channels
+ *
+ * @param config mode and points
+ * @param channels channel bits of the blocks decimated
+ *
+ * @return if config is valid
+ */
+bool decCheckConfig(const DecConfig &config, uint8_t channels);
+
+/**
+ * Reads the config stored by decBegin()
+ *
+ * @param config set to the stored config, the defaults if none is valid
+ * @param channels channel bits the config has to work with
+ *
+ * @return if a stored config was found
+ */
+bool decLoadConfig(DecConfig *config, uint8_t channels);
+
+/**
+ * Decimates a block, the points stay valid until the
+ * next call
+ *
+ * @param samples block of whole sample sets, starting at the lowest channel
+ * @param count samples in the block
+ * @param points set to the points
+ *
+ * @return samples in the points, 0 if not started
+ */
+uint16_t decReduce(const SampleWord *samples, uint16_t count, const SampleWord **points);
+
+/**
+ * Gets the samples each point of a channel takes
+ *
+ * @return 2 for min/max, 1 otherwise
+ */
+uint8_t decPointSamples(void);
+
+#endif
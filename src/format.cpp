@@ -0,0 +1,183 @@
+/*
+	format.cpp - allocation free number formatting
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "format.h"
+
+/**
+ * Divides a value by 10
+ *
+ * @param value value to divide, replaced by the quotient
+ *
+ * @return remainder of the division
+ */
+template <typename T>
+uint8_t formatDivMod10(T *value) {
+	if (!Board::hardwareDivide) {
+		// q ~= n * 0.8 / 8, then corrects the estimate with the remainder
+		T n = *value;
+		T q = (n >> 1) + (n >> 2);
+		q += q >> 4;
+		q += q >> 8;
+		q += q >> 16;
+		if (sizeof(T) > 4U) {
+			q += q >> 16 >> 16;
+		}
+		q >>= 3;
+
+		uint8_t remainder = (uint8_t)(n - ((q << 3) + (q << 1)));
+		while (remainder > 9U) {
+			q++;
+			remainder -= 10U;
+		}
+
+		*value = q;
+		return remainder;
+	}
+
+	// compilers turn a constant divide into a multiply
+	T q = *value / 10U;
+	uint8_t remainder = (uint8_t)(*value - q * 10U);
+	*value = q;
+	return remainder;
+}
+
+/**
+ * Writes the digits of a value, most significant first
+ *
+ * @param buffer buffer to write to
+ * @param value value to format
+ * @param base DEC or HEX
+ *
+ * @return number of characters written, excluding the terminator
+ */
+template <typename T>
+uint8_t formatDigits(char *buffer, T value, uint8_t base) {
+	char digits[20];
+	uint8_t count = 0U;
+
+	if (base == HEX) {
+		do {
+			uint8_t nibble = (uint8_t)(value & 0x0FU);
+			digits[count++] = (char)(nibble < 10U ? '0' + nibble : 'A' + nibble - 10U);
+			value >>= 4;
+		} while (value);
+	}
+	else {
+		do {
+			digits[count++] = (char)('0' + formatDivMod10(&value));
+		} while (value);
+	}
+
+	for (uint8_t i = 0U; i < count; i++) {
+		buffer[i] = digits[count - 1U - i];
+	}
+	buffer[count] = '\0';
+	return count;
+}
+
+/**
+ * Writes a signed value with its sign
+ *
+ * @param buffer buffer to write to
+ * @param value value to format
+ * @param base DEC or HEX
+ *
+ * @return number of characters written, excluding the terminator
+ */
+template <typename S, typename U>
+uint8_t formatSignedDigits(char *buffer, S value, uint8_t base) {
+	if (base == HEX || value >= 0) {
+		return formatDigits(buffer, (U)value, base);
+	}
+
+	// negates unsigned so the minimum value doesn't overflow
+	buffer[0] = '-';
+	return 1U + formatDigits(buffer + 1, (U)(0U - (U)value), DEC);
+}
+
+uint8_t formatUnsigned(char *buffer, uint32_t value, uint8_t base) {
+	return formatDigits(buffer, value, base);
+}
+
+uint8_t formatUnsigned(char *buffer, uint64_t value, uint8_t base) {
+	// most values fit 32 bits, which is far cheaper without 64 bit registers
+	if (!Board::native64 && value <= 0xFFFFFFFFULL) {
+		return formatDigits(buffer, (uint32_t)value, base);
+	}
+	return formatDigits(buffer, value, base);
+}
+
+uint8_t formatSigned(char *buffer, int32_t value, uint8_t base) {
+	return formatSignedDigits<int32_t, uint32_t>(buffer, value, base);
+}
+
+uint8_t formatSigned(char *buffer, int64_t value, uint8_t base) {
+	if (!Board::native64 && base != HEX && value >= INT32_MIN && value <= INT32_MAX) {
+		return formatSignedDigits<int32_t, uint32_t>(buffer, (int32_t)value, base);
+	}
+	return formatSignedDigits<int64_t, uint64_t>(buffer, value, base);
+}
+
+uint8_t formatFloat(char *buffer, double value, uint8_t decimals) {
+	uint8_t length = 0U;
+
+	if (isnan(value)) {
+		strcpy(buffer, "nan");
+		return 3U;
+	}
+	if (isinf(value)) {
+		strcpy(buffer, value < 0.0 ? "-inf" : "inf");
+		return value < 0.0 ? 4U : 3U;
+	}
+	if (decimals > FORMAT_MAX_DECIMALS) {
+		decimals = FORMAT_MAX_DECIMALS;
+	}
+
+	if (value < 0.0) {
+		buffer[length++] = '-';
+		value = -value;
+	}
+
+	double rounding = 0.5;
+	for (uint8_t i = 0U; i < decimals; i++) {
+		rounding /= 10.0;
+	}
+	value += rounding;
+
+	if (value >= 18446744073709551615.0) {
+		strcpy(buffer, "ovf");
+		return 3U;
+	}
+
+	uint64_t whole = (uint64_t)value;
+	double remainder = value - (double)whole;
+	length += formatUnsigned(buffer + length, whole, DEC);
+
+	if (decimals > 0U) {
+		buffer[length++] = '.';
+	}
+	for (uint8_t i = 0U; i < decimals; i++) {
+		remainder *= 10.0;
+		uint8_t digit = (uint8_t)remainder;
+		buffer[length++] = (char)('0' + digit);
+		remainder -= digit;
+	}
+
+	buffer[length] = '\0';
+	return length;
+}
@@ -0,0 +1,146 @@
+/*
+	format.h - allocation free number formatting
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <Arduino.h>
+#include "compile_flags.h"
+#include "board_traits.h"
+
+/****************************
+ * Number Formatting
+ *
+ * Numbers are written into a buffer supplied by the
+ * caller, usually on the stack, and terminated. No
+ * heap is used so debug prints don't fragment RAM.
+****************************/
+
+// most decimals printed after the point of a float
+#define FORMAT_MAX_DECIMALS 9U
+
+// sign, 20 digits of a u64, point, decimals and terminator
+#define FORMAT_BUFFER_SIZE (1U + 20U + 1U + FORMAT_MAX_DECIMALS + 1U)
+
+/**
+ * Formats an unsigned integer
+ *
+ * @param buffer buffer of FORMAT_BUFFER_SIZE bytes to write to
+ * @param value value to format
+ * @param base DEC or HEX
+ *
+ * @return number of characters written, excluding the terminator
+ */
+uint8_t formatUnsigned(char *buffer, uint32_t value, uint8_t base);
+
+/**
+ * Formats an unsigned 64 bit integer
+ *
+ * @param buffer buffer of FORMAT_BUFFER_SIZE bytes to write to
+ * @param value value to format
+ * @param base DEC or HEX
+ *
+ * @return number of characters written, excluding the terminator
+ */
+uint8_t formatUnsigned(char *buffer, uint64_t value, uint8_t base);
+
+/**
+ * Formats a signed integer, hex prints the two's complement
+ *
+ * @param buffer buffer of FORMAT_BUFFER_SIZE bytes to write to
+ * @param value value to format
+ * @param base DEC or HEX
+ *
+ * @return number of characters written, excluding the terminator
+ */
+uint8_t formatSigned(char *buffer, int32_t value, uint8_t base);
+
+/**
+ * Formats a signed 64 bit integer, hex prints the two's complement
+ *
+ * @param buffer buffer of FORMAT_BUFFER_SIZE bytes to write to
+ * @param value value to format
+ * @param base DEC or HEX
+ *
+ * @return number of characters written, excluding the terminator
+ */
+uint8_t formatSigned(char *buffer, int64_t value, uint8_t base);
+
+/**
+ * Formats a float with a fixed number of decimals, rounded
+ * like Serial.print(). Values past the u64 range print "ovf"
+ *
+ * @param buffer buffer of FORMAT_BUFFER_SIZE bytes to write to
+ * @param value value to format
+ * @param decimals digits after the point, at most FORMAT_MAX_DECIMALS
+ *
+ * @return number of characters written, excluding the terminator
+ */
+uint8_t formatFloat(char *buffer, double value, uint8_t decimals);
+
+/****************************
+ * Type Dispatch
+****************************/
+
+inline uint8_t formatNumber(char *buffer, bool value) {
+	return formatUnsigned(buffer, (uint32_t)value, DEC);
+}
+
+inline uint8_t formatNumber(char *buffer, int8_t value, uint8_t base = DEC) {
+	return base == DEC ? formatSigned(buffer, (int32_t)value, DEC) :
+		formatUnsigned(buffer, (uint32_t)(uint8_t)value, base);
+}
+
+inline uint8_t formatNumber(char *buffer, uint8_t value, uint8_t base = DEC) {
+	return formatUnsigned(buffer, (uint32_t)value, base);
+}
+
+inline uint8_t formatNumber(char *buffer, int16_t value, uint8_t base = DEC) {
+	return base == DEC ? formatSigned(buffer, (int32_t)value, DEC) :
+		formatUnsigned(buffer, (uint32_t)(uint16_t)value, base);
+}
+
+inline uint8_t formatNumber(char *buffer, uint16_t value, uint8_t base = DEC) {
+	return formatUnsigned(buffer, (uint32_t)value, base);
+}
+
+inline uint8_t formatNumber(char *buffer, int32_t value, uint8_t base = DEC) {
+	return formatSigned(buffer, value, base);
+}
+
+inline uint8_t formatNumber(char *buffer, uint32_t value, uint8_t base = DEC) {
+	return formatUnsigned(buffer, value, base);
+}
+
+inline uint8_t formatNumber(char *buffer, int64_t value, uint8_t base = DEC) {
+	return formatSigned(buffer, value, base);
+}
+
+inline uint8_t formatNumber(char *buffer, uint64_t value, uint8_t base = DEC) {
+	return formatUnsigned(buffer, value, base);
+}
+
+inline uint8_t formatNumber(char *buffer, float value, uint8_t decimals = 2U) {
+	return formatFloat(buffer, (double)value, decimals);
+}
+
+inline uint8_t formatNumber(char *buffer, double value, uint8_t decimals = 2U) {
+	return formatFloat(buffer, value, decimals);
+}
+
+#endif
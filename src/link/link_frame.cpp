@@ -0,0 +1,203 @@
+/*
+	link_frame.cpp - binary frames for streaming samples
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "link_frame.h"
+#include "../nvm/generic_nvm.h"
+
+#define LINK_CRC_START 0xFFFFU
+
+LinkSink linkSink = NULL;
+uint16_t linkSequence = 0U;
+uint32_t linkRefusedCount = 0UL;
+
+/**
+ * Gets the payload length of a buffered header
+ *
+ * @param header whole header
+ *
+ * @return length in the header
+ */
+inline uint16_t linkHeaderLength(const uint8_t *header) {
+	return (uint16_t)(header[6] | (header[7] << 8));
+}
+
+/**
+ * Drops bytes from the front of the buffer and any up to
+ * the next sync after them
+ *
+ * @param parser parser to drop from
+ * @param count bytes to drop, at most those buffered
+ */
+void linkDrop(LinkParser *parser, uint32_t count) {
+	const uint8_t *sync = count < parser->fill ?
+		(const uint8_t*)memchr(&parser->buffer[count], LINK_SYNC, parser->fill - count) : NULL;
+	uint32_t next = sync == NULL ? parser->fill : (uint32_t)(sync - parser->buffer);
+
+	parser->skipped += next - count;
+	parser->fill -= next;
+	memmove(parser->buffer, &parser->buffer[next], parser->fill);
+}
+
+/**
+ * Drops the frame being gathered after a CRC failure,
+ * keeping what follows the next sync in it
+ *
+ * @param parser parser to resync
+ */
+void linkResync(LinkParser *parser) {
+	parser->corrupt++;
+	parser->skipped++;
+	linkDrop(parser, 1UL);
+}
+
+/****************************
+ * Link Methods
+****************************/
+
+void linkBegin(LinkSink sink) {
+	linkSink = sink;
+	linkSequence = 0U;
+	linkRefusedCount = 0UL;
+}
+
+bool linkSendFrame(uint8_t kind, uint8_t channels, const void *payload, uint16_t length) {
+	if (linkSink == NULL || length > LINK_MAX_PAYLOAD) {
+		return false;
+	}
+
+	uint8_t header[LINK_HEADER_SIZE] = {
+		LINK_SYNC, kind, channels, (uint8_t)Board::adcBits,
+		(uint8_t)linkSequence, (uint8_t)(linkSequence >> 8),
+		(uint8_t)length, (uint8_t)(length >> 8), 0U
+	};
+	header[8] = nvmCrc8(0U, &header[1], LINK_HEADER_SIZE - 2U);
+
+	uint16_t crc = nvmCrc16(LINK_CRC_START, &header[1], LINK_HEADER_SIZE - 1U);
+	crc = nvmCrc16(crc, (const uint8_t*)payload, length);
+	uint8_t trailer[LINK_CRC_SIZE] = {(uint8_t)crc, (uint8_t)(crc >> 8)};
+
+	LinkSpan spans[3] = {
+		{header, LINK_HEADER_SIZE},
+		{(const uint8_t*)payload, length},
+		{trailer, LINK_CRC_SIZE}
+	};
+	if (!linkSink(spans, 3U)) {
+		linkRefusedCount++;
+		return false;
+	}
+	linkSequence++;
+	return true;
+}
+
+bool linkSendSamples(const SampleWord *samples, uint16_t count, uint8_t channels, uint8_t kind) {
+	if ((uint32_t)count * sizeof(SampleWord) > LINK_MAX_PAYLOAD) {
+		return false;
+	}
+	return linkSendFrame(kind, channels, samples, (uint16_t)(count * sizeof(SampleWord)));
+}
+
+uint32_t linkRefused(void) {
+	return linkRefusedCount;
+}
+
+void linkParserReset(LinkParser *parser) {
+	parser->fill = 0UL;
+	parser->taken = 0UL;
+	parser->expected = 0U;
+	parser->started = false;
+	parser->frames = 0UL;
+	parser->skipped = 0UL;
+	parser->corrupt = 0UL;
+	parser->lost = 0UL;
+}
+
+bool linkParse(LinkParser *parser, const uint8_t *data, uint16_t size, uint16_t *used, LinkFrame *frame) {
+	uint8_t *buffer = parser->buffer;
+	uint16_t i = 0U;
+
+	// bytes after the last frame stay, they were buffered in a resync
+	if (parser->taken != 0UL) {
+		linkDrop(parser, parser->taken);
+		parser->taken = 0UL;
+	}
+
+	for (;;) {
+		// what the buffered bytes still need, checking each part once whole
+		uint32_t whole = LINK_HEADER_SIZE;
+		if (parser->fill >= LINK_HEADER_SIZE) {
+			uint16_t length = linkHeaderLength(buffer);
+			if (length > LINK_PARSER_PAYLOAD ||
+				nvmCrc8(0U, &buffer[1], LINK_HEADER_SIZE - 2U) != buffer[8]) {
+
+				linkResync(parser);
+				continue;
+			}
+			whole = LINK_HEADER_SIZE + (uint32_t)length + LINK_CRC_SIZE;
+		}
+
+		if (parser->fill >= whole) {
+			uint16_t length = linkHeaderLength(buffer);
+			uint16_t crc = nvmCrc16(LINK_CRC_START, &buffer[1], (uint16_t)(LINK_HEADER_SIZE - 1U + length));
+			const uint8_t *trailer = &buffer[LINK_HEADER_SIZE + length];
+			if (crc != (uint16_t)(trailer[0] | (trailer[1] << 8))) {
+				linkResync(parser);
+				continue;
+			}
+
+			frame->kind = buffer[1];
+			frame->channels = buffer[2];
+			frame->bits = buffer[3];
+			frame->sequence = (uint16_t)(buffer[4] | (buffer[5] << 8));
+			frame->length = length;
+			frame->payload = &buffer[LINK_HEADER_SIZE];
+
+			if (parser->started) {
+				parser->lost += (uint16_t)(frame->sequence - parser->expected);
+			}
+			parser->expected = (uint16_t)(frame->sequence + 1U);
+			parser->started = true;
+			parser->frames++;
+			parser->taken = whole;
+			*used = i;
+			return true;
+		}
+
+		if (i == size) {
+			break;
+		}
+
+		if (parser->fill == 0UL) {
+			const uint8_t *sync = (const uint8_t*)memchr(&data[i], LINK_SYNC, (size_t)(size - i));
+			uint16_t next = sync == NULL ? size : (uint16_t)(sync - data);
+			parser->skipped += (uint16_t)(next - i);
+			i = next;
+			if (i == size) {
+				break;
+			}
+		}
+
+		uint32_t take = whole - parser->fill;
+		take = take < (uint32_t)(size - i) ? take : (uint32_t)(size - i);
+		memcpy(&buffer[parser->fill], &data[i], take);
+		parser->fill += take;
+		i = (uint16_t)(i + take);
+	}
+
+	*used = size;
+	return false;
+}
@@ -0,0 +1,177 @@
+/*
+	link_frame.h - binary frames for streaming samples
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef LINK_FRAME_H
+#define LINK_FRAME_H
+
+#include <Arduino.h>
+#include "../compile_flags.h"
+#include "../board_traits.h"
+
+/****************************
+ * Link Frames
+ *
+ * Samples go to apps in length delimited frames:
+ * - 9 header bytes: sync 0x5A, kind, channel mask, bits
+ *   per sample, sequence and payload length, both little
+ *   endian, then a CRC-8 of the 7 bytes after the sync
+ * - the payload, at most LINK_MAX_PAYLOAD bytes
+ * - a CRC-16 CCITT, little endian, of the header after
+ *   the sync and the payload
+ *
+ * The header CRC lets a receiver drop a bad length
+ * without waiting for its payload, and the sync differs
+ * from DEBUG_FRAME_SYNC so log frames sharing a port are
+ * skipped. Frames are handed to a LinkSink as spans, the
+ * header, the payload where it already is and the CRC,
+ * so samples are never copied to be sent.
+****************************/
+
+#define LINK_SYNC 0x5AU
+#define LINK_HEADER_SIZE 9U
+#define LINK_CRC_SIZE 2U
+
+// fixed by the protocol, the largest trigger frame of any board
+#define LINK_MAX_PAYLOAD 16384U
+
+// payload a LinkParser holds, smaller drops bigger frames as bad
+#ifndef LINK_PARSER_PAYLOAD
+#define LINK_PARSER_PAYLOAD LINK_MAX_PAYLOAD
+#endif
+
+static_assert(LINK_PARSER_PAYLOAD <= LINK_MAX_PAYLOAD, "LINK_PARSER_PAYLOAD can't be over LINK_MAX_PAYLOAD");
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "Samples are sent in place, so as little endian");
+
+enum LinkKind : uint8_t {
+	LINK_BLOCK = 1U, // acquisition buffer, interleaved from the lowest channel
+	LINK_TRIGGERED = 2U, // trigger frame
+	LINK_POINTS = 3U, // average or peak points
+	LINK_MINMAX = 4U, // min/max points, a pair per channel
+	LINK_CODED = 0x80U // ored with a kind, the payload is a codec block
+};
+
+/**
+ * Bytes sent as part of a frame
+ */
+struct LinkSpan {
+	const uint8_t *data;
+	uint16_t size;
+};
+
+/**
+ * Sends a frame, all of it or none
+ *
+ * @param spans parts of the frame in order
+ * @param count number of spans
+ *
+ * @return if the frame was taken, false if the link is busy
+ */
+typedef bool (*LinkSink)(const LinkSpan *spans, uint8_t count);
+
+/**
+ * Frame received by linkParse(), payload points into the
+ * parser until the next call
+ */
+struct LinkFrame {
+	uint8_t kind;
+	uint8_t channels;
+	uint8_t bits;
+	uint16_t sequence;
+	uint16_t length;
+	const uint8_t *payload;
+};
+
+/**
+ * Receiving side of a link, large so usually static
+ */
+struct LinkParser {
+	uint8_t buffer[LINK_HEADER_SIZE + LINK_PARSER_PAYLOAD + LINK_CRC_SIZE];
+	uint32_t fill; // bytes of the frame being gathered
+	uint32_t taken; // bytes of the frame last handed out
+	uint16_t expected; // sequence of the next frame
+	bool started; // if expected is known
+	uint32_t frames;
+	uint32_t skipped; // bytes skipped finding a sync
+	uint32_t corrupt; // headers or frames failing their CRC
+	uint32_t lost; // frames missing from the sequence
+};
+
+/****************************
+ * Link Methods
+****************************/
+
+/**
+ * Starts sending frames, the sequence starts at 0
+ *
+ * @param sink where frames go
+ */
+void linkBegin(LinkSink sink);
+
+/**
+ * Sends a frame, only call it from one task
+ *
+ * @param kind LinkKind of the payload
+ * @param channels ADC channel mask of the payload
+ * @param payload bytes to send, read in place
+ * @param length bytes of payload, at most LINK_MAX_PAYLOAD
+ *
+ * @return if the sink took the frame, the sequence only counts frames taken
+ */
+bool linkSendFrame(uint8_t kind, uint8_t channels, const void *payload, uint16_t length);
+
+/**
+ * Sends samples as they are in their buffer
+ *
+ * @param samples acquisition buffer, trigger frame or points
+ * @param count samples to send
+ * @param channels ADC channel mask of the samples
+ * @param kind LinkKind of the samples
+ *
+ * @return if the sink took the frame
+ */
+bool linkSendSamples(const SampleWord *samples, uint16_t count, uint8_t channels, uint8_t kind = LINK_BLOCK);
+
+/**
+ * Gets how many frames the sink turned away
+ *
+ * @return frames refused since linkBegin()
+ */
+uint32_t linkRefused(void);
+
+/**
+ * Empties a parser and clears its counts
+ *
+ * @param parser parser to reset
+ */
+void linkParserReset(LinkParser *parser);
+
+/**
+ * Gathers received bytes into frames, call it again with
+ * the bytes after used until it returns false
+ *
+ * @param parser parser of this link
+ * @param data bytes received
+ * @param size number of bytes
+ * @param used set to bytes taken from data
+ * @param frame set to the frame once one is whole
+ *
+ * @return if a frame passed its CRCs
+ */
+bool linkParse(LinkParser *parser, const uint8_t *data, uint16_t size, uint16_t *used, LinkFrame *frame);
+
+#endif
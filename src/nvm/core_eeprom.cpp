@@ -17,13 +17,32 @@
 */
 
 #include "core_eeprom.h"
+#include "nvm_stats.h"
+#include "nvm_async.h"
 
-#ifndef NVM_PREF
+#if !defined(NVM_PREF) && !defined(NVM_LOG)
 
+#if defined(NVM_FILE)
+#include "core_file.h"
+#elif defined(NVM_FLASH)
+#include "core_flash.h"
+#else
 #include <EEPROM.h>
+#endif
 
 bool started = false;
 uint16_t nvmSize = 0U;
+uint16_t nvmDataSize = 0U;
+
+#ifdef NVM_SHADOW
+uint8_t *nvmShadow = NULL;
+uint8_t *nvmDirtyPages = NULL;
+uint16_t nvmPageCount = 0U;
+
+uint32_t nvmSlotSize = 0UL;
+uint8_t nvmSlotActive = 0U;
+uint32_t nvmSlotSequence = 0UL;
+#endif
 
 /**
  * Gets if nvm is started and debugs it
@@ -32,40 +51,456 @@ uint16_t nvmSize = 0U;
  */
 bool nvmStarted() {
 	if (!started) {
-		#ifdef __NVM_DEBUG__
-			printNVM();
-			Serial.println(F("EEPROM not started"));
-		#endif
+		LOG_W(NVM, "EEPROM not started");
 		return false;
 	}
 	return true;
 }
 
+#ifdef NVM_SHADOW
+
+/**
+ * Gets the crc of a slot's data, length and sequence
+ * 
+ * @param base address of the slot
+ * @param length data bytes in the slot
+ * @param trailer length and sequence bytes of the trailer
+ * 
+ * @return crc of the slot
+ */
+uint16_t nvmSlotCrc(uint32_t base, uint16_t length, const uint8_t *trailer) {
+	uint16_t crc = 0xFFFFU;
+	for (uint16_t i = 0U; i < length; i++) {
+		uint8_t data = EEPROM.read((int)(base + i));
+		crc = nvmCrc16(crc, &data, 1U);
+	}
+	return nvmCrc16(crc, trailer, 6U);
+}
+
+/**
+ * Reads and checks a slot's trailer
+ * 
+ * @param slot slot to check
+ * @param length variable to store data bytes to
+ * @param sequence variable to store slot sequence to
+ * 
+ * @return if the slot is whole
+ */
+bool nvmSlotValid(uint8_t slot, uint16_t *length, uint32_t *sequence) {
+	uint32_t base = slot * nvmSlotSize;
+	uint32_t end = base + nvmSlotSize - NVM_SLOT_TRAILER;
+
+	uint8_t trailer[NVM_SLOT_TRAILER];
+	for (uint8_t i = 0U; i < NVM_SLOT_TRAILER; i++) {
+		trailer[i] = EEPROM.read((int)(end + i));
+	}
+
+	*length = (uint16_t)(trailer[1] | (trailer[2] << 8));
+	*sequence = (uint32_t)trailer[3] | ((uint32_t)trailer[4] << 8) |
+		((uint32_t)trailer[5] << 16) | ((uint32_t)trailer[6] << 24);
+	uint16_t stored = (uint16_t)(trailer[7] | (trailer[8] << 8));
+
+	return trailer[0] == NVM_SLOT_MAGIC && *length <= nvmSlotSize - NVM_SLOT_TRAILER &&
+		nvmSlotCrc(base, *length, &trailer[1]) == stored;
+}
+
+/**
+ * Allocates the RAM shadow and loads the newest whole
+ * slot into it. With no whole slot the first is loaded
+ * as is, which is where values were before slots
+ * 
+ * @return if shadow was loaded
+ */
+bool nvmShadowLoad(void) {
+	nvmPageCount = (nvmSize + NVM_PAGE_SIZE - 1U) / NVM_PAGE_SIZE;
+
+	nvmShadow = (uint8_t*)malloc(nvmSize);
+	nvmDirtyPages = (uint8_t*)calloc((nvmPageCount + 7U) / 8U, 1U);
+
+	if (nvmShadow == NULL || nvmDirtyPages == NULL) {
+		free(nvmShadow);
+		free(nvmDirtyPages);
+		nvmShadow = NULL;
+		nvmDirtyPages = NULL;
+		return false;
+	}
+
+	bool found = false;
+	uint16_t length = nvmSize;
+	nvmSlotActive = 0U;
+	nvmSlotSequence = 0UL;
+
+	for (uint8_t slot = 0U; slot < NVM_SLOTS; slot++) {
+		uint16_t slotLength;
+		uint32_t sequence;
+		// sequences wrap, the newer is ahead by less than half
+		if (nvmSlotValid(slot, &slotLength, &sequence) &&
+			(!found || (int32_t)(sequence - nvmSlotSequence) > 0)) {
+			found = true;
+			length = slotLength < nvmSize ? slotLength : nvmSize;
+			nvmSlotActive = slot;
+			nvmSlotSequence = sequence;
+		}
+	}
+
+	uint32_t base = nvmSlotActive * nvmSlotSize;
+	for (uint16_t i = 0U; i < nvmSize; i++) {
+		nvmShadow[i] = i < length ? EEPROM.read((int)(base + i)) : 0xFFU;
+	}
+
+	if (!found) {
+		LOG_I(NVM, "EEPROM has no committed slot, loaded the region as is");
+	}
+
+	return true;
+}
+
+/**
+ * Writes the shadow to the slot not holding the newest
+ * copy and commits it, the slot only becomes the newest
+ * once the commit finished
+ * 
+ * @return if commit was successful
+ */
+bool nvmSlotCommit(void) {
+	uint8_t slot = (uint8_t)((nvmSlotActive + 1U) % NVM_SLOTS);
+	uint32_t base = slot * nvmSlotSize;
+	uint32_t sequence = nvmSlotSequence + 1UL;
+
+	// the slot is a commit behind, so every page is compared
+	for (uint16_t page = 0U; page < nvmPageCount; page++) {
+		uint16_t start = page * NVM_PAGE_SIZE;
+		uint16_t end = start + NVM_PAGE_SIZE;
+		if (end > nvmSize) {
+			end = nvmSize;
+		}
+
+		uint16_t programmed = 0U;
+		for (uint16_t address = start; address < end; address++) {
+			if (EEPROM.read((int)(base + address)) != nvmShadow[address]) {
+				EEPROM.write((int)(base + address), nvmShadow[address]);
+				programmed++;
+			}
+		}
+		nvmStatsProgram(start, programmed);
+	}
+
+	uint8_t trailer[NVM_SLOT_TRAILER] = {
+		NVM_SLOT_MAGIC,
+		(uint8_t)(nvmSize & LEAST_BYTE), (uint8_t)((nvmSize & SECOND_LEAST_BYTE) >> 8),
+		(uint8_t)sequence, (uint8_t)(sequence >> 8), (uint8_t)(sequence >> 16), (uint8_t)(sequence >> 24),
+		0U, 0U
+	};
+	uint16_t crc = nvmSlotCrc(base, nvmSize, &trailer[1]);
+	trailer[7] = (uint8_t)(crc & LEAST_BYTE);
+	trailer[8] = (uint8_t)((crc & SECOND_LEAST_BYTE) >> 8);
+
+	uint32_t end = base + nvmSlotSize - NVM_SLOT_TRAILER;
+	for (uint8_t i = 0U; i < NVM_SLOT_TRAILER; i++) {
+		EEPROM.write((int)(end + i), trailer[i]);
+	}
+
+	bool result = true;
+	#ifdef __NVM_COMMIT__
+		result = EEPROM.commit();
+		nvmStatsCommit();
+	#endif
+
+	if (result) {
+		nvmSlotActive = slot;
+		nvmSlotSequence = sequence;
+	}
+	return result;
+}
+
+/**
+ * Writes bytes into the shadow and marks changed pages dirty
+ * 
+ * @param key key of nvm address
+ * @param data bytes to write
+ * @param size number of bytes to write
+ * 
+ * @return if write was within the shadow
+ */
+bool nvmShadowWrite(uint16_t key, const uint8_t *data, uint16_t size) {
+	if ((uint32_t)key + size > nvmSize) {
+		return false;
+	}
+
+	bool changed = false;
+
+	for (uint16_t i = 0U; i < size; i++) {
+		uint16_t address = key + i;
+		if (nvmShadow[address] != data[i]) {
+			uint16_t page = address / NVM_PAGE_SIZE;
+			nvmShadow[address] = data[i];
+			nvmDirtyPages[page >> 3] |= (uint8_t)(1U << (page & 7U));
+			changed = true;
+		}
+	}
+
+	if (!changed) {
+		nvmStatsSkip();
+	}
+
+	return true;
+}
+
+/**
+ * Reads bytes from the shadow
+ * 
+ * @param key key of nvm address
+ * @param data buffer to store bytes to
+ * @param size number of bytes to read
+ * 
+ * @return if read was within the shadow
+ */
+bool nvmShadowRead(uint16_t key, uint8_t *data, uint16_t size) {
+	if ((uint32_t)key + size > nvmSize) {
+		return false;
+	}
+
+	memcpy(data, &nvmShadow[key], size);
+	return true;
+}
+
+#endif
+
+#ifndef NVM_SHADOW
+
+/**
+ * Writes bytes to EEPROM, skipping unchanged bytes
+ * 
+ * @param address address to start writing at
+ * @param data bytes to write
+ * @param size number of bytes to write
+ * 
+ * @return if any byte changed
+ */
+bool eepromWriteBytes(uint16_t address, const uint8_t *data, uint16_t size) {
+	bool changed = false;
+
+	for (uint16_t i = 0U; i < size; i++) {
+		if (EEPROM.read((int)(address + i)) != data[i]) {
+			EEPROM.write((int)(address + i), data[i]);
+			nvmStatsProgram(address + i, 1U);
+			changed = true;
+		}
+	}
+
+	return changed;
+}
+
+#endif
+
+/**
+ * Checks that every batch entry fits in the data region
+ * 
+ * @param batch staged entries
+ * @param length length of staged entries
+ * 
+ * @return if all entries fit
+ */
+bool eepromBatchFits(const uint8_t *batch, uint16_t length) {
+	uint16_t offset = 0U;
+	uint16_t key;
+	uint8_t varType;
+
+	while (offset < length) {
+		uint16_t valueOffset = nvmBatchEntry(batch, length, offset, &key, &varType);
+		if (valueOffset == 0U) {
+			return false;
+		}
+
+		uint8_t size = nvmVarSize(varType);
+		if ((uint32_t)key + size > nvmDataSize) {
+			return false;
+		}
+		offset = valueOffset + size;
+	}
+
+	return true;
+}
+
+/**
+ * Writes every batch entry to its address
+ * 
+ * @param batch staged entries
+ * @param length length of staged entries
+ */
+void eepromBatchApply(const uint8_t *batch, uint16_t length) {
+	uint16_t offset = 0U;
+	uint16_t key;
+	uint8_t varType;
+
+	while (offset < length) {
+		uint16_t valueOffset = nvmBatchEntry(batch, length, offset, &key, &varType);
+		uint8_t size = nvmVarSize(varType);
+
+		#ifdef NVM_SHADOW
+			nvmShadowWrite(key, &batch[valueOffset], size);
+		#else
+			if (!eepromWriteBytes(key, &batch[valueOffset], size)) {
+				nvmStatsSkip();
+			}
+		#endif
+
+		offset = valueOffset + size;
+	}
+}
+
+#ifndef NVM_SHADOW
+
+/**
+ * Finishes a batch left in the journal by a reset
+ */
+void nvmJournalRecover(void) {
+	uint16_t journal = nvmDataSize;
+	if (EEPROM.read((int)journal) != NVM_JOURNAL_MAGIC) {
+		return;
+	}
+
+	uint16_t length = (uint16_t)(
+		EEPROM.read((int)(journal + 1U)) | (EEPROM.read((int)(journal + 2U)) << 8)
+	);
+
+	if (length <= NVM_BATCH_SIZE) {
+		for (uint16_t i = 0U; i < length; i++) {
+			nvmBatch[i] = EEPROM.read((int)(journal + 3U + i));
+		}
+
+		uint8_t lengthBytes[2] = {
+			(uint8_t)(length & LEAST_BYTE), (uint8_t)((length & SECOND_LEAST_BYTE) >> 8)
+		};
+		uint16_t crc = nvmCrc16(0xFFFFU, lengthBytes, sizeof(lengthBytes));
+		crc = nvmCrc16(crc, nvmBatch, length);
+		uint16_t stored = (uint16_t)(
+			EEPROM.read((int)(journal + 3U + length)) |
+			(EEPROM.read((int)(journal + 4U + length)) << 8)
+		);
+
+		if (crc == stored && eepromBatchFits(nvmBatch, length)) {
+			eepromBatchApply(nvmBatch, length);
+
+			LOG_I(NVM, "EEPROM recovered batch, bytes: {}", length);
+		}
+	}
+
+	uint8_t blank = 0U;
+	eepromWriteBytes(journal, &blank, 1U);
+}
+
+#endif
+
+bool nvmCommitBatch(void) {
+	TRACE_SCOPE("nvmCommitBatch");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	// a batch only holds the async queue, the worker commits it
+	if (nvmAsyncActive()) {
+		return nvmAsyncCommitBatch();
+	}
+
+	NVMStorageLock lock;
+
+	if (!nvmBatchActive()) {
+		LOG_W(NVM, "EEPROM has no batch to commit");
+		return false;
+	}
+
+	if (!eepromBatchFits(nvmBatch, nvmBatchLength)) {
+		LOG_ERROR("EEPROM batch outside of nvm region");
+		nvmBatchClear();
+		return false;
+	}
+
+	bool result = true;
+
+	#ifdef NVM_SHADOW
+		// nothing reaches storage until the single flush commit
+		eepromBatchApply(nvmBatch, nvmBatchLength);
+		result = nvmFlush();
+	#else
+		uint16_t journal = nvmDataSize;
+		uint16_t length = nvmBatchLength;
+		uint8_t lengthBytes[2] = {
+			(uint8_t)(length & LEAST_BYTE), (uint8_t)((length & SECOND_LEAST_BYTE) >> 8)
+		};
+		uint16_t crc = nvmCrc16(0xFFFFU, lengthBytes, sizeof(lengthBytes));
+		crc = nvmCrc16(crc, nvmBatch, length);
+		uint8_t crcBytes[2] = {
+			(uint8_t)(crc & LEAST_BYTE), (uint8_t)((crc & SECOND_LEAST_BYTE) >> 8)
+		};
+		uint8_t marker = NVM_JOURNAL_MAGIC;
+
+		// journal copy is only trusted once the marker is written
+		eepromWriteBytes(journal + 1U, lengthBytes, sizeof(lengthBytes));
+		eepromWriteBytes(journal + 3U, nvmBatch, length);
+		eepromWriteBytes(journal + 3U + length, crcBytes, sizeof(crcBytes));
+		eepromWriteBytes(journal, &marker, 1U);
+
+		eepromBatchApply(nvmBatch, length);
+
+		marker = 0U;
+		eepromWriteBytes(journal, &marker, 1U);
+	#endif
+
+	LOG_I(NVM, "EEPROM committed batch, bytes: {}", nvmBatchLength);
+
+	nvmBatchClear();
+	return result;
+}
+
 enum NVMStartCode nvmInit(uint16_t setNVMSize) {
+	TRACE_SCOPE("nvmInit");
+
 	if (started) {
-		#ifdef __NVM_DEBUG__
-			printNVM();
-			Serial.println(F("EEPROM already started"));
-		#endif
+		LOG_W(NVM, "EEPROM already started");
 		return NVM_STARTED;
 	}
 
 	if (setNVMSize == (uint16_t)DEFAULT_NVM_SIZE) {
-		#ifdef __NVM_DEBUG__
-			printNVM();
-			Serial.println(F("NVM size given was default, not initialized"));
-		#endif
+		LOG_W(NVM, "NVM size given was default, not initialized");
 		return NVM_INVALID_SIZE;
 	}
 
-	nvmSize = nvmSize;
+	#ifdef NVM_SHADOW
+		if (setNVMSize < NVM_SCHEMA_SIZE) {
+			LOG_W(NVM, "NVM size given can't fit schema, not initialized");
+			return NVM_INVALID_SIZE;
+		}
+	#else
+		// the journal sits after the data, a region short of the schema would overlap it
+		if (setNVMSize < NVM_SCHEMA_SIZE + NVM_JOURNAL_SIZE) {
+			LOG_W(NVM, "NVM size given can't fit schema and batch journal, not initialized");
+			return NVM_INVALID_SIZE;
+		}
+	#endif
+
+	nvmSize = setNVMSize;
+
+	#ifdef NVM_SHADOW
+		nvmDataSize = nvmSize;
+		nvmSlotSize = ((uint32_t)nvmSize + NVM_SLOT_TRAILER + NVM_SECTOR_SIZE - 1UL) /
+			NVM_SECTOR_SIZE * NVM_SECTOR_SIZE;
+	#else
+		nvmDataSize = nvmSize - NVM_JOURNAL_SIZE;
+	#endif
 
 	#ifdef __NVM_BEGIN__
 		#ifdef __NVM_BEGIN_SIZE__
+			#ifdef NVM_SHADOW
+				uint32_t deviceSize = NVM_SLOTS * nvmSlotSize;
+			#else
+				uint32_t deviceSize = nvmSize;
+			#endif
 			#ifdef __NVM_BEGIN_RETURN__
-				started = EEPROM.begin(nvmSize);
+				started = EEPROM.begin(deviceSize);
 			#else
-				EEPROM.begin(nvmSize);
+				EEPROM.begin(deviceSize);
 				started = true;
 			#endif
 		#else
@@ -81,171 +516,375 @@ enum NVMStartCode nvmInit(uint16_t setNVMSize) {
 	#endif
 
 	if (!started) {
-		#ifdef __ERROR_DEBUG__
-			printError();
-			Serial.println(F("'EEPROM' library failed to start"));
-		#endif
+		LOG_ERROR("'EEPROM' library failed to start");
 		return NVM_FAILED;
 	}
 
-	#ifdef __NVM_DEBUG__
-		printNVM();
-		Serial.println(F("Started EEPROM for NVM"));
+	#ifdef NVM_SHADOW
+		if (!nvmShadowLoad()) {
+			started = false;
+			LOG_ERROR("EEPROM shadow couldn't be allocated");
+			return NVM_FAILED;
+		}
 	#endif
 
+	nvmStatsBegin(nvmSize);
+
+	#ifndef NVM_SHADOW
+		nvmJournalRecover();
+	#endif
+
+	LOG_I(NVM, "Started EEPROM for NVM");
+
 	return NVM_OK;
 }
 
-/**
- * Writes value to nvm
- * 
- * @param key key of nvm address
- * @param value value to write to nvm
- * 
- * @return if write was valid
- */
-template <typename T>
-bool nvmWriteCommit(uint16_t key, T value) {
-	// inserts value
-	EEPROM.put((int)key, value);
-	#ifdef __NVM_COMMIT__
-		EEPROM.commit();
+void nvmEnd(void) {
+	nvmBatchClear();
+
+	#ifdef NVM_SHADOW
+		free(nvmShadow);
+		free(nvmDirtyPages);
+		nvmShadow = NULL;
+		nvmDirtyPages = NULL;
+		nvmPageCount = 0U;
 	#endif
 
+	started = false;
+}
+
+bool nvmWriteBlock(uint16_t key, const void *data, uint16_t size) {
+	TRACE_SCOPE("nvmWriteBlock");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	if (nvmBatchActive()) {
+		LOG_W(NVM, "EEPROM blocks can't be staged in a batch");
+		return false;
+	}
+
+	uint32_t start = nvmStatsClock();
+	bool result = (uint32_t)key + size <= nvmDataSize;
+
+	if (result) {
+		#ifdef NVM_SHADOW
+			nvmShadowWrite(key, (const uint8_t*)data, size);
+		#else
+			if (!eepromWriteBytes(key, (const uint8_t*)data, size)) {
+				nvmStatsSkip();
+			}
+		#endif
+		nvmStatsWrite(VAR_BYTES, start);
+	}
+	else {
+		LOG_ERROR("EEPROM block outside of nvm region at key {}", key);
+	}
+
+	LOG_NVM("EEPROM wrote block of {} bytes to key {}", size, key);
+
+	return result;
+}
+
+bool nvmReadBlock(uint16_t key, void *data, uint16_t size) {
+	TRACE_SCOPE("nvmReadBlock");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	if ((uint32_t)key + size > nvmDataSize) {
+		LOG_ERROR("EEPROM block outside of nvm region at key {}", key);
+		return false;
+	}
+
+	uint32_t start = nvmStatsClock();
+
+	#ifdef NVM_SHADOW
+		nvmShadowRead(key, (uint8_t*)data, size);
+	#else
+		for (uint16_t i = 0U; i < size; i++) {
+			((uint8_t*)data)[i] = EEPROM.read((int)(key + i));
+		}
+	#endif
+
+	nvmStatsRead(VAR_BYTES, start);
+
+	LOG_NVM("EEPROM read block of {} bytes from key {}", size, key);
+
+	return true;
+}
+
+bool nvmWriteBytes(uint16_t key, const void *data, uint16_t length, uint16_t capacity) {
+	TRACE_SCOPE("nvmWriteBytes");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	if (nvmBatchActive()) {
+		LOG_W(NVM, "EEPROM bytes can't be staged in a batch");
+		return false;
+	}
+
+	if (!nvmBytesFit(key, length, capacity)) {
+		return false;
+	}
+
+	if ((uint32_t)key + capacity > nvmDataSize) {
+		LOG_ERROR("EEPROM bytes outside of nvm region at key {}", key);
+		return false;
+	}
+
+	uint32_t start = nvmStatsClock();
+	uint8_t prefix = (uint8_t)length;
+
+	#ifdef NVM_SHADOW
+		// one copy into the shadow, committed by the next flush
+		uint8_t block[NVM_LENGTH_PREFIX + NVM_BYTES_MAX];
+		block[0] = prefix;
+		memcpy(&block[NVM_LENGTH_PREFIX], data, length);
+		nvmShadowWrite(key, block, NVM_LENGTH_PREFIX + length);
+	#else
+		bool changed = eepromWriteBytes(key + NVM_LENGTH_PREFIX, (const uint8_t*)data, length);
+		if (!eepromWriteBytes(key, &prefix, NVM_LENGTH_PREFIX) && !changed) {
+			nvmStatsSkip();
+		}
+	#endif
+
+	nvmStatsWrite(VAR_BYTES, start);
+
+	LOG_NVM("EEPROM wrote {} bytes to key {}", length, key);
+
+	return true;
+}
+
+bool nvmGetBytes(uint16_t key, void *data, uint16_t *length, uint16_t capacity) {
+	TRACE_SCOPE("nvmGetBytes");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	if ((uint32_t)key + capacity > nvmDataSize || capacity < NVM_LENGTH_PREFIX) {
+		LOG_ERROR("EEPROM bytes outside of nvm region at key {}", key);
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	uint32_t start = nvmStatsClock();
+	uint8_t prefix = 0U;
+
+	#ifdef NVM_SHADOW
+		nvmShadowRead(key, &prefix, NVM_LENGTH_PREFIX);
+	#else
+		prefix = EEPROM.read((int)key);
+	#endif
+
+	// erased or never written fields fail the bounds check
+	bool result = prefix + NVM_LENGTH_PREFIX <= capacity;
+
+	if (result) {
+		#ifdef NVM_SHADOW
+			nvmShadowRead(key + NVM_LENGTH_PREFIX, (uint8_t*)data, prefix);
+		#else
+			for (uint16_t i = 0U; i < prefix; i++) {
+				((uint8_t*)data)[i] = EEPROM.read((int)(key + NVM_LENGTH_PREFIX + i));
+			}
+		#endif
+		*length = prefix;
+	}
+
+	nvmStatsRead(VAR_BYTES, start);
+
+	if (!result) {
+		LOG_ERROR("EEPROM has no bytes that fit {} bytes at key {}", capacity, key);
+	}
+
+	LOG_NVM("EEPROM read {} bytes from key {}", prefix, key);
+
+	return result;
+}
+
+bool nvmWriteString(uint16_t key, const char *value, uint16_t capacity) {
+	size_t length = strlen(value);
+	if (length > NVM_BYTES_MAX) {
+		length = NVM_BYTES_MAX + 1U;
+	}
+	return nvmWriteBytes(key, value, (uint16_t)length, capacity);
+}
+
+bool nvmGetString(uint16_t key, char *value, uint16_t capacity) {
+	uint16_t length;
+	if (!nvmGetBytes(key, value, &length, capacity)) {
+		return false;
+	}
+	value[length] = '\0';
 	return true;
 }
 
 /**
- * Runs whole write process
+ * Writes value to nvm
  * 
  * @param key key of nvm address
  * @param value value to write to nvm
- * @param var variable type for printing
  * 
  * @return if write was valid
  */
 template <typename T>
-bool nvmWrite(uint16_t key, T value) {
+bool nvmWriteCommit(uint16_t key, T value) {
+	#ifdef NVM_SHADOW
+		// stages value until nvmFlush()
+		return nvmShadowWrite(key, (const uint8_t*)&value, sizeof(T));
+	#else
+		if ((uint32_t)key + sizeof(T) > nvmDataSize) {
+			return false;
+		}
+
+		// inserts value
+		if (!eepromWriteBytes(key, (const uint8_t*)&value, sizeof(T))) {
+			nvmStatsSkip();
+		}
+		return true;
+	#endif
+}
+
+bool nvmFlush(void) {
+	TRACE_SCOPE("nvmFlush");
 
 	if (!nvmStarted()) {
 		return false;
 	}
 
-	bool result = nvmWriteCommit(key, value);
-
-	if (!result) {
-		#ifdef __ERROR_DEBUG__
-			printError();
-			Serial.print(F("EEPROM couldn't write value '"));
-			Serial.print(value);
-			Serial.print(F("' to key "));
-			Serial.println(key);
-		#endif
+	if (nvmAsyncActive()) {
+		return nvmSync();
 	}
 
-	#ifdef __NVM_DEBUG__
-		printNVM();
-		Serial.print(F("EEPROM wrote value '"));
-		Serial.print(value);
-		Serial.print(F("' from key "));
-		Serial.println(key);
-	#endif
+	NVMStorageLock lock;
 
-	return result;
-}
+	#ifdef NVM_SHADOW
+		bool dirty = false;
+
+		for (uint16_t i = 0U; i < (nvmPageCount + 7U) / 8U; i++) {
+			dirty = dirty || nvmDirtyPages[i] != 0U;
+		}
+
+		if (!dirty) {
+			return true;
+		}
+
+		bool result = nvmSlotCommit();
+		if (result) {
+			memset(nvmDirtyPages, 0, (nvmPageCount + 7U) / 8U);
+		}
 
-#ifndef INT64_SUPPORT
+		if (!result) {
+			LOG_ERROR("EEPROM couldn't commit shadow");
+		}
+
+		LOG_I(NVM, "EEPROM flushed shadow");
+
+		return result;
+	#else
+		return true;
+	#endif
+}
 
 /**
- * Runs whole write process for i64 and u64
+ * Runs whole write process
  * 
  * @param key key of nvm address
  * @param value value to write to nvm
- * @param var variable type for printing
+ * @param var variable type of value
  * 
  * @return if write was valid
  */
 template <typename T>
-bool nvmWrite64(uint16_t key, T value) {
+bool nvmWrite(uint16_t key, T value, enum VarType var) {
+	TRACE_SCOPE("nvmWriteValue");
+
 	if (!nvmStarted()) {
 		return false;
 	}
 
+	uint32_t start = nvmStatsClock();
+
+	if (nvmAsyncActive()) {
+		bool queued = nvmAsyncStage(key, var, &value);
+		nvmStatsWrite(var, start);
+		return queued;
+	}
+
+	NVMStorageLock lock;
+
+	if (nvmBatchActive()) {
+		bool staged = nvmBatchStage(key, var, &value);
+		nvmStatsWrite(var, start);
+		return staged;
+	}
+
 	bool result = nvmWriteCommit(key, value);
+	nvmStatsWrite(var, start);
 
 	if (!result) {
-		#ifdef __ERROR_DEBUG__
-			printError();
-			Serial.print(F("EEPROM couldn't write value '"));
-			printInt64(value);
-			Serial.print(F("' to key "));
-			Serial.println(key);
-		#endif
+		LOG_ERROR("EEPROM couldn't write value '{}' to key {}", value, key);
 	}
 
-	#ifdef __NVM_DEBUG__
-		printNVM();
-		Serial.print(F("EEPROM wrote value '"));
-		printInt64(value);
-		Serial.print(F("' from key "));
-		Serial.println(key);
-	#endif
+	LOG_NVM("EEPROM wrote value '{}' from key {}", value, key);
 
 	return result;
 }
 
-#endif
-
 bool nvmWriteValue(uint16_t key, bool value) {
-	return nvmWrite(key, value);
+	return nvmWrite(key, value, VAR_BOOL);
 }
 
 bool nvmWriteValue(uint16_t key, int8_t value) {
-	return nvmWrite(key, value);
+	return nvmWrite(key, value, VAR_INT8);
 }
 
 bool nvmWriteValue(uint16_t key, uint8_t value) {
-	return nvmWrite(key, value);
+	return nvmWrite(key, value, VAR_UINT8);
 }
 
 bool nvmWriteValue(uint16_t key, int16_t value) {
-	return nvmWrite(key, value);
+	return nvmWrite(key, value, VAR_INT16);
 }
 
 bool nvmWriteValue(uint16_t key, uint16_t value) {
-	return nvmWrite(key, value);
+	return nvmWrite(key, value, VAR_UINT16);
 }
 
 bool nvmWriteValue(uint16_t key, int32_t value) {
-	return nvmWrite(key, value);
+	return nvmWrite(key, value, VAR_INT32);
 }
 
 bool nvmWriteValue(uint16_t key, uint32_t value) {
-	return nvmWrite(key, value);
+	return nvmWrite(key, value, VAR_UINT32);
 }
 
 bool nvmWriteValue(uint16_t key, int64_t value) {
-	#ifdef INT64_SUPPORT
-	return nvmWrite(key, value);
-	#else
-	return nvmWrite64(key, value);
-	#endif
+	return nvmWrite(key, value, VAR_INT64);
 }
 
 bool nvmWriteValue(uint16_t key, uint64_t value) {
-	#ifdef INT64_SUPPORT
-	return nvmWrite(key, value);
-	#else
-	return nvmWrite64(key, value);
-	#endif
+	return nvmWrite(key, value, VAR_UINT64);
 }
 
 bool nvmWriteValue(uint16_t key, float value) {
-	return nvmWrite(key, value);
+	return nvmWrite(key, value, VAR_FLOAT);
 }
 
 bool nvmWriteValue(uint16_t key, double value) {
-	return nvmWrite(key, value);
+	return nvmWrite(key, value, VAR_DOUBLE);
 }
 
 /**
@@ -258,8 +897,16 @@ bool nvmWriteValue(uint16_t key, double value) {
  */
 template <typename T>
 bool nvmGetVal(uint16_t key, T *value) {
-	EEPROM.get((int)key, *value);
-	return true;
+	#ifdef NVM_SHADOW
+		return nvmShadowRead(key, (uint8_t*)value, sizeof(T));
+	#else
+		if ((uint32_t)key + sizeof(T) > nvmDataSize) {
+			return false;
+		}
+
+		EEPROM.get((int)key, *value);
+		return true;
+	#endif
 }
 
 /**
@@ -267,129 +914,86 @@ bool nvmGetVal(uint16_t key, T *value) {
  * 
  * @param key key of nvm address
  * @param value value to write to nvm
+ * @param var variable type of value
  * 
  * @return if get was successful
  */
 template <typename T>
-bool nvmGet(uint16_t key, T *value) {
+bool nvmGet(uint16_t key, T *value, enum VarType var) {
+	TRACE_SCOPE("nvmGetValue");
+
 	if (!nvmStarted()) {
 		return false;
 	}
 
-	bool result = nvmGetVal(key, value);
+	uint32_t start = nvmStatsClock();
 
-	if (!result) {
-		#ifdef __ERROR_DEBUG__
-			printError();
-			Serial.print(F("EEPROM couldn't get value '"));
-			Serial.print(*value);
-			Serial.print(F("' to key "));
-			Serial.println(key);
-		#endif
+	if (nvmAsyncLookup(key, var, value)) {
+		nvmStatsRead(var, start);
+		return true;
 	}
 
-	#ifdef __NVM_DEBUG__
-		printNVM();
-		Serial.print(F("EEPROM get value '"));
-		Serial.print(*value);
-		Serial.print(F("' from key "));
-		Serial.println(key);
-	#endif
-
-	return result;
-}
-
-#ifndef INT64_SUPPORT
+	NVMStorageLock lock;
 
-/**
- * Runs whole get process for i64 and u64
- * 
- * @param key key of nvm address
- * @param value value to write to nvm
- * 
- * @return if get was successful
- */
-template <typename T>
-bool nvmGet64(uint16_t key, T *value) {
-	if (!nvmStarted()) {
-		return false;
+	if (nvmBatchLookup(key, var, value)) {
+		nvmStatsRead(var, start);
+		return true;
 	}
 
 	bool result = nvmGetVal(key, value);
+	nvmStatsRead(var, start);
 
 	if (!result) {
-		#ifdef __ERROR_DEBUG__
-			printError();
-			Serial.print(F("EEPROM couldn't get value '"));
-			printInt64(*value);
-			Serial.print(F("' to key "));
-			Serial.println(key);
-		#endif
+		LOG_ERROR("EEPROM couldn't get value '{}' to key {}", *value, key);
 	}
 
-	#ifdef __NVM_DEBUG__
-		printNVM();
-		Serial.print(F("EEPROM get value '"));
-		printInt64(*value);
-		Serial.print(F("' from key "));
-		Serial.println(key);
-	#endif
+	LOG_NVM("EEPROM get value '{}' from key {}", *value, key);
 
 	return result;
 }
 
-#endif
-
 bool nvmGetValue(uint16_t key, bool *value) {
-	return nvmGet(key, value);
+	return nvmGet(key, value, VAR_BOOL);
 }
 
 bool nvmGetValue(uint16_t key, int8_t *value) {
-	return nvmGet(key, value);
+	return nvmGet(key, value, VAR_INT8);
 }
 
 bool nvmGetValue(uint16_t key, uint8_t *value) {
-	return nvmGet(key, value);
+	return nvmGet(key, value, VAR_UINT8);
 }
 
 bool nvmGetValue(uint16_t key, int16_t *value) {
-	return nvmGet(key, value);
+	return nvmGet(key, value, VAR_INT16);
 }
 
 bool nvmGetValue(uint16_t key, uint16_t *value) {
-	return nvmGet(key, value);
+	return nvmGet(key, value, VAR_UINT16);
 }
 
 bool nvmGetValue(uint16_t key, int32_t *value) {
-	return nvmGet(key, value);
+	return nvmGet(key, value, VAR_INT32);
 }
 
 bool nvmGetValue(uint16_t key, uint32_t *value) {
-	return nvmGet(key, value);
+	return nvmGet(key, value, VAR_UINT32);
 }
 
 bool nvmGetValue(uint16_t key, int64_t *value) {
-	#ifdef INT64_SUPPORT
-	return nvmGet(key, value);
-	#else
-	return nvmGet64(key, value);
-	#endif
+	return nvmGet(key, value, VAR_INT64);
 }
 
 bool nvmGetValue(uint16_t key, uint64_t *value) {
-	#ifdef INT64_SUPPORT
-	return nvmGet(key, value);
-	#else
-	return nvmGet64(key, value);
-	#endif
+	return nvmGet(key, value, VAR_UINT64);
 }
 
 bool nvmGetValue(uint16_t key, float *value) {
-	return nvmGet(key, value);
+	return nvmGet(key, value, VAR_FLOAT);
 }
 
 bool nvmGetValue(uint16_t key, double *value) {
-	return nvmGet(key, value);
+	return nvmGet(key, value, VAR_DOUBLE);
 }
 
 #endif
\ No newline at end of file
@@ -28,5 +28,59 @@
 #include "eeprom_addresses.h"
 #include "../debug.h"
 
+#ifdef NVM_SHADOW
+
+#if defined(NVM_FILE)
+#include "core_file.h"
+#elif defined(NVM_FLASH)
+#include "core_flash.h"
+#endif
+
+// bytes tracked by each dirty bit of the shadow
+#ifndef NVM_PAGE_SIZE
+#define NVM_PAGE_SIZE 32U
+#endif
+
+/**
+ * Each flush writes the whole shadow to the slot not
+ * holding the newest copy and commits it, so a reset mid
+ * commit leaves the newest copy whole. Slots start on
+ * their own erase sector, nvmInit() loads the newest slot
+ * whose crc matches
+ *
+ * slot: data(nvm size) ... trailer at the slot's end
+ * trailer: magic(1) length(2) sequence(4) crc(2)
+ */
+#define NVM_SLOT_MAGIC 0xA5U
+#define NVM_SLOT_TRAILER 9U
+#define NVM_SLOTS 2U
+
+// bytes a commit erases together
+#if defined(NVM_FILE)
+#define NVM_SECTOR_SIZE NVM_FILE_PAGE_SIZE
+#elif defined(NVM_FLASH)
+#define NVM_SECTOR_SIZE NVM_FLASH_SECTOR_SIZE
+#else
+#define NVM_SECTOR_SIZE 4096U
+#endif
+
+#else
+
+/**
+ * Batches are journaled at the end of the nvm region so
+ * a reset while applying them is finished at nvmInit
+ * 
+ * journal: magic(1) length(2) entries(length) crc(2)
+ */
+#define NVM_JOURNAL_MAGIC 0x5AU
+#define NVM_JOURNAL_SIZE (NVM_BATCH_SIZE + 5U)
+
+static_assert(
+	NVM_SCHEMA_SIZE + NVM_JOURNAL_SIZE <= NVM_CAPACITY,
+	"NVM schema and batch journal don't fit the board's EEPROM"
+);
+
+#endif
+
 #endif
 #endif
\ No newline at end of file
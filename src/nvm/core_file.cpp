@@ -0,0 +1,260 @@
+/*
+	core_file.cpp - memory mapped file standing in for EEPROM
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "core_file.h"
+
+#ifdef NVM_FILE
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "../debug.h"
+
+NVMFileClass EEPROM;
+
+NVMFileClass::NVMFileClass(void) :
+	path(NVM_FILE_PATH), mapped(NULL), ram(NULL), erases(NULL),
+	size(0U), pageCount(0U), cutBudget(0U), cutArmed(false), lost(false) {
+	resetStats();
+}
+
+NVMFileClass::~NVMFileClass(void) {
+	end();
+}
+
+bool NVMFileClass::begin(size_t setSize) {
+	end();
+
+	int fd = open(path, O_RDWR | O_CREAT, 0644);
+	if (fd < 0) {
+		LOG_ERROR("NVM file couldn't be opened: {}", path);
+		return false;
+	}
+
+	struct stat info;
+	bool result = fstat(fd, &info) == 0;
+	size_t oldSize = result ? (size_t)info.st_size : 0U;
+
+	if (result && oldSize < setSize) {
+		result = ftruncate(fd, (off_t)setSize) == 0;
+	}
+
+	void *region = MAP_FAILED;
+	if (result) {
+		region = mmap(NULL, setSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+
+	if (region == MAP_FAILED) {
+		LOG_ERROR("NVM file couldn't be mapped: {}", path);
+		return false;
+	}
+
+	mapped = (uint8_t*)region;
+	size = setSize;
+	pageCount = (uint16_t)((size + NVM_FILE_PAGE_SIZE - 1U) / NVM_FILE_PAGE_SIZE);
+
+	// bytes the file didn't hold yet start out erased
+	if (oldSize < size) {
+		memset(&mapped[oldSize], NVM_FILE_ERASED, size - oldSize);
+	}
+
+	erases = (uint32_t*)calloc(pageCount, sizeof(uint32_t));
+	bool allocated = erases != NULL;
+
+	#ifdef __NVM_COMMIT__
+		ram = (uint8_t*)malloc(size);
+		allocated = allocated && ram != NULL;
+		if (ram != NULL) {
+			memcpy(ram, mapped, size);
+		}
+	#endif
+
+	if (!allocated) {
+		end();
+		return false;
+	}
+
+	lost = false;
+	return true;
+}
+
+void NVMFileClass::end(void) {
+	if (mapped != NULL) {
+		msync(mapped, size, MS_SYNC);
+		munmap(mapped, size);
+	}
+
+	free(ram);
+	free(erases);
+	mapped = NULL;
+	ram = NULL;
+	erases = NULL;
+	size = 0U;
+	pageCount = 0U;
+}
+
+uint8_t NVMFileClass::read(int address) {
+	if (mapped == NULL || address < 0 || (size_t)address >= size) {
+		return NVM_FILE_ERASED;
+	}
+
+	#ifdef __NVM_COMMIT__
+		return ram[address];
+	#else
+		return mapped[address];
+	#endif
+}
+
+void NVMFileClass::write(int address, uint8_t value) {
+	if (mapped == NULL || address < 0 || (size_t)address >= size) {
+		return;
+	}
+
+	#ifdef __NVM_COMMIT__
+		ram[address] = value;
+	#else
+		program((uint32_t)address, value);
+	#endif
+}
+
+void NVMFileClass::update(int address, uint8_t value) {
+	if (read(address) != value) {
+		write(address, value);
+	}
+}
+
+bool NVMFileClass::commit(void) {
+	if (mapped == NULL || lost) {
+		return false;
+	}
+
+	counters.commits++;
+
+	#ifdef __NVM_COMMIT__
+		for (uint16_t page = 0U; page < pageCount; page++) {
+			size_t start = (size_t)page * NVM_FILE_PAGE_SIZE;
+			size_t pageSize = size - start < NVM_FILE_PAGE_SIZE ? size - start : NVM_FILE_PAGE_SIZE;
+
+			if (memcmp(&mapped[start], &ram[start], pageSize) == 0) {
+				continue;
+			}
+
+			// programming only clears bits, setting any needs an erase
+			bool clearsOnly = true;
+			for (size_t i = 0U; i < pageSize && clearsOnly; i++) {
+				clearsOnly = (mapped[start + i] & ram[start + i]) == ram[start + i];
+			}
+			if (!clearsOnly) {
+				erase(page);
+			}
+
+			// bytes that already match don't need programming
+			for (size_t i = 0U; i < pageSize; i++) {
+				if (ram[start + i] != mapped[start + i] && !program((uint32_t)(start + i), ram[start + i])) {
+					return false;
+				}
+			}
+		}
+	#endif
+
+	return !lost;
+}
+
+uint16_t NVMFileClass::length(void) {
+	return (uint16_t)size;
+}
+
+void NVMFileClass::setPath(const char *setPath) {
+	path = setPath;
+}
+
+void NVMFileClass::setPowerLoss(uint32_t bytes) {
+	cutBudget = bytes;
+	cutArmed = true;
+}
+
+void NVMFileClass::clearPowerLoss(void) {
+	cutArmed = false;
+}
+
+bool NVMFileClass::powerLost(void) {
+	return lost;
+}
+
+uint32_t NVMFileClass::pageErases(uint16_t page) {
+	if (erases == NULL || page >= pageCount) {
+		return 0U;
+	}
+	return erases[page];
+}
+
+const NVMFileStats &NVMFileClass::stats(void) {
+	return counters;
+}
+
+void NVMFileClass::resetStats(void) {
+	memset(&counters, 0, sizeof(counters));
+}
+
+/**
+ * Programs a byte into the file unless power was cut
+ *
+ * @param address address in the nvm region
+ * @param value byte to program
+ *
+ * @return if byte was programmed
+ */
+bool NVMFileClass::program(uint32_t address, uint8_t value) {
+	if (lost) {
+		return false;
+	}
+
+	if (cutArmed) {
+		if (cutBudget == 0U) {
+			lost = true;
+			cutArmed = false;
+			LOG_W(NVM, "NVM file lost power at address {}", address);
+			return false;
+		}
+		cutBudget--;
+	}
+
+	mapped[address] = value;
+	counters.bytesProgrammed++;
+	counters.busyMicros += NVM_FILE_PROGRAM_US;
+	return true;
+}
+
+/**
+ * Erases a page of the file
+ *
+ * @param page page of the nvm region
+ */
+void NVMFileClass::erase(uint16_t page) {
+	size_t start = (size_t)page * NVM_FILE_PAGE_SIZE;
+	size_t pageSize = size - start < NVM_FILE_PAGE_SIZE ? size - start : NVM_FILE_PAGE_SIZE;
+
+	memset(&mapped[start], NVM_FILE_ERASED, pageSize);
+	erases[page]++;
+	counters.pageErases++;
+	counters.busyMicros += NVM_FILE_ERASE_US;
+}
+
+#endif
@@ -0,0 +1,183 @@
+/*
+	core_file.h - memory mapped file standing in for EEPROM
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "../compile_flags.h"
+
+#ifndef COREFILE_H
+#define COREFILE_H
+
+#ifdef NVM_FILE
+
+#include <Arduino.h>
+
+/****************************
+ * File Device Model
+ *
+ * With __NVM_COMMIT__ the file acts like flash emulated
+ * EEPROM, writes land in RAM and commit() programs every
+ * changed page, erasing it first only if a bit has to go
+ * from 0 to 1. Without it every write programs the byte
+ * straight away like AVR EEPROM.
+ *
+ * Only bytes programmed into the file count towards a
+ * power cut, so a cut can leave a page erased or torn.
+****************************/
+
+// file the nvm region is mapped from
+#ifndef NVM_FILE_PATH
+#define NVM_FILE_PATH "nvm.bin"
+#endif
+
+// bytes erased together, matches RP2040 and ESP32 flash sectors
+#ifndef NVM_FILE_PAGE_SIZE
+#define NVM_FILE_PAGE_SIZE 4096U
+#endif
+
+// modelled time to erase a page in microseconds
+#ifndef NVM_FILE_ERASE_US
+#define NVM_FILE_ERASE_US 45000UL
+#endif
+
+// modelled time to program a byte in microseconds
+#ifndef NVM_FILE_PROGRAM_US
+#define NVM_FILE_PROGRAM_US 3UL
+#endif
+
+// value of an erased byte
+#define NVM_FILE_ERASED 0xFFU
+
+/**
+ * Counters of work done by the file device
+ */
+struct NVMFileStats {
+	uint32_t commits;
+	uint32_t pageErases;
+	uint32_t bytesProgrammed;
+	uint64_t busyMicros;
+};
+
+class NVMFileClass {
+	public:
+		NVMFileClass(void);
+		~NVMFileClass(void);
+
+		/**
+		 * Maps the nvm file, creating it erased if missing
+		 *
+		 * @param size bytes of the nvm region
+		 *
+		 * @return if file was mapped
+		 */
+		bool begin(size_t size);
+
+		/**
+		 * Unmaps the nvm file without committing
+		 */
+		void end(void);
+
+		uint8_t read(int address);
+		void write(int address, uint8_t value);
+		void update(int address, uint8_t value);
+
+		template <typename T>
+		T &get(int address, T &value) {
+			uint8_t *bytes = (uint8_t*)&value;
+			for (size_t i = 0U; i < sizeof(T); i++) {
+				bytes[i] = read(address + (int)i);
+			}
+			return value;
+		}
+
+		template <typename T>
+		const T &put(int address, const T &value) {
+			const uint8_t *bytes = (const uint8_t*)&value;
+			for (size_t i = 0U; i < sizeof(T); i++) {
+				write(address + (int)i, bytes[i]);
+			}
+			return value;
+		}
+
+		/**
+		 * Programs every page changed since the last commit,
+		 * erasing the pages that need a bit set
+		 *
+		 * @return if all pages were programmed before a power cut
+		 */
+		bool commit(void);
+
+		uint16_t length(void);
+
+		/**
+		 * Sets the file used by the next begin()
+		 *
+		 * @param path path of nvm file
+		 */
+		void setPath(const char *path);
+
+		/**
+		 * Cuts power once this many more bytes are programmed
+		 *
+		 * @param bytes bytes programmed before the cut
+		 */
+		void setPowerLoss(uint32_t bytes);
+
+		/**
+		 * Disarms a pending power cut
+		 */
+		void clearPowerLoss(void);
+
+		/**
+		 * Gets if the simulated power cut happened, the device
+		 * ignores writes until the next begin()
+		 *
+		 * @return if power was cut
+		 */
+		bool powerLost(void);
+
+		/**
+		 * Gets how many times a page has been erased since begin()
+		 *
+		 * @param page page of the nvm region
+		 *
+		 * @return erase count of page
+		 */
+		uint32_t pageErases(uint16_t page);
+
+		const NVMFileStats &stats(void);
+		void resetStats(void);
+
+	private:
+		bool program(uint32_t address, uint8_t value);
+		void erase(uint16_t page);
+
+		const char *path;
+		uint8_t *mapped;
+		uint8_t *ram;
+		uint32_t *erases;
+		size_t size;
+		uint16_t pageCount;
+		uint32_t cutBudget;
+		bool cutArmed;
+		bool lost;
+		NVMFileStats counters;
+};
+
+extern NVMFileClass EEPROM;
+
+#endif
+#endif
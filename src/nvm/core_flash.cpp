@@ -0,0 +1,151 @@
+/*
+	core_flash.cpp - RP2040 flash sectors standing in for EEPROM
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "core_flash.h"
+
+#ifdef NVM_FLASH
+
+#include <hardware/flash.h>
+#include <hardware/sync.h>
+#include <hardware/regs/addressmap.h>
+#include "../debug.h"
+#include "../critical.h"
+
+static_assert(NVM_FLASH_SECTOR_SIZE == FLASH_SECTOR_SIZE, "NVM flash sectors must match the chip's erase size");
+
+// placed by the Pico core's linker script
+extern uint8_t _EEPROM_start;
+extern uint8_t _FS_start;
+extern uint8_t __flash_binary_end;
+
+NVMFlashClass EEPROM;
+
+NVMFlashClass::NVMFlashClass(void) : ram(NULL), size(0U), sectorCount(0U) {}
+
+NVMFlashClass::~NVMFlashClass(void) {
+	end();
+}
+
+/**
+ * Gets where a sector of the region is mapped
+ *
+ * @param index sector of the region
+ *
+ * @return first byte of the sector in XIP flash
+ */
+const uint8_t *NVMFlashClass::sector(uint16_t index) {
+	if (index == 0U) {
+		return &_EEPROM_start;
+	}
+	return &_FS_start - (size_t)index * NVM_FLASH_SECTOR_SIZE;
+}
+
+bool NVMFlashClass::begin(size_t setSize) {
+	end();
+
+	uint16_t count = (uint16_t)((setSize + NVM_FLASH_SECTOR_SIZE - 1U) / NVM_FLASH_SECTOR_SIZE);
+	if (count == 0U) {
+		return false;
+	}
+	if (count > 1U && sector((uint16_t)(count - 1U)) < &__flash_binary_end) {
+		LOG_ERROR("NVM flash sectors overlap the sketch");
+		return false;
+	}
+
+	ram = (uint8_t*)malloc((size_t)count * NVM_FLASH_SECTOR_SIZE);
+	if (ram == NULL) {
+		return false;
+	}
+
+	size = setSize;
+	sectorCount = count;
+	for (uint16_t index = 0U; index < sectorCount; index++) {
+		memcpy(&ram[(size_t)index * NVM_FLASH_SECTOR_SIZE], sector(index), NVM_FLASH_SECTOR_SIZE);
+	}
+	return true;
+}
+
+void NVMFlashClass::end(void) {
+	free(ram);
+	ram = NULL;
+	size = 0U;
+	sectorCount = 0U;
+}
+
+uint8_t NVMFlashClass::read(int address) {
+	if (ram == NULL || address < 0 || (size_t)address >= size) {
+		return 0xFFU;
+	}
+	return ram[address];
+}
+
+void NVMFlashClass::write(int address, uint8_t value) {
+	if (ram == NULL || address < 0 || (size_t)address >= size) {
+		return;
+	}
+	ram[address] = value;
+}
+
+void NVMFlashClass::update(int address, uint8_t value) {
+	write(address, value);
+}
+
+bool NVMFlashClass::commit(void) {
+	if (ram == NULL) {
+		return false;
+	}
+
+	for (uint16_t index = 0U; index < sectorCount; index++) {
+		const uint8_t *flash = sector(index);
+		const uint8_t *data = &ram[(size_t)index * NVM_FLASH_SECTOR_SIZE];
+		if (memcmp(flash, data, NVM_FLASH_SECTOR_SIZE) == 0) {
+			continue;
+		}
+
+		// programming only clears bits, setting any needs an erase
+		bool clearsOnly = true;
+		for (size_t i = 0U; i < NVM_FLASH_SECTOR_SIZE && clearsOnly; i++) {
+			clearsOnly = (flash[i] & data[i]) == data[i];
+		}
+
+		// XIP is off while the sector is rewritten, nothing may run from flash
+		uint32_t offset = (uint32_t)((uintptr_t)flash - XIP_BASE);
+		criticalPauseOtherCore();
+		uint32_t state = save_and_disable_interrupts();
+		if (clearsOnly) {
+			for (size_t page = 0U; page < NVM_FLASH_SECTOR_SIZE; page += FLASH_PAGE_SIZE) {
+				if (memcmp(&flash[page], &data[page], FLASH_PAGE_SIZE) != 0) {
+					flash_range_program(offset + page, &data[page], FLASH_PAGE_SIZE);
+				}
+			}
+		}
+		else {
+			flash_range_erase(offset, NVM_FLASH_SECTOR_SIZE);
+			flash_range_program(offset, data, NVM_FLASH_SECTOR_SIZE);
+		}
+		restore_interrupts(state);
+		criticalResumeOtherCore();
+	}
+	return true;
+}
+
+uint16_t NVMFlashClass::length(void) {
+	return (uint16_t)size;
+}
+
+#endif
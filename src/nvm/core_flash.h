@@ -0,0 +1,93 @@
+/*
+	core_flash.h - RP2040 flash sectors standing in for EEPROM
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "../compile_flags.h"
+
+#ifndef COREFLASH_H
+#define COREFLASH_H
+
+#ifdef NVM_FLASH
+
+#include <Arduino.h>
+
+/****************************
+ * Flash Device
+ *
+ * The Pico core's EEPROM library erases its one sector on
+ * every commit, so nothing written through it survives a
+ * power cut mid commit. This takes its place with the
+ * same calls over several sectors. A sector is only
+ * erased when its own bytes need a bit set, bytes that
+ * only clear bits are programmed in place, so a copy in
+ * one sector outlives a cut while another is rewritten
+ * and appends into erased bytes leave the rest alone.
+ *
+ * The first sector is the EEPROM library's, so values it
+ * stored are still found. The others are the sectors
+ * below the filesystem, which the sketch must not reach.
+ * Don't include EEPROM.h next to it.
+****************************/
+
+// bytes erased together
+#define NVM_FLASH_SECTOR_SIZE 4096U
+
+class NVMFlashClass {
+	public:
+		NVMFlashClass(void);
+		~NVMFlashClass(void);
+
+		/**
+		 * Maps whole sectors and loads them into RAM
+		 *
+		 * @param size bytes of the nvm region, rounded up to whole sectors
+		 *
+		 * @return if the sectors are clear of the sketch and RAM was allocated
+		 */
+		bool begin(size_t size);
+
+		/**
+		 * Frees the RAM copy without committing
+		 */
+		void end(void);
+
+		uint8_t read(int address);
+		void write(int address, uint8_t value);
+		void update(int address, uint8_t value);
+
+		/**
+		 * Programs every sector changed since the last commit,
+		 * lowest first, erasing the ones that need a bit set
+		 *
+		 * @return if the region is mapped
+		 */
+		bool commit(void);
+
+		uint16_t length(void);
+
+	private:
+		const uint8_t *sector(uint16_t index);
+
+		uint8_t *ram;
+		size_t size;
+		uint16_t sectorCount;
+};
+
+extern NVMFlashClass EEPROM;
+
+#endif
+#endif
@@ -0,0 +1,1079 @@
+/*
+	core_log.cpp - methods for log structured EEPROM usage
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "core_log.h"
+#include "nvm_stats.h"
+#include "nvm_async.h"
+
+#ifdef NVM_LOG
+
+#if !defined(NVM_FILE) && !defined(NVM_FLASH)
+#include <EEPROM.h>
+#endif
+
+#define EMPTY_OFFSET 0U
+
+// maps a key to the offset of its newest record
+struct LogIndexEntry {
+	uint16_t key;
+	uint16_t offset;
+};
+
+bool started = false;
+uint16_t nvmSize = 0U;
+
+uint16_t bankSize = 0U;
+uint16_t bankStride = 0U;
+uint16_t bankStart = 0U;
+uint16_t bankHead = 0U;
+uint16_t bankSequence = 0U;
+
+// the active bank holds keys the index had no room for
+bool logIndexFull = false;
+
+LogIndexEntry logIndex[NVM_LOG_INDEX_SIZE];
+
+/**
+ * Gets if nvm is started and debugs it
+ * 
+ * @return if nvm is started
+ */
+bool nvmStarted() {
+	if (!started) {
+		LOG_W(NVM, "Log not started");
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Reads bytes from EEPROM
+ * 
+ * @param address address to start reading at
+ * @param data buffer to store bytes to
+ * @param size number of bytes to read
+ */
+void logRead(uint16_t address, uint8_t *data, uint16_t size) {
+	for (uint16_t i = 0U; i < size; i++) {
+		data[i] = EEPROM.read((int)(address + i));
+	}
+}
+
+/**
+ * Writes bytes to EEPROM, skipping unchanged bytes
+ * 
+ * @param address address to start writing at
+ * @param data bytes to write
+ * @param size number of bytes to write
+ */
+void logWrite(uint16_t address, const uint8_t *data, uint16_t size) {
+	for (uint16_t i = 0U; i < size; i++) {
+		if (EEPROM.read((int)(address + i)) != data[i]) {
+			EEPROM.write((int)(address + i), data[i]);
+			nvmStatsProgram(address + i, 1U);
+		}
+	}
+}
+
+/**
+ * Commits EEPROM if the library needs it
+ * 
+ * @return if commit was successful
+ */
+bool logCommit(void) {
+	#ifdef __NVM_COMMIT__
+		nvmStatsCommit();
+		return EEPROM.commit();
+	#else
+		return true;
+	#endif
+}
+
+#ifdef __NVM_COMMIT__
+
+/**
+ * Erases a bank in RAM so its commit leaves only erased
+ * bytes past the records
+ * 
+ * @param start address of the bank
+ */
+void logEraseBank(uint16_t start) {
+	for (uint16_t i = 0U; i < bankSize; i++) {
+		if (EEPROM.read((int)(start + i)) != NVM_LOG_ERASED) {
+			EEPROM.write((int)(start + i), NVM_LOG_ERASED);
+		}
+	}
+}
+
+/**
+ * Gets if appends to the active bank only program erased
+ * bytes, a record torn by a cut would need its sector erased
+ * 
+ * @return if the bank is erased past its head
+ */
+bool logBankAppendable(void) {
+	for (uint16_t offset = bankHead; offset < bankSize; offset++) {
+		if (EEPROM.read((int)(bankStart + offset)) != NVM_LOG_ERASED) {
+			return false;
+		}
+	}
+	return true;
+}
+
+#endif
+
+/**
+ * Reads and validates a bank header
+ * 
+ * @param start address of the bank
+ * @param sequence variable to store bank sequence to
+ * 
+ * @return if the header is valid
+ */
+bool logReadHeader(uint16_t start, uint16_t *sequence) {
+	uint8_t header[NVM_LOG_HEADER_SIZE];
+	logRead(start, header, NVM_LOG_HEADER_SIZE);
+
+	if (header[0] != NVM_LOG_MAGIC) {
+		return false;
+	}
+	if (nvmCrc8(0U, header, NVM_LOG_HEADER_SIZE - 1U) != header[3]) {
+		return false;
+	}
+
+	*sequence = (uint16_t)(header[1] | (header[2] << 8));
+	return true;
+}
+
+/**
+ * Writes a bank header
+ * 
+ * @param start address of the bank
+ * @param sequence sequence of the bank
+ */
+void logWriteHeader(uint16_t start, uint16_t sequence) {
+	uint8_t header[NVM_LOG_HEADER_SIZE];
+	header[0] = NVM_LOG_MAGIC;
+	header[1] = (uint8_t)(sequence & LEAST_BYTE);
+	header[2] = (uint8_t)((sequence & SECOND_LEAST_BYTE) >> 8);
+	header[3] = nvmCrc8(0U, header, NVM_LOG_HEADER_SIZE - 1U);
+	logWrite(start, header, NVM_LOG_HEADER_SIZE);
+}
+
+/**
+ * Finds the index slot of a key
+ * 
+ * @param key key of nvm value
+ * 
+ * @return slot holding the key or the empty slot to insert it at,
+ * NVM_LOG_INDEX_SIZE if the index is full
+ */
+uint16_t logFindSlot(uint16_t key) {
+	uint16_t slot = (uint16_t)(key * 40503U) & (NVM_LOG_INDEX_SIZE - 1U);
+
+	for (uint16_t i = 0U; i < NVM_LOG_INDEX_SIZE; i++) {
+		LogIndexEntry *entry = &logIndex[slot];
+		if (entry->offset == EMPTY_OFFSET || entry->key == key) {
+			return slot;
+		}
+		slot = (slot + 1U) & (NVM_LOG_INDEX_SIZE - 1U);
+	}
+
+	return NVM_LOG_INDEX_SIZE;
+}
+
+/**
+ * Gets if a record type carries a length byte
+ * 
+ * @param varType type of the record, may include the batch flag
+ * 
+ * @return if the record holds a byte block
+ */
+bool logIsBlock(uint8_t varType) {
+	return (varType & (uint8_t)~NVM_LOG_BATCH_FLAG) == VAR_BYTES;
+}
+
+/**
+ * Reads a record and checks its crc
+ * 
+ * @param offset offset of the record in the active bank
+ * @param key variable to store record key to
+ * @param varType variable to store record type to
+ * @param valueSize variable to store value size to
+ * 
+ * @return size of the record, 0 if invalid
+ */
+uint16_t logReadRecord(uint16_t offset, uint16_t *key, uint8_t *varType, uint8_t *valueSize) {
+	if (offset + NVM_LOG_RECORD_OVERHEAD > bankSize) {
+		return 0U;
+	}
+
+	uint8_t head[4];
+	logRead(bankStart + offset, head, 3U);
+
+	if (head[2] == NVM_LOG_ERASED) {
+		return 0U;
+	}
+
+	uint8_t baseType = head[2] & (uint8_t)~NVM_LOG_BATCH_FLAG;
+	uint8_t headSize = 3U;
+	uint8_t size = nvmVarSize(baseType);
+
+	if (baseType == VAR_BYTES) {
+		head[3] = EEPROM.read((int)(bankStart + offset + 3U));
+		headSize = 4U;
+		size = head[3];
+	}
+	else if (size == 0U && baseType != NVM_LOG_COMMIT_TYPE) {
+		return 0U;
+	}
+
+	uint16_t recordSize = headSize + size + 1U;
+	if (offset + recordSize > bankSize) {
+		return 0U;
+	}
+
+	uint8_t crc = nvmCrc8((uint8_t)bankSequence, head, headSize);
+	for (uint16_t i = 0U; i < size; i++) {
+		uint8_t value = EEPROM.read((int)(bankStart + offset + headSize + i));
+		crc = nvmCrc8(crc, &value, 1U);
+	}
+	if (EEPROM.read((int)(bankStart + offset + recordSize - 1U)) != crc) {
+		return 0U;
+	}
+
+	*key = (uint16_t)(head[0] | (head[1] << 8));
+	*varType = head[2];
+	*valueSize = size;
+	return recordSize;
+}
+
+/**
+ * Gets the address of a record's value in the active bank
+ * 
+ * @param offset offset of the record
+ * @param varType type of the record
+ * 
+ * @return EEPROM address of the value
+ */
+uint16_t logValueAddress(uint16_t offset, uint8_t varType) {
+	return bankStart + offset + (logIsBlock(varType) ? 4U : 3U);
+}
+
+/**
+ * Writes a record at the head of the active bank
+ * 
+ * @param key key of nvm value
+ * @param varType type of the value, may include the batch flag
+ * @param value bytes of the value
+ * @param size number of value bytes
+ * 
+ * @return offset of the record
+ */
+uint16_t logAppendRecord(uint16_t key, uint8_t varType, const uint8_t *value, uint8_t size) {
+	uint8_t head[4];
+	uint8_t headSize = logIsBlock(varType) ? 4U : 3U;
+	head[0] = (uint8_t)(key & LEAST_BYTE);
+	head[1] = (uint8_t)((key & SECOND_LEAST_BYTE) >> 8);
+	head[2] = varType;
+	head[3] = size;
+
+	uint8_t crc = nvmCrc8((uint8_t)bankSequence, head, headSize);
+	crc = nvmCrc8(crc, value, size);
+
+	uint16_t offset = bankHead;
+	uint16_t next = offset + headSize + size + 1U;
+
+	// ends the log after this record so stale bytes aren't replayed,
+	// an erased byte already does and stays programmable
+	if (next + 3U <= bankSize && EEPROM.read((int)(bankStart + next + 2U)) != NVM_LOG_ERASED) {
+		uint8_t end = VAR_INVALID;
+		logWrite(bankStart + next + 2U, &end, 1U);
+	}
+
+	logWrite(bankStart + offset, head, headSize);
+	logWrite(bankStart + offset + headSize, value, size);
+	logWrite(bankStart + offset + headSize + size, &crc, 1U);
+
+	bankHead = next;
+	return offset;
+}
+
+/**
+ * Adds a record to the RAM index
+ * 
+ * @param key key of nvm value
+ * @param offset offset of the record
+ * 
+ * @return if the index had room
+ */
+bool logIndexRecord(uint16_t key, uint16_t offset) {
+	uint16_t slot = logFindSlot(key);
+	if (slot == NVM_LOG_INDEX_SIZE) {
+		LOG_ERROR("Log index full");
+		return false;
+	}
+
+	logIndex[slot].key = key;
+	logIndex[slot].offset = offset;
+	return true;
+}
+
+/**
+ * Finds the end of a batch starting at an offset
+ * 
+ * @param offset offset of the first batch record
+ * 
+ * @return offset after the batch commit record, 0 if never committed
+ */
+uint16_t logBatchEnd(uint16_t offset) {
+	uint16_t key;
+	uint8_t varType;
+	uint8_t size;
+
+	while (true) {
+		uint16_t recordSize = logReadRecord(offset, &key, &varType, &size);
+		if (recordSize == 0U) {
+			return 0U;
+		}
+		offset += recordSize;
+
+		if (varType == NVM_LOG_COMMIT_TYPE) {
+			return offset;
+		}
+		if (!(varType & NVM_LOG_BATCH_FLAG)) {
+			return 0U;
+		}
+	}
+}
+
+/**
+ * Rebuilds the RAM index from the active bank
+ */
+void logReplay(void) {
+	memset(logIndex, 0, sizeof(logIndex));
+	bankHead = NVM_LOG_HEADER_SIZE;
+	logIndexFull = false;
+
+	uint16_t key;
+	uint8_t varType;
+	uint8_t size;
+	uint16_t batchEnd = 0U;
+
+	while (true) {
+		uint16_t recordSize = logReadRecord(bankHead, &key, &varType, &size);
+		if (recordSize == 0U) {
+			break;
+		}
+
+		if ((varType & NVM_LOG_BATCH_FLAG) && bankHead >= batchEnd) {
+			// uncommitted batches are dropped and overwritten
+			batchEnd = logBatchEnd(bankHead);
+			if (batchEnd == 0U) {
+				break;
+			}
+		}
+
+		// keeps scanning past keys that don't fit so the head isn't overwritten
+		if (varType != NVM_LOG_COMMIT_TYPE) {
+			uint16_t slot = logFindSlot(key);
+			if (slot == NVM_LOG_INDEX_SIZE) {
+				logIndexFull = true;
+			}
+			else {
+				logIndex[slot].key = key;
+				logIndex[slot].offset = bankHead;
+			}
+		}
+		bankHead += recordSize;
+	}
+
+	if (logIndexFull) {
+		LOG_ERROR("Log holds more keys than NVM_LOG_INDEX_SIZE, raise it to read them all");
+	}
+}
+
+/**
+ * Moves live records into the inactive bank and activates it
+ * 
+ * @return if compaction was committed
+ */
+bool logCompact(void) {
+	// records missing from the index would be dropped
+	if (logIndexFull) {
+		LOG_ERROR("Log can't compact keys missing from its index");
+		return false;
+	}
+
+	uint16_t oldStart = bankStart;
+	uint16_t oldSequence = bankSequence;
+	uint16_t newStart = (bankStart == bankStride) ? 0U : bankStride;
+
+	// invalidates the target bank before reusing it
+	#ifdef __NVM_COMMIT__
+		logEraseBank(newStart);
+	#else
+		uint8_t blank = 0U;
+		logWrite(newStart, &blank, 1U);
+	#endif
+
+	uint16_t key;
+	uint8_t varType;
+	uint8_t size;
+	uint8_t value[NVM_LOG_BLOCK_SIZE];
+
+	uint16_t newHead = NVM_LOG_HEADER_SIZE;
+	uint16_t newSequence = oldSequence + 1U;
+
+	#ifndef __NVM_COMMIT__
+		uint8_t end = VAR_INVALID;
+		logWrite(newStart + newHead + 2U, &end, 1U);
+	#endif
+
+	for (uint16_t slot = 0U; slot < NVM_LOG_INDEX_SIZE; slot++) {
+		if (logIndex[slot].offset == EMPTY_OFFSET) {
+			continue;
+		}
+
+		bankStart = oldStart;
+		bankSequence = oldSequence;
+		logReadRecord(logIndex[slot].offset, &key, &varType, &size);
+		logRead(logValueAddress(logIndex[slot].offset, varType), value, size);
+
+		bankStart = newStart;
+		bankSequence = newSequence;
+		bankHead = newHead;
+		logIndex[slot].offset = logAppendRecord(
+			key, varType & (uint8_t)~NVM_LOG_BATCH_FLAG, value, size
+		);
+		newHead = bankHead;
+	}
+
+	bankStart = newStart;
+	bankSequence = newSequence;
+	bankHead = newHead;
+
+	// header is committed after the records so a reset keeps the old bank
+	if (!logCommit()) {
+		return false;
+	}
+	logWriteHeader(bankStart, bankSequence);
+
+	LOG_I(NVM, "Log compacted to bank at {}", bankStart);
+
+	return logCommit();
+}
+
+enum NVMStartCode nvmInit(uint16_t setNVMSize) {
+	TRACE_SCOPE("nvmInit");
+
+	if (started) {
+		LOG_W(NVM, "Log already started");
+		return NVM_STARTED;
+	}
+
+	if (setNVMSize == (uint16_t)DEFAULT_NVM_SIZE || setNVMSize < NVM_LOG_MIN_SIZE) {
+		LOG_W(NVM, "NVM size given too small for log, not initialized");
+		return NVM_INVALID_SIZE;
+	}
+
+	nvmSize = setNVMSize;
+	bankSize = nvmSize / 2U;
+
+	// compacting into a bank never erases a sector of the other
+	#ifdef __NVM_COMMIT__
+		bankStride = (uint16_t)(((uint32_t)bankSize + NVM_LOG_SECTOR_SIZE - 1UL) /
+			NVM_LOG_SECTOR_SIZE * NVM_LOG_SECTOR_SIZE);
+	#else
+		bankStride = bankSize;
+	#endif
+
+	#ifdef __NVM_BEGIN__
+		#ifdef __NVM_BEGIN_SIZE__
+			#ifdef __NVM_BEGIN_RETURN__
+				started = EEPROM.begin(bankStride + bankSize);
+			#else
+				EEPROM.begin(bankStride + bankSize);
+				started = true;
+			#endif
+		#else
+			#ifdef __NVM_BEGIN_RETURN__
+				started = EEPROM.begin();
+			#else
+				EEPROM.begin();
+				started = true;
+			#endif
+		#endif
+	#else
+		started = true;
+	#endif
+
+	if (!started) {
+		LOG_ERROR("'EEPROM' library failed to start");
+		return NVM_FAILED;
+	}
+
+	nvmStatsBegin(bankStride + bankSize);
+
+	uint16_t sequence0;
+	uint16_t sequence1;
+	bool valid0 = logReadHeader(0U, &sequence0);
+	bool valid1 = logReadHeader(bankStride, &sequence1);
+
+	if (valid0 && (!valid1 || (int16_t)(sequence0 - sequence1) > 0)) {
+		bankStart = 0U;
+		bankSequence = sequence0;
+	}
+	else if (valid1) {
+		bankStart = bankStride;
+		bankSequence = sequence1;
+	}
+	else {
+		// formats an empty log
+		bankStart = 0U;
+		bankSequence = 1U;
+		#ifdef __NVM_COMMIT__
+			logEraseBank(bankStart);
+		#else
+			uint8_t end = VAR_INVALID;
+			logWrite(bankStart + NVM_LOG_HEADER_SIZE + 2U, &end, 1U);
+		#endif
+		logWriteHeader(bankStart, bankSequence);
+		if (!logCommit()) {
+			started = false;
+			return NVM_FAILED;
+		}
+	}
+
+	logReplay();
+
+	#ifdef __NVM_COMMIT__
+		if (!logBankAppendable() && !logCompact()) {
+			LOG_ERROR("Log couldn't move to an erased bank");
+		}
+	#endif
+
+	LOG_I(NVM, "Started log for NVM, head at {}", bankHead);
+
+	return NVM_OK;
+}
+
+void nvmEnd(void) {
+	nvmBatchClear();
+	started = false;
+}
+
+bool nvmFlush(void) {
+	TRACE_SCOPE("nvmFlush");
+
+	if (nvmAsyncActive()) {
+		return nvmSync();
+	}
+
+	// log commits on every append
+	return nvmStarted();
+}
+
+bool nvmCommitBatch(void) {
+	TRACE_SCOPE("nvmCommitBatch");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	// a batch only holds the async queue, the worker commits it
+	if (nvmAsyncActive()) {
+		return nvmAsyncCommitBatch();
+	}
+
+	NVMStorageLock lock;
+
+	if (!nvmBatchActive()) {
+		LOG_W(NVM, "Log has no batch to commit");
+		return false;
+	}
+
+	uint16_t offset = 0U;
+	uint16_t key;
+	uint8_t varType;
+	uint16_t needed = NVM_LOG_RECORD_OVERHEAD;
+	uint16_t newKeys = 0U;
+	uint16_t freeSlots = 0U;
+
+	for (uint16_t slot = 0U; slot < NVM_LOG_INDEX_SIZE; slot++) {
+		if (logIndex[slot].offset == EMPTY_OFFSET) {
+			freeSlots++;
+		}
+	}
+
+	while (true) {
+		uint16_t valueOffset = nvmBatchEntry(nvmBatch, nvmBatchLength, offset, &key, &varType);
+		if (valueOffset == 0U) {
+			break;
+		}
+
+		uint16_t slot = logFindSlot(key);
+		if (slot == NVM_LOG_INDEX_SIZE || logIndex[slot].offset == EMPTY_OFFSET) {
+			newKeys++;
+		}
+
+		needed += NVM_LOG_RECORD_OVERHEAD + nvmVarSize(varType);
+		offset = valueOffset + nvmVarSize(varType);
+	}
+
+	bool result = newKeys <= freeSlots;
+
+	if (result && bankHead + needed > bankSize) {
+		result = logCompact() && bankHead + needed <= bankSize;
+	}
+
+	if (result) {
+		uint16_t recordOffsets[NVM_BATCH_SIZE / NVM_BATCH_ENTRY_OVERHEAD];
+		uint16_t count = 0U;
+
+		offset = 0U;
+		while (true) {
+			uint16_t valueOffset = nvmBatchEntry(nvmBatch, nvmBatchLength, offset, &key, &varType);
+			if (valueOffset == 0U) {
+				break;
+			}
+
+			recordOffsets[count++] = logAppendRecord(
+				key, varType | NVM_LOG_BATCH_FLAG, &nvmBatch[valueOffset], nvmVarSize(varType)
+			);
+			offset = valueOffset + nvmVarSize(varType);
+		}
+
+		// the batch only exists once this record is written
+		logAppendRecord(0U, NVM_LOG_COMMIT_TYPE, NULL, 0U);
+
+		offset = 0U;
+		for (uint16_t i = 0U; i < count; i++) {
+			uint16_t valueOffset = nvmBatchEntry(nvmBatch, nvmBatchLength, offset, &key, &varType);
+			logIndexRecord(key, recordOffsets[i]);
+			offset = valueOffset + nvmVarSize(varType);
+		}
+
+		result = logCommit();
+	}
+
+	if (!result) {
+		LOG_ERROR("Log couldn't fit batch");
+	}
+
+	LOG_I(NVM, "Log committed batch, bytes: {}", nvmBatchLength);
+
+	nvmBatchClear();
+	return result;
+}
+
+/**
+ * Gets if a record already holds a value
+ * 
+ * @param offset offset of the record in the active bank
+ * @param varType type of the value
+ * @param value bytes of the value
+ * @param size number of value bytes
+ * 
+ * @return if the record type and value match
+ */
+bool logSameValue(uint16_t offset, uint8_t varType, const uint8_t *value, uint8_t size) {
+	uint8_t storedType = EEPROM.read((int)(bankStart + offset + 2U)) & (uint8_t)~NVM_LOG_BATCH_FLAG;
+	if (storedType != varType) {
+		return false;
+	}
+	if (logIsBlock(varType) && EEPROM.read((int)(bankStart + offset + 3U)) != size) {
+		return false;
+	}
+
+	uint16_t address = logValueAddress(offset, varType);
+	for (uint8_t i = 0U; i < size; i++) {
+		if (EEPROM.read((int)(address + i)) != value[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Appends a record, compacting first if the bank is full
+ * 
+ * @param key key of nvm value
+ * @param varType type of the value
+ * @param value bytes of the value
+ * @param size number of value bytes
+ * 
+ * @return if the record was committed
+ */
+bool logStore(uint16_t key, uint8_t varType, const uint8_t *value, uint8_t size) {
+	uint16_t slot = logFindSlot(key);
+	uint16_t recordSize = NVM_LOG_RECORD_OVERHEAD + size + (logIsBlock(varType) ? 1U : 0U);
+	bool result = slot != NVM_LOG_INDEX_SIZE;
+
+	// rewriting the newest value would only add wear
+	if (result && logIndex[slot].offset != EMPTY_OFFSET &&
+		logSameValue(logIndex[slot].offset, varType, value, size)) {
+		nvmStatsSkip();
+		return true;
+	}
+
+	if (result && bankHead + recordSize > bankSize) {
+		result = logCompact() && bankHead + recordSize <= bankSize;
+	}
+
+	if (result) {
+		logIndex[slot].key = key;
+		logIndex[slot].offset = logAppendRecord(key, varType, value, size);
+		result = logCommit();
+	}
+
+	return result;
+}
+
+bool nvmWriteBlock(uint16_t key, const void *data, uint16_t size) {
+	TRACE_SCOPE("nvmWriteBlock");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	if (nvmBatchActive()) {
+		LOG_W(NVM, "Log blocks can't be staged in a batch");
+		return false;
+	}
+
+	uint32_t start = nvmStatsClock();
+	bool result = size <= NVM_LOG_BLOCK_SIZE &&
+		logStore(key, VAR_BYTES, (const uint8_t*)data, (uint8_t)size);
+	nvmStatsWrite(VAR_BYTES, start);
+
+	if (!result) {
+		LOG_ERROR("Log couldn't write block to key {}", key);
+	}
+
+	LOG_NVM("Log wrote block of {} bytes to key {}", size, key);
+
+	return result;
+}
+
+bool nvmReadBlock(uint16_t key, void *data, uint16_t size) {
+	TRACE_SCOPE("nvmReadBlock");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	uint32_t start = nvmStatsClock();
+	uint16_t slot = logFindSlot(key);
+	bool result = slot != NVM_LOG_INDEX_SIZE && logIndex[slot].offset != EMPTY_OFFSET;
+
+	if (result) {
+		uint16_t offset = logIndex[slot].offset;
+		uint8_t storedType = EEPROM.read((int)(bankStart + offset + 2U));
+		result = logIsBlock(storedType) &&
+			EEPROM.read((int)(bankStart + offset + 3U)) == size;
+		if (result) {
+			logRead(logValueAddress(offset, storedType), (uint8_t*)data, size);
+		}
+	}
+
+	nvmStatsRead(VAR_BYTES, start);
+
+	if (!result) {
+		LOG_ERROR("Log has no block of {} bytes for key {}", size, key);
+	}
+
+	return result;
+}
+
+bool nvmWriteBytes(uint16_t key, const void *data, uint16_t length, uint16_t capacity) {
+	TRACE_SCOPE("nvmWriteBytes");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	if (nvmBatchActive()) {
+		LOG_W(NVM, "Log bytes can't be staged in a batch");
+		return false;
+	}
+
+	if (!nvmBytesFit(key, length, capacity)) {
+		return false;
+	}
+
+	// the block record's length byte is the length prefix
+	uint32_t start = nvmStatsClock();
+	bool result = length <= NVM_LOG_BLOCK_SIZE &&
+		logStore(key, VAR_BYTES, (const uint8_t*)data, (uint8_t)length);
+	nvmStatsWrite(VAR_BYTES, start);
+
+	if (!result) {
+		LOG_ERROR("Log couldn't write bytes to key {}", key);
+	}
+
+	LOG_NVM("Log wrote {} bytes to key {}", length, key);
+
+	return result;
+}
+
+bool nvmGetBytes(uint16_t key, void *data, uint16_t *length, uint16_t capacity) {
+	TRACE_SCOPE("nvmGetBytes");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	uint32_t start = nvmStatsClock();
+	uint16_t slot = logFindSlot(key);
+	bool result = slot != NVM_LOG_INDEX_SIZE && logIndex[slot].offset != EMPTY_OFFSET;
+
+	if (result) {
+		uint16_t offset = logIndex[slot].offset;
+		uint8_t storedType = EEPROM.read((int)(bankStart + offset + 2U));
+		uint8_t size = EEPROM.read((int)(bankStart + offset + 3U));
+		result = logIsBlock(storedType) && size + NVM_LENGTH_PREFIX <= capacity;
+		if (result) {
+			logRead(logValueAddress(offset, storedType), (uint8_t*)data, size);
+			*length = size;
+		}
+	}
+
+	nvmStatsRead(VAR_BYTES, start);
+
+	if (!result) {
+		LOG_ERROR("Log has no bytes that fit {} bytes for key {}", capacity, key);
+	}
+
+	return result;
+}
+
+bool nvmWriteString(uint16_t key, const char *value, uint16_t capacity) {
+	size_t length = strlen(value);
+	if (length > NVM_BYTES_MAX) {
+		length = NVM_BYTES_MAX + 1U;
+	}
+	return nvmWriteBytes(key, value, (uint16_t)length, capacity);
+}
+
+bool nvmGetString(uint16_t key, char *value, uint16_t capacity) {
+	uint16_t length;
+	if (!nvmGetBytes(key, value, &length, capacity)) {
+		return false;
+	}
+	value[length] = '\0';
+	return true;
+}
+
+/**
+ * Runs whole write process
+ * 
+ * @param key key of nvm value
+ * @param value value to write to nvm
+ * @param var variable type stored with the record
+ * 
+ * @return if write was valid
+ */
+template <typename T>
+bool nvmWrite(uint16_t key, T value, enum VarType var) {
+	TRACE_SCOPE("nvmWriteValue");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	uint32_t start = nvmStatsClock();
+
+	if (nvmAsyncActive()) {
+		bool queued = nvmAsyncStage(key, var, &value);
+		nvmStatsWrite(var, start);
+		return queued;
+	}
+
+	NVMStorageLock lock;
+
+	if (nvmBatchActive()) {
+		bool staged = nvmBatchStage(key, var, &value);
+		nvmStatsWrite(var, start);
+		return staged;
+	}
+
+	bool result = logStore(key, (uint8_t)var, (const uint8_t*)&value, sizeof(T));
+	nvmStatsWrite(var, start);
+
+	if (!result) {
+		LOG_ERROR("Log couldn't write value '{}' to key {}", value, key);
+	}
+
+	LOG_NVM("Log wrote {} '{}' to key {}", nvmVarName(var), value, key);
+
+	return result;
+}
+
+bool nvmWriteValue(uint16_t key, bool value) {
+	return nvmWrite(key, value, VAR_BOOL);
+}
+
+bool nvmWriteValue(uint16_t key, int8_t value) {
+	return nvmWrite(key, value, VAR_INT8);
+}
+
+bool nvmWriteValue(uint16_t key, uint8_t value) {
+	return nvmWrite(key, value, VAR_UINT8);
+}
+
+bool nvmWriteValue(uint16_t key, int16_t value) {
+	return nvmWrite(key, value, VAR_INT16);
+}
+
+bool nvmWriteValue(uint16_t key, uint16_t value) {
+	return nvmWrite(key, value, VAR_UINT16);
+}
+
+bool nvmWriteValue(uint16_t key, int32_t value) {
+	return nvmWrite(key, value, VAR_INT32);
+}
+
+bool nvmWriteValue(uint16_t key, uint32_t value) {
+	return nvmWrite(key, value, VAR_UINT32);
+}
+
+bool nvmWriteValue(uint16_t key, int64_t value) {
+	return nvmWrite(key, value, VAR_INT64);
+}
+
+bool nvmWriteValue(uint16_t key, uint64_t value) {
+	return nvmWrite(key, value, VAR_UINT64);
+}
+
+bool nvmWriteValue(uint16_t key, float value) {
+	return nvmWrite(key, value, VAR_FLOAT);
+}
+
+bool nvmWriteValue(uint16_t key, double value) {
+	return nvmWrite(key, value, VAR_DOUBLE);
+}
+
+/**
+ * Runs whole get process
+ * 
+ * @param key key of nvm value
+ * @param value variable to store result to
+ * @param var variable type expected in the record
+ * 
+ * @return if get was successful
+ */
+template <typename T>
+bool nvmGet(uint16_t key, T *value, enum VarType var) {
+	TRACE_SCOPE("nvmGetValue");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	uint32_t start = nvmStatsClock();
+
+	if (nvmAsyncLookup(key, var, value)) {
+		nvmStatsRead(var, start);
+		return true;
+	}
+
+	NVMStorageLock lock;
+
+	if (nvmBatchLookup(key, var, value)) {
+		nvmStatsRead(var, start);
+		return true;
+	}
+
+	uint16_t slot = logFindSlot(key);
+	bool result = slot != NVM_LOG_INDEX_SIZE && logIndex[slot].offset != EMPTY_OFFSET;
+
+	if (result) {
+		uint16_t offset = logIndex[slot].offset;
+		uint8_t storedType = EEPROM.read((int)(bankStart + offset + 2U)) & (uint8_t)~NVM_LOG_BATCH_FLAG;
+		result = storedType == (uint8_t)var;
+		if (result) {
+			logRead(logValueAddress(offset, storedType), (uint8_t*)value, sizeof(T));
+		}
+	}
+
+	nvmStatsRead(var, start);
+
+	if (!result) {
+		LOG_ERROR("Log has no value for key {}", key);
+		return false;
+	}
+
+	LOG_NVM("Log got {} '{}' from key {}", nvmVarName(var), *value, key);
+
+	return true;
+}
+
+bool nvmGetValue(uint16_t key, bool *value) {
+	return nvmGet(key, value, VAR_BOOL);
+}
+
+bool nvmGetValue(uint16_t key, int8_t *value) {
+	return nvmGet(key, value, VAR_INT8);
+}
+
+bool nvmGetValue(uint16_t key, uint8_t *value) {
+	return nvmGet(key, value, VAR_UINT8);
+}
+
+bool nvmGetValue(uint16_t key, int16_t *value) {
+	return nvmGet(key, value, VAR_INT16);
+}
+
+bool nvmGetValue(uint16_t key, uint16_t *value) {
+	return nvmGet(key, value, VAR_UINT16);
+}
+
+bool nvmGetValue(uint16_t key, int32_t *value) {
+	return nvmGet(key, value, VAR_INT32);
+}
+
+bool nvmGetValue(uint16_t key, uint32_t *value) {
+	return nvmGet(key, value, VAR_UINT32);
+}
+
+bool nvmGetValue(uint16_t key, int64_t *value) {
+	return nvmGet(key, value, VAR_INT64);
+}
+
+bool nvmGetValue(uint16_t key, uint64_t *value) {
+	return nvmGet(key, value, VAR_UINT64);
+}
+
+bool nvmGetValue(uint16_t key, float *value) {
+	return nvmGet(key, value, VAR_FLOAT);
+}
+
+bool nvmGetValue(uint16_t key, double *value) {
+	return nvmGet(key, value, VAR_DOUBLE);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,90 @@
+/*
+	core_log.h - methods for log structured EEPROM usage
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "../compile_flags.h"
+
+#ifndef CORELOG_H
+#define CORELOG_H
+
+#ifdef NVM_LOG
+
+#include <Arduino.h>
+#include "generic_nvm.h"
+#include "eeprom_addresses.h"
+#include "../debug.h"
+
+/****************************
+ * Log Layout
+ * 
+ * The nvm region is split into two banks. Only one
+ * bank is active, it starts with a header followed
+ * by appended records. When the active bank fills,
+ * live records are compacted into the other bank.
+ * 
+ * header: magic(1) sequence(2) crc(1)
+ * record: key(2) type(1) value(n) crc(1)
+ * block record: key(2) type(1) length(1) value(length) crc(1)
+ * 
+ * Records of a batch have the batch flag set in their
+ * type and only count once a commit record follows them.
+ * An erased type byte ends the log like an end record.
+ * 
+ * On flash emulated EEPROM each bank starts on its own
+ * erase sector and is erased before compacting into it,
+ * so appends only program erased bytes and never erase
+ * the records before them. Its header is committed after
+ * its records so a cut mid compaction keeps the old bank.
+****************************/
+
+#if defined(NVM_FILE)
+#include "core_file.h"
+#elif defined(NVM_FLASH)
+#include "core_flash.h"
+#endif
+
+// bytes a commit erases together
+#if defined(NVM_FILE)
+#define NVM_LOG_SECTOR_SIZE NVM_FILE_PAGE_SIZE
+#elif defined(NVM_FLASH)
+#define NVM_LOG_SECTOR_SIZE NVM_FLASH_SECTOR_SIZE
+#else
+#define NVM_LOG_SECTOR_SIZE 4096U
+#endif
+
+// number of keys the RAM index can hold, must be a power of 2
+#ifndef NVM_LOG_INDEX_SIZE
+#define NVM_LOG_INDEX_SIZE 32U
+#endif
+
+// largest byte block a single record can hold
+#ifndef NVM_LOG_BLOCK_SIZE
+#define NVM_LOG_BLOCK_SIZE 64U
+#endif
+
+#define NVM_LOG_MAGIC 0xA5U
+#define NVM_LOG_HEADER_SIZE 4U
+#define NVM_LOG_RECORD_OVERHEAD 4U
+#define NVM_LOG_BATCH_FLAG 0x80U
+#define NVM_LOG_COMMIT_TYPE 0x7FU
+#define NVM_LOG_ERASED 0xFFU
+
+// smallest region that fits both banks and a double record
+#define NVM_LOG_MIN_SIZE (2U * (NVM_LOG_HEADER_SIZE + NVM_LOG_RECORD_OVERHEAD + BYTE8_SIZE))
+
+#endif
+#endif
\ No newline at end of file
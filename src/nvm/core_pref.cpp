@@ -17,6 +17,8 @@
 */
 
 #include "core_pref.h"
+#include "nvm_stats.h"
+#include "nvm_async.h"
 
 #ifndef NVM_EEPROM
 
@@ -24,107 +26,930 @@
 #define DEFAULT_BOOL false
 #define DEFAULT_FLOAT NAN
 
-#define GOT_VALUE true
-#define WROTE_VALUE false
+#define CHAR_KEY_SIZE 5
 
-#define CHAR_KEY_SIZE 3
+// preferences key holding a batch while it is applied
+#define BATCH_KEY "batch"
+
+// preferences key holding all values in packed mode
+#define PACKED_KEY "packed"
+
+// preferences key holding the format of key names, set once legacy names are renamed
+#define KEYS_KEY "keys"
+#define KEYS_FORMAT 1U
+#define LEGACY_KEY_SIZE 3
 
 bool started = false;
 uint16_t nvmSize = 0U;
 Preferences preferences;
 
-#ifdef __NVM_DEBUG__
+#ifdef NVM_PREF_PACKED
+uint8_t *packedImage = NULL;
+uint16_t packedLength = 0U;
+bool packedDirty = false;
+#endif
 
-template <typename T> void printGotValue(
-	enum VarType varType, const uint16_t key, T value, bool gets
-) {
-	printNVM();
-	Serial.print(F("Pref "));
+bool nvmStarted(void) {
+	if (!started) {
+		LOG_ERROR("Pref not started");
+		return false;
+	}
+	return true;
+}
+
+void keyToChar(uint16_t key, char* keyStr) {
+	// hex digits keep keys with a zero byte from ending the string
+	const char digits[] = "0123456789abcdef";
 
-	if (gets) {
-		Serial.print(F("got, "));
+	keyStr[0] = digits[(key >> 12) & 0xFU];
+	keyStr[1] = digits[(key >> 8) & 0xFU];
+	keyStr[2] = digits[(key >> 4) & 0xFU];
+	keyStr[3] = digits[key & 0xFU];
+	keyStr[4] = '\0';
+}
+
+/**
+ * Gets the name a key was stored under before keys were hex
+ * digits, its two bytes as is up to the first zero byte
+ * 
+ * @param key key of nvm address
+ * @param keyStr variable to store name to
+ */
+void keyToLegacyChar(uint16_t key, char *keyStr) {
+	keyStr[0] = (char)(key & LEAST_BYTE);
+	keyStr[1] = (char)((key & SECOND_LEAST_BYTE) >> 8);
+	keyStr[2] = '\0';
+}
+
+/**
+ * Records a preferences put, each put is its own commit
+ * 
+ * @param key key of nvm address
+ * @param written bytes written by preferences
+ */
+void prefStatsPut(uint16_t key, size_t written) {
+	if (written != 0U) {
+		nvmStatsProgram(key, (uint16_t)written);
+		nvmStatsCommit();
+	}
+}
+
+/**
+ * Writes a batch entry with the put method of its type
+ * 
+ * @param keyStr preferences key
+ * @param varType type of the value
+ * @param value bytes of the value
+ * 
+ * @return bytes written by preferences
+ */
+size_t prefPutEntry(const char *keyStr, uint8_t varType, const uint8_t *value) {
+	switch(varType) {
+		case VAR_BOOL: {
+			bool v; memcpy(&v, value, sizeof(v));
+			return preferences.putBool(keyStr, v);
+		}
+		case VAR_INT8: {
+			int8_t v; memcpy(&v, value, sizeof(v));
+			return preferences.putChar(keyStr, v);
+		}
+		case VAR_UINT8: {
+			uint8_t v; memcpy(&v, value, sizeof(v));
+			return preferences.putUChar(keyStr, v);
+		}
+		case VAR_INT16: {
+			int16_t v; memcpy(&v, value, sizeof(v));
+			return preferences.putShort(keyStr, v);
+		}
+		case VAR_UINT16: {
+			uint16_t v; memcpy(&v, value, sizeof(v));
+			return preferences.putUShort(keyStr, v);
+		}
+		case VAR_INT32: {
+			int32_t v; memcpy(&v, value, sizeof(v));
+			return preferences.putInt(keyStr, v);
+		}
+		case VAR_UINT32: {
+			uint32_t v; memcpy(&v, value, sizeof(v));
+			return preferences.putUInt(keyStr, v);
+		}
+		case VAR_INT64: {
+			int64_t v; memcpy(&v, value, sizeof(v));
+			return preferences.putLong64(keyStr, v);
+		}
+		case VAR_UINT64: {
+			uint64_t v; memcpy(&v, value, sizeof(v));
+			return preferences.putULong64(keyStr, v);
+		}
+		case VAR_FLOAT: {
+			float v; memcpy(&v, value, sizeof(v));
+			return preferences.putFloat(keyStr, v);
+		}
+		case VAR_DOUBLE: {
+			double v; memcpy(&v, value, sizeof(v));
+			return preferences.putDouble(keyStr, v);
+		}
+		default:
+			return 0U;
+	}
+}
+
+/**
+ * Writes every batch entry to its own preferences key
+ * 
+ * @param batch staged entries
+ * @param length length of staged entries
+ * 
+ * @return if every entry was written
+ */
+bool prefBatchApply(const uint8_t *batch, uint16_t length) {
+	uint16_t offset = 0U;
+	uint16_t key;
+	uint8_t varType;
+	bool result = true;
+	char keyStr[CHAR_KEY_SIZE];
+
+	while (offset < length) {
+		uint16_t valueOffset = nvmBatchEntry(batch, length, offset, &key, &varType);
+		if (valueOffset == 0U) {
+			return false;
+		}
+
+		keyToChar(key, keyStr);
+		size_t written = prefPutEntry(keyStr, varType, &batch[valueOffset]);
+		prefStatsPut(key, written);
+		if (!written) {
+			result = false;
+		}
+		offset = valueOffset + nvmVarSize(varType);
+	}
+
+	return result;
+}
+
+#ifndef NVM_PREF_PACKED
+
+/**
+ * Committed batches stay in one blob that reads check
+ * before the keys, so a commit is a single blob write.
+ * Values are moved to their own keys only when a commit
+ * wouldn't fit the blob, before the blob is replaced
+ * 
+ * blob: entries(length) crc(2)
+ */
+uint8_t prefOverlay[NVM_BATCH_SIZE + 2U];
+uint16_t prefOverlayLength = 0U;
+
+/**
+ * Loads the committed batch blob
+ */
+void prefOverlayLoad(void) {
+	prefOverlayLength = 0U;
+
+	size_t length = preferences.getBytesLength(BATCH_KEY);
+	if (length == 0U) {
+		return;
+	}
+
+	if (length >= 2U && length <= sizeof(prefOverlay)) {
+		preferences.getBytes(BATCH_KEY, prefOverlay, length);
+
+		uint16_t entries = (uint16_t)(length - 2U);
+		uint16_t crc = nvmCrc16(0xFFFFU, prefOverlay, entries);
+		uint16_t stored = (uint16_t)(prefOverlay[entries] | (prefOverlay[entries + 1U] << 8));
+
+		if (crc == stored) {
+			prefOverlayLength = entries;
+			return;
+		}
+	}
+
+	LOG_ERROR("Pref batch blob failed crc");
+	preferences.remove(BATCH_KEY);
+}
+
+/**
+ * Replaces the committed batch blob with one blob write
+ * 
+ * @param entries entries to publish, with 2 spare bytes for the crc
+ * @param length length of the entries
+ * 
+ * @return if the blob was written
+ */
+bool prefOverlayStore(uint8_t *entries, uint16_t length) {
+	uint16_t crc = nvmCrc16(0xFFFFU, entries, length);
+	entries[length] = (uint8_t)(crc & LEAST_BYTE);
+	entries[length + 1U] = (uint8_t)((crc & SECOND_LEAST_BYTE) >> 8);
+
+	size_t size = length + 2U;
+	if (preferences.putBytes(BATCH_KEY, entries, size) != size) {
+		return false;
+	}
+	prefStatsPut(0U, size);
+
+	if (entries != prefOverlay) {
+		memcpy(prefOverlay, entries, size);
+	}
+	prefOverlayLength = length;
+	return true;
+}
+
+/**
+ * Gets a value from the committed batch blob
+ * 
+ * @param key key of nvm address
+ * @param varType type of the value
+ * @param value variable to store result to
+ * 
+ * @return if the key is in the blob with that type
+ */
+bool prefOverlayGet(uint16_t key, uint8_t varType, void *value) {
+	uint16_t valueOffset = nvmEntryFind(prefOverlay, prefOverlayLength, key, (enum VarType)varType);
+	if (valueOffset == 0U) {
+		return false;
+	}
+
+	memcpy(value, &prefOverlay[valueOffset], nvmVarSize(varType));
+	return true;
+}
+
+/**
+ * Updates a value held by the committed batch blob, which
+ * would hide a write to its own key
+ * 
+ * @param key key of nvm address
+ * @param varType type of the value
+ * @param value bytes of the value
+ * @param written variable to store bytes written to, 0 if the write failed
+ * 
+ * @return if the key is in the blob with that type
+ */
+bool prefOverlayPut(uint16_t key, uint8_t varType, const void *value, size_t *written) {
+	uint16_t valueOffset = nvmEntryFind(prefOverlay, prefOverlayLength, key, (enum VarType)varType);
+	if (valueOffset == 0U) {
+		return false;
+	}
+
+	uint8_t size = nvmVarSize(varType);
+	*written = size;
+	if (!memcmp(&prefOverlay[valueOffset], value, size)) {
+		nvmStatsSkip();
+		return true;
+	}
+
+	uint8_t entries[sizeof(prefOverlay)];
+	memcpy(entries, prefOverlay, prefOverlayLength);
+	memcpy(&entries[valueOffset], value, size);
+	if (!prefOverlayStore(entries, prefOverlayLength)) {
+		*written = 0U;
+	}
+	return true;
+}
+
+#endif
+
+/**
+ * Copies a preferences entry to a new name with its own
+ * type and removes the old name
+ * 
+ * @param from name the entry is stored under
+ * @param to name to store the entry under
+ * 
+ * @return if the entry was copied
+ */
+bool prefRename(const char *from, const char *to) {
+	size_t written = 0U;
+
+	switch (preferences.getType(from)) {
+		case PT_I8:
+			written = preferences.putChar(to, preferences.getChar(from));
+			break;
+		case PT_U8:
+			written = preferences.putUChar(to, preferences.getUChar(from));
+			break;
+		case PT_I16:
+			written = preferences.putShort(to, preferences.getShort(from));
+			break;
+		case PT_U16:
+			written = preferences.putUShort(to, preferences.getUShort(from));
+			break;
+		case PT_I32:
+			written = preferences.putInt(to, preferences.getInt(from));
+			break;
+		case PT_U32:
+			written = preferences.putUInt(to, preferences.getUInt(from));
+			break;
+		case PT_I64:
+			written = preferences.putLong64(to, preferences.getLong64(from));
+			break;
+		case PT_U64:
+			written = preferences.putULong64(to, preferences.getULong64(from));
+			break;
+		case PT_STR: {
+			String value = preferences.getString(from);
+
+			// bytes with the terminator, an empty string writes none
+			written = preferences.putString(to, value) == value.length() ? value.length() + 1U : 0U;
+			break;
+		}
+		case PT_BLOB: {
+			size_t size = preferences.getBytesLength(from);
+			uint8_t *value = (uint8_t*)malloc(size);
+			if (value != NULL && preferences.getBytes(from, value, size) == size) {
+				written = preferences.putBytes(to, value, size);
+			}
+			free(value);
+			break;
+		}
+		default:
+			return false;
+	}
+
+	if (written == 0U) {
+		return false;
+	}
+	prefStatsPut(0U, written);
+	preferences.remove(from);
+	return true;
+}
+
+/**
+ * Renames every value stored under a legacy key name once,
+ * names a reset left are renamed at the next start
+ */
+void prefMigrateKeys(void) {
+	if (preferences.getUChar(KEYS_KEY, 0U) == KEYS_FORMAT) {
+		return;
+	}
+
+	char legacyStr[LEGACY_KEY_SIZE];
+	char keyStr[CHAR_KEY_SIZE];
+	uint16_t renamed = 0U;
+
+	for (uint32_t key = 0UL; key < nvmSize; key++) {
+		keyToLegacyChar((uint16_t)key, legacyStr);
+
+		// keys with a zero low byte had the empty name, which nvs refuses
+		if (legacyStr[0] == '\0' || !preferences.isKey(legacyStr)) {
+			continue;
+		}
+
+		keyToChar((uint16_t)key, keyStr);
+		if (prefRename(legacyStr, keyStr)) {
+			renamed++;
+		}
+		else {
+			LOG_W(NVM, "Pref couldn't rename legacy key {}", (uint16_t)key);
+		}
+	}
+
+	preferences.putUChar(KEYS_KEY, KEYS_FORMAT);
+
+	if (renamed != 0U) {
+		LOG_I(NVM, "Pref renamed legacy keys: {}", renamed);
+	}
+}
+
+#ifdef NVM_PREF_PACKED
+
+/**
+ * Allocates the packed image and loads it with a single read
+ * 
+ * @return if image was allocated
+ */
+bool packedLoad(void) {
+	// image holds nvmSize bytes of entries followed by a crc
+	packedImage = (uint8_t*)malloc(nvmSize + 2U);
+	if (packedImage == NULL) {
+		return false;
+	}
+
+	packedLength = 0U;
+	packedDirty = false;
+
+	size_t length = preferences.getBytesLength(PACKED_KEY);
+	if (length < 2U || length > nvmSize + 2U) {
+		return true;
+	}
+
+	preferences.getBytes(PACKED_KEY, packedImage, length);
+
+	uint16_t entries = (uint16_t)(length - 2U);
+	uint16_t crc = nvmCrc16(0xFFFFU, packedImage, entries);
+	uint16_t stored = (uint16_t)(packedImage[entries] | (packedImage[entries + 1U] << 8));
+
+	if (crc == stored) {
+		packedLength = entries;
 	}
 	else {
-		Serial.print(F("wrote, "));
+		LOG_ERROR("Pref packed blob failed crc");
+	}
+
+	return true;
+}
+
+/**
+ * Finds the entry of a key in the packed image
+ * 
+ * @param key key of nvm address
+ * @param varType variable to store the entry type to
+ * 
+ * @return offset of the entry, packedLength if missing
+ */
+uint16_t packedFind(uint16_t key, uint8_t *varType) {
+	uint16_t offset = 0U;
+	uint16_t entryKey;
+
+	while (true) {
+		uint16_t valueOffset = nvmBatchEntry(
+			packedImage, packedLength, offset, &entryKey, varType
+		);
+		if (valueOffset == 0U) {
+			return packedLength;
+		}
+		if (entryKey == key) {
+			return offset;
+		}
+		offset = valueOffset + nvmVarSize(*varType);
 	}
+}
+
+/**
+ * Stores a value in the packed image
+ * 
+ * @param key key of nvm address
+ * @param varType type of the value
+ * @param value bytes of the value
+ * 
+ * @return if the value fit in the image
+ */
+bool packedStore(uint16_t key, uint8_t varType, const uint8_t *value) {
+	uint8_t size = nvmVarSize(varType);
+	uint8_t entryType;
+	uint16_t offset = packedFind(key, &entryType);
+
+	if (offset != packedLength && entryType != varType) {
+		// key changed type, drops the old entry
+		uint16_t entrySize = NVM_BATCH_ENTRY_OVERHEAD + nvmVarSize(entryType);
+		memmove(
+			&packedImage[offset], &packedImage[offset + entrySize],
+			packedLength - offset - entrySize
+		);
+		packedLength -= entrySize;
+		offset = packedLength;
+	}
+
+	if (offset == packedLength) {
+		if (packedLength + NVM_BATCH_ENTRY_OVERHEAD + size > nvmSize) {
+			return false;
+		}
+		packedImage[offset] = (uint8_t)(key & LEAST_BYTE);
+		packedImage[offset + 1U] = (uint8_t)((key & SECOND_LEAST_BYTE) >> 8);
+		packedImage[offset + 2U] = varType;
+		packedLength += NVM_BATCH_ENTRY_OVERHEAD + size;
+	}
+	else if (!memcmp(&packedImage[offset + NVM_BATCH_ENTRY_OVERHEAD], value, size)) {
+		nvmStatsSkip();
+		return true;
+	}
+
+	memcpy(&packedImage[offset + NVM_BATCH_ENTRY_OVERHEAD], value, size);
+	packedDirty = true;
+	return true;
+}
 
-	printVarType(varType);
-	Serial.print(F(": '"));
-	Serial.print(value);
-	Serial.print(F("', key: '"));
-	Serial.print(key);
-	Serial.println(F("'"));
+/**
+ * Gets a value from the packed image
+ * 
+ * @param key key of nvm address
+ * @param varType type of the value
+ * @param value variable to store result to
+ * 
+ * @return if the key is stored with that type
+ */
+bool packedGet(uint16_t key, uint8_t varType, uint8_t *value) {
+	uint8_t entryType;
+	uint16_t offset = packedFind(key, &entryType);
+
+	if (offset == packedLength || entryType != varType) {
+		return false;
+	}
+
+	memcpy(value, &packedImage[offset + NVM_BATCH_ENTRY_OVERHEAD], nvmVarSize(varType));
+	return true;
 }
 
-void nvmWriteFailed(enum VarType varType) {
-	printNVM();
-	Serial.print(F("pref failed write "));
-	printVarType(varType);
-	Serial.println(F(""));
-	
+/**
+ * Writes the packed image back with a single blob write
+ * 
+ * @return if the blob was written
+ */
+bool packedSave(void) {
+	if (!packedDirty) {
+		return true;
+	}
+
+	uint16_t crc = nvmCrc16(0xFFFFU, packedImage, packedLength);
+	packedImage[packedLength] = (uint8_t)(crc & LEAST_BYTE);
+	packedImage[packedLength + 1U] = (uint8_t)((crc & SECOND_LEAST_BYTE) >> 8);
+
+	size_t length = packedLength + 2U;
+	bool result = preferences.putBytes(PACKED_KEY, packedImage, length) == length;
+	if (result) {
+		packedDirty = false;
+		prefStatsPut(0U, length);
+	}
+
+	LOG_I(NVM, "Pref saved packed blob, bytes: {}", packedLength);
+
+	return result;
 }
+
 #endif
 
 enum NVMStartCode nvmInit(uint16_t setNVMSize) {
+	TRACE_SCOPE("nvmInit");
+
 	if (started) {
-		#ifdef __NVM_DEBUG__
-			printNVM();
-			Serial.println(F("Pref already started"));
-		#endif
+		LOG_W(NVM, "Pref already started");
 		return NVM_STARTED;
 	}
 
 	if (setNVMSize == (uint16_t)DEFAULT_NVM_SIZE) {
-		#ifdef __NVM_DEBUG__
-			printNVM();
-			Serial.println(F("NVM size given was default, not initialized"));
-		#endif
+		LOG_W(NVM, "NVM size given was default, not initialized");
 		return NVM_INVALID_SIZE;
 	}
 
 	nvmSize = setNVMSize;
 
-	#ifdef __NVM_BEGIN__
-		//const char *name = "Osc";
-		started = preferences.begin("Osc", false);
-	#else
-		started = true;
-	#endif
+	// every Preferences call fails until its namespace is opened
+	started = preferences.begin("Osc", false);
 
 	if (!started) {
-		#ifdef __ERROR_DEBUG__
-			printError();
-			Serial.println(F("Preferences lib failed to start"));
-		#endif
+		LOG_ERROR("Preferences lib failed to start");
 		return NVM_FAILED;
 	}
 
-	#ifdef __NVM_DEBUG__
-		printNVM();
-		Serial.println(F("Started Preferences for NVM"));
+	nvmStatsBegin(nvmSize);
+
+	prefMigrateKeys();
+
+	#ifdef NVM_PREF_PACKED
+		if (!packedLoad()) {
+			started = false;
+			LOG_ERROR("Pref packed image couldn't be allocated");
+			return NVM_FAILED;
+		}
+	#else
+		prefOverlayLoad();
 	#endif
 
+	LOG_I(NVM, "Started Preferences for NVM");
+
 	return NVM_OK;
 }
 
-bool nvmStarted(void) {
-	if (!started) {
-		#ifdef __ERROR_DEBUG__
-			printError();
-			Serial.print(F("Pref not started"));
-		#endif
+void nvmEnd(void) {
+	nvmBatchClear();
+
+	#ifdef NVM_PREF_PACKED
+		free(packedImage);
+		packedImage = NULL;
+		packedLength = 0U;
+		packedDirty = false;
+	#else
+		prefOverlayLength = 0U;
+	#endif
+
+	if (started) {
+		preferences.end();
+	}
+
+	started = false;
+}
+
+bool nvmCommitBatch(void) {
+	TRACE_SCOPE("nvmCommitBatch");
+
+	if (!nvmStarted()) {
 		return false;
 	}
-	return true;
+
+	// a batch only holds the async queue, the worker commits it
+	if (nvmAsyncActive()) {
+		return nvmAsyncCommitBatch();
+	}
+
+	NVMStorageLock lock;
+
+	if (!nvmBatchActive()) {
+		LOG_W(NVM, "Pref has no batch to commit");
+		return false;
+	}
+
+	#ifdef NVM_PREF_PACKED
+		uint16_t offset = 0U;
+		uint16_t key;
+		uint8_t varType;
+		uint8_t entryType;
+		uint16_t needed = 0U;
+
+		// checks the image has room before changing any value
+		while (true) {
+			uint16_t valueOffset = nvmBatchEntry(nvmBatch, nvmBatchLength, offset, &key, &varType);
+			if (valueOffset == 0U) {
+				break;
+			}
+			if (packedFind(key, &entryType) == packedLength || entryType != varType) {
+				needed += NVM_BATCH_ENTRY_OVERHEAD + nvmVarSize(varType);
+			}
+			offset = valueOffset + nvmVarSize(varType);
+		}
+
+		bool result = packedLength + needed <= nvmSize;
+
+		if (result) {
+			offset = 0U;
+			while (true) {
+				uint16_t valueOffset = nvmBatchEntry(nvmBatch, nvmBatchLength, offset, &key, &varType);
+				if (valueOffset == 0U) {
+					break;
+				}
+				packedStore(key, varType, &nvmBatch[valueOffset]);
+				offset = valueOffset + nvmVarSize(varType);
+			}
+
+			// the whole image is published by one blob write
+			result = packedSave();
+		}
+		else {
+			LOG_ERROR("Pref packed image can't fit batch");
+		}
+
+		LOG_I(NVM, "Pref committed batch, bytes: {}", nvmBatchLength);
+
+		nvmBatchClear();
+		return result;
+	#else
+
+	uint8_t entries[sizeof(prefOverlay)];
+	uint16_t length = prefOverlayLength;
+	uint16_t offset = 0U;
+	uint16_t key;
+	uint8_t varType;
+	bool result = true;
+
+	// the batch is merged into the blob so one write publishes it
+	memcpy(entries, prefOverlay, length);
+	while (true) {
+		uint16_t valueOffset = nvmBatchEntry(nvmBatch, nvmBatchLength, offset, &key, &varType);
+		if (valueOffset == 0U) {
+			break;
+		}
+		if (!nvmEntryStage(entries, &length, NVM_BATCH_SIZE, key, (enum VarType)varType, &nvmBatch[valueOffset])) {
+			// moves the blob to its own keys, the blob still matches them if reset
+			result = prefBatchApply(prefOverlay, prefOverlayLength);
+			length = nvmBatchLength;
+			memcpy(entries, nvmBatch, length);
+			break;
+		}
+		offset = valueOffset + nvmVarSize(varType);
+	}
+
+	result = result && prefOverlayStore(entries, length);
+
+	LOG_I(NVM, "Pref committed batch, bytes: {}", nvmBatchLength);
+
+	nvmBatchClear();
+	return result;
+	#endif
 }
 
-void keyToChar(uint16_t key, char* keyStr) {
-	uint8_t key0 = key & LEAST_BYTE;
-	uint8_t key1 = (key & SECOND_LEAST_BYTE) >> 8;
+bool nvmFlush(void) {
+	TRACE_SCOPE("nvmFlush");
 
-	keyStr[0] = key0;
-	keyStr[1] = key1;
-	keyStr[2] = '\0';
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	if (nvmAsyncActive()) {
+		return nvmSync();
+	}
+
+	NVMStorageLock lock;
+
+	#ifdef NVM_PREF_PACKED
+		return packedSave();
+	#else
+		// preferences commits on every put
+		return true;
+	#endif
+}
+
+bool nvmWriteBlock(uint16_t key, const void *data, uint16_t size) {
+	TRACE_SCOPE("nvmWriteBlock");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	if (nvmBatchActive()) {
+		LOG_W(NVM, "Pref blocks can't be staged in a batch");
+		return false;
+	}
+
+	char keyStr[CHAR_KEY_SIZE];
+	keyToChar(key, keyStr);
+
+	// blocks keep their own blob, even in packed mode
+	uint32_t start = nvmStatsClock();
+	bool result = preferences.putBytes(keyStr, data, size) == size;
+	if (result) {
+		prefStatsPut(key, size);
+	}
+	nvmStatsWrite(VAR_BYTES, start);
+
+	if (!result) {
+		LOG_W(NVM, "Pref failed to write block of {} bytes to key {}", size, key);
+	}
+	else {
+		LOG_NVM("Pref wrote block of {} bytes to key {}", size, key);
+	}
+
+	return result;
+}
+
+bool nvmReadBlock(uint16_t key, void *data, uint16_t size) {
+	TRACE_SCOPE("nvmReadBlock");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	char keyStr[CHAR_KEY_SIZE];
+	keyToChar(key, keyStr);
+
+	uint32_t start = nvmStatsClock();
+	bool result = preferences.getBytesLength(keyStr) == size &&
+		preferences.getBytes(keyStr, data, size) == size;
+	nvmStatsRead(VAR_BYTES, start);
+
+	if (!result) {
+		LOG_W(NVM, "Pref failed to read block of {} bytes from key {}", size, key);
+	}
+	else {
+		LOG_NVM("Pref read block of {} bytes from key {}", size, key);
+	}
+
+	return result;
+}
+
+bool nvmWriteBytes(uint16_t key, const void *data, uint16_t length, uint16_t capacity) {
+	TRACE_SCOPE("nvmWriteBytes");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	if (nvmBatchActive()) {
+		LOG_W(NVM, "Pref bytes can't be staged in a batch");
+		return false;
+	}
+
+	if (!nvmBytesFit(key, length, capacity)) {
+		return false;
+	}
+
+	char keyStr[CHAR_KEY_SIZE];
+	keyToChar(key, keyStr);
+
+	// preferences stores the length with the blob, but stores
+	// nothing for an empty one, so removing the key empties it
+	uint32_t start = nvmStatsClock();
+	bool result;
+	if (length == 0U) {
+		result = !preferences.isKey(keyStr) || preferences.remove(keyStr);
+	}
+	else {
+		result = preferences.putBytes(keyStr, data, length) == length;
+	}
+	if (result) {
+		prefStatsPut(key, length);
+	}
+	nvmStatsWrite(VAR_BYTES, start);
+
+	if (!result) {
+		LOG_W(NVM, "Pref failed to write {} bytes to key {}", length, key);
+	}
+	else {
+		LOG_NVM("Pref wrote {} bytes to key {}", length, key);
+	}
+
+	return result;
+}
+
+bool nvmGetBytes(uint16_t key, void *data, uint16_t *length, uint16_t capacity) {
+	TRACE_SCOPE("nvmGetBytes");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	char keyStr[CHAR_KEY_SIZE];
+	keyToChar(key, keyStr);
+
+	// a missing key was written empty or never, both read as empty
+	uint32_t start = nvmStatsClock();
+	size_t size = preferences.getBytesLength(keyStr);
+	bool result = size + NVM_LENGTH_PREFIX <= capacity &&
+		(size == 0U || preferences.getBytes(keyStr, data, size) == size);
+	if (result) {
+		*length = (uint16_t)size;
+	}
+	nvmStatsRead(VAR_BYTES, start);
+
+	if (!result) {
+		LOG_W(NVM, "Pref failed to read {} bytes from key {}", size, key);
+	}
+	else {
+		LOG_NVM("Pref read {} bytes from key {}", size, key);
+	}
+
+	return result;
+}
+
+bool nvmWriteString(uint16_t key, const char *value, uint16_t capacity) {
+	TRACE_SCOPE("nvmWriteString");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	if (nvmBatchActive()) {
+		LOG_W(NVM, "Pref strings can't be staged in a batch");
+		return false;
+	}
+
+	size_t length = strlen(value);
+	if (!nvmBytesFit(key, length > NVM_BYTES_MAX ? NVM_BYTES_MAX + 1U : (uint16_t)length, capacity)) {
+		return false;
+	}
+
+	char keyStr[CHAR_KEY_SIZE];
+	keyToChar(key, keyStr);
+
+	uint32_t start = nvmStatsClock();
+	bool result = preferences.putString(keyStr, value) == length;
+	if (result) {
+		prefStatsPut(key, length + 1U);
+	}
+	nvmStatsWrite(VAR_BYTES, start);
+
+	if (!result) {
+		LOG_W(NVM, "Pref failed to write string '{}' to key {}", value, key);
+	}
+	else {
+		LOG_NVM("Pref wrote string '{}' to key {}", value, key);
+	}
+
+	return result;
+}
+
+bool nvmGetString(uint16_t key, char *value, uint16_t capacity) {
+	TRACE_SCOPE("nvmGetString");
+
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	NVMStorageLock lock;
+
+	char keyStr[CHAR_KEY_SIZE];
+	keyToChar(key, keyStr);
+
+	// getString fails when the string and terminator don't fit capacity
+	uint32_t start = nvmStatsClock();
+	bool result = capacity != 0U && preferences.getString(keyStr, value, capacity) != 0U;
+	nvmStatsRead(VAR_BYTES, start);
+
+	if (!result) {
+		LOG_W(NVM, "Pref failed to read string from key {}", key);
+	}
+	else {
+		LOG_NVM("Pref read string '{}' from key {}", value, key);
+	}
+
+	return result;
 }
 
 typedef size_t	(Preferences::*PrefPutB)	(const char*, bool);
@@ -141,24 +966,49 @@ typedef size_t	(Preferences::*PrefPutD)	(const char*, double);
 
 template <typename PTR, typename VAL>
 bool nvmWrite(PTR prefptr, const uint16_t key, VAL value, VarType var) {
+	TRACE_SCOPE("nvmWriteValue");
 
 	if (!nvmStarted()) {
 		return false;
 	}
 
-	char keyStr[CHAR_KEY_SIZE];
-	keyToChar(key, keyStr);
+	uint32_t start = nvmStatsClock();
 
-	size_t result = (preferences.*prefptr)(keyStr, value);
+	if (nvmAsyncActive()) {
+		bool queued = nvmAsyncStage(key, var, &value);
+		nvmStatsWrite(var, start);
+		return queued;
+	}
+
+	NVMStorageLock lock;
+
+	if (nvmBatchActive()) {
+		bool staged = nvmBatchStage(key, var, &value);
+		nvmStatsWrite(var, start);
+		return staged;
+	}
+
+	#ifdef NVM_PREF_PACKED
+		size_t result = packedStore(key, var, (const uint8_t*)&value);
+	#else
+		size_t result;
+		if (!prefOverlayPut(key, var, &value, &result)) {
+			char keyStr[CHAR_KEY_SIZE];
+			keyToChar(key, keyStr);
+
+			result = (preferences.*prefptr)(keyStr, value);
+			prefStatsPut(key, result);
+		}
+	#endif
+
+	nvmStatsWrite(var, start);
 
-	#ifdef __NVM_DEBUG__
 	if (!result) {
-		nvmWriteFailed(var);
+		LOG_W(NVM, "pref failed write {}", nvmVarName(var));
 	}
 	else {
-		printGotValue(var, key, value, WROTE_VALUE);
+		LOG_NVM("Pref wrote, {}: '{}', key: '{}'", nvmVarName(var), value, key);
 	}
-	#endif
 
 	return (bool)result;
 }
@@ -221,20 +1071,43 @@ typedef double		(Preferences::*PrefGetD)	(const char*, double);
 
 template <typename PTR, typename VAL>
 bool nvmGet(PTR prefptr, const uint16_t key, VAL *value, VAL defValue, VarType var) {
+	TRACE_SCOPE("nvmGetValue");
 
 	if (!nvmStarted()) {
 		return false;
 	}
 
-	char keyStr[CHAR_KEY_SIZE];
-	keyToChar(key, keyStr);
+	uint32_t start = nvmStatsClock();
+
+	if (nvmAsyncLookup(key, var, value)) {
+		nvmStatsRead(var, start);
+		return true;
+	}
+
+	NVMStorageLock lock;
 
-	*value = (preferences.*prefptr)(keyStr, defValue);
+	if (nvmBatchLookup(key, var, value)) {
+		nvmStatsRead(var, start);
+		return true;
+	}
+
+	#ifdef NVM_PREF_PACKED
+		if (!packedGet(key, var, (uint8_t*)value)) {
+			*value = defValue;
+		}
+	#else
+		if (!prefOverlayGet(key, var, value)) {
+			char keyStr[CHAR_KEY_SIZE];
+			keyToChar(key, keyStr);
 
-	#ifdef __NVM_DEBUG__
-		printGotValue(var, key, *value, GOT_VALUE);
+			*value = (preferences.*prefptr)(keyStr, defValue);
+		}
 	#endif
 
+	nvmStatsRead(var, start);
+
+	LOG_NVM("Pref got, {}: '{}', key: '{}'", nvmVarName(var), *value, key);
+
 	return true;
 }
 
@@ -20,6 +20,7 @@
 #define EEPROMADDRESSES_H
 
 #include <Arduino.h>
+#include "nvm_schema.h"
 
 #define BYTE1_SIZE 1U
 #define BYTE2_SIZE 2U
@@ -30,7 +31,10 @@
  * Network Config
  * 
  * NOTE: the size includes the terminating
- * character to the char array
+ * character to the char array, in nvm the
+ * length prefix takes its place. Use
+ * nvmWriteFieldString<NVMSsidField>(ssid)
+ * to store credentials in one operation
 ****************************/
 
 // max string size for network SSID(name)
@@ -53,6 +57,57 @@
 #define EEPROM_VERSION 33
 
 // network credentials
-#define SSID_SIZE BYTE1_SIZE * SSID_STRING_SIZE
+#define SSID_SIZE (BYTE1_SIZE * SSID_STRING_SIZE)
+#define PASS_SIZE (BYTE1_SIZE * PASS_STRING_SIZE)
+
+/****************************
+ * NVM Schema
+ * 
+ * Each setting is declared with its type, addresses
+ * follow from the previous field and are checked at
+ * compile time. Use nvmWriteField<Field>(value) and
+ * nvmGetField<Field>(&value) to access them
+****************************/
+
+typedef NVMField<uint8_t, EEPROM_VERSION_KEY> NVMVersionField;
+typedef NVMNext<char[SSID_STRING_SIZE], NVMVersionField> NVMSsidField;
+typedef NVMNext<char[PASS_STRING_SIZE], NVMSsidField> NVMPassField;
+
+// acquisition restored by acqInit(), samples per second per channel and channel bits
+typedef NVMNext<uint32_t, NVMPassField> NVMSampleRateField;
+typedef NVMNext<uint8_t, NVMSampleRateField> NVMChannelsField;
+
+// trigger restored by trigInit(), see TrigConfig
+typedef NVMNext<uint8_t, NVMChannelsField> NVMTrigModeField;
+typedef NVMNext<uint8_t, NVMTrigModeField> NVMTrigSourceField;
+typedef NVMNext<uint16_t, NVMTrigSourceField> NVMTrigLevelField;
+typedef NVMNext<uint16_t, NVMTrigLevelField> NVMTrigHysteresisField;
+typedef NVMNext<uint16_t, NVMTrigHysteresisField> NVMTrigPreField;
+typedef NVMNext<uint16_t, NVMTrigPreField> NVMTrigLengthField;
+typedef NVMNext<uint32_t, NVMTrigLengthField> NVMTrigHoldoffField;
+typedef NVMNext<uint32_t, NVMTrigHoldoffField> NVMTrigPulseMinField;
+typedef NVMNext<uint32_t, NVMTrigPulseMinField> NVMTrigPulseMaxField;
+
+// decimation restored by decInit(), see DecConfig
+typedef NVMNext<uint8_t, NVMTrigPulseMaxField> NVMDecModeField;
+typedef NVMNext<uint16_t, NVMDecModeField> NVMDecPointsField;
+
+// transport restored by transportInit(), see TransportConfig, SSID and password above
+typedef NVMNext<uint8_t, NVMDecPointsField> NVMLinkMediumField;
+typedef NVMNext<uint32_t, NVMLinkMediumField> NVMLinkBaudField;
+typedef NVMNext<uint32_t, NVMLinkBaudField> NVMLinkAddressField;
+typedef NVMNext<uint16_t, NVMLinkAddressField> NVMLinkPortField;
+
+// last field of the schema
+typedef NVMLinkPortField NVMSchemaLast;
+
+// bytes of nvm used by the schema
+#define NVM_SCHEMA_SIZE ((uint16_t)NVMSchemaLast::end)
+
+static_assert(NVMVersionField::size == EEPROM_VERSION_SIZE, "EEPROM version size changed");
+static_assert(NVMSsidField::size == SSID_SIZE, "SSID field size changed");
+static_assert(NVMPassField::size == PASS_SIZE, "password field size changed");
+static_assert(NVMSampleRateField::size == BYTE4_SIZE, "sample rate field size changed");
+static_assert(NVMChannelsField::size == BYTE1_SIZE, "channels field size changed");
 
 #endif
\ No newline at end of file
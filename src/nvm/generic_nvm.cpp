@@ -17,48 +17,275 @@
 */
 
 #include "generic_nvm.h"
+#include "eeprom_addresses.h"
 
-#ifdef __NVM_DEBUG__
+uint8_t nvmCrc8(uint8_t crc, const uint8_t *data, uint16_t size) {
+	for (uint16_t i = 0U; i < size; i++) {
+		crc ^= data[i];
+		for (uint8_t bit = 0U; bit < 8U; bit++) {
+			if (crc & 0x80U) {
+				crc = (uint8_t)((crc << 1) ^ 0x07U);
+			}
+			else {
+				crc = (uint8_t)(crc << 1);
+			}
+		}
+	}
+	return crc;
+}
 
-void printVarType(enum VarType varType) {
+uint16_t nvmCrc16(uint16_t crc, const uint8_t *data, uint16_t size) {
+	// a byte at a time with shifts, the same as 8 bitwise steps
+	for (uint16_t i = 0U; i < size; i++) {
+		crc = (uint16_t)((crc >> 8) | (crc << 8));
+		crc ^= data[i];
+		crc ^= (uint16_t)((crc & 0xFFU) >> 4);
+		crc ^= (uint16_t)(crc << 12);
+		crc ^= (uint16_t)((crc & 0xFFU) << 5);
+	}
+	return crc;
+}
+
+uint8_t nvmVarSize(uint8_t varType) {
 	switch(varType) {
 		case VAR_BOOL:
-			Serial.print(F("bool"));
-		break;
+			return sizeof(bool);
 		case VAR_INT8:
-			Serial.print(F("i8"));
-		break;
 		case VAR_UINT8:
-			Serial.print(F("iu8"));
-		break;
+			return sizeof(uint8_t);
 		case VAR_INT16:
-			Serial.print(F("i16"));
-		break;
 		case VAR_UINT16:
-			Serial.print(F("iu16"));
-		break;
+			return sizeof(uint16_t);
 		case VAR_INT32:
-			Serial.print(F("i32"));
-		break;
 		case VAR_UINT32:
-			Serial.print(F("iu32"));
-		break;
+			return sizeof(uint32_t);
 		case VAR_INT64:
-			Serial.print(F("i64"));
-		break;
 		case VAR_UINT64:
-			Serial.print(F("iu64"));
-		break;
+			return sizeof(uint64_t);
 		case VAR_FLOAT:
-			Serial.print(F("float"));
-		break;
+			return sizeof(float);
 		case VAR_DOUBLE:
-			Serial.print(F("double"));
-		break;
+			return sizeof(double);
 		default:
-			Serial.print(F("invalid"));
-		break;
+			return 0U;
 	}
 }
 
+/****************************
+ * NVM Batch Staging
+****************************/
+
+uint8_t nvmBatch[NVM_BATCH_SIZE];
+uint16_t nvmBatchLength = 0U;
+bool batching = false;
+
+bool nvmBatchActive(void) {
+	return batching;
+}
+
+uint16_t nvmBatchEntry(
+	const uint8_t *batch, uint16_t length, uint16_t offset,
+	uint16_t *key, uint8_t *varType
+) {
+	if (offset + NVM_BATCH_ENTRY_OVERHEAD > length) {
+		return 0U;
+	}
+
+	uint8_t size = nvmVarSize(batch[offset + 2U]);
+	if (size == 0U || offset + NVM_BATCH_ENTRY_OVERHEAD + size > length) {
+		return 0U;
+	}
+
+	*key = (uint16_t)(batch[offset] | (batch[offset + 1U] << 8));
+	*varType = batch[offset + 2U];
+	return offset + NVM_BATCH_ENTRY_OVERHEAD;
+}
+
+uint16_t nvmEntryFind(const uint8_t *entries, uint16_t length, uint16_t key, enum VarType varType) {
+	uint16_t offset = 0U;
+	uint16_t entryKey;
+	uint8_t entryType;
+
+	while (true) {
+		uint16_t valueOffset = nvmBatchEntry(
+			entries, length, offset, &entryKey, &entryType
+		);
+		if (valueOffset == 0U) {
+			return 0U;
+		}
+		if (entryKey == key && entryType == (uint8_t)varType) {
+			return valueOffset;
+		}
+		offset = valueOffset + nvmVarSize(entryType);
+	}
+}
+
+bool nvmEntryStage(
+	uint8_t *entries, uint16_t *length, uint16_t capacity,
+	uint16_t key, enum VarType varType, const void *value
+) {
+	uint8_t size = nvmVarSize(varType);
+	uint16_t valueOffset = nvmEntryFind(entries, *length, key, varType);
+
+	if (valueOffset == 0U) {
+		if (size == 0U || *length + NVM_BATCH_ENTRY_OVERHEAD + size > capacity) {
+			return false;
+		}
+
+		entries[*length] = (uint8_t)(key & LEAST_BYTE);
+		entries[*length + 1U] = (uint8_t)((key & SECOND_LEAST_BYTE) >> 8);
+		entries[*length + 2U] = (uint8_t)varType;
+		valueOffset = *length + NVM_BATCH_ENTRY_OVERHEAD;
+		*length = valueOffset + size;
+	}
+
+	memcpy(&entries[valueOffset], value, size);
+	return true;
+}
+
+bool nvmBatchStage(uint16_t key, enum VarType varType, const void *value) {
+	if (!nvmEntryStage(nvmBatch, &nvmBatchLength, NVM_BATCH_SIZE, key, varType, value)) {
+		LOG_ERROR("NVM batch full, dropped key {}", key);
+		return false;
+	}
+	return true;
+}
+
+bool nvmBatchLookup(uint16_t key, enum VarType varType, void *value) {
+	if (!batching) {
+		return false;
+	}
+
+	uint16_t valueOffset = nvmEntryFind(nvmBatch, nvmBatchLength, key, varType);
+	if (valueOffset == 0U) {
+		return false;
+	}
+
+	memcpy(value, &nvmBatch[valueOffset], nvmVarSize(varType));
+	return true;
+}
+
+void nvmBatchClear(void) {
+	batching = false;
+	nvmBatchLength = 0U;
+}
+
+bool nvmBeginBatch(void) {
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	if (nvmAsyncActive()) {
+		return nvmAsyncBeginBatch();
+	}
+
+	if (batching) {
+		LOG_W(NVM, "NVM batch already started");
+		return false;
+	}
+
+	batching = true;
+	nvmBatchLength = 0U;
+	return true;
+}
+
+void nvmAbortBatch(void) {
+	if (nvmAsyncActive()) {
+		nvmAsyncAbortBatch();
+		return;
+	}
+
+	if (batching) {
+		LOG_I(NVM, "NVM batch aborted, bytes: {}", nvmBatchLength);
+	}
+
+	nvmBatchClear();
+}
+
+/****************************
+ * NVM Strings
+****************************/
+
+bool nvmBytesFit(uint16_t key, uint16_t length, uint16_t capacity) {
+	if (capacity > NVM_BYTES_MAX + NVM_LENGTH_PREFIX || length + NVM_LENGTH_PREFIX > capacity) {
+		LOG_ERROR("NVM value of {} bytes doesn't fit {} bytes at key {}", length, capacity, key);
+		return false;
+	}
+	return true;
+}
+
+/****************************
+ * NVM Snapshots
+****************************/
+
+bool nvmStoreSnapshot(uint16_t key, const void *data, uint16_t size) {
+	uint16_t crc = nvmCrc16(0xFFFFU, (const uint8_t*)data, size);
+
+	// the crc follows the block, a block torn from its crc fails the
+	// check on load, the version only tags the layout of every snapshot
+	bool result = nvmWriteBlock(key, data, size) &&
+		nvmWriteValue((uint16_t)(key + size), crc) &&
+		nvmWriteValue((uint16_t)EEPROM_VERSION_KEY, (uint8_t)EEPROM_VERSION);
+
+	return result && nvmFlush();
+}
+
+bool nvmLoadSnapshot(uint16_t key, void *data, uint16_t size) {
+	uint8_t version;
+	uint16_t crc;
+
+	if (!nvmGetValue((uint16_t)EEPROM_VERSION_KEY, &version) || version != EEPROM_VERSION) {
+		LOG_W(NVM, "Snapshot version doesn't match");
+		return false;
+	}
+
+	if (!nvmReadBlock(key, data, size) || !nvmGetValue((uint16_t)(key + size), &crc)) {
+		return false;
+	}
+
+	if (crc != nvmCrc16(0xFFFFU, (const uint8_t*)data, size)) {
+		LOG_ERROR("Snapshot failed crc");
+		return false;
+	}
+
+	return true;
+}
+
+#if DEBUG_LEVEL > DEBUG_LEVEL_NONE || defined(NVM_STATS)
+
+const __FlashStringHelper *nvmVarName(enum VarType varType) {
+	switch(varType) {
+		case VAR_BOOL:
+			return F("bool");
+		case VAR_INT8:
+			return F("i8");
+		case VAR_UINT8:
+			return F("iu8");
+		case VAR_INT16:
+			return F("i16");
+		case VAR_UINT16:
+			return F("iu16");
+		case VAR_INT32:
+			return F("i32");
+		case VAR_UINT32:
+			return F("iu32");
+		case VAR_INT64:
+			return F("i64");
+		case VAR_UINT64:
+			return F("iu64");
+		case VAR_FLOAT:
+			return F("float");
+		case VAR_DOUBLE:
+			return F("double");
+		case VAR_BYTES:
+			return F("bytes");
+		default:
+			return F("invalid");
+	}
+}
+
+void printVarType(enum VarType varType) {
+	Serial.print(nvmVarName(varType));
+}
+
 #endif
\ No newline at end of file
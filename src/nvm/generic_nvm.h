@@ -21,6 +21,7 @@
 
 #include <Arduino.h>
 #include "debug.h"
+#include "trace.h"
 
 #define DEFAULT_NVM_SIZE 0U
 
@@ -40,10 +41,157 @@ enum VarType {
 	VAR_INT16, VAR_UINT16,
 	VAR_INT32, VAR_UINT32,
 	VAR_INT64, VAR_UINT64,
-	VAR_FLOAT, VAR_DOUBLE
+	VAR_FLOAT, VAR_DOUBLE,
+	VAR_BYTES
 };
 
-#ifdef __NVM_DEBUG__
+/**
+ * Updates a CRC-8 (poly 0x07) with the given bytes
+ * 
+ * @param crc starting crc value
+ * @param data bytes to add to the crc
+ * @param size number of bytes
+ * 
+ * @return updated crc
+ */
+uint8_t nvmCrc8(uint8_t crc, const uint8_t *data, uint16_t size);
+
+/**
+ * Updates a CRC-16 (CCITT) with the given bytes
+ * 
+ * @param crc starting crc value
+ * @param data bytes to add to the crc
+ * @param size number of bytes
+ * 
+ * @return updated crc
+ */
+uint16_t nvmCrc16(uint16_t crc, const uint8_t *data, uint16_t size);
+
+/**
+ * Gets the stored size of a variable type
+ * 
+ * @param varType type of variable
+ * 
+ * @return size in bytes, 0 if invalid
+ */
+uint8_t nvmVarSize(uint8_t varType);
+
+/**
+ * Gets if nvm is started and debugs it
+ * 
+ * @return if nvm is started
+ */
+bool nvmStarted(void);
+
+/****************************
+ * NVM Batch Staging
+ * 
+ * Values written during a batch are staged in RAM
+ * as entries of key(2) type(1) value(n) until the
+ * backend publishes them in nvmCommitBatch()
+****************************/
+
+// bytes of RAM used to stage batched writes
+#ifndef NVM_BATCH_SIZE
+#define NVM_BATCH_SIZE 64U
+#endif
+
+#define NVM_BATCH_ENTRY_OVERHEAD 3U
+
+extern uint8_t nvmBatch[NVM_BATCH_SIZE];
+extern uint16_t nvmBatchLength;
+
+/**
+ * Gets if a batch is being staged
+ * 
+ * @return if writes are staged
+ */
+bool nvmBatchActive(void);
+
+/**
+ * Stages a value in the batch, replacing an earlier value of the key
+ * 
+ * @param key key of nvm address
+ * @param varType type of the value
+ * @param value bytes of the value
+ * 
+ * @return if the value fit in the batch
+ */
+bool nvmBatchStage(uint16_t key, enum VarType varType, const void *value);
+
+/**
+ * Gets a staged value from the batch
+ * 
+ * @param key key of nvm address
+ * @param varType type of the value
+ * @param value variable to store result to
+ * 
+ * @return if the key is staged with that type
+ */
+bool nvmBatchLookup(uint16_t key, enum VarType varType, void *value);
+
+/**
+ * Parses a batch entry
+ * 
+ * @param batch staged entries
+ * @param length length of staged entries
+ * @param offset offset of the entry to parse
+ * @param key variable to store entry key to
+ * @param varType variable to store entry type to
+ * 
+ * @return offset of the entry value, 0 if no valid entry
+ */
+uint16_t nvmBatchEntry(
+	const uint8_t *batch, uint16_t length, uint16_t offset,
+	uint16_t *key, uint8_t *varType
+);
+
+/**
+ * Finds the value offset of a key in staged entries
+ * 
+ * @param entries staged entries
+ * @param length length of staged entries
+ * @param key key of nvm address
+ * @param varType type of the value
+ * 
+ * @return offset of the staged value, 0 if not staged
+ */
+uint16_t nvmEntryFind(const uint8_t *entries, uint16_t length, uint16_t key, enum VarType varType);
+
+/**
+ * Stages a value in a buffer of entries, replacing an earlier value of the key
+ * 
+ * @param entries staged entries
+ * @param length length of staged entries, updated when an entry is added
+ * @param capacity bytes the entries buffer can hold
+ * @param key key of nvm address
+ * @param varType type of the value
+ * @param value bytes of the value
+ * 
+ * @return if the value fit in the buffer
+ */
+bool nvmEntryStage(
+	uint8_t *entries, uint16_t *length, uint16_t capacity,
+	uint16_t key, enum VarType varType, const void *value
+);
+
+/**
+ * Ends the batch without publishing staged values
+ * 
+ * @return void
+ */
+void nvmBatchClear(void);
+
+#if DEBUG_LEVEL > DEBUG_LEVEL_NONE || defined(NVM_STATS)
+
+/**
+ * Gets the name of a variable type for logs
+ * 
+ * @param varType type of variable
+ * 
+ * @return name formatted with F()
+ */
+const __FlashStringHelper *nvmVarName(enum VarType varType);
 
 /**
  * Prints the variable type inputted to console
@@ -61,12 +209,198 @@ void printVarType(enum VarType varType);
 /**
  * Initializes NVM for operation
  * 
- * @param nvmSize size in bytes of nvm storage
+ * @param nvmSize size in bytes of nvm storage, with EEPROM
+ * at least the schema and its batch journal
  * 
- * @return code from trying to initialize
+ * @return code from trying to initialize, NVM_INVALID_SIZE if too small
  */
 enum NVMStartCode nvmInit(uint16_t nvmSize);
 
+/**
+ * Stops NVM without flushing, pending writes are
+ * dropped the same as a reset
+ */
+void nvmEnd(void);
+
+/**
+ * Commits pending nvm writes to storage
+ * 
+ * @return if flush was successful
+ */
+bool nvmFlush(void);
+
+/**
+ * Starts staging writes so they are published together
+ * 
+ * @return if batch was started
+ */
+bool nvmBeginBatch(void);
+
+/**
+ * Publishes all staged writes in a single atomic commit
+ * 
+ * @return if every staged write was committed
+ */
+bool nvmCommitBatch(void);
+
+/**
+ * Discards all staged writes
+ * 
+ * @return void
+ */
+void nvmAbortBatch(void);
+
+/****************************
+ * NVM Block Methods
+****************************/
+
+/**
+ * Writes a contiguous block of bytes to nvm
+ * 
+ * @param key key of nvm address
+ * @param data bytes to write
+ * @param size number of bytes to write
+ * 
+ * @return if write was valid
+ */
+bool nvmWriteBlock(uint16_t key, const void *data, uint16_t size);
+
+/**
+ * Reads a contiguous block of bytes from nvm
+ * 
+ * @param key key of nvm address
+ * @param data buffer to store bytes to
+ * @param size number of bytes to read
+ * 
+ * @return if the whole block was read
+ */
+bool nvmReadBlock(uint16_t key, void *data, uint16_t size);
+
+/**
+ * Stores a snapshot block tagged with EEPROM_VERSION and
+ * a crc, then flushes it. The snapshot uses key for the
+ * data and key + size for the crc. A reset between the
+ * block and its crc loses the snapshot, it is never
+ * loaded torn
+ * 
+ * @param key key of nvm address
+ * @param data snapshot to store
+ * @param size size of the snapshot
+ * 
+ * @return if snapshot was stored
+ */
+bool nvmStoreSnapshot(uint16_t key, const void *data, uint16_t size);
+
+/**
+ * Loads a snapshot stored with nvmStoreSnapshot()
+ * 
+ * @param key key of nvm address
+ * @param data buffer to store snapshot to, undefined on failure
+ * @param size size of the snapshot
+ * 
+ * @return if snapshot matched EEPROM_VERSION and its crc
+ */
+bool nvmLoadSnapshot(uint16_t key, void *data, uint16_t size);
+
+/**
+ * Stores a packed struct as a snapshot
+ * 
+ * @param key key of nvm address
+ * @param snapshot struct to store
+ * 
+ * @return if snapshot was stored
+ */
+template <typename T>
+bool nvmStoreSnapshot(uint16_t key, const T &snapshot) {
+	return nvmStoreSnapshot(key, &snapshot, sizeof(T));
+}
+
+/**
+ * Loads a packed struct stored as a snapshot
+ * 
+ * @param key key of nvm address
+ * @param snapshot struct to store result to
+ * 
+ * @return if snapshot matched EEPROM_VERSION and its crc
+ */
+template <typename T>
+bool nvmLoadSnapshot(uint16_t key, T *snapshot) {
+	return nvmLoadSnapshot(key, snapshot, sizeof(T));
+}
+
+/****************************
+ * NVM String Methods
+ * 
+ * Strings and byte arrays are stored with a length
+ * prefix in front of the data, so a field reserved
+ * for a char array of capacity bytes holds a string
+ * of up to capacity - 1 characters like it would in
+ * RAM. Preferences keeps the length itself
+****************************/
+
+// bytes in front of a string or byte array holding its length
+#define NVM_LENGTH_PREFIX 1U
+
+// longest string or byte array the length prefix can hold
+#define NVM_BYTES_MAX 255U
+
+/**
+ * Checks a string or byte array fits the bytes reserved for it
+ * 
+ * @param key key of nvm address
+ * @param length length of the value
+ * @param capacity bytes reserved at key, including the length prefix
+ * 
+ * @return if value fits
+ */
+bool nvmBytesFit(uint16_t key, uint16_t length, uint16_t capacity);
+
+/**
+ * Writes a string to nvm in one operation
+ * 
+ * @param key key of nvm address
+ * @param value string to write
+ * @param capacity bytes reserved at key, same as the size of a char array
+ * 
+ * @return if write was valid
+ */
+bool nvmWriteString(uint16_t key, const char *value, uint16_t capacity);
+
+/**
+ * Gets a string from nvm in one operation
+ * 
+ * @param key key of nvm address
+ * @param value buffer of capacity bytes to store the terminated string to
+ * @param capacity bytes reserved at key, same as the size of a char array
+ * 
+ * @return if get was successful
+ */
+bool nvmGetString(uint16_t key, char *value, uint16_t capacity);
+
+/**
+ * Writes a byte array to nvm in one operation
+ * 
+ * @param key key of nvm address
+ * @param data bytes to write
+ * @param length number of bytes to write
+ * @param capacity bytes reserved at key, including the length prefix
+ * 
+ * @return if write was valid
+ */
+bool nvmWriteBytes(uint16_t key, const void *data, uint16_t length, uint16_t capacity);
+
+/**
+ * Gets a byte array from nvm in one operation
+ * 
+ * @param key key of nvm address
+ * @param data buffer of capacity - 1 bytes to store result to
+ * @param length variable to store the number of bytes to
+ * @param capacity bytes reserved at key, including the length prefix
+ * 
+ * @return if get was successful
+ */
+bool nvmGetBytes(uint16_t key, void *data, uint16_t *length, uint16_t capacity);
+
 /****************************
  * NVM Write Methods
 ****************************/
@@ -295,4 +629,7 @@ bool nvmGetValue(uint16_t key, float *value);
  */
 bool nvmGetValue(uint16_t key, double *value);
 
+// async commits extend the api with nvmSync()
+#include "nvm_async.h"
+
 #endif
\ No newline at end of file
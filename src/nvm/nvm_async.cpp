@@ -0,0 +1,437 @@
+/*
+	nvm_async.cpp - deferred nvm commits from a background task
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nvm_async.h"
+
+#ifdef NVM_ASYNC
+
+/****************************
+ * Task Primitives
+****************************/
+
+#if defined(HOSTLINUX)
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+std::mutex asyncQueueMutex;
+std::recursive_mutex asyncStorageMutex;
+std::mutex asyncWakeMutex;
+std::condition_variable asyncWakeSignal;
+bool asyncWakeRequested = false;
+std::thread asyncWorker;
+thread_local bool asyncOnWorker = false;
+std::atomic<bool> asyncRunning(false);
+
+void asyncLockQueue(void) {
+	asyncQueueMutex.lock();
+}
+
+void asyncUnlockQueue(void) {
+	asyncQueueMutex.unlock();
+}
+
+bool asyncIsWorker(void) {
+	return asyncOnWorker;
+}
+
+void asyncWake(void) {
+	std::lock_guard<std::mutex> lock(asyncWakeMutex);
+	asyncWakeRequested = true;
+	asyncWakeSignal.notify_one();
+}
+
+void asyncWait(uint32_t ms) {
+	std::unique_lock<std::mutex> lock(asyncWakeMutex);
+	asyncWakeSignal.wait_for(lock, std::chrono::milliseconds(ms), [] { return asyncWakeRequested; });
+	asyncWakeRequested = false;
+}
+
+void asyncWorkerLoop(void);
+
+void asyncWorkerThread(void) {
+	asyncOnWorker = true;
+	asyncWorkerLoop();
+}
+
+bool asyncStartWorker(void) {
+	asyncRunning = true;
+	asyncWorker = std::thread(asyncWorkerThread);
+	return true;
+}
+
+void asyncStopWorker(void) {
+	asyncRunning = false;
+	asyncWake();
+	asyncWorker.join();
+}
+
+#elif defined(ESP32DEVC)
+
+SemaphoreHandle_t asyncQueueMutex = NULL;
+SemaphoreHandle_t asyncStorageMutex = NULL;
+TaskHandle_t asyncWorker = NULL;
+volatile bool asyncRunning = false;
+volatile bool asyncStopped = true;
+
+void asyncLockQueue(void) {
+	xSemaphoreTake(asyncQueueMutex, portMAX_DELAY);
+}
+
+void asyncUnlockQueue(void) {
+	xSemaphoreGive(asyncQueueMutex);
+}
+
+bool asyncIsWorker(void) {
+	return xTaskGetCurrentTaskHandle() == asyncWorker;
+}
+
+void asyncWake(void) {
+	xTaskNotifyGive(asyncWorker);
+}
+
+void asyncWait(uint32_t ms) {
+	ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms));
+}
+
+void asyncWorkerLoop(void);
+
+void asyncWorkerTask(void *parameter) {
+	asyncWorkerLoop();
+	asyncStopped = true;
+	vTaskDelete(NULL);
+}
+
+bool asyncStartWorker(void) {
+	if (asyncQueueMutex == NULL) {
+		asyncQueueMutex = xSemaphoreCreateMutex();
+		asyncStorageMutex = xSemaphoreCreateRecursiveMutex();
+	}
+	if (asyncQueueMutex == NULL || asyncStorageMutex == NULL) {
+		return false;
+	}
+
+	asyncRunning = true;
+	asyncStopped = false;
+
+	// flash work stays off the core running loop()
+	if (xTaskCreatePinnedToCore(
+		asyncWorkerTask, "nvm", NVM_ASYNC_STACK, NULL, 1, &asyncWorker, 0
+	) != pdPASS) {
+		asyncRunning = false;
+		asyncStopped = true;
+		return false;
+	}
+	return true;
+}
+
+void asyncStopWorker(void) {
+	asyncRunning = false;
+	asyncWake();
+	while (!asyncStopped) {
+		delay(1);
+	}
+	asyncWorker = NULL;
+}
+
+#endif
+
+/****************************
+ * Write Queue
+****************************/
+
+uint8_t asyncQueue[NVM_ASYNC_SIZE];
+uint16_t asyncQueueLength = 0U;
+uint8_t asyncHeldQueue[NVM_ASYNC_SIZE];
+uint16_t asyncHeldLength = 0U;
+bool asyncHeld = false;
+bool asyncSyncRequested = false;
+bool asyncLastResult = true;
+uint32_t asyncQuietMs = NVM_ASYNC_QUIET_MS;
+unsigned long asyncLastWrite = 0UL;
+
+/**
+ * Removes entries from the queue that still hold the
+ * published value, entries rewritten since stay queued
+ *
+ * @param entries published entries
+ * @param length length of published entries
+ */
+void asyncRemovePublished(const uint8_t *entries, uint16_t length) {
+	uint16_t offset = 0U;
+	uint16_t key;
+	uint8_t varType;
+
+	while (true) {
+		uint16_t valueOffset = nvmBatchEntry(entries, length, offset, &key, &varType);
+		if (valueOffset == 0U) {
+			return;
+		}
+
+		uint8_t size = nvmVarSize(varType);
+		uint16_t queued = nvmEntryFind(asyncQueue, asyncQueueLength, key, (enum VarType)varType);
+
+		if (queued != 0U && !memcmp(&asyncQueue[queued], &entries[valueOffset], size)) {
+			uint16_t start = queued - NVM_BATCH_ENTRY_OVERHEAD;
+			uint16_t end = queued + size;
+			memmove(&asyncQueue[start], &asyncQueue[end], asyncQueueLength - end);
+			asyncQueueLength -= end - start;
+		}
+
+		offset = valueOffset + size;
+	}
+}
+
+/**
+ * Commits a copy of the queue as one backend batch, skipped
+ * while a batch holds the queue so its entries stay atomic
+ */
+void asyncPublish(void) {
+	TRACE_SCOPE("asyncPublish");
+
+	uint8_t entries[NVM_ASYNC_SIZE];
+	uint16_t length;
+
+	asyncLockQueue();
+	if (asyncHeld) {
+		asyncUnlockQueue();
+		return;
+	}
+	length = asyncQueueLength;
+	memcpy(entries, asyncQueue, length);
+	asyncUnlockQueue();
+
+	bool result;
+	{
+		NVMStorageLock lock;
+		result = nvmBeginBatch();
+		if (result) {
+			memcpy(nvmBatch, entries, length);
+			nvmBatchLength = length;
+			result = nvmCommitBatch() && nvmFlush();
+		}
+	}
+
+	if (!result) {
+		LOG_ERROR("NVM async commit failed, dropped bytes: {}", length);
+	}
+
+	asyncLockQueue();
+	asyncRemovePublished(entries, length);
+	asyncLastResult = result;
+	asyncUnlockQueue();
+}
+
+void asyncWorkerLoop(void) {
+	while (asyncRunning) {
+		asyncWait(asyncQuietMs);
+
+		asyncLockQueue();
+		bool due = asyncQueueLength != 0U && !asyncHeld &&
+			(asyncSyncRequested || millis() - asyncLastWrite >= asyncQuietMs);
+		asyncUnlockQueue();
+
+		if (due) {
+			asyncPublish();
+		}
+	}
+}
+
+bool nvmStartAsync(uint32_t quietMs) {
+	if (!nvmStarted()) {
+		return false;
+	}
+
+	if (asyncRunning) {
+		LOG_W(NVM, "NVM async already started");
+		return false;
+	}
+
+	asyncQueueLength = 0U;
+	asyncHeld = false;
+	asyncSyncRequested = false;
+	asyncLastResult = true;
+	asyncQuietMs = quietMs;
+
+	if (!asyncStartWorker()) {
+		LOG_ERROR("NVM async worker couldn't be started");
+		return false;
+	}
+
+	return true;
+}
+
+bool nvmStopAsync(void) {
+	if (!asyncRunning) {
+		return true;
+	}
+
+	asyncLockQueue();
+	bool held = asyncHeld;
+	asyncUnlockQueue();
+
+	if (held) {
+		LOG_W(NVM, "NVM async can't stop during a batch");
+		return false;
+	}
+
+	bool result = nvmSync();
+	asyncStopWorker();
+	return result;
+}
+
+bool nvmSync(void) {
+	TRACE_SCOPE("nvmSync");
+
+	if (!asyncRunning || asyncIsWorker()) {
+		return nvmFlush();
+	}
+
+	asyncLockQueue();
+	asyncSyncRequested = true;
+	asyncUnlockQueue();
+	asyncWake();
+
+	// a held queue belongs to a batch of the caller
+	while (true) {
+		asyncLockQueue();
+		bool waiting = asyncQueueLength != 0U && !asyncHeld;
+		asyncUnlockQueue();
+		if (!waiting) {
+			break;
+		}
+		delay(1);
+	}
+
+	asyncLockQueue();
+	asyncSyncRequested = false;
+	bool result = asyncLastResult;
+	asyncUnlockQueue();
+
+	return result;
+}
+
+bool nvmAsyncActive(void) {
+	return asyncRunning && !asyncIsWorker();
+}
+
+bool nvmAsyncStage(uint16_t key, enum VarType varType, const void *value) {
+	while (true) {
+		asyncLockQueue();
+		bool queued = nvmEntryStage(
+			asyncQueue, &asyncQueueLength, NVM_ASYNC_SIZE, key, varType, value
+		);
+		bool held = asyncHeld;
+		if (queued) {
+			asyncLastWrite = millis();
+		}
+		else if (!held) {
+			asyncSyncRequested = true;
+		}
+		asyncUnlockQueue();
+
+		if (queued) {
+			return true;
+		}
+
+		if (held) {
+			LOG_ERROR("NVM async batch full, dropped key {}", key);
+			return false;
+		}
+
+		// queue is full of other keys, waits for the worker to make room
+		asyncWake();
+		delay(1);
+	}
+}
+
+bool nvmAsyncLookup(uint16_t key, enum VarType varType, void *value) {
+	if (!asyncRunning) {
+		return false;
+	}
+
+	asyncLockQueue();
+	uint16_t valueOffset = nvmEntryFind(asyncQueue, asyncQueueLength, key, varType);
+	if (valueOffset != 0U) {
+		memcpy(value, &asyncQueue[valueOffset], nvmVarSize(varType));
+	}
+	asyncUnlockQueue();
+
+	return valueOffset != 0U;
+}
+
+bool nvmAsyncBeginBatch(void) {
+	asyncLockQueue();
+	bool result = !asyncHeld;
+	if (result) {
+		asyncHeld = true;
+		asyncHeldLength = asyncQueueLength;
+		memcpy(asyncHeldQueue, asyncQueue, asyncQueueLength);
+	}
+	asyncUnlockQueue();
+
+	if (!result) {
+		LOG_W(NVM, "NVM batch already started");
+	}
+	return result;
+}
+
+bool nvmAsyncCommitBatch(void) {
+	asyncLockQueue();
+	bool result = asyncHeld;
+	asyncHeld = false;
+	asyncLastWrite = millis();
+	asyncUnlockQueue();
+	return result;
+}
+
+void nvmAsyncAbortBatch(void) {
+	asyncLockQueue();
+	if (asyncHeld) {
+		asyncQueueLength = asyncHeldLength;
+		memcpy(asyncQueue, asyncHeldQueue, asyncHeldLength);
+		asyncHeld = false;
+	}
+	asyncUnlockQueue();
+}
+
+bool nvmAsyncLockStorage(void) {
+	if (!asyncRunning) {
+		return false;
+	}
+
+	#if defined(HOSTLINUX)
+		asyncStorageMutex.lock();
+	#elif defined(ESP32DEVC)
+		xSemaphoreTakeRecursive(asyncStorageMutex, portMAX_DELAY);
+	#endif
+	return true;
+}
+
+void nvmAsyncUnlockStorage(void) {
+	#if defined(HOSTLINUX)
+		asyncStorageMutex.unlock();
+	#elif defined(ESP32DEVC)
+		xSemaphoreGiveRecursive(asyncStorageMutex);
+	#endif
+}
+
+#endif
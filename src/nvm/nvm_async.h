@@ -0,0 +1,178 @@
+/*
+	nvm_async.h - deferred nvm commits from a background task
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NVMASYNC_H
+#define NVMASYNC_H
+
+#include <Arduino.h>
+#include "../compile_flags.h"
+#include "generic_nvm.h"
+
+/****************************
+ * Async Commits
+ *
+ * While async is running, value writes are coalesced
+ * per key in a RAM queue and return straight away. A
+ * worker task publishes the queue as one batch once no
+ * write arrived for the quiet window. Queued values stay
+ * visible to reads until they are committed.
+ *
+ * Reads of keys that aren't queued, block writes and
+ * flushes wait for a publish in progress to finish.
+ * Stop async before nvmEnd().
+****************************/
+
+// bytes of RAM the write queue can hold, published as one batch
+#ifndef NVM_ASYNC_SIZE
+#define NVM_ASYNC_SIZE NVM_BATCH_SIZE
+#endif
+
+// time without writes before the queue is committed
+#ifndef NVM_ASYNC_QUIET_MS
+#define NVM_ASYNC_QUIET_MS 500UL
+#endif
+
+// stack of the worker task
+#ifndef NVM_ASYNC_STACK
+#define NVM_ASYNC_STACK 4096U
+#endif
+
+static_assert(NVM_ASYNC_SIZE <= NVM_BATCH_SIZE, "NVM async queue must fit in one batch");
+
+#ifdef NVM_ASYNC
+
+/**
+ * Starts the worker task, writes are queued from now on
+ *
+ * @param quietMs time without writes before the queue is committed
+ *
+ * @return if worker was started
+ */
+bool nvmStartAsync(uint32_t quietMs);
+
+/**
+ * Commits the queue and stops the worker task,
+ * writes are committed inline again
+ *
+ * @return if the queue was committed, false during a batch
+ */
+bool nvmStopAsync(void);
+
+/**
+ * Waits until every queued write is committed
+ *
+ * @return if the last commit was successful
+ */
+bool nvmSync(void);
+
+/****************************
+ * Backend Hooks
+****************************/
+
+/**
+ * Gets if writes of the calling task go through the queue,
+ * the worker itself writes straight to the backend
+ *
+ * @return if writes are queued
+ */
+bool nvmAsyncActive(void);
+
+/**
+ * Queues a value, replacing an earlier queued value of the key
+ *
+ * @param key key of nvm address
+ * @param varType type of the value
+ * @param value bytes of the value
+ *
+ * @return if the value was queued
+ */
+bool nvmAsyncStage(uint16_t key, enum VarType varType, const void *value);
+
+/**
+ * Gets a value that is queued but not yet committed
+ *
+ * @param key key of nvm address
+ * @param varType type of the value
+ * @param value variable to store result to
+ *
+ * @return if the key is queued with that type
+ */
+bool nvmAsyncLookup(uint16_t key, enum VarType varType, void *value);
+
+/**
+ * Holds the queue until nvmAsyncCommitBatch() so
+ * the batch is published together
+ *
+ * @return if batch was started
+ */
+bool nvmAsyncBeginBatch(void);
+
+/**
+ * Releases the queue held by a batch
+ *
+ * @return if batch was active
+ */
+bool nvmAsyncCommitBatch(void);
+
+/**
+ * Restores the queue to before the batch started
+ */
+void nvmAsyncAbortBatch(void);
+
+/**
+ * Locks the backend storage against the worker
+ *
+ * @return if lock was taken, only while async is running
+ */
+bool nvmAsyncLockStorage(void);
+
+/**
+ * Unlocks the backend storage
+ */
+void nvmAsyncUnlockStorage(void);
+
+#else
+
+inline bool nvmSync(void) { return nvmFlush(); }
+
+inline bool nvmAsyncActive(void) { return false; }
+inline bool nvmAsyncStage(uint16_t key, enum VarType varType, const void *value) { return false; }
+inline bool nvmAsyncLookup(uint16_t key, enum VarType varType, void *value) { return false; }
+inline bool nvmAsyncBeginBatch(void) { return false; }
+inline bool nvmAsyncCommitBatch(void) { return false; }
+inline void nvmAsyncAbortBatch(void) {}
+inline bool nvmAsyncLockStorage(void) { return false; }
+inline void nvmAsyncUnlockStorage(void) {}
+
+#endif
+
+/**
+ * Holds the storage lock for the rest of a scope
+ */
+struct NVMStorageLock {
+	NVMStorageLock(void) : locked(nvmAsyncLockStorage()) {}
+	~NVMStorageLock(void) {
+		if (locked) {
+			nvmAsyncUnlockStorage();
+		}
+	}
+
+	bool locked;
+};
+
+#endif
@@ -0,0 +1,221 @@
+/*
+	nvm_schema.h - compile time layout of nvm settings
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NVMSCHEMA_H
+#define NVMSCHEMA_H
+
+#include <Arduino.h>
+#include "../compile_flags.h"
+#include "../board_traits.h"
+#include "generic_nvm.h"
+
+/**
+ * Fields compile to direct EEPROM access when values
+ * live at fixed addresses and need no commit
+ */
+#if defined(NVM_EEPROM) && !defined(NVM_SHADOW) && !defined(NVM_LOG)
+#define NVM_SCHEMA_DIRECT
+#ifdef NVM_FILE
+#include "core_file.h"
+#else
+#include <EEPROM.h>
+#endif
+#endif
+
+/**
+ * Total bytes of nvm the board can hold
+ */
+#ifndef NVM_CAPACITY
+#define NVM_CAPACITY ((uint32_t)Board::nvmBytes)
+#endif
+
+/****************************
+ * Schema Fields
+****************************/
+
+/**
+ * Setting stored at a fixed nvm address
+ * 
+ * @param T type of the setting
+ * @param ADDRESS key of nvm address
+ */
+template <typename T, uint16_t ADDRESS>
+struct NVMField {
+	typedef T Type;
+	enum : uint32_t {
+		address = ADDRESS,
+		size = sizeof(T),
+		end = (uint32_t)ADDRESS + sizeof(T)
+	};
+	static_assert(end <= NVM_CAPACITY, "NVM field ends past the nvm capacity");
+};
+
+/**
+ * Setting placed directly after the previous field
+ * 
+ * @param T type of the setting
+ * @param PREV field this setting follows
+ */
+template <typename T, typename PREV>
+struct NVMNext : NVMField<T, (uint16_t)PREV::end> {
+	static_assert(PREV::end <= 0xFFFFUL, "NVM field address doesn't fit a key");
+};
+
+/**
+ * Checks at compile time that two fields don't share bytes
+ * 
+ * @param A first field
+ * @param B second field
+ */
+template <typename A, typename B>
+struct NVMNoOverlap {
+	static_assert(
+		(uint32_t)A::end <= (uint32_t)B::address ||
+		(uint32_t)B::end <= (uint32_t)A::address,
+		"NVM fields overlap"
+	);
+	static const bool value = true;
+};
+
+/****************************
+ * Schema Scalar Dispatch
+****************************/
+
+/**
+ * Writes a field value that isn't a scalar as a block
+ * 
+ * @param key key of nvm address
+ * @param value value to write
+ * 
+ * @return if write was valid
+ */
+template <typename T>
+inline bool nvmFieldWrite(uint16_t key, const T &value) {
+	return nvmWriteBlock(key, &value, sizeof(T));
+}
+
+/**
+ * Reads a field value that isn't a scalar as a block
+ * 
+ * @param key key of nvm address
+ * @param value variable to store result to
+ * 
+ * @return if get was successful
+ */
+template <typename T>
+inline bool nvmFieldGet(uint16_t key, T *value) {
+	return nvmReadBlock(key, value, sizeof(T));
+}
+
+#define NVM_SCALAR_FIELD(TYPE) \
+	inline bool nvmFieldWrite(uint16_t key, const TYPE &value) { \
+		return nvmWriteValue(key, value); \
+	} \
+	inline bool nvmFieldGet(uint16_t key, TYPE *value) { \
+		return nvmGetValue(key, value); \
+	}
+
+NVM_SCALAR_FIELD(bool)
+NVM_SCALAR_FIELD(int8_t)
+NVM_SCALAR_FIELD(uint8_t)
+NVM_SCALAR_FIELD(int16_t)
+NVM_SCALAR_FIELD(uint16_t)
+NVM_SCALAR_FIELD(int32_t)
+NVM_SCALAR_FIELD(uint32_t)
+NVM_SCALAR_FIELD(int64_t)
+NVM_SCALAR_FIELD(uint64_t)
+NVM_SCALAR_FIELD(float)
+NVM_SCALAR_FIELD(double)
+
+#undef NVM_SCALAR_FIELD
+
+/****************************
+ * Schema Accessors
+****************************/
+
+/**
+ * Writes a schema field, a value the field already holds
+ * isn't written again so modules can store their config
+ * every time they begin
+ * 
+ * With NVM_SCHEMA_DIRECT this is a single EEPROM.put at a
+ * constant address with no started, batch or bounds checks,
+ * the layout was already checked at compile time
+ * 
+ * @param FIELD field to write
+ * @param value value to write
+ * 
+ * @return if write was valid
+ */
+template <typename FIELD>
+inline bool nvmWriteField(const typename FIELD::Type &value) {
+	#ifdef NVM_SCHEMA_DIRECT
+		EEPROM.put((int)FIELD::address, value);
+		return true;
+	#else
+		return nvmFieldWrite((uint16_t)FIELD::address, value);
+	#endif
+}
+
+/**
+ * Gets a schema field
+ * 
+ * @param FIELD field to get
+ * @param value variable to store result to
+ * 
+ * @return if get was successful
+ */
+template <typename FIELD>
+inline bool nvmGetField(typename FIELD::Type *value) {
+	#ifdef NVM_SCHEMA_DIRECT
+		EEPROM.get((int)FIELD::address, *value);
+		return true;
+	#else
+		return nvmFieldGet((uint16_t)FIELD::address, value);
+	#endif
+}
+
+/**
+ * Writes a string to a char array schema field
+ * with a length prefix, see nvmWriteString()
+ * 
+ * @param FIELD char array field to write
+ * @param value string to write
+ * 
+ * @return if write was valid
+ */
+template <typename FIELD>
+inline bool nvmWriteFieldString(const char *value) {
+	static_assert(FIELD::size <= NVM_BYTES_MAX + NVM_LENGTH_PREFIX, "NVM string field too long for its length prefix");
+	return nvmWriteString((uint16_t)FIELD::address, value, (uint16_t)FIELD::size);
+}
+
+/**
+ * Gets a string from a char array schema field
+ * 
+ * @param FIELD char array field to get
+ * @param value buffer of FIELD::size bytes to store result to
+ * 
+ * @return if get was successful
+ */
+template <typename FIELD>
+inline bool nvmGetFieldString(char *value) {
+	return nvmGetString((uint16_t)FIELD::address, value, (uint16_t)FIELD::size);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,162 @@
+/*
+	nvm_stats.cpp - counters of nvm usage
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "nvm_stats.h"
+
+#ifdef NVM_STATS
+
+NVMStats nvmStats;
+
+const NVMStats *nvmGetStats(void) {
+	return &nvmStats;
+}
+
+void nvmResetStats(void) {
+	nvmStats.reads = 0U;
+	nvmStats.writes = 0U;
+	nvmStats.commits = 0U;
+	nvmStats.bytesWritten = 0U;
+	nvmStats.skippedWrites = 0U;
+	memset(nvmStats.readLatency, 0, sizeof(nvmStats.readLatency));
+	memset(nvmStats.writeLatency, 0, sizeof(nvmStats.writeLatency));
+	memset(nvmStats.writeHistogram, 0, sizeof(nvmStats.writeHistogram));
+}
+
+void nvmStatsBegin(uint16_t size) {
+	uint16_t pageSize = (uint16_t)((size + NVM_WEAR_PAGES - 1U) / NVM_WEAR_PAGES);
+
+	// wear is kept across restarts of the same region
+	if (pageSize != nvmStats.wearPageSize) {
+		nvmStats.wearPageSize = pageSize == 0U ? 1U : pageSize;
+		memset(nvmStats.pageWear, 0, sizeof(nvmStats.pageWear));
+	}
+}
+
+/**
+ * Adds an operation time to a latency entry
+ *
+ * @param latency entry to update
+ * @param elapsed time the operation took
+ */
+void nvmStatsLatency(NVMLatency *latency, uint32_t elapsed) {
+	if (latency->count == 0U || elapsed < latency->minMicros) {
+		latency->minMicros = elapsed;
+	}
+	if (elapsed > latency->maxMicros) {
+		latency->maxMicros = elapsed;
+	}
+	latency->count++;
+	latency->totalMicros += elapsed;
+}
+
+void nvmStatsRead(enum VarType varType, uint32_t start) {
+	nvmStats.reads++;
+	if ((uint8_t)varType < NVM_STATS_TYPES) {
+		nvmStatsLatency(&nvmStats.readLatency[varType], nvmStatsClock() - start);
+	}
+}
+
+void nvmStatsWrite(enum VarType varType, uint32_t start) {
+	uint32_t elapsed = nvmStatsClock() - start;
+
+	nvmStats.writes++;
+	if ((uint8_t)varType < NVM_STATS_TYPES) {
+		nvmStatsLatency(&nvmStats.writeLatency[varType], elapsed);
+	}
+
+	uint8_t bucket = 0U;
+	uint32_t limit = 4U;
+	while (bucket < NVM_LATENCY_BUCKETS - 1U && elapsed >= limit) {
+		bucket++;
+		limit <<= 2;
+	}
+	nvmStats.writeHistogram[bucket]++;
+}
+
+void nvmStatsSkip(void) {
+	nvmStats.skippedWrites++;
+}
+
+void nvmStatsProgram(uint16_t address, uint16_t size) {
+	if (size == 0U || nvmStats.wearPageSize == 0U) {
+		return;
+	}
+
+	nvmStats.bytesWritten += size;
+
+	uint16_t first = address / nvmStats.wearPageSize;
+	uint16_t last = (uint16_t)(((uint32_t)address + size - 1U) / nvmStats.wearPageSize);
+
+	for (uint16_t page = first; page <= last; page++) {
+		nvmStats.pageWear[page < NVM_WEAR_PAGES ? page : NVM_WEAR_PAGES - 1U]++;
+	}
+}
+
+void nvmStatsCommit(void) {
+	nvmStats.commits++;
+}
+
+void nvmPrintStats(void) {
+	Serial.print(F("reads: "));
+	Serial.print(nvmStats.reads);
+	Serial.print(F(", writes: "));
+	Serial.print(nvmStats.writes);
+	Serial.print(F(", commits: "));
+	Serial.print(nvmStats.commits);
+	Serial.print(F(", bytes written: "));
+	Serial.print(nvmStats.bytesWritten);
+	Serial.print(F(", skipped writes: "));
+	Serial.println(nvmStats.skippedWrites);
+
+	for (uint8_t varType = 1U; varType < NVM_STATS_TYPES; varType++) {
+		for (uint8_t write = 0U; write < 2U; write++) {
+			const NVMLatency *latency = write ?
+				&nvmStats.writeLatency[varType] : &nvmStats.readLatency[varType];
+			if (latency->count == 0U) {
+				continue;
+			}
+
+			Serial.print(write ? F("write ") : F("read "));
+			printVarType((enum VarType)varType);
+			Serial.print(F(" us min/avg/max: "));
+			Serial.print(latency->minMicros);
+			Serial.print(F("/"));
+			Serial.print(latency->totalMicros / latency->count);
+			Serial.print(F("/"));
+			Serial.println(latency->maxMicros);
+		}
+	}
+
+	Serial.print(F("write us histogram (<4, <16, ...):"));
+	for (uint8_t bucket = 0U; bucket < NVM_LATENCY_BUCKETS; bucket++) {
+		Serial.print(F(" "));
+		Serial.print(nvmStats.writeHistogram[bucket]);
+	}
+	Serial.println();
+
+	Serial.print(F("wear per "));
+	Serial.print(nvmStats.wearPageSize);
+	Serial.print(F(" bytes:"));
+	for (uint8_t page = 0U; page < NVM_WEAR_PAGES; page++) {
+		Serial.print(F(" "));
+		Serial.print(nvmStats.pageWear[page]);
+	}
+	Serial.println();
+}
+
+#endif
@@ -0,0 +1,152 @@
+/*
+	nvm_stats.h - counters of nvm usage
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef NVMSTATS_H
+#define NVMSTATS_H
+
+#include <Arduino.h>
+#include "../compile_flags.h"
+#include "generic_nvm.h"
+
+// number of VarType values tracked
+#define NVM_STATS_TYPES ((uint8_t)VAR_BYTES + 1U)
+
+// buckets of the wear map, the nvm region is split evenly between them
+#ifndef NVM_WEAR_PAGES
+#define NVM_WEAR_PAGES 32U
+#endif
+
+/**
+ * Buckets of the write latency histogram, bucket n
+ * counts writes under 4^(n+1) microseconds and the
+ * last bucket counts everything slower
+ */
+#define NVM_LATENCY_BUCKETS 8U
+
+#ifdef NVM_STATS
+
+/**
+ * Latency of one operation on one variable type
+ */
+struct NVMLatency {
+	uint32_t count;
+	uint32_t minMicros;
+	uint32_t maxMicros;
+	uint32_t totalMicros;
+};
+
+/**
+ * Counters of nvm usage since start or nvmResetStats()
+ */
+struct NVMStats {
+	uint32_t reads;
+	uint32_t writes;
+	uint32_t commits;
+	uint32_t bytesWritten;
+	uint32_t skippedWrites;
+	NVMLatency readLatency[NVM_STATS_TYPES];
+	NVMLatency writeLatency[NVM_STATS_TYPES];
+	uint32_t writeHistogram[NVM_LATENCY_BUCKETS];
+	uint16_t wearPageSize;
+	uint32_t pageWear[NVM_WEAR_PAGES];
+};
+
+/**
+ * Gets the nvm usage counters
+ *
+ * @return current counters
+ */
+const NVMStats *nvmGetStats(void);
+
+/**
+ * Clears every counter except the wear map
+ */
+void nvmResetStats(void);
+
+/**
+ * Prints the nvm usage counters to the serial monitor
+ */
+void nvmPrintStats(void);
+
+/****************************
+ * Backend Hooks
+****************************/
+
+/**
+ * Gets the start time of an operation
+ *
+ * @return current time in microseconds
+ */
+inline uint32_t nvmStatsClock(void) {
+	return (uint32_t)micros();
+}
+
+/**
+ * Sizes the wear map for the nvm region
+ *
+ * @param size bytes of the nvm region
+ */
+void nvmStatsBegin(uint16_t size);
+
+/**
+ * Records a finished value read
+ *
+ * @param varType type of the value
+ * @param start time the read started at
+ */
+void nvmStatsRead(enum VarType varType, uint32_t start);
+
+/**
+ * Records a finished value write
+ *
+ * @param varType type of the value
+ * @param start time the write started at
+ */
+void nvmStatsWrite(enum VarType varType, uint32_t start);
+
+/**
+ * Records a write that didn't change storage
+ */
+void nvmStatsSkip(void);
+
+/**
+ * Records bytes programmed into storage
+ *
+ * @param address first address programmed
+ * @param size number of bytes programmed
+ */
+void nvmStatsProgram(uint16_t address, uint16_t size);
+
+/**
+ * Records a commit of storage
+ */
+void nvmStatsCommit(void);
+
+#else
+
+inline uint32_t nvmStatsClock(void) { return 0U; }
+inline void nvmStatsBegin(uint16_t size) {}
+inline void nvmStatsRead(enum VarType varType, uint32_t start) {}
+inline void nvmStatsWrite(enum VarType varType, uint32_t start) {}
+inline void nvmStatsSkip(void) {}
+inline void nvmStatsProgram(uint16_t address, uint16_t size) {}
+inline void nvmStatsCommit(void) {}
+
+#endif
+
+#endif
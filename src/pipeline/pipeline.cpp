@@ -0,0 +1,507 @@
+/*
+	pipeline.cpp - acquisition to transport pipeline over two cores
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "pipeline.h"
+#include "../trace.h"
+#include "../critical.h"
+#include "../sample_ring.h"
+#include "../acquisition/acquisition.h"
+#include "../trigger/trigger.h"
+#include "../decimation/decimation.h"
+#include "../codec/codec.h"
+#include "../link/link_frame.h"
+#include "../transport/transport.h"
+
+// cores the process stage can be given, the second needs PIPE_DUAL_CORE's worker
+#ifdef PIPE_DUAL_CORE
+#define PIPE_CORES (Board::cores >= 2U ? 2U : 1U)
+#define PIPE_SLOT_SAMPLES ((uint32_t)PIPE_BLOCKS * PIPE_BLOCK_SAMPLES)
+#else
+#define PIPE_CORES 1U
+#define PIPE_SLOT_SAMPLES 0UL
+#endif
+
+// buffers of the stages, the rest of RAM is left to the stack and other globals
+#define PIPE_BUFFER_BYTES ((uint32_t)sizeof(SampleWord) * ( \
+	(uint32_t)ACQ_BUFFERS * ACQ_BUFFER_SAMPLES + 2UL * TRIG_FRAME_SAMPLES + \
+	2UL * DEC_MAX_POINTS + PIPE_SLOT_SAMPLES) + 2UL * TRANSPORT_BATCH_SIZE)
+
+static_assert(PIPE_BUFFER_BYTES <= Board::ramBytes / 4UL * 3UL,
+	"Pipeline buffers leave under a quarter of the board's RAM, shrink them in board_traits.h");
+
+/**
+ * Block handed from the acquire stage to the process stage
+ */
+struct PipeBlock {
+	const SampleWord *samples;
+	uint16_t count;
+	uint8_t channels;
+	uint8_t kind; // LINK_BLOCK or LINK_TRIGGERED
+};
+
+PipeConfig pipeConfig;
+PipeStats pipeStats;
+bool pipeStarted = false;
+bool pipeDual = false;
+
+uint8_t pipeCoded[CODEC_MAX_BYTES(PIPE_BLOCK_SAMPLES)];
+
+/****************************
+ * Process Stage
+****************************/
+
+/**
+ * Sends a block as configured, on the core of the process stage
+ *
+ * @param block block to send
+ */
+void pipeProcess(const PipeBlock &block) {
+	unsigned long start = micros();
+
+	const SampleWord *samples = block.samples;
+	uint16_t count = block.count;
+	uint8_t kind = block.kind;
+	uint8_t stride = acqChannelCount(block.channels);
+
+	if (pipeConfig.decimate) {
+		count = decReduce(samples, count, &samples);
+		kind = decPointSamples() == 2U ? LINK_MINMAX : LINK_POINTS;
+		stride = (uint8_t)(stride * decPointSamples());
+	}
+
+	// decimation not started
+	if (count == 0U) {
+		return;
+	}
+
+	bool sent;
+	if (pipeConfig.coded) {
+		// min/max points code as two series per channel
+		uint16_t length = codecEncode(samples, count, stride, pipeCoded, sizeof(pipeCoded));
+		sent = length != 0U && linkSendFrame((uint8_t)(kind | LINK_CODED), block.channels, pipeCoded, length);
+	}
+	else {
+		sent = linkSendSamples(samples, count, block.channels, kind);
+	}
+
+	if (sent) {
+		pipeStats.frames++;
+	}
+	else {
+		pipeStats.refused++;
+	}
+	pipeStats.processMicros += (uint32_t)(micros() - start);
+}
+
+#ifdef PIPE_DUAL_CORE
+
+/****************************
+ * Slots
+ *
+ * Slot indexes go round two rings, full ones from the
+ * acquire stage to the process stage and free ones back,
+ * so each ring has one producer and one consumer
+****************************/
+
+SampleWord pipeSlots[PIPE_BLOCKS][PIPE_BLOCK_SAMPLES];
+PipeBlock pipeBlocks[PIPE_BLOCKS];
+SampleRing<uint8_t, PIPE_BLOCKS> pipeFull;
+SampleRing<uint8_t, PIPE_BLOCKS> pipeFree;
+
+// slot taken by the acquire stage and not yet handed off
+int16_t pipeHeld = -1;
+
+/****************************
+ * Worker Primitives
+ *
+ * The process stage's loop on the other core, woken by
+ * pipeWake() when a block is handed off and otherwise
+ * polling the transport
+****************************/
+
+void pipeWorkerLoop(void);
+
+#if defined(HOSTLINUX)
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+std::mutex pipeWakeMutex;
+std::condition_variable pipeWakeSignal;
+bool pipeWakeRequested = false;
+std::atomic<bool> pipeSleeping(false);
+std::thread pipeWorker;
+std::atomic<bool> pipeRunning(false);
+
+/**
+ * Signals a sleeping worker once half the slots are full,
+ * it looks every millisecond anyway and a signal costs
+ * the acquire stage many times the copy
+ */
+void pipeWake(void) {
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (pipeSleeping && pipeFull.available() <= PIPE_BLOCKS / 2U) {
+		std::lock_guard<std::mutex> lock(pipeWakeMutex);
+		pipeWakeRequested = true;
+		pipeWakeSignal.notify_one();
+	}
+}
+
+void pipeWait(void) {
+	std::unique_lock<std::mutex> lock(pipeWakeMutex);
+	pipeSleeping = true;
+	if (pipeFull.empty()) {
+		pipeWakeSignal.wait_for(lock, std::chrono::milliseconds(1), [] { return pipeWakeRequested; });
+	}
+	pipeSleeping = false;
+	pipeWakeRequested = false;
+}
+
+bool pipeStartWorker(void) {
+	pipeRunning = true;
+	pipeWorker = std::thread(pipeWorkerLoop);
+	return true;
+}
+
+void pipeStopWorker(void) {
+	pipeRunning = false;
+	pipeWake();
+	pipeWorker.join();
+}
+
+#elif defined(ESP32DEVC)
+
+TaskHandle_t pipeWorker = NULL;
+volatile bool pipeRunning = false;
+volatile bool pipeStopped = true;
+
+void pipeWake(void) {
+	xTaskNotifyGive(pipeWorker);
+}
+
+/**
+ * Blocks for a tick at most, which also lets core 0's
+ * idle task feed the watchdog
+ */
+void pipeWait(void) {
+	ulTaskNotifyTake(pdTRUE, 1);
+}
+
+void pipeWorkerTask(void *parameter) {
+	pipeWorkerLoop();
+	pipeStopped = true;
+	vTaskDelete(NULL);
+}
+
+bool pipeStartWorker(void) {
+	pipeRunning = true;
+	pipeStopped = false;
+
+	// loop() runs on core 1, the process stage shares core 0 with the radio
+	if (xTaskCreatePinnedToCore(
+		pipeWorkerTask, "pipe", PIPE_STACK, NULL, 1, &pipeWorker, 0
+	) != pdPASS) {
+		pipeRunning = false;
+		pipeStopped = true;
+		return false;
+	}
+	return true;
+}
+
+void pipeStopWorker(void) {
+	pipeRunning = false;
+	pipeWake();
+	while (!pipeStopped) {
+		delay(1);
+	}
+	pipeWorker = NULL;
+}
+
+#elif defined(PICO)
+
+#include <pico/multicore.h>
+
+volatile bool pipeRunning = false;
+volatile bool pipeStopped = true;
+
+void pipeWake(void) {
+	__sev();
+}
+
+/**
+ * Sleeps until the other core hands off a block, only
+ * when the transport has nothing left to send
+ */
+void pipeWait(void) {
+	if (transportPending() == 0UL) {
+		__wfe();
+	}
+}
+
+/**
+ * Runs from flash, so it answers the lockout nvm commits
+ * take while a sector is rewritten
+ */
+void pipeWorkerCore(void) {
+	criticalLockoutBegin();
+	pipeWorkerLoop();
+	criticalLockoutEnd();
+	pipeStopped = true;
+}
+
+/**
+ * Takes core 1 for the process stage, so the sketch
+ * can't define setup1() and loop1()
+ */
+bool pipeStartWorker(void) {
+	pipeRunning = true;
+	pipeStopped = false;
+	multicore_launch_core1(pipeWorkerCore);
+	return true;
+}
+
+void pipeStopWorker(void) {
+	pipeRunning = false;
+	pipeWake();
+	while (!pipeStopped) {
+		delay(1);
+	}
+	multicore_reset_core1();
+}
+
+#endif
+
+void pipeWorkerLoop(void) {
+	while (pipeRunning) {
+		uint8_t slot;
+		bool processed = pipeFull.pop(&slot);
+		if (processed) {
+			pipeProcess(pipeBlocks[slot]);
+			pipeFree.push(slot);
+		}
+		if (transportPoll() == 0U && !processed) {
+			pipeWait();
+		}
+	}
+}
+
+/**
+ * Copies a block into a free slot, it goes to the process
+ * stage once committed
+ *
+ * @param samples block to copy
+ * @param count samples in the block
+ * @param kind LINK_BLOCK or LINK_TRIGGERED
+ *
+ * @return if a slot was free
+ */
+bool pipeCopy(const SampleWord *samples, uint16_t count, uint8_t kind) {
+	if (pipeHeld < 0) {
+		uint8_t slot;
+		if (!pipeFree.pop(&slot)) {
+			return false;
+		}
+		pipeHeld = slot;
+	}
+
+	PipeBlock &block = pipeBlocks[pipeHeld];
+	memcpy(pipeSlots[pipeHeld], samples, count * sizeof(SampleWord));
+	block.samples = pipeSlots[pipeHeld];
+	block.count = count;
+	block.channels = acqChannels();
+	block.kind = kind;
+	return true;
+}
+
+/**
+ * Hands the copied block to the process stage
+ */
+void pipeCommit(void) {
+	pipeFull.push((uint8_t)pipeHeld);
+	pipeHeld = -1;
+	pipeWake();
+}
+
+#endif
+
+/****************************
+ * Acquire Stage
+****************************/
+
+/**
+ * Passes an acquisition buffer on as a block
+ *
+ * @param samples buffer from acqGetBuffer()
+ * @param count samples in the buffer
+ *
+ * @return if the block was passed on
+ */
+bool pipeStream(const SampleWord *samples, uint16_t count) {
+	#ifdef PIPE_DUAL_CORE
+		if (pipeDual) {
+			// a buffer overwritten while copied keeps its slot for the next
+			bool copied = pipeCopy(samples, count, LINK_BLOCK);
+			if (!acqReleaseBuffer() || !copied) {
+				return false;
+			}
+			pipeCommit();
+			return true;
+		}
+	#endif
+
+	PipeBlock block = {samples, count, acqChannels(), LINK_BLOCK};
+	pipeProcess(block);
+	return acqReleaseBuffer();
+}
+
+/**
+ * Passes the frame of the last trigger on as a block
+ *
+ * @param samples frame from trigGetFrame()
+ * @param count samples in the frame
+ *
+ * @return if the block was passed on
+ */
+bool pipeTriggered(const SampleWord *samples, uint16_t count) {
+	bool passed = true;
+	#ifdef PIPE_DUAL_CORE
+		if (pipeDual) {
+			// frames hold still until released, so the copy is whole
+			passed = pipeCopy(samples, count, LINK_TRIGGERED);
+			if (passed) {
+				pipeCommit();
+			}
+			trigReleaseFrame();
+			return passed;
+		}
+	#endif
+
+	PipeBlock block = {samples, count, acqChannels(), LINK_TRIGGERED};
+	pipeProcess(block);
+	trigReleaseFrame();
+	return passed;
+}
+
+/****************************
+ * Pipeline Methods
+****************************/
+
+bool pipelineCheckConfig(const PipeConfig &config) {
+	return config.source <= PIPE_TRIGGERED && config.cores >= 1U && config.cores <= PIPE_CORES;
+}
+
+bool pipelineBegin(const PipeConfig &config) {
+	TRACE_SCOPE("pipelineBegin");
+
+	if (pipeStarted) {
+		LOG_W(LINK, "Pipeline already started");
+		return false;
+	}
+	if (!pipelineCheckConfig(config)) {
+		LOG_E(LINK, "Pipeline config can't run on this board");
+		return false;
+	}
+
+	pipeConfig = config;
+	memset(&pipeStats, 0, sizeof(pipeStats));
+	pipeDual = config.cores == 2U;
+	linkBegin(transportSink);
+
+	#ifdef PIPE_DUAL_CORE
+		if (pipeDual) {
+			pipeFull.reset();
+			pipeFree.reset();
+			pipeHeld = -1;
+			for (uint8_t slot = 0U; slot < PIPE_BLOCKS; slot++) {
+				pipeFree.push(slot);
+			}
+			if (!pipeStartWorker()) {
+				LOG_E(LINK, "Pipeline worker couldn't be started");
+				return false;
+			}
+		}
+	#endif
+
+	pipeStarted = true;
+	return true;
+}
+
+void pipelineEnd(void) {
+	if (!pipeStarted) {
+		return;
+	}
+	#ifdef PIPE_DUAL_CORE
+		if (pipeDual) {
+			pipeStopWorker();
+		}
+	#endif
+	pipeStarted = false;
+}
+
+bool pipelinePoll(void) {
+	if (!pipeStarted) {
+		return false;
+	}
+
+	bool passed = false;
+	const SampleWord *samples;
+	uint16_t count = acqGetBuffer(&samples);
+	if (count != 0U) {
+		unsigned long start = micros();
+		uint32_t processed = pipeStats.processMicros;
+		if (pipeConfig.source == PIPE_STREAM) {
+			passed = pipeStream(samples, count);
+		}
+		else {
+			trigPush(samples, count);
+			acqReleaseBuffer();
+
+			uint32_t position;
+			count = trigGetFrame(&samples, &position);
+			if (count != 0U) {
+				passed = pipeTriggered(samples, count);
+			}
+		}
+
+		// with one core the process stage's time is its own
+		uint32_t elapsed = (uint32_t)(micros() - start);
+		if (!pipeDual) {
+			elapsed -= pipeStats.processMicros - processed;
+		}
+		pipeStats.acquireMicros += elapsed;
+
+		if (passed) {
+			pipeStats.blocks++;
+		}
+		else if (pipeConfig.source == PIPE_STREAM || count != 0U) {
+			pipeStats.dropped++;
+		}
+	}
+
+	if (!pipeDual) {
+		transportPoll();
+	}
+	return passed;
+}
+
+void pipelineGetStats(PipeStats *stats) {
+	*stats = pipeStats;
+}
@@ -0,0 +1,136 @@
+/*
+	pipeline.h - acquisition to transport pipeline over two cores
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <Arduino.h>
+#include "../compile_flags.h"
+#include "../board_traits.h"
+#include "../debug.h"
+
+/****************************
+ * Pipeline
+ *
+ * Blocks go through two stages:
+ * - acquire: acqGetBuffer() and, for triggered frames,
+ *   trigPush(), run by pipelinePoll() from loop()
+ * - process: decReduce(), codecEncode(), the link and
+ *   transportPoll()
+ *
+ * With two cores the process stage runs on the other
+ * core, a task on core 0 beside the radio on the ESP32,
+ * core 1 on the Pico and a thread on the host. Blocks
+ * are copied into one of PIPE_BLOCKS slots, a lock free
+ * ring hands full slots to the process stage and another
+ * hands them back. With one core, or cores set to 1,
+ * pipelinePoll() runs both stages on the block in place.
+ *
+ * The ADC never waits, a block with no free slot is
+ * dropped and counted. Acquisition, the trigger, the
+ * decimation and the transport are started by their own
+ * init or begin before pipelineBegin(), and only the
+ * pipeline may call them until pipelineEnd().
+****************************/
+
+// slots between the stages, a power of two
+#ifndef PIPE_BLOCKS
+#define PIPE_BLOCKS 4U
+#endif
+
+// stack of the process task on the ESP32
+#ifndef PIPE_STACK
+#define PIPE_STACK 4096U
+#endif
+
+// samples in a slot, an acquisition buffer or a trigger frame
+#define PIPE_BLOCK_SAMPLES (ACQ_BUFFER_SAMPLES > TRIG_FRAME_SAMPLES ? ACQ_BUFFER_SAMPLES : TRIG_FRAME_SAMPLES)
+
+static_assert(PIPE_BLOCKS >= 2U && (PIPE_BLOCKS & (PIPE_BLOCKS - 1U)) == 0U,
+	"PIPE_BLOCKS must be a power of two of at least 2");
+
+enum PipeSource : uint8_t {
+	PIPE_STREAM, // every acquisition buffer
+	PIPE_TRIGGERED // trigger frames
+};
+
+/**
+ * What the pipeline sends
+ */
+struct PipeConfig {
+	uint8_t source; // PipeSource
+	bool decimate; // sends points from decReduce()
+	bool coded; // sends codec blocks
+	uint8_t cores; // 2 processes on the other core, 1 in pipelinePoll()
+};
+
+/**
+ * Counts since pipelineBegin(), each written by one stage
+ */
+struct PipeStats {
+	uint32_t blocks; // blocks the acquire stage passed on
+	uint32_t dropped; // blocks with no free slot or overwritten while copied
+	uint32_t frames; // frames the link took
+	uint32_t refused; // frames the transport had no room for
+	uint32_t acquireMicros; // time in the acquire stage with a block
+	uint32_t processMicros; // time in the process stage with a block
+};
+
+/****************************
+ * Pipeline Methods
+****************************/
+
+/**
+ * Checks a config can run on this board
+ *
+ * @param config what to send
+ *
+ * @return if it can run
+ */
+bool pipelineCheckConfig(const PipeConfig &config);
+
+/**
+ * Starts the pipeline, sending through transportSink()
+ *
+ * @param config what to send
+ *
+ * @return if it started, false if it is running or the config can't run
+ */
+bool pipelineBegin(const PipeConfig &config);
+
+/**
+ * Stops the pipeline, blocks waiting in slots are dropped
+ */
+void pipelineEnd(void);
+
+/**
+ * Runs the acquire stage, and the process stage with one
+ * core, call it from loop()
+ *
+ * @return if a block was passed on
+ */
+bool pipelinePoll(void);
+
+/**
+ * Gets the counts since pipelineBegin()
+ *
+ * @param stats set to the counts
+ */
+void pipelineGetStats(PipeStats *stats);
+
+#endif
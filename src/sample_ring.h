@@ -0,0 +1,370 @@
+/*
+	sample_ring.h - single producer single consumer sample ring
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef SAMPLE_RING_H
+#define SAMPLE_RING_H
+
+#include <Arduino.h>
+#include "compile_flags.h"
+#include "board_traits.h"
+
+#if !defined(UNOR3)
+#include <atomic>
+#endif
+
+/****************************
+ * Sample Ring
+ *
+ * Moves samples from one producer, an ADC interrupt or
+ * DMA callback, to one consumer, the processing loop,
+ * without locks. Each side only writes its own index,
+ * so neither waits on the other or turns interrupts off.
+ *
+ * Indexes run freely and are masked on access, which
+ * needs a power of two capacity. The Uno uses byte
+ * indexes, which AVR loads and stores in one go, the
+ * other boards use atomics so the sides can be on
+ * different cores.
+****************************/
+
+/**
+ * Index of a ring, a byte on 8 bit boards so an interrupt
+ * can't see half of it
+ *
+ * @param BITS word size of the board
+ */
+template <uint8_t BITS, bool SMALL = (BITS <= 8U)>
+struct SampleRingIndex {
+	typedef uint32_t type;
+};
+
+template <uint8_t BITS>
+struct SampleRingIndex<BITS, true> {
+	typedef uint8_t type;
+};
+
+#if defined(UNOR3)
+
+/**
+ * Index written by one side and read by the other,
+ * AVR byte accesses can't tear and the core is in order,
+ * so only the compiler has to keep the data first
+ */
+template <typename I>
+struct SampleRingCounter {
+	volatile I value;
+
+	I loadOwn(void) const {
+		return value;
+	}
+
+	I loadOther(void) const {
+		I other = value;
+		__asm__ __volatile__("" ::: "memory");
+		return other;
+	}
+
+	I loadAfterReads(void) const {
+		__asm__ __volatile__("" ::: "memory");
+		return value;
+	}
+
+	void publish(I next) {
+		__asm__ __volatile__("" ::: "memory");
+		value = next;
+	}
+};
+
+#else
+
+/**
+ * Index written by one side and read by the other,
+ * publishing releases the samples before it and reading
+ * the other side's index acquires them
+ */
+template <typename I>
+struct SampleRingCounter {
+	std::atomic<I> value;
+
+	I loadOwn(void) const {
+		return value.load(std::memory_order_relaxed);
+	}
+
+	I loadOther(void) const {
+		return value.load(std::memory_order_acquire);
+	}
+
+	// checks data read before it wasn't overwritten, like a seqlock
+	I loadAfterReads(void) const {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return value.load(std::memory_order_relaxed);
+	}
+
+	void publish(I next) {
+		value.store(next, std::memory_order_release);
+	}
+};
+
+#endif
+
+// keeps the producer and consumer indexes on their own cache lines
+#if defined(HOSTLINUX)
+#define SAMPLE_RING_ALIGN 64U
+#else
+#define SAMPLE_RING_ALIGN 4U
+#endif
+
+/**
+ * Lock free ring of samples for one producer and one
+ * consumer. Producer methods may only be called from
+ * the producer and consumer methods from the consumer,
+ * reset() only while neither runs.
+ *
+ * @param T type of one sample
+ * @param CAPACITY samples held, a power of two
+ */
+template <typename T, uint32_t CAPACITY>
+class SampleRing {
+	public:
+		typedef typename SampleRingIndex<Board::wordBits>::type Index;
+
+		static_assert(CAPACITY != 0U && (CAPACITY & (CAPACITY - 1U)) == 0U,
+			"SampleRing capacity must be a power of two");
+		static_assert(CAPACITY <= ((uint32_t)(Index)~(Index)0 >> 1) + 1U,
+			"SampleRing capacity must fit half the index range");
+
+		SampleRing(void) {
+			reset();
+		}
+
+		/**
+		 * Empties the ring, neither side may be running
+		 */
+		void reset(void) {
+			head.publish(0U);
+			tail.publish(0U);
+			headCache = 0U;
+			tailCache = 0U;
+		}
+
+		static constexpr uint32_t capacity(void) {
+			return CAPACITY;
+		}
+
+		/****************************
+		 * Producer
+		****************************/
+
+		/**
+		 * Adds a sample
+		 *
+		 * @param value sample to add
+		 *
+		 * @return if there was room, the sample is dropped if not
+		 */
+		bool push(const T &value) {
+			Index position = head.loadOwn();
+			if ((Index)(position - tailCache) == (Index)CAPACITY) {
+				tailCache = tail.loadOther();
+				if ((Index)(position - tailCache) == (Index)CAPACITY) {
+					return false;
+				}
+			}
+
+			samples[position & MASK] = value;
+			head.publish((Index)(position + 1U));
+			return true;
+		}
+
+		/**
+		 * Adds as many samples as fit
+		 *
+		 * @param values samples to add
+		 * @param count number of samples
+		 *
+		 * @return number of samples added, from the front of values
+		 */
+		Index pushN(const T *values, Index count) {
+			T *span;
+			Index added = 0U;
+
+			// at most two spans, the end of the buffer then its start
+			while (added < count) {
+				Index room = reserveContiguous(&span);
+				if (room == 0U) {
+					break;
+				}
+				if (room > count - added) {
+					room = count - added;
+				}
+				memcpy(span, &values[added], room * sizeof(T));
+				commit(room);
+				added += room;
+			}
+			return added;
+		}
+
+		/**
+		 * Gets free space that can be written in place, a DMA
+		 * transfer or ADC read can fill it before commit()
+		 *
+		 * @param span set to the first free sample
+		 *
+		 * @return free samples after span without wrapping
+		 */
+		Index reserveContiguous(T **span) {
+			Index position = head.loadOwn();
+			tailCache = tail.loadOther();
+
+			Index room = (Index)(CAPACITY - (Index)(position - tailCache));
+			Index toEnd = (Index)(CAPACITY - (position & MASK));
+			*span = &samples[position & MASK];
+			return room < toEnd ? room : toEnd;
+		}
+
+		/**
+		 * Hands samples written after reserveContiguous() to
+		 * the consumer
+		 *
+		 * @param count samples written, at most the span reserved
+		 */
+		void commit(Index count) {
+			head.publish((Index)(head.loadOwn() + count));
+		}
+
+		/**
+		 * Gets free space as seen by the producer
+		 *
+		 * @return samples that can be pushed
+		 */
+		Index available(void) {
+			tailCache = tail.loadOther();
+			return (Index)(CAPACITY - (Index)(head.loadOwn() - tailCache));
+		}
+
+		/****************************
+		 * Consumer
+		****************************/
+
+		/**
+		 * Takes the oldest sample
+		 *
+		 * @param value set to the sample
+		 *
+		 * @return if there was a sample
+		 */
+		bool pop(T *value) {
+			Index position = tail.loadOwn();
+			if (position == headCache) {
+				headCache = head.loadOther();
+				if (position == headCache) {
+					return false;
+				}
+			}
+
+			*value = samples[position & MASK];
+			tail.publish((Index)(position + 1U));
+			return true;
+		}
+
+		/**
+		 * Takes up to count of the oldest samples
+		 *
+		 * @param values buffer of count samples
+		 * @param count most samples to take
+		 *
+		 * @return number of samples taken
+		 */
+		Index popN(T *values, Index count) {
+			const T *span;
+			Index taken = 0U;
+
+			while (taken < count) {
+				Index ready = peekContiguous(&span);
+				if (ready == 0U) {
+					break;
+				}
+				if (ready > count - taken) {
+					ready = count - taken;
+				}
+				memcpy(&values[taken], span, ready * sizeof(T));
+				consume(ready);
+				taken += ready;
+			}
+			return taken;
+		}
+
+		/**
+		 * Gets the oldest samples in place, they stay in the
+		 * ring until consume()
+		 *
+		 * @param span set to the oldest sample
+		 *
+		 * @return samples after span without wrapping
+		 */
+		Index peekContiguous(const T **span) {
+			Index position = tail.loadOwn();
+			headCache = head.loadOther();
+
+			Index ready = (Index)(headCache - position);
+			Index toEnd = (Index)(CAPACITY - (position & MASK));
+			*span = &samples[position & MASK];
+			return ready < toEnd ? ready : toEnd;
+		}
+
+		/**
+		 * Frees samples read with peekContiguous()
+		 *
+		 * @param count samples read, at most the span peeked
+		 */
+		void consume(Index count) {
+			tail.publish((Index)(tail.loadOwn() + count));
+		}
+
+		/**
+		 * Gets samples waiting as seen by the consumer
+		 *
+		 * @return samples that can be taken
+		 */
+		Index size(void) {
+			headCache = head.loadOther();
+			return (Index)(headCache - tail.loadOwn());
+		}
+
+		bool empty(void) {
+			return size() == 0U;
+		}
+
+	private:
+		static constexpr Index MASK = (Index)(CAPACITY - 1U);
+
+		// producer side
+		alignas(SAMPLE_RING_ALIGN) SampleRingCounter<Index> head;
+		Index tailCache;
+
+		// consumer side
+		alignas(SAMPLE_RING_ALIGN) SampleRingCounter<Index> tail;
+		Index headCache;
+
+		alignas(SAMPLE_RING_ALIGN) T samples[CAPACITY];
+};
+
+// ring of raw ADC samples sized for the board
+typedef SampleRing<SampleWord, SAMPLE_RING_SIZE> BoardSampleRing;
+
+#endif
@@ -0,0 +1,167 @@
+/*
+	trace.cpp - scoped timing trace of hot paths
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "trace.h"
+#include "critical.h"
+
+#ifdef DEBUG_TRACE
+
+#if defined(HOSTLINUX)
+#include <atomic>
+#include <chrono>
+#elif defined(ESP32DEVC)
+#include <esp_timer.h>
+#elif defined(PICO)
+#include <hardware/timer.h>
+#include <pico/platform.h>
+#endif
+
+static_assert((TRACE_EVENTS & (TRACE_EVENTS - 1U)) == 0U, "TRACE_EVENTS must be a power of two");
+static_assert(TRACE_EVENTS <= 32768UL, "TRACE_EVENTS must fit the 16 bit ring index");
+
+TraceEvent traceEvents[TRACE_EVENTS];
+
+// events recorded since start or traceClear(), the ring holds the newest
+volatile uint32_t traceCount = 0U;
+volatile bool tracePaused = false;
+
+#if defined(HOSTLINUX)
+std::atomic<uint8_t> traceTracks(0U);
+thread_local uint8_t traceTrack = 0xFFU;
+#endif
+
+/**
+ * Reads the trace clock, one clock for every track as the
+ * ESP32 cycle counters of the two cores aren't in step
+ * 
+ * @return ticks, wrapping at 32 bits
+ */
+inline uint32_t traceClock(void) {
+	#if defined(ESP32DEVC)
+		return (uint32_t)esp_timer_get_time();
+	#elif defined(PICO)
+		return time_us_32();
+	#elif defined(HOSTLINUX)
+		return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	#else
+		return (uint32_t)micros();
+	#endif
+}
+
+/**
+ * Gets the clock rate for the dump header
+ * 
+ * @return ticks per millisecond
+ */
+uint32_t traceTicksPerMilli(void) {
+	#if defined(HOSTLINUX)
+		return 1000000UL;
+	#else
+		return 1000UL;
+	#endif
+}
+
+/**
+ * Gets the track of the caller, the core on ESP32 and
+ * Pico and the thread on the host
+ * 
+ * @return track id
+ */
+inline uint8_t traceCurrentTrack(void) {
+	#if defined(ESP32DEVC)
+		return (uint8_t)xPortGetCoreID();
+	#elif defined(PICO)
+		return (uint8_t)get_core_num();
+	#elif defined(HOSTLINUX)
+		if (traceTrack == 0xFFU) {
+			traceTrack = traceTracks++;
+		}
+		return traceTrack;
+	#else
+		return 0U;
+	#endif
+}
+
+void traceRecord(uint16_t site, uint8_t phase) {
+	uint8_t track = traceCurrentTrack();
+	CriticalSection critical;
+
+	if (tracePaused) {
+		return;
+	}
+
+	// time is read inside so events stay in order
+	TraceEvent *event = &traceEvents[traceCount & (TRACE_EVENTS - 1U)];
+	event->time = traceClock();
+	event->site = site;
+	event->phase = phase;
+	event->track = track;
+	traceCount++;
+}
+
+/**
+ * Writes a little endian value to Serial
+ * 
+ * @param value value to write
+ * @param size bytes of the value
+ */
+void traceWriteValue(uint32_t value, uint8_t size) {
+	for (uint8_t i = 0U; i < size; i++) {
+		Serial.write((uint8_t)(value >> (8U * i)));
+	}
+}
+
+void traceDump(void) {
+	uint32_t count;
+	{
+		CriticalSection critical;
+		tracePaused = true;
+		count = traceCount;
+	}
+
+	uint16_t events = count > TRACE_EVENTS ? TRACE_EVENTS : (uint16_t)count;
+	uint32_t first = count - events;
+
+	// log lines queued before the dump go out first
+	debugFlush();
+
+	Serial.write((const uint8_t*)TRACE_DUMP_MAGIC, 4U);
+	traceWriteValue(traceTicksPerMilli(), 4U);
+	traceWriteValue(count, 4U);
+	traceWriteValue(events, 2U);
+
+	for (uint32_t i = first; i < count; i++) {
+		const TraceEvent *event = &traceEvents[i & (TRACE_EVENTS - 1U)];
+		traceWriteValue(event->time, 4U);
+		traceWriteValue(event->site, 2U);
+		traceWriteValue(event->phase, 1U);
+		traceWriteValue(event->track, 1U);
+	}
+	Serial.flush();
+
+	CriticalSection critical;
+	tracePaused = false;
+}
+
+void traceClear(void) {
+	CriticalSection critical;
+	traceCount = 0U;
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*
+	trace.h - scoped timing trace of hot paths
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include "compile_flags.h"
+#include "debug.h"
+
+/****************************
+ * Trace Scopes
+ * 
+ * With DEBUG_TRACE, TRACE_SCOPE("name") records a begin
+ * event where it is declared and an end event when the
+ * scope exits. Events are 8 bytes in a ring of TRACE_EVENTS
+ * that overwrites the oldest, traceDump() sends it and
+ * extras/tools/trace_to_chrome.py turns the dump into a
+ * Chrome / Perfetto trace. Without DEBUG_TRACE the macros
+ * are empty.
+ * 
+ * Timestamps are micros() on the Uno, esp_timer on ESP32
+ * (the cycle counters of its cores aren't in step), the
+ * 1 MHz timer on Pico (the M0+ has no cycle counter) and
+ * steady_clock on the host.
+****************************/
+
+// event kinds
+#define TRACE_BEGIN 'B'
+#define TRACE_END 'E'
+
+// start of a dump, followed by the header and events
+#define TRACE_DUMP_MAGIC "TRC1"
+
+/**
+ * Folds the hash of a trace name to a 16 bit site id
+ * 
+ * @param hash debugHash() of "trace|" and the name
+ * 
+ * @return id of the site
+ */
+constexpr uint16_t traceSite(uint32_t hash) {
+	return (uint16_t)(hash ^ (hash >> 16));
+}
+
+#ifdef DEBUG_TRACE
+
+/**
+ * One begin or end event
+ */
+struct TraceEvent {
+	uint32_t time;
+	uint16_t site;
+	uint8_t phase;
+	uint8_t track;
+};
+
+/**
+ * Records an event, safe from interrupts
+ * 
+ * @param site id of the site
+ * @param phase TRACE_BEGIN or TRACE_END
+ */
+void traceRecord(uint16_t site, uint8_t phase);
+
+/**
+ * Sends the recorded events to Serial, waiting on it.
+ * Recording pauses during the dump
+ */
+void traceDump(void);
+
+/**
+ * Drops all recorded events
+ */
+void traceClear(void);
+
+/**
+ * Records the begin and end of a scope
+ */
+struct TraceScope {
+	TraceScope(uint16_t site) : site(site) {
+		traceRecord(site, TRACE_BEGIN);
+	}
+
+	~TraceScope(void) {
+		traceRecord(site, TRACE_END);
+	}
+
+	uint16_t site;
+};
+
+#define TRACE_ID(name) traceSite(DebugToken<debugHash("trace|" name)>::value)
+#define TRACE_JOIN(left, right) left##right
+#define TRACE_VAR(line) TRACE_JOIN(traceScope, line)
+
+#define TRACE_SCOPE(name) TraceScope TRACE_VAR(__LINE__)(TRACE_ID(name))
+#define TRACE_BEGIN_SITE(name) traceRecord(TRACE_ID(name), TRACE_BEGIN)
+#define TRACE_END_SITE(name) traceRecord(TRACE_ID(name), TRACE_END)
+
+#else
+
+inline void traceDump(void) {}
+
+inline void traceClear(void) {}
+
+#define TRACE_SCOPE(name)
+#define TRACE_BEGIN_SITE(name)
+#define TRACE_END_SITE(name)
+
+#endif
+
+#endif
@@ -0,0 +1,257 @@
+/*
+	transport.cpp - batched link transports over Serial, WiFi and BLE
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "transport.h"
+
+uint8_t transportBatches[2][TRANSPORT_BATCH_SIZE];
+uint8_t transportFilling = 0U; // batch frames are copied to
+uint16_t transportFillSize = 0U;
+uint16_t transportDrainSize = 0U; // bytes of the other batch, 0 once sent
+uint16_t transportDrained = 0U;
+
+const TransportBackend *transportActive = NULL;
+TransportStats transportStatCounts;
+
+/**
+ * Gets the backend of a medium
+ *
+ * @param medium TransportMedium
+ *
+ * @return backend, NULL if the board doesn't have the medium
+ */
+const TransportBackend *transportFind(uint8_t medium) {
+	switch (medium) {
+		case TRANSPORT_SERIAL:
+			return &transportSerialBackend;
+		#ifdef TRANSPORT_WIFI
+		case TRANSPORT_UDP:
+			return &transportUdpBackend;
+		#endif
+		#ifdef TRANSPORT_BLUETOOTH
+		case TRANSPORT_BLE:
+			return &transportBleBackend;
+		#endif
+		#ifdef HOSTLINUX
+		case TRANSPORT_LOOPBACK:
+			return &transportLoopbackBackend;
+		#endif
+		default:
+			return NULL;
+	}
+}
+
+/**
+ * Hands the filled batch over to be sent, the other
+ * batch must be sent already
+ */
+void transportSwap(void) {
+	transportDrainSize = transportFillSize;
+	transportDrained = 0U;
+	transportFilling ^= 1U;
+	transportFillSize = 0U;
+	transportStatCounts.batches++;
+}
+
+/**
+ * Copies bytes into the batches, transportReady() must
+ * have found room for them
+ *
+ * @param data bytes to copy
+ * @param size number of bytes
+ */
+void transportAppend(const uint8_t *data, uint16_t size) {
+	while (size != 0U) {
+		if (transportFillSize == TRANSPORT_BATCH_SIZE) {
+			transportSwap();
+		}
+		uint16_t room = (uint16_t)(TRANSPORT_BATCH_SIZE - transportFillSize);
+		uint16_t length = size < room ? size : room;
+		memcpy(&transportBatches[transportFilling][transportFillSize], data, length);
+		transportFillSize = (uint16_t)(transportFillSize + length);
+		data += length;
+		size = (uint16_t)(size - length);
+	}
+}
+
+/****************************
+ * Transport Methods
+****************************/
+
+bool transportCheckConfig(const TransportConfig &config) {
+	if (transportFind(config.medium) == NULL) {
+		return false;
+	}
+	switch (config.medium) {
+		case TRANSPORT_SERIAL:
+			return config.baud != 0UL;
+		case TRANSPORT_UDP:
+			return config.port != 0U;
+		default:
+			return true;
+	}
+}
+
+bool transportLoadConfig(TransportConfig *config) {
+	TransportConfig stored;
+	if (nvmGetField<NVMLinkMediumField>(&stored.medium) &&
+		nvmGetField<NVMLinkBaudField>(&stored.baud) &&
+		nvmGetField<NVMLinkAddressField>(&stored.address) &&
+		nvmGetField<NVMLinkPortField>(&stored.port) &&
+		transportCheckConfig(stored)) {
+
+		// credentials are stored on their own, serial needs none
+		if (!nvmGetFieldString<NVMSsidField>(stored.ssid)) {
+			stored.ssid[0] = '\0';
+		}
+		if (!nvmGetFieldString<NVMPassField>(stored.pass)) {
+			stored.pass[0] = '\0';
+		}
+		*config = stored;
+		return true;
+	}
+
+	config->medium = TRANSPORT_DEFAULT_MEDIUM;
+	config->baud = TRANSPORT_DEFAULT_BAUD;
+	config->address = TRANSPORT_DEFAULT_ADDRESS;
+	config->port = TRANSPORT_DEFAULT_PORT;
+	config->ssid[0] = '\0';
+	config->pass[0] = '\0';
+	return false;
+}
+
+bool transportInit(void) {
+	TransportConfig config;
+	if (!transportLoadConfig(&config)) {
+		LOG_I(LINK, "No stored transport, using defaults");
+	}
+	return transportBegin(config);
+}
+
+bool transportBegin(const TransportConfig &config) {
+	if (!transportCheckConfig(config)) {
+		LOG_E(LINK, "Can't open medium {}", config.medium);
+		return false;
+	}
+
+	transportEnd();
+	const TransportBackend *backend = transportFind(config.medium);
+	if (!backend->open(config)) {
+		LOG_E(LINK, "Medium {} didn't open", config.medium);
+		return false;
+	}
+
+	transportFilling = 0U;
+	transportFillSize = 0U;
+	transportDrainSize = 0U;
+	transportDrained = 0U;
+	memset(&transportStatCounts, 0, sizeof(transportStatCounts));
+	transportActive = backend;
+
+	nvmWriteField<NVMLinkMediumField>(config.medium);
+	nvmWriteField<NVMLinkBaudField>(config.baud);
+	nvmWriteField<NVMLinkAddressField>(config.address);
+	nvmWriteField<NVMLinkPortField>(config.port);
+
+	// other mediums don't carry credentials, the stored network stays
+	if (config.medium == TRANSPORT_UDP) {
+		nvmWriteFieldString<NVMSsidField>(config.ssid);
+		nvmWriteFieldString<NVMPassField>(config.pass);
+	}
+
+	LOG_I(LINK, "Opened medium {}", config.medium);
+	return true;
+}
+
+void transportEnd(void) {
+	if (transportActive == NULL) {
+		return;
+	}
+	transportActive->close();
+	transportActive = NULL;
+}
+
+bool transportSink(const LinkSpan *spans, uint8_t count) {
+	uint32_t size = 0UL;
+	for (uint8_t i = 0U; i < count; i++) {
+		size += spans[i].size;
+	}
+	if (!transportReady(size)) {
+		transportStatCounts.refused++;
+		return false;
+	}
+	for (uint8_t i = 0U; i < count; i++) {
+		transportAppend(spans[i].data, spans[i].size);
+	}
+	return true;
+}
+
+uint16_t transportPoll(void) {
+	if (transportActive == NULL) {
+		return 0U;
+	}
+	if (transportDrainSize == 0U && transportFillSize != 0U) {
+		transportSwap();
+	}
+
+	// the medium fills its own buffers, writes stop once it's full
+	const uint8_t *batch = transportBatches[transportFilling ^ 1U];
+	uint16_t sent = 0U;
+	while (transportDrained < transportDrainSize) {
+		uint16_t size = (uint16_t)(transportDrainSize - transportDrained);
+		size = size < transportActive->mtu ? size : transportActive->mtu;
+		uint16_t written = transportActive->write(&batch[transportDrained], size);
+		if (written == 0U) {
+			transportStatCounts.stalls++;
+			break;
+		}
+		transportStatCounts.writes++;
+		transportDrained = (uint16_t)(transportDrained + written);
+		sent = (uint16_t)(sent + written);
+
+		if (transportDrained == transportDrainSize) {
+			transportDrainSize = 0U;
+			transportDrained = 0U;
+			if (transportFillSize != 0U) {
+				transportSwap();
+				batch = transportBatches[transportFilling ^ 1U];
+			}
+		}
+	}
+	transportStatCounts.bytes += sent;
+	return sent;
+}
+
+uint32_t transportPending(void) {
+	return (uint32_t)transportFillSize + transportDrainSize - transportDrained;
+}
+
+bool transportReady(uint32_t size) {
+	if (transportActive == NULL) {
+		return false;
+	}
+	// a free batch is filled on from the one filling
+	uint32_t room = (uint32_t)(TRANSPORT_BATCH_SIZE - transportFillSize);
+	if (transportDrainSize == 0U) {
+		room += TRANSPORT_BATCH_SIZE;
+	}
+	return size <= room;
+}
+
+void transportGetStats(TransportStats *stats) {
+	*stats = transportStatCounts;
+}
@@ -0,0 +1,252 @@
+/*
+	transport.h - batched link transports over Serial, WiFi and BLE
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <Arduino.h>
+#include "../compile_flags.h"
+#include "../board_traits.h"
+#include "../debug.h"
+#include "../link/link_frame.h"
+#include "../nvm/eeprom_addresses.h"
+
+/****************************
+ * Transport
+ *
+ * Link frames handed to transportSink() are copied into
+ * one of two batches of TRANSPORT_BATCH_SIZE bytes while
+ * the other is sent, so a frame costs one copy and no
+ * wait. transportPoll() swaps in the filled batch once
+ * the last one is sent and writes it to the medium in
+ * writes of up to the medium's MTU, as much as the
+ * medium takes without blocking.
+ *
+ * A frame that doesn't fit the free batch space is
+ * refused whole, which the link counts, so a slow medium
+ * drops frames instead of holding up the loop. Frames run
+ * on from one batch into the next, so a frame can be up
+ * to twice TRANSPORT_BATCH_SIZE.
+ *
+ * One medium is open at a time. Serial is shared with
+ * debug output, so build without logs when streaming
+ * over it or the two interleave.
+****************************/
+
+// medium used when none is stored
+#ifndef TRANSPORT_DEFAULT_MEDIUM
+#define TRANSPORT_DEFAULT_MEDIUM TRANSPORT_SERIAL
+#endif
+
+#ifndef TRANSPORT_DEFAULT_BAUD
+#define TRANSPORT_DEFAULT_BAUD 115200UL
+#endif
+
+// UDP frames are broadcast on the network by default
+#ifndef TRANSPORT_DEFAULT_ADDRESS
+#define TRANSPORT_DEFAULT_ADDRESS 0xFFFFFFFFUL
+#endif
+
+#ifndef TRANSPORT_DEFAULT_PORT
+#define TRANSPORT_DEFAULT_PORT 5210U
+#endif
+
+// name the board advertises over BLE
+#ifndef TRANSPORT_BLE_NAME
+#define TRANSPORT_BLE_NAME "MC Oscilloscope"
+#endif
+
+// bytes a write may send, the UART FIFO or a USB packet, a datagram and a BLE notification
+#define TRANSPORT_SERIAL_MTU 64U
+#define TRANSPORT_UDP_MTU 1472U
+#define TRANSPORT_BLE_MTU 244U
+
+static_assert(2UL * TRANSPORT_BATCH_SIZE >= LINK_HEADER_SIZE + Board::triggerFrameSamples * sizeof(SampleWord) + LINK_CRC_SIZE,
+	"Transport batches must hold a trigger frame with its link header");
+
+enum TransportMedium : uint8_t {
+	TRANSPORT_SERIAL, // USB serial, a pty on the host
+	TRANSPORT_UDP, // datagrams over WiFi, a socket on the host
+	TRANSPORT_BLE, // notifications of the Nordic UART service
+	TRANSPORT_LOOPBACK, // host only, bytes read back by transportHostRead()
+	TRANSPORT_MEDIA
+};
+
+/**
+ * Medium and its connection, unused fields are ignored
+ */
+struct TransportConfig {
+	uint8_t medium; // TransportMedium
+	uint32_t baud; // serial
+	uint32_t address; // IPv4 address for UDP, first octet in the low byte
+	uint16_t port; // UDP port
+	char ssid[SSID_STRING_SIZE]; // WiFi network joined for UDP
+	char pass[PASS_STRING_SIZE];
+};
+
+/**
+ * Counts since transportBegin()
+ */
+struct TransportStats {
+	uint32_t bytes; // bytes the medium took
+	uint32_t writes; // writes to the medium
+	uint32_t batches; // batches swapped in to send
+	uint32_t refused; // frames refused for lack of room
+	uint32_t stalls; // polls the medium took nothing while bytes waited
+};
+
+/**
+ * A medium, each write sends what it can without blocking
+ */
+struct TransportBackend {
+	uint16_t mtu; // most bytes a write sends
+
+	/**
+	 * Opens the medium, a connection may still be made after
+	 *
+	 * @param config medium and connection
+	 *
+	 * @return if the medium started
+	 */
+	bool (*open)(const TransportConfig &config);
+
+	/**
+	 * Closes the medium
+	 */
+	void (*close)(void);
+
+	/**
+	 * Sends bytes
+	 *
+	 * @param data bytes to send
+	 * @param size number of bytes, at most mtu
+	 *
+	 * @return bytes taken from the front of data, 0 while busy or not connected
+	 */
+	uint16_t (*write)(const uint8_t *data, uint16_t size);
+};
+
+/****************************
+ * Transport Methods
+****************************/
+
+/**
+ * Checks a config can be opened on this board
+ *
+ * @param config medium and connection
+ *
+ * @return if the medium exists and its connection is set
+ */
+bool transportCheckConfig(const TransportConfig &config);
+
+/**
+ * Gets the config stored by the last transportBegin(),
+ * or the defaults if none was stored
+ *
+ * @param config set to the stored config or the defaults
+ *
+ * @return if a valid config was stored
+ */
+bool transportLoadConfig(TransportConfig *config);
+
+/**
+ * Opens the medium stored by the last transportBegin(),
+ * or the defaults
+ *
+ * @return if the medium opened
+ */
+bool transportInit(void);
+
+/**
+ * Opens a medium in place of the open one and stores the
+ * config for the next transportInit(), nvmFlush() makes
+ * it persist. WiFi credentials are only stored by UDP
+ *
+ * @param config medium and connection
+ *
+ * @return if the medium opened
+ */
+bool transportBegin(const TransportConfig &config);
+
+/**
+ * Closes the medium, bytes not sent are dropped
+ */
+void transportEnd(void);
+
+/**
+ * Queues a frame, pass it to linkBegin()
+ *
+ * @param spans parts of the frame in order
+ * @param count number of spans
+ *
+ * @return if the frame fit, false and nothing queued if not
+ */
+bool transportSink(const LinkSpan *spans, uint8_t count);
+
+/**
+ * Sends queued bytes the medium takes without blocking,
+ * call it from loop() or other idle time
+ *
+ * @return bytes sent
+ */
+uint16_t transportPoll(void);
+
+/**
+ * Gets bytes queued and not yet sent
+ *
+ * @return bytes in both batches
+ */
+uint32_t transportPending(void);
+
+/**
+ * Gets if a frame would be taken now
+ *
+ * @param size bytes of the frame
+ *
+ * @return if there is room for it
+ */
+bool transportReady(uint32_t size);
+
+/**
+ * Gets the counts since transportBegin()
+ *
+ * @param stats set to the counts
+ */
+void transportGetStats(TransportStats *stats);
+
+/****************************
+ * Backends
+ *
+ * Defined by the board's transport files
+****************************/
+
+extern const TransportBackend transportSerialBackend;
+
+#ifdef TRANSPORT_WIFI
+extern const TransportBackend transportUdpBackend;
+#endif
+
+#ifdef TRANSPORT_BLUETOOTH
+extern const TransportBackend transportBleBackend;
+#endif
+
+#ifdef HOSTLINUX
+extern const TransportBackend transportLoopbackBackend;
+#endif
+
+#endif
@@ -0,0 +1,170 @@
+/*
+	transport_esp32.cpp - link transports over ESP32 WiFi and BLE
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "transport.h"
+
+#if defined(ESP32DEVC)
+
+#include <WiFi.h>
+#include <WiFiUdp.h>
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <BLE2902.h>
+
+/****************************
+ * ESP32 Transports
+ *
+ * UDP joins the stored network and sends each write as
+ * one datagram, nothing is sent until the station is
+ * connected. lwIP refusing a datagram for lack of buffers
+ * holds the batch back until the next poll.
+ *
+ * BLE advertises the Nordic UART service and sends each
+ * write as one notification on its TX characteristic, cut
+ * to the MTU the central agreed to.
+****************************/
+
+#define ESP_NUS_SERVICE "6E400001-B5A3-F393-E0A9-E50E24DCCA9E"
+#define ESP_NUS_TX "6E400003-B5A3-F393-E0A9-E50E24DCCA9E"
+
+// ATT header bytes in a notification
+#define ESP_ATT_HEADER 3U
+
+WiFiUDP espUdp;
+IPAddress espUdpAddress;
+uint16_t espUdpPort = 0U;
+
+BLEServer *espBleServer = NULL;
+BLECharacteristic *espBleTx = NULL;
+volatile bool espBleConnected = false;
+volatile uint16_t espBleMtu = 20U;
+
+/**
+ * Follows the central connecting and leaving
+ */
+class EspBleCallbacks : public BLEServerCallbacks {
+	void onConnect(BLEServer *server, esp_ble_gatts_cb_param_t *param) {
+		uint16_t mtu = (uint16_t)(server->getPeerMTU(param->connect.conn_id) - ESP_ATT_HEADER);
+		espBleMtu = mtu < TRANSPORT_BLE_MTU ? mtu : (uint16_t)TRANSPORT_BLE_MTU;
+		espBleConnected = true;
+	}
+
+	void onDisconnect(BLEServer *server) {
+		espBleConnected = false;
+		server->startAdvertising();
+	}
+};
+
+EspBleCallbacks espBleCallbacks;
+
+/****************************
+ * UDP
+****************************/
+
+/**
+ * Starts joining the network, writes wait for it
+ */
+bool transportUdpOpen(const TransportConfig &config) {
+	if (config.ssid[0] == '\0') {
+		LOG_E(LINK, "No WiFi network stored");
+		return false;
+	}
+	espUdpAddress = IPAddress(config.address);
+	espUdpPort = config.port;
+
+	WiFi.mode(WIFI_STA);
+	WiFi.setSleep(false);
+	WiFi.begin(config.ssid, config.pass);
+	return espUdp.begin(config.port) == 1;
+}
+
+void transportUdpClose(void) {
+	espUdp.stop();
+	WiFi.disconnect(true);
+}
+
+/**
+ * Sends one datagram once connected
+ */
+uint16_t transportUdpWrite(const uint8_t *data, uint16_t size) {
+	if (WiFi.status() != WL_CONNECTED || espUdp.beginPacket(espUdpAddress, espUdpPort) != 1) {
+		return 0U;
+	}
+	espUdp.write(data, size);
+	return espUdp.endPacket() == 1 ? size : 0U;
+}
+
+const TransportBackend transportUdpBackend = {
+	TRANSPORT_UDP_MTU,
+	transportUdpOpen,
+	transportUdpClose,
+	transportUdpWrite
+};
+
+/****************************
+ * BLE
+****************************/
+
+/**
+ * Starts advertising the UART service
+ */
+bool transportBleOpen(const TransportConfig &config) {
+	BLEDevice::init(TRANSPORT_BLE_NAME);
+	BLEDevice::setMTU(TRANSPORT_BLE_MTU + ESP_ATT_HEADER);
+
+	espBleServer = BLEDevice::createServer();
+	espBleServer->setCallbacks(&espBleCallbacks);
+	BLEService *service = espBleServer->createService(ESP_NUS_SERVICE);
+	espBleTx = service->createCharacteristic(ESP_NUS_TX, BLECharacteristic::PROPERTY_NOTIFY);
+	espBleTx->addDescriptor(new BLE2902());
+	service->start();
+
+	BLEAdvertising *advertising = BLEDevice::getAdvertising();
+	advertising->addServiceUUID(ESP_NUS_SERVICE);
+	advertising->start();
+	return true;
+}
+
+void transportBleClose(void) {
+	espBleConnected = false;
+	BLEDevice::deinit(false);
+	espBleServer = NULL;
+	espBleTx = NULL;
+}
+
+/**
+ * Sends one notification once a central connects
+ */
+uint16_t transportBleWrite(const uint8_t *data, uint16_t size) {
+	if (!espBleConnected) {
+		return 0U;
+	}
+	uint16_t length = size < espBleMtu ? size : espBleMtu;
+	espBleTx->setValue((uint8_t*)data, length);
+	espBleTx->notify();
+	return length;
+}
+
+const TransportBackend transportBleBackend = {
+	TRANSPORT_BLE_MTU,
+	transportBleOpen,
+	transportBleClose,
+	transportBleWrite
+};
+
+#endif
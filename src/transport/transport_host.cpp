@@ -0,0 +1,197 @@
+/*
+	transport_host.cpp - host stand-ins for the link transports
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "transport_host.h"
+
+#ifdef HOSTLINUX
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "../sample_ring.h"
+
+int transportHostPty = -1;
+int transportHostPtyPeer = -1; // held open so writes don't fail with no reader
+char transportHostPtyPath[64];
+uint64_t transportHostCredit = 0U; // bytes times a million the pty may take
+uint32_t transportHostRate = 0UL; // bytes per second
+unsigned long transportHostLast = 0UL;
+
+int transportHostSocket = -1;
+struct sockaddr_in transportHostTarget;
+
+SampleRing<uint8_t, TRANSPORT_LOOPBACK_SIZE> transportHostRing;
+
+/****************************
+ * Serial
+****************************/
+
+/**
+ * Opens a raw pty
+ */
+bool transportHostPtyOpen(const TransportConfig &config) {
+	transportHostPty = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+	if (transportHostPty < 0 || grantpt(transportHostPty) != 0 || unlockpt(transportHostPty) != 0 ||
+		ptsname_r(transportHostPty, transportHostPtyPath, sizeof(transportHostPtyPath)) != 0) {
+
+		LOG_E(LINK, "pty didn't open");
+		if (transportHostPty >= 0) {
+			close(transportHostPty);
+			transportHostPty = -1;
+		}
+		return false;
+	}
+
+	// bytes pass through untouched, no echo or line editing
+	transportHostPtyPeer = open(transportHostPtyPath, O_RDWR | O_NOCTTY | O_NONBLOCK);
+	struct termios settings;
+	if (transportHostPtyPeer >= 0 && tcgetattr(transportHostPtyPeer, &settings) == 0) {
+		cfmakeraw(&settings);
+		tcsetattr(transportHostPtyPeer, TCSANOW, &settings);
+	}
+
+	// start bits and stop bits, as a UART sends
+	transportHostRate = config.baud / 10UL;
+	transportHostCredit = 0U;
+	transportHostLast = micros();
+	return true;
+}
+
+void transportHostPtyClose(void) {
+	if (transportHostPtyPeer >= 0) {
+		close(transportHostPtyPeer);
+		transportHostPtyPeer = -1;
+	}
+	close(transportHostPty);
+	transportHostPty = -1;
+}
+
+/**
+ * Writes what the baud allows since the last write, up
+ * to a UART FIFO of bytes
+ */
+uint16_t transportHostPtyWrite(const uint8_t *data, uint16_t size) {
+	unsigned long now = micros();
+	transportHostCredit += (uint64_t)(now - transportHostLast) * transportHostRate;
+	transportHostLast = now;
+	if (transportHostCredit > (uint64_t)TRANSPORT_SERIAL_MTU * 1000000U) {
+		transportHostCredit = (uint64_t)TRANSPORT_SERIAL_MTU * 1000000U;
+	}
+
+	// like a board's Serial, waits for a whole write or half the FIFO
+	uint16_t length = (uint16_t)(transportHostCredit / 1000000U);
+	if (length < size && length < TRANSPORT_SERIAL_MTU / 2U) {
+		return 0U;
+	}
+	length = length < size ? length : size;
+	ssize_t written = write(transportHostPty, data, length);
+	if (written <= 0) {
+		return 0U;
+	}
+	transportHostCredit -= (uint64_t)written * 1000000U;
+	return (uint16_t)written;
+}
+
+const TransportBackend transportSerialBackend = {
+	TRANSPORT_SERIAL_MTU,
+	transportHostPtyOpen,
+	transportHostPtyClose,
+	transportHostPtyWrite
+};
+
+/****************************
+ * UDP
+****************************/
+
+bool transportHostUdpOpen(const TransportConfig &config) {
+	transportHostSocket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	if (transportHostSocket < 0) {
+		LOG_E(LINK, "UDP socket didn't open");
+		return false;
+	}
+	int broadcast = 1;
+	setsockopt(transportHostSocket, SOL_SOCKET, SO_BROADCAST, &broadcast, sizeof(broadcast));
+
+	memset(&transportHostTarget, 0, sizeof(transportHostTarget));
+	transportHostTarget.sin_family = AF_INET;
+	transportHostTarget.sin_port = htons(config.port);
+	transportHostTarget.sin_addr.s_addr = config.address;
+	return true;
+}
+
+void transportHostUdpClose(void) {
+	close(transportHostSocket);
+	transportHostSocket = -1;
+}
+
+/**
+ * Sends one datagram unless the socket buffer is full
+ */
+uint16_t transportHostUdpWrite(const uint8_t *data, uint16_t size) {
+	ssize_t sent = sendto(transportHostSocket, data, size, 0,
+		(const struct sockaddr*)&transportHostTarget, sizeof(transportHostTarget));
+	return sent == (ssize_t)size ? size : 0U;
+}
+
+const TransportBackend transportUdpBackend = {
+	TRANSPORT_UDP_MTU,
+	transportHostUdpOpen,
+	transportHostUdpClose,
+	transportHostUdpWrite
+};
+
+/****************************
+ * Loopback
+****************************/
+
+bool transportHostLoopbackOpen(const TransportConfig &config) {
+	transportHostRing.reset();
+	return true;
+}
+
+void transportHostLoopbackClose(void) {}
+
+uint16_t transportHostLoopbackWrite(const uint8_t *data, uint16_t size) {
+	return (uint16_t)transportHostRing.pushN(data, size);
+}
+
+const TransportBackend transportLoopbackBackend = {
+	TRANSPORT_BLE_MTU,
+	transportHostLoopbackOpen,
+	transportHostLoopbackClose,
+	transportHostLoopbackWrite
+};
+
+/****************************
+ * Host Transport Methods
+****************************/
+
+const char *transportHostPtyName(void) {
+	return transportHostPty >= 0 ? transportHostPtyPath : NULL;
+}
+
+uint16_t transportHostRead(uint8_t *data, uint16_t size) {
+	return (uint16_t)transportHostRing.popN(data, size);
+}
+
+#endif
@@ -0,0 +1,63 @@
+/*
+	transport_host.h - host stand-ins for the link transports
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "../compile_flags.h"
+
+#ifndef TRANSPORTHOST_H
+#define TRANSPORTHOST_H
+
+#ifdef HOSTLINUX
+
+#include <Arduino.h>
+#include "transport.h"
+
+/****************************
+ * Host Transports
+ *
+ * Serial is a pty paced at the config's baud like a UART,
+ * an app or a terminal opens transportHostPtyName(). UDP
+ * is a socket sending to the config's address and port.
+ * Loopback queues bytes in memory for transportHostRead()
+ * in writes the size of a BLE notification.
+****************************/
+
+// bytes the loopback holds before writes are refused, a power of two
+#ifndef TRANSPORT_LOOPBACK_SIZE
+#define TRANSPORT_LOOPBACK_SIZE 65536UL
+#endif
+
+/**
+ * Gets the pty serial writes to
+ *
+ * @return path of the pty, NULL unless serial is open
+ */
+const char *transportHostPtyName(void);
+
+/**
+ * Takes bytes sent over the loopback, only call it from
+ * one thread
+ *
+ * @param data buffer of size bytes
+ * @param size most bytes to take
+ *
+ * @return bytes taken
+ */
+uint16_t transportHostRead(uint8_t *data, uint16_t size);
+
+#endif
+#endif
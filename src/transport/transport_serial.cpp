@@ -0,0 +1,65 @@
+/*
+	transport_serial.cpp - link transport over the board's Serial
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "transport.h"
+
+#if !defined(HOSTLINUX)
+
+/****************************
+ * Serial Transport
+ *
+ * Writes only what fits Serial's transmit buffer, the
+ * UART ring on the Uno and ESP32 and the USB endpoint on
+ * the Pico, so Serial.write() never waits. Bytes wait for
+ * a whole write or half the buffer free.
+****************************/
+
+/**
+ * Starts Serial at the config's baud
+ */
+bool transportSerialOpen(const TransportConfig &config) {
+	Serial.begin(config.baud);
+	return true;
+}
+
+/**
+ * Leaves Serial running, debug output may still use it
+ */
+void transportSerialClose(void) {}
+
+/**
+ * Writes what Serial can buffer
+ */
+uint16_t transportSerialWrite(const uint8_t *data, uint16_t size) {
+	// waits for half the buffer free rather than writing a byte at a time
+	int room = Serial.availableForWrite();
+	if (room <= 0 || ((uint16_t)room < size && (uint16_t)room < TRANSPORT_SERIAL_MTU / 2U)) {
+		return 0U;
+	}
+	uint16_t length = (uint16_t)room < size ? (uint16_t)room : size;
+	return (uint16_t)Serial.write(data, length);
+}
+
+const TransportBackend transportSerialBackend = {
+	TRANSPORT_SERIAL_MTU,
+	transportSerialOpen,
+	transportSerialClose,
+	transportSerialWrite
+};
+
+#endif
@@ -0,0 +1,366 @@
+/*
+	trigger.cpp - streaming trigger with pre-trigger capture
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "trigger.h"
+#include "../acquisition/acquisition.h"
+#include "../nvm/eeprom_addresses.h"
+
+#define TRIG_HISTORY_MASK ((uint16_t)(TRIG_FRAME_SAMPLES - 1U))
+#define TRIG_MAX_CODE ((uint16_t)((1UL << Board::adcBits) - 1UL))
+
+// positions are compared by their difference
+#define TRIG_HOLDOFF_MAX 0x7FFFFFFFUL
+
+enum TrigFrameState : uint8_t {TRIG_WAITING, TRIG_COLLECTING, TRIG_READY};
+
+SampleWord trigHistory[TRIG_FRAME_SAMPLES];
+SampleWord trigFrame[TRIG_FRAME_SAMPLES];
+
+TrigConfig trigConfig;
+uint8_t trigStride = 0U;
+uint8_t trigSlot = 0U;
+SampleWord trigHighLevel = 0U; // at or above goes high
+SampleWord trigLowLevel = 0U; // below goes low
+
+bool trigActive = false;
+bool trigStarted = false; // first sample seen
+bool trigHigh = false;
+bool trigPulseOpen = false;
+uint32_t trigPulseStart = 0UL;
+
+uint32_t trigPosition = 0UL; // of the block's first set
+uint32_t trigArmed = 0UL; // first position a trigger can be taken at
+uint16_t trigHistoryHead = 0U;
+
+uint8_t trigFrameState = TRIG_WAITING;
+uint16_t trigFrameLength = 0U;
+uint16_t trigFrameFill = 0U;
+uint32_t trigFramePosition = 0UL;
+uint32_t trigFrameCount = 0UL;
+
+/**
+ * Gets the Schmitt levels of a config
+ *
+ * @param config condition to get levels of
+ * @param high set to the level at or above which the source goes high
+ * @param low set to the level below which the source goes low
+ *
+ * @return if the levels fit the ADC range
+ */
+bool trigLevels(const TrigConfig &config, SampleWord *high, SampleWord *low) {
+	if (config.mode == TRIG_FALLING) {
+		// goes low at the level, high once past the hysteresis above it
+		if ((uint32_t)config.level + config.hysteresis + 1UL > TRIG_MAX_CODE) {
+			return false;
+		}
+		*high = (SampleWord)(config.level + config.hysteresis + 1U);
+		*low = (SampleWord)(config.level + 1U);
+		return true;
+	}
+
+	if (config.level > TRIG_MAX_CODE || config.level <= config.hysteresis) {
+		return false;
+	}
+	*high = (SampleWord)config.level;
+	*low = (SampleWord)(config.level - config.hysteresis);
+	return true;
+}
+
+/**
+ * Copies the newest samples of the history
+ *
+ * @param destination where to copy to
+ * @param count samples to copy, at most TRIG_FRAME_SAMPLES
+ */
+void trigCopyHistory(SampleWord *destination, uint16_t count) {
+	uint16_t start = (uint16_t)((trigHistoryHead - count) & TRIG_HISTORY_MASK);
+	uint16_t first = (uint16_t)(TRIG_FRAME_SAMPLES - start);
+	if (first > count) {
+		first = count;
+	}
+	memcpy(destination, &trigHistory[start], first * sizeof(SampleWord));
+	memcpy(&destination[first], trigHistory, (count - first) * sizeof(SampleWord));
+}
+
+/**
+ * Appends a block to the history
+ *
+ * @param samples block of whole sample sets
+ * @param count samples in the block
+ */
+void trigAppendHistory(const SampleWord *samples, uint16_t count) {
+	if (count > TRIG_FRAME_SAMPLES) {
+		samples += count - TRIG_FRAME_SAMPLES;
+		count = TRIG_FRAME_SAMPLES;
+	}
+	uint16_t first = (uint16_t)(TRIG_FRAME_SAMPLES - trigHistoryHead);
+	if (first > count) {
+		first = count;
+	}
+	memcpy(&trigHistory[trigHistoryHead], samples, first * sizeof(SampleWord));
+	memcpy(trigHistory, &samples[first], (count - first) * sizeof(SampleWord));
+	trigHistoryHead = (uint16_t)((trigHistoryHead + count) & TRIG_HISTORY_MASK);
+}
+
+/**
+ * Copies block samples into the frame being collected
+ *
+ * @param samples samples following those collected
+ * @param count samples available
+ */
+void trigCollect(const SampleWord *samples, uint16_t count) {
+	uint16_t needed = (uint16_t)(trigFrameLength - trigFrameFill);
+	if (count > needed) {
+		count = needed;
+	}
+	memcpy(&trigFrame[trigFrameFill], samples, count * sizeof(SampleWord));
+	trigFrameFill = (uint16_t)(trigFrameFill + count);
+
+	if (trigFrameFill == trigFrameLength) {
+		trigFrameState = TRIG_READY;
+		trigFrameCount++;
+		LOG_T(TRIG, "Frame at {} ready", trigFramePosition);
+	}
+}
+
+/**
+ * Takes a trigger if the frame is free and holdoff is over
+ *
+ * @param samples block being scanned
+ * @param count samples in the block
+ * @param index index of the source sample that triggered
+ */
+void trigFire(const SampleWord *samples, uint16_t count, uint16_t index) {
+	uint32_t position = trigPosition + index / trigStride;
+	if (trigFrameState != TRIG_WAITING || (int32_t)(position - trigArmed) < 0) {
+		return;
+	}
+
+	// pre-trigger sets come from the history then the block
+	uint16_t base = (uint16_t)(index - trigSlot);
+	uint16_t pre = (uint16_t)(trigConfig.preTrigger * trigStride);
+	uint16_t fromBlock = base < pre ? base : pre;
+	trigCopyHistory(trigFrame, (uint16_t)(pre - fromBlock));
+	memcpy(&trigFrame[pre - fromBlock], &samples[base - fromBlock], fromBlock * sizeof(SampleWord));
+
+	trigFrameFill = pre;
+	trigFramePosition = position;
+	trigFrameState = TRIG_COLLECTING;
+	trigArmed = position + trigConfig.holdoff;
+	trigCollect(&samples[base], (uint16_t)(count - base));
+}
+
+/****************************
+ * Trigger Methods
+****************************/
+
+bool trigCheckConfig(const TrigConfig &config, uint8_t channels) {
+	SampleWord high;
+	SampleWord low;
+	uint8_t stride = acqChannelCount(channels);
+
+	return config.mode < TRIG_MODES &&
+		config.source < Board::adcChannels &&
+		(channels & (1U << config.source)) != 0U &&
+		trigLevels(config, &high, &low) &&
+		config.preTrigger < config.length &&
+		(uint32_t)config.length * stride <= TRIG_FRAME_SAMPLES &&
+		config.holdoff <= TRIG_HOLDOFF_MAX &&
+		config.pulseMin <= config.pulseMax;
+}
+
+bool trigLoadConfig(TrigConfig *config, uint8_t channels) {
+	TrigConfig stored;
+	if (nvmGetField<NVMTrigModeField>(&stored.mode) &&
+		nvmGetField<NVMTrigSourceField>(&stored.source) &&
+		nvmGetField<NVMTrigLevelField>(&stored.level) &&
+		nvmGetField<NVMTrigHysteresisField>(&stored.hysteresis) &&
+		nvmGetField<NVMTrigPreField>(&stored.preTrigger) &&
+		nvmGetField<NVMTrigLengthField>(&stored.length) &&
+		nvmGetField<NVMTrigHoldoffField>(&stored.holdoff) &&
+		nvmGetField<NVMTrigPulseMinField>(&stored.pulseMin) &&
+		nvmGetField<NVMTrigPulseMaxField>(&stored.pulseMax) &&
+		trigCheckConfig(stored, channels)) {
+
+		*config = stored;
+		return true;
+	}
+
+	// rising edge at mid scale on the lowest channel, centred in the frame
+	uint8_t source = 0U;
+	while (source < Board::adcChannels - 1U && (channels & (1U << source)) == 0U) {
+		source++;
+	}
+	uint8_t stride = acqChannelCount(channels);
+	uint16_t length = (uint16_t)(TRIG_FRAME_SAMPLES / (stride != 0U ? stride : 1U));
+
+	config->mode = TRIG_RISING;
+	config->source = source;
+	config->level = TRIG_DEFAULT_LEVEL;
+	config->hysteresis = (uint16_t)(TRIG_DEFAULT_LEVEL / 32U);
+	config->preTrigger = (uint16_t)(length / 2U);
+	config->length = length;
+	config->holdoff = 0UL;
+	config->pulseMin = 0UL;
+	config->pulseMax = 0UL;
+	return false;
+}
+
+bool trigInit(uint8_t channels) {
+	TrigConfig config;
+	if (!trigLoadConfig(&config, channels)) {
+		LOG_I(TRIG, "No stored trigger, using defaults");
+	}
+	return trigBegin(config, channels);
+}
+
+bool trigBegin(const TrigConfig &config, uint8_t channels) {
+	if (!trigCheckConfig(config, channels)) {
+		LOG_E(TRIG, "Can't trigger in mode {} on channel {} of {}", config.mode, config.source, channels);
+		trigActive = false;
+		return false;
+	}
+
+	trigConfig = config;
+	trigLevels(config, &trigHighLevel, &trigLowLevel);
+	trigStride = acqChannelCount(channels);
+	trigSlot = acqChannelCount((uint8_t)(channels & ((1U << config.source) - 1U)));
+
+	trigStarted = false;
+	trigPulseOpen = false;
+	trigPosition = 0UL;
+	trigArmed = config.preTrigger; // history has to fill first
+	trigHistoryHead = 0U;
+	trigFrameState = TRIG_WAITING;
+	trigFrameLength = (uint16_t)(config.length * trigStride);
+	trigFrameCount = 0UL;
+	trigActive = true;
+
+	nvmWriteField<NVMTrigModeField>(config.mode);
+	nvmWriteField<NVMTrigSourceField>(config.source);
+	nvmWriteField<NVMTrigLevelField>(config.level);
+	nvmWriteField<NVMTrigHysteresisField>(config.hysteresis);
+	nvmWriteField<NVMTrigPreField>(config.preTrigger);
+	nvmWriteField<NVMTrigLengthField>(config.length);
+	nvmWriteField<NVMTrigHoldoffField>(config.holdoff);
+	nvmWriteField<NVMTrigPulseMinField>(config.pulseMin);
+	nvmWriteField<NVMTrigPulseMaxField>(config.pulseMax);
+
+	LOG_I(TRIG, "Triggering in mode {} on channel {} at {}", config.mode, config.source, config.level);
+	return true;
+}
+
+void trigPush(const SampleWord *samples, uint16_t count) {
+	if (!trigActive || count < trigStride) {
+		return;
+	}
+
+	if (trigFrameState == TRIG_COLLECTING) {
+		trigCollect(samples, count);
+	}
+
+	if (!trigStarted) {
+		// a signal already past the level doesn't trigger
+		trigHigh = samples[trigSlot] >= trigHighLevel;
+		trigStarted = true;
+	}
+
+	uint16_t i = trigSlot;
+	if (trigConfig.mode == TRIG_LEVEL) {
+		while (trigFrameState == TRIG_WAITING) {
+			// skip to the end of holdoff
+			int32_t wait = (int32_t)(trigArmed - trigPosition);
+			if (wait > 0) {
+				if ((uint32_t)wait >= count / trigStride) {
+					break;
+				}
+				uint16_t armed = (uint16_t)(wait * trigStride + trigSlot);
+				i = armed > i ? armed : i;
+			}
+
+			i = trigFind<TrigWord, true>(samples, i, count, trigStride, trigSlot, trigHighLevel);
+			if (i >= count) {
+				break;
+			}
+			trigFire(samples, count, i);
+			i = (uint16_t)(i + trigStride);
+		}
+	}
+	else {
+		// only the source's crossings are looked at one by one
+		while (true) {
+			i = trigHigh ?
+				trigFind<TrigWord, false>(samples, i, count, trigStride, trigSlot, trigLowLevel) :
+				trigFind<TrigWord, true>(samples, i, count, trigStride, trigSlot, trigHighLevel);
+			if (i >= count) {
+				break;
+			}
+			trigHigh = !trigHigh;
+
+			switch (trigConfig.mode) {
+				case TRIG_RISING:
+					if (trigHigh) {
+						trigFire(samples, count, i);
+					}
+					break;
+				case TRIG_FALLING:
+					if (!trigHigh) {
+						trigFire(samples, count, i);
+					}
+					break;
+				default: {
+					// pulses open on one edge and trigger on the next
+					uint32_t position = trigPosition + i / trigStride;
+					bool opening = trigHigh == (trigConfig.mode == TRIG_PULSE_HIGH);
+					if (!opening && trigPulseOpen) {
+						uint32_t width = position - trigPulseStart;
+						if (width >= trigConfig.pulseMin && width <= trigConfig.pulseMax) {
+							trigFire(samples, count, i);
+						}
+					}
+					trigPulseOpen = opening;
+					trigPulseStart = position;
+					break;
+				}
+			}
+			i = (uint16_t)(i + trigStride);
+		}
+	}
+
+	trigAppendHistory(samples, count);
+	trigPosition += count / trigStride;
+}
+
+uint16_t trigGetFrame(const SampleWord **samples, uint32_t *position) {
+	if (trigFrameState != TRIG_READY) {
+		return 0U;
+	}
+	*samples = trigFrame;
+	*position = trigFramePosition;
+	return trigFrameLength;
+}
+
+void trigReleaseFrame(void) {
+	if (trigFrameState == TRIG_READY) {
+		trigFrameState = TRIG_WAITING;
+	}
+}
+
+uint32_t trigFrames(void) {
+	return trigFrameCount;
+}
@@ -0,0 +1,267 @@
+/*
+	trigger.h - streaming trigger with pre-trigger capture
+	Copyright (C) 2025 Camren Chraplak
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include <Arduino.h>
+#include "../compile_flags.h"
+#include "../board_traits.h"
+#include "../debug.h"
+
+/****************************
+ * Trigger
+ *
+ * Blocks of samples, interleaved like the acquisition
+ * buffers and starting at the lowest channel, are pushed
+ * through trigPush(). The source channel runs through a
+ * Schmitt trigger, level for going high and level less
+ * hysteresis for going low, flipped above the level for
+ * falling modes. A trigger copies the last preTrigger
+ * samples of every channel from the history and collects
+ * the rest of the frame, which trigGetFrame() hands out.
+ *
+ * No trigger is taken while a frame is collected or
+ * waiting, or within holdoff samples of the last one.
+ * Positions and widths count samples of one channel.
+****************************/
+
+// level of the trigger used when none is stored, mid scale
+#ifndef TRIG_DEFAULT_LEVEL
+#define TRIG_DEFAULT_LEVEL ((uint16_t)(1UL << (Board::adcBits - 1U)))
+#endif
+
+static_assert(TRIG_FRAME_SAMPLES != 0U && (TRIG_FRAME_SAMPLES & (TRIG_FRAME_SAMPLES - 1U)) == 0U,
+	"TRIG_FRAME_SAMPLES must be a power of two");
+static_assert(Board::adcBits < sizeof(SampleWord) * 8U, "Trigger scan needs a spare top bit in each sample");
+
+enum TrigMode : uint8_t {
+	TRIG_RISING, // goes high
+	TRIG_FALLING, // goes low
+	TRIG_LEVEL, // is high, no edge needed
+	TRIG_PULSE_HIGH, // goes low after a high pulse of pulseMin to pulseMax
+	TRIG_PULSE_LOW, // goes high after a low pulse of pulseMin to pulseMax
+	TRIG_MODES
+};
+
+/**
+ * Condition and frame of a trigger, sample counts are of
+ * one channel
+ */
+struct TrigConfig {
+	uint8_t mode; // TrigMode
+	uint8_t source; // ADC channel the condition is tested on
+	uint16_t level;
+	uint16_t hysteresis;
+	uint16_t preTrigger; // samples kept from before the trigger
+	uint16_t length; // samples in a frame, pre-trigger included
+	uint32_t holdoff; // samples after a trigger before the next
+	uint32_t pulseMin;
+	uint32_t pulseMax;
+};
+
+/****************************
+ * Trigger Methods
+****************************/
+
+/**
+ * Starts the trigger with the config stored by the last
+ * trigBegin(), or a rising edge at mid scale
+ *
+ * @param channels channel bits of the blocks pushed
+ *
+ * @return if the trigger started
+ */
+bool trigInit(uint8_t channels);
+
+/**
+ * Starts the trigger, drops any frame and history, and
+ * stores the config for the next trigInit()
+ *
+ * @param config condition and frame
+ * @param channels channel bits of the blocks pushed
+ *
+ * @return if config was valid
+ */
+bool trigBegin(const TrigConfig &config, uint8_t channels);
+
+/**
+ * Checks a config works with a set of channels
+ *
+ * @param config condition and frame
+ * @param channels channel bits of the blocks pushed
+ *
+ * @return if config is valid
+ */
+bool trigCheckConfig(const TrigConfig &config, uint8_t channels);
+
+/**
+ * Reads the config stored by trigBegin()
+ *
+ * @param config set to the stored config, the defaults if none is valid
+ * @param channels channel bits the config has to work with
+ *
+ * @return if a stored config was found
+ */
+bool trigLoadConfig(TrigConfig *config, uint8_t channels);
+
+/**
+ * Scans a block for the trigger and collects frames
+ *
+ * @param samples block of whole sample sets
+ * @param count samples in the block
+ */
+void trigPush(const SampleWord *samples, uint16_t count);
+
+/**
+ * Gets the frame of the last trigger
+ *
+ * @param samples set to the first sample, the lowest channel
+ * @param position set to the trigger's sample count since trigBegin()
+ *
+ * @return samples in the frame, 0 if none is ready
+ */
+uint16_t trigGetFrame(const SampleWord **samples, uint32_t *position);
+
+/**
+ * Hands the frame back so the next trigger can be taken
+ */
+void trigReleaseFrame(void);
+
+/**
+ * Gets frames completed since trigBegin()
+ *
+ * @return frames triggered
+ */
+uint32_t trigFrames(void);
+
+/****************************
+ * Scan Methods
+ *
+ * Finds the next sample of a channel past a threshold a
+ * word at a time. A word holds several samples in lanes,
+ * each lane's top bit is free as samples are narrower,
+ * so one subtract compares every lane without borrowing
+ * into the next. Words that divide into whole sample sets
+ * use a lane mask for the channel, others and boards
+ * without wide words test one sample at a time.
+****************************/
+
+/**
+ * Widest word the board handles in one operation
+ */
+template <bool WIDE, bool NATIVE64>
+struct TrigScanWord {
+	typedef SampleWord type;
+};
+
+template <>
+struct TrigScanWord<true, false> {
+	typedef uint32_t type;
+};
+
+template <>
+struct TrigScanWord<true, true> {
+	typedef uint64_t type;
+};
+
+typedef TrigScanWord<(Board::wordBits >= 32U), Board::native64>::type TrigWord;
+
+/**
+ * Gets the lowest set bit of a word
+ *
+ * @param mask word with a bit set
+ *
+ * @return index of the bit
+ */
+template <typename W>
+inline uint8_t trigFirstBit(W mask) {
+	return (uint8_t)(sizeof(W) > sizeof(unsigned long) ?
+		__builtin_ctzll((unsigned long long)mask) : __builtin_ctzl((unsigned long)mask));
+}
+
+/**
+ * Finds the next sample of a channel at or above, or
+ * below, a threshold
+ *
+ * @param W word to scan with, SampleWord for one at a time
+ * @param ABOVE if looking for at or above, below if not
+ * @param samples interleaved samples
+ * @param start index to look from, any channel
+ * @param count samples in the block
+ * @param stride number of channels
+ * @param slot place of the channel in a sample set
+ * @param threshold threshold to compare with, at most 0x7FFF
+ *
+ * @return index of the sample, count if there is none
+ */
+template <typename W, bool ABOVE>
+uint16_t trigFind(
+	const SampleWord *samples, uint16_t start, uint16_t count,
+	uint8_t stride, uint8_t slot, SampleWord threshold
+) {
+	if (!ABOVE && threshold == 0U) {
+		return count;
+	}
+
+	const uint8_t LANES = sizeof(W) / sizeof(SampleWord);
+	uint16_t i = start;
+
+	if (LANES > 1U && LANES % stride == 0U) {
+		const uint8_t LANE_BITS = sizeof(SampleWord) * 8U;
+		const W ONES = (W)~(W)0 / (W)(SampleWord)~(SampleWord)0;
+		const W HIGH = ONES << (LANE_BITS - 1U);
+		const W LIMIT = ONES * (W)(ABOVE ? threshold : threshold - 1U);
+
+		// unaligned words are slow or fault on the boards
+		while (i < count && ((uintptr_t)&samples[i] & (sizeof(W) - 1U)) != 0U) {
+			if (i % stride == slot && (ABOVE ? samples[i] >= threshold : samples[i] < threshold)) {
+				return i;
+			}
+			i++;
+		}
+
+		// lanes of the channel, the same in every word as sets divide words
+		W select = 0U;
+		for (uint8_t lane = 0U; lane < LANES; lane++) {
+			if ((i + lane) % stride == slot) {
+				select |= (W)1U << (lane * LANE_BITS + LANE_BITS - 1U);
+			}
+		}
+
+		for (; (uint16_t)(count - i) >= LANES; i += LANES) {
+			W word;
+			memcpy(&word, &samples[i], sizeof(W));
+			W found = (ABOVE ? ((word | HIGH) - LIMIT) : ((LIMIT | HIGH) - word)) & select;
+			if (found != 0U) {
+				return (uint16_t)(i + trigFirstBit(found) / LANE_BITS);
+			}
+		}
+	}
+
+	// one at a time from the channel's next sample
+	i = (uint16_t)(i + (uint8_t)(slot + stride - i % stride) % stride);
+	for (; i < count; i += stride) {
+		if (ABOVE ? samples[i] >= threshold : samples[i] < threshold) {
+			return i;
+		}
+	}
+	return count;
+}
+
+#endif